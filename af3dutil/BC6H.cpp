@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "af3d/BC6H.h"
+#include <algorithm>
+#include <cstring>
+
+namespace af3d
+{
+    namespace
+    {
+        const int bc6hWeights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        // Unsigned half float bits, round to nearest.
+        std::uint32_t toHalfBits(float f)
+        {
+            if (!(f > 0.0f)) {
+                return 0;
+            }
+            if (f >= 65504.0f) {
+                return 0x7BFF;
+            }
+
+            std::uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+
+            int exp = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+            std::uint32_t mant = bits & 0x7FFFFF;
+
+            if (exp <= 0) {
+                if (exp < -10) {
+                    return 0;
+                }
+                mant |= 0x800000;
+                int shift = 14 - exp;
+                return (mant >> shift) + ((mant >> (shift - 1)) & 1);
+            }
+
+            std::uint32_t h = (static_cast<std::uint32_t>(exp) << 10) | (mant >> 13);
+            h += (mant >> 12) & 1;
+            return (std::min)(h, 0x7BFFU);
+        }
+
+        // 10-bit endpoint to 16-bit, as decoder does it.
+        inline int unquantize(int e)
+        {
+            if (e == 0) {
+                return 0;
+            } else if (e == 1023) {
+                return 0xFFFF;
+            }
+            return (e << 6) + 32;
+        }
+
+        // Decoded half bits of palette entry 'i'.
+        inline int paletteValue(int e0, int e1, int i)
+        {
+            int v = ((64 - bc6hWeights[i]) * unquantize(e0) + bc6hWeights[i] * unquantize(e1) + 32) >> 6;
+            return (v * 31) >> 6;
+        }
+
+        inline int quantize(float u)
+        {
+            return (std::max)(0, (std::min)(1023, static_cast<int>((u - 32.0f) / 64.0f + 0.5f)));
+        }
+
+        class BitWriter
+        {
+        public:
+            explicit BitWriter(Byte* out)
+            : out_(out)
+            {
+                std::memset(out_, 0, 16);
+            }
+
+            void write(std::uint32_t value, int numBits)
+            {
+                for (int i = 0; i < numBits; ++i, ++pos_) {
+                    out_[pos_ >> 3] |= ((value >> i) & 1) << (pos_ & 7);
+                }
+            }
+
+        private:
+            Byte* out_;
+            int pos_ = 0;
+        };
+
+        void encodeBlock(const std::uint32_t (&texels)[16][3], Byte* out)
+        {
+            // Work in decoder's pre-finish space, where endpoints interpolate linearly.
+            float u[16][3];
+            float mean[3] = { 0.0f, 0.0f, 0.0f };
+            for (int i = 0; i < 16; ++i) {
+                for (int c = 0; c < 3; ++c) {
+                    u[i][c] = texels[i][c] * (64.0f / 31.0f);
+                    mean[c] += u[i][c] / 16.0f;
+                }
+            }
+
+            // Bounding box diagonal, flipped per channel to follow the main trend.
+            int mainC = 0;
+            float lo[3], hi[3];
+            for (int c = 0; c < 3; ++c) {
+                lo[c] = hi[c] = u[0][c];
+                for (int i = 1; i < 16; ++i) {
+                    lo[c] = (std::min)(lo[c], u[i][c]);
+                    hi[c] = (std::max)(hi[c], u[i][c]);
+                }
+                if ((hi[c] - lo[c]) > (hi[mainC] - lo[mainC])) {
+                    mainC = c;
+                }
+            }
+
+            int e0[3], e1[3];
+            for (int c = 0; c < 3; ++c) {
+                float cov = 0.0f;
+                for (int i = 0; i < 16; ++i) {
+                    cov += (u[i][c] - mean[c]) * (u[i][mainC] - mean[mainC]);
+                }
+                e0[c] = quantize((cov < 0.0f) ? hi[c] : lo[c]);
+                e1[c] = quantize((cov < 0.0f) ? lo[c] : hi[c]);
+            }
+
+            int palette[16][3];
+            for (int i = 0; i < 16; ++i) {
+                for (int c = 0; c < 3; ++c) {
+                    palette[i][c] = paletteValue(e0[c], e1[c], i);
+                }
+            }
+
+            int indices[16];
+            for (int i = 0; i < 16; ++i) {
+                int best = 0;
+                std::int64_t bestErr = -1;
+                for (int j = 0; j < 16; ++j) {
+                    std::int64_t err = 0;
+                    for (int c = 0; c < 3; ++c) {
+                        std::int64_t d = palette[j][c] - static_cast<int>(texels[i][c]);
+                        err += d * d;
+                    }
+                    if ((bestErr < 0) || (err < bestErr)) {
+                        bestErr = err;
+                        best = j;
+                    }
+                }
+                indices[i] = best;
+            }
+
+            // First index is stored without its top bit, palette is symmetric, so just flip.
+            if (indices[0] >= 8) {
+                std::swap(e0, e1);
+                for (int i = 0; i < 16; ++i) {
+                    indices[i] = 15 - indices[i];
+                }
+            }
+
+            BitWriter bw(out);
+            bw.write(0x03, 5);
+            for (int c = 0; c < 3; ++c) {
+                bw.write(e0[c], 10);
+            }
+            for (int c = 0; c < 3; ++c) {
+                bw.write(e1[c], 10);
+            }
+            bw.write(indices[0], 3);
+            for (int i = 1; i < 16; ++i) {
+                bw.write(indices[i], 4);
+            }
+        }
+    }
+
+    std::uint32_t bc6hSize(std::uint32_t width, std::uint32_t height)
+    {
+        return ((width + 3) / 4) * ((height + 3) / 4) * 16;
+    }
+
+    void bc6hEncode(const float* pixels, std::uint32_t width, std::uint32_t height, Byte* out)
+    {
+        std::uint32_t texels[16][3];
+
+        for (std::uint32_t by = 0; by < height; by += 4) {
+            for (std::uint32_t bx = 0; bx < width; bx += 4) {
+                // Edge blocks of small mips repeat last row/column.
+                for (std::uint32_t y = 0; y < 4; ++y) {
+                    for (std::uint32_t x = 0; x < 4; ++x) {
+                        const float* p = pixels + ((std::min)(by + y, height - 1) * width + (std::min)(bx + x, width - 1)) * 3;
+                        for (int c = 0; c < 3; ++c) {
+                            texels[y * 4 + x][c] = toHalfBits(p[c]);
+                        }
+                    }
+                }
+                encodeBlock(texels, out);
+                out += 16;
+            }
+        }
+    }
+}
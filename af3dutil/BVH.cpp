@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "af3d/BVH.h"
+#include <algorithm>
+
+namespace af3d
+{
+    namespace
+    {
+        const int numBins = 12;
+
+        // Half surface area, it's only used for comparisons.
+        inline float getHalfArea(const AABB& aabb)
+        {
+            auto sz = aabb.getSize();
+            return sz.x() * sz.y() + sz.y() * sz.z() + sz.z() * sz.x();
+        }
+
+        // Clamped, float error can put centers at the upper bound one past the last bin.
+        inline int binIndex(float offset, float k)
+        {
+            return std::min(numBins - 1, std::max(0, static_cast<int>(offset * k)));
+        }
+
+        inline AABB emptyAABB()
+        {
+            return AABB(btVector3(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT),
+                btVector3(-BT_LARGE_FLOAT, -BT_LARGE_FLOAT, -BT_LARGE_FLOAT));
+        }
+    }
+
+    void BVH::build(const std::vector<AABB>& aabbs, int maxLeafSize)
+    {
+        clear();
+
+        if (aabbs.empty()) {
+            return;
+        }
+
+        std::vector<BuildItem> items(aabbs.size());
+
+        indices_.resize(aabbs.size());
+
+        for (size_t i = 0; i < aabbs.size(); ++i) {
+            items[i].aabb = aabbs[i];
+            items[i].center = aabbs[i].getCenter();
+            items[i].index = i;
+        }
+
+        nodes_.reserve(aabbs.size() * 2);
+
+        buildNode(items, 0, aabbs.size(), 0, btMax(maxLeafSize, 1));
+
+        for (size_t i = 0; i < items.size(); ++i) {
+            indices_[i] = items[i].index;
+        }
+    }
+
+    void BVH::clear()
+    {
+        nodes_.clear();
+        indices_.clear();
+    }
+
+    void BVH::buildNode(std::vector<BuildItem>& items, std::uint32_t first, std::uint32_t count, int depth, int maxLeafSize)
+    {
+        // Traversal stack holds at most one pending sibling per level plus the root.
+        btAssert(depth < maxDepth);
+
+        auto nodeIdx = nodes_.size();
+        nodes_.emplace_back();
+
+        AABB aabb = emptyAABB();
+        AABB centerAABB = emptyAABB();
+
+        for (auto i = first; i < first + count; ++i) {
+            aabb.combine(items[i].aabb);
+            centerAABB.combine(items[i].center);
+        }
+
+        nodes_[nodeIdx].aabb = aabb;
+
+        if (count <= static_cast<std::uint32_t>(maxLeafSize)) {
+            nodes_[nodeIdx].offset = first;
+            nodes_[nodeIdx].count = count;
+            return;
+        }
+
+        auto extents = centerAABB.getSize();
+        int axis = extents.maxAxis();
+
+        std::uint32_t mid = first + count / 2;
+
+        // Stay well within traversal stack, fall back to median split when deep.
+        bool useSAH = (depth < (maxDepth / 2 - 2)) && (extents[axis] > SIMD_EPSILON);
+
+        if (useSAH) {
+            struct Bin
+            {
+                AABB aabb = emptyAABB();
+                std::uint32_t count = 0;
+            } bins[numBins];
+
+            float k = numBins * (1.0f - SIMD_EPSILON) / extents[axis];
+
+            for (auto i = first; i < first + count; ++i) {
+                int b = binIndex(items[i].center[axis] - centerAABB.lowerBound[axis], k);
+                bins[b].count++;
+                bins[b].aabb.combine(items[i].aabb);
+            }
+
+            float rightCost[numBins - 1];
+            AABB acc = emptyAABB();
+            std::uint32_t accCount = 0;
+            for (int b = numBins - 1; b > 0; --b) {
+                acc.combine(bins[b].aabb);
+                accCount += bins[b].count;
+                rightCost[b - 1] = accCount ? getHalfArea(acc) * accCount : 0.0f;
+            }
+
+            int bestSplit = -1;
+            float bestCost = getHalfArea(aabb) * count;
+            acc = emptyAABB();
+            accCount = 0;
+            for (int b = 0; b < numBins - 1; ++b) {
+                acc.combine(bins[b].aabb);
+                accCount += bins[b].count;
+                if ((accCount == 0) || (accCount == count)) {
+                    continue;
+                }
+                float cost = getHalfArea(acc) * accCount + rightCost[b];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestSplit = b;
+                }
+            }
+
+            if (bestSplit >= 0) {
+                float splitPos = centerAABB.lowerBound[axis];
+                auto it = std::partition(items.begin() + first, items.begin() + first + count,
+                    [axis, splitPos, k, bestSplit](const BuildItem& item) {
+                    return binIndex(item.center[axis] - splitPos, k) <= bestSplit;
+                });
+                mid = it - items.begin();
+            } else {
+                useSAH = false;
+            }
+        }
+
+        if (!useSAH) {
+            std::nth_element(items.begin() + first, items.begin() + mid, items.begin() + first + count,
+                [axis](const BuildItem& a, const BuildItem& b) {
+                return a.center[axis] < b.center[axis];
+            });
+        }
+
+        buildNode(items, first, mid - first, depth + 1, maxLeafSize);
+        nodes_[nodeIdx].offset = nodes_.size();
+        nodes_[nodeIdx].count = 0;
+        buildNode(items, mid, first + count - mid, depth + 1, maxLeafSize);
+    }
+}
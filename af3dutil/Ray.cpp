@@ -50,6 +50,7 @@ namespace af3d
     }
 
     // See: http://psgraphics.blogspot.com/2016/02/new-simple-ray-box-test-from-andrew.html
+    // Inclusive, so flat boxes (planar meshes, single triangles) can still be hit.
     RayTestResult Ray::testAABB(const AABB& aabb) const
     {
         float tmin = -(std::numeric_limits<float>::max)();
@@ -64,7 +65,7 @@ namespace af3d
             }
             tmin = t0 > tmin ? t0 : tmin;
             tmax = t1 < tmax ? t1 : tmax;
-            if (tmax <= tmin) {
+            if (tmax < tmin) {
                 return RayTestResult(false, 0.0f);
             }
         }
@@ -121,4 +122,29 @@ namespace af3d
             return RayTestResult(t >= 0, t);
         }
     }
+
+    bool Ray::testTriangle(const btVector3& v0, const btVector3& v1, const btVector3& v2,
+        float& t, float& u, float& v) const
+    {
+        auto e1 = v1 - v0;
+        auto e2 = v2 - v0;
+        auto p = dir.cross(e2);
+        float det = e1.dot(p);
+        if (btFabs(det) < SIMD_EPSILON * SIMD_EPSILON) {
+            return false;
+        }
+        float invDet = 1.0f / det;
+        auto s = pos - v0;
+        u = s.dot(p) * invDet;
+        if ((u < 0.0f) || (u > 1.0f)) {
+            return false;
+        }
+        auto q = s.cross(e1);
+        v = dir.dot(q) * invDet;
+        if ((v < 0.0f) || (u + v > 1.0f)) {
+            return false;
+        }
+        t = e2.dot(q) * invDet;
+        return t >= 0.0f;
+    }
 }
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Log appenders: 'GameLogAppender' ring buffer with background writer, blocking and dropping,
+ * vs. log4cplus 'FileAppender' with a small buffer and no immediate flush, which formats and writes
+ * on the calling thread just like the old 'GameLogAppender' did. Throughput counts until
+ * the appender is closed, i.e. includes draining the ring. Latency is per call on the first thread.
+ * Usage: bench_log_appender [num records per thread] [num threads]
+ */
+
+#include "GameLogAppender.h"
+#include <log4cplus/fileappender.h>
+#include <log4cplus/initializer.h>
+#include <log4cplus/layout.h>
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include <log4cplus/helpers/property.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+using namespace log4cplus;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const tchar* pattern = LOG4CPLUS_TEXT("%D{%m/%d/%y %H:%M:%S} %-5p %c [%x] - %m%n");
+
+    std::size_t countLines(const char* fileName)
+    {
+        std::ifstream is(fileName, std::ios_base::binary);
+        return std::count(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>(), '\n');
+    }
+
+    void run(const char* name, const SharedAppenderPtr& appender, const char* fileName,
+        int numRecords, int numThreads)
+    {
+        appender->setLayout(std::unique_ptr<Layout>(new PatternLayout(pattern)));
+
+        Logger logger = Logger::getInstance(LOG4CPLUS_TEXT("bench"));
+        logger.addAppender(appender);
+
+        std::vector<double> latencies;
+        latencies.reserve(numRecords);
+
+        auto start = Clock::now();
+
+        std::vector<std::thread> threads;
+        for (int i = 1; i < numThreads; ++i) {
+            threads.emplace_back([&logger, numRecords, i]() {
+                for (int j = 0; j < numRecords; ++j) {
+                    LOG4CPLUS_INFO(logger, "thread " << i << " record " << j << ", some payload to make it look like a real record");
+                }
+            });
+        }
+        for (int j = 0; j < numRecords; ++j) {
+            auto t = Clock::now();
+            LOG4CPLUS_INFO(logger, "thread " << 0 << " record " << j << ", some payload to make it look like a real record");
+            latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t).count());
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        logger.removeAllAppenders();
+        appender->close();
+
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        std::sort(latencies.begin(), latencies.end());
+
+        std::size_t total = static_cast<std::size_t>(numRecords) * numThreads;
+
+        std::printf("%-14s %10.1f ms %12.0f records/s, latency p50 %6.2f us p99 %8.2f us max %9.1f us, %d/%d lines\n",
+            name, ms, total / (ms / 1000.0), latencies[latencies.size() / 2],
+            latencies[latencies.size() * 99 / 100], latencies.back(),
+            static_cast<int>(countLines(fileName)), static_cast<int>(total));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int numRecords = (argc > 1) ? std::atoi(argv[1]) : 200000;
+    int numThreads = (argc > 2) ? std::atoi(argv[2]) : 4;
+
+    Initializer initializer;
+
+    Logger::getInstance(LOG4CPLUS_TEXT("bench")).setAdditivity(false);
+
+    std::printf("%d records per thread, %d threads\n", numRecords, numThreads);
+
+    {
+        helpers::Properties props;
+        props.setProperty(LOG4CPLUS_TEXT("File"), LOG4CPLUS_TEXT("log_sync.txt"));
+        props.setProperty(LOG4CPLUS_TEXT("ImmediateFlush"), LOG4CPLUS_TEXT("false"));
+        props.setProperty(LOG4CPLUS_TEXT("BufferSize"), LOG4CPLUS_TEXT("512"));
+        run("sync", SharedAppenderPtr(new FileAppender(props)), "log_sync.txt", numRecords, numThreads);
+    }
+
+    {
+        helpers::Properties props;
+        props.setProperty(LOG4CPLUS_TEXT("BufferSize"), LOG4CPLUS_TEXT("1048576"));
+        props.setProperty(LOG4CPLUS_TEXT("Blocking"), LOG4CPLUS_TEXT("true"));
+        run("ring blocking", SharedAppenderPtr(new GameLogAppender(props)), "log.txt", numRecords, numThreads);
+    }
+
+    {
+        helpers::Properties props;
+        props.setProperty(LOG4CPLUS_TEXT("BufferSize"), LOG4CPLUS_TEXT("1048576"));
+        props.setProperty(LOG4CPLUS_TEXT("Blocking"), LOG4CPLUS_TEXT("false"));
+        run("ring dropping", SharedAppenderPtr(new GameLogAppender(props)), "log.txt", numRecords, numThreads);
+    }
+
+    return 0;
+}
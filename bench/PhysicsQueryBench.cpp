@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Physics queries against a world of static boxes and spheres: one btCollisionWorld::rayTest/
+ * convexSweepTest per query with a std::function per hit (what 'PhysicsComponentManager::rayCast'
+ * does) vs. batched 'rayCastQuery'/'sweepQuery' (what 'rayCastBatch'/'sweepBatch' do), on one
+ * and several threads.
+ * Usage: bench_physics_query [num objects] [num queries] [num threads]
+ */
+
+#include "PhysicsQuery.h"
+#include "bullet/BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace af3d;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    using HitFn = std::function<float(const btCollisionObject*, const btVector3&, const btVector3&, float)>;
+
+    struct PerCallRayCallback : public btCollisionWorld::RayResultCallback
+    {
+    public:
+        PerCallRayCallback(const btVector3& p1, const btVector3& p2, const HitFn& fn)
+        : p1_(p1),
+          p2_(p2),
+          fn_(fn) {}
+
+        float addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace) override
+        {
+            btVector3 normalWorld;
+            if (normalInWorldSpace) {
+                normalWorld = rayResult.m_hitNormalLocal;
+            } else {
+                normalWorld = rayResult.m_collisionObject->getWorldTransform().getBasis() * rayResult.m_hitNormalLocal;
+            }
+            btVector3 pointWorld;
+            pointWorld.setInterpolate3(p1_, p2_, rayResult.m_hitFraction);
+
+            float f = fn_(rayResult.m_collisionObject, pointWorld, normalWorld, rayResult.m_hitFraction);
+            if ((f >= 0.0f) && (f < m_closestHitFraction)) {
+                m_closestHitFraction = f;
+            }
+            return m_closestHitFraction;
+        }
+
+    private:
+        const btVector3& p1_;
+        const btVector3& p2_;
+        const HitFn& fn_;
+    };
+
+    const int numRuns = 5;
+
+    // Best of 'numRuns', timings are noisy.
+    template <class Fn>
+    double bestMs(const Fn& fn)
+    {
+        double res = 0.0;
+        for (int i = 0; i < numRuns; ++i) {
+            auto start = Clock::now();
+            fn();
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            res = (i == 0) ? ms : (std::min)(res, ms);
+        }
+        return res;
+    }
+
+    void report(const char* name, double ms, std::size_t numQueries, int numHits)
+    {
+        std::printf("%-22s %10.2f ms %10.1f ns/query %12.0f queries/s, %d hits\n", name, ms,
+            ms * 1.0e6 / numQueries, numQueries / (ms / 1000.0), numHits);
+    }
+
+    int countHits(const std::vector<QueryHit>& hits)
+    {
+        int res = 0;
+        for (const auto& h : hits) {
+            res += h.hit() ? 1 : 0;
+        }
+        return res;
+    }
+
+    // Splits [0, num) across 'numThreads', calling thread takes the first chunk, like 'runBatch'.
+    template <class Fn>
+    void runThreaded(std::size_t num, int numThreads, const Fn& fn)
+    {
+        std::size_t chunk = (num + numThreads - 1) / numThreads;
+        std::vector<std::thread> threads;
+        for (int i = 1; i < numThreads; ++i) {
+            std::size_t begin = (std::min)(i * chunk, num);
+            std::size_t end = (std::min)(begin + chunk, num);
+            threads.emplace_back([&fn, begin, end]() {
+                PhysicsQueryStack stack;
+                fn(begin, end, stack);
+            });
+        }
+        PhysicsQueryStack stack;
+        fn(0, (std::min)(chunk, num), stack);
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int numObjects = (argc > 1) ? std::atoi(argv[1]) : 5000;
+    std::size_t numQueries = (argc > 2) ? std::atoi(argv[2]) : 100000;
+    int numThreads = (argc > 3) ? std::atoi(argv[3]) : 4;
+
+    btDefaultCollisionConfiguration collisionCfg;
+    btCollisionDispatcher dispatcher(&collisionCfg);
+    btDbvtBroadphase broadphase;
+    btCollisionWorld world(&dispatcher, &broadphase, &collisionCfg);
+
+    btBoxShape box(btVector3(0.5f, 0.5f, 0.5f));
+    btSphereShape sphere(0.5f);
+
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> pos(-100.0f, 100.0f);
+
+    std::vector<std::unique_ptr<btCollisionObject>> objects;
+    for (int i = 0; i < numObjects; ++i) {
+        std::unique_ptr<btCollisionObject> obj(new btCollisionObject());
+        obj->setCollisionShape((i % 2) ? static_cast<btCollisionShape*>(&box) : &sphere);
+        obj->setWorldTransform(btTransform(btQuaternion::getIdentity(), btVector3(pos(rng), pos(rng), pos(rng))));
+        world.addCollisionObject(obj.get());
+        objects.push_back(std::move(obj));
+    }
+    world.updateAabbs();
+    // Let dbvt settle into its fixed set like it does after a few simulation steps.
+    for (int i = 0; i < 10; ++i) {
+        world.performDiscreteCollisionDetection();
+    }
+
+    // Line-of-sight like rays, 20 units long.
+    std::vector<RayCastQuery> rays;
+    std::vector<SweepQuery> sweeps;
+    rays.reserve(numQueries);
+    sweeps.reserve(numQueries);
+    std::uniform_real_distribution<float> dir(-1.0f, 1.0f);
+    for (std::size_t i = 0; i < numQueries; ++i) {
+        btVector3 p1(pos(rng), pos(rng), pos(rng));
+        btVector3 d(dir(rng), dir(rng), dir(rng));
+        if (d.fuzzyZero()) {
+            d = btVector3(0.0f, -1.0f, 0.0f);
+        }
+        btVector3 p2 = p1 + d.normalized() * 20.0f;
+        rays.emplace_back(p1, p2);
+        sweeps.emplace_back(btTransform(btQuaternion::getIdentity(), p1), btTransform(btQuaternion::getIdentity(), p2));
+    }
+
+    std::printf("%d objects, %d queries, %d threads\n", numObjects, static_cast<int>(numQueries), numThreads);
+
+    std::vector<QueryHit> hits(numQueries);
+
+    double ms = bestMs([&]() {
+        for (std::size_t i = 0; i < numQueries; ++i) {
+            const auto& q = rays[i];
+            auto& hit = hits[i];
+            hit = QueryHit();
+            HitFn fn = [&hit](const btCollisionObject* obj, const btVector3& pt, const btVector3& n, float fraction) {
+                if (fraction < hit.fraction) {
+                    hit.collisionObject = obj;
+                    hit.shape = const_cast<btCollisionShape*>(obj->getCollisionShape());
+                    hit.point = pt;
+                    hit.normal = n;
+                    hit.fraction = fraction;
+                }
+                return fraction;
+            };
+            PerCallRayCallback cb(q.p1, q.p2, fn);
+            cb.m_flags |= btTriangleRaycastCallback::kF_UseGjkConvexCastRaytest;
+            world.rayTest(q.p1, q.p2, cb);
+        }
+    });
+    report("ray per-call", ms, numQueries, countHits(hits));
+    auto perCallHits = hits;
+
+    ms = bestMs([&]() {
+        hits.assign(numQueries, QueryHit());
+        PhysicsQueryStack stack;
+        for (std::size_t i = 0; i < numQueries; ++i) {
+            rayCastQuery(broadphase, rays[i], hits[i], nullptr, stack);
+        }
+    });
+    report("ray batched", ms, numQueries, countHits(hits));
+
+    int mismatches = 0;
+    for (std::size_t i = 0; i < numQueries; ++i) {
+        if ((hits[i].collisionObject != perCallHits[i].collisionObject) &&
+            (btFabs(hits[i].fraction - perCallHits[i].fraction) > 1.0e-4f)) {
+            ++mismatches;
+        }
+    }
+
+    ms = bestMs([&]() {
+        hits.assign(numQueries, QueryHit());
+        runThreaded(numQueries, numThreads, [&](std::size_t begin, std::size_t end, PhysicsQueryStack& stack) {
+            for (auto i = begin; i < end; ++i) {
+                rayCastQuery(broadphase, rays[i], hits[i], nullptr, stack);
+            }
+        });
+    });
+    report("ray batched threaded", ms, numQueries, countHits(hits));
+
+    ms = bestMs([&]() {
+        hits.assign(numQueries, QueryHit());
+        for (std::size_t i = 0; i < numQueries; ++i) {
+            btCollisionWorld::ClosestConvexResultCallback cb(sweeps[i].from.getOrigin(), sweeps[i].to.getOrigin());
+            world.convexSweepTest(&sphere, sweeps[i].from, sweeps[i].to, cb);
+            if (cb.hasHit()) {
+                hits[i].collisionObject = cb.m_hitCollisionObject;
+                hits[i].shape = const_cast<btCollisionShape*>(cb.m_hitCollisionObject->getCollisionShape());
+                hits[i].fraction = cb.m_closestHitFraction;
+            }
+        }
+    });
+    report("sweep per-call", ms, numQueries, countHits(hits));
+
+    ms = bestMs([&]() {
+        hits.assign(numQueries, QueryHit());
+        PhysicsQueryStack stack;
+        for (std::size_t i = 0; i < numQueries; ++i) {
+            sweepQuery(broadphase, &sphere, sweeps[i], hits[i], nullptr, stack);
+        }
+    });
+    report("sweep batched", ms, numQueries, countHits(hits));
+
+    ms = bestMs([&]() {
+        hits.assign(numQueries, QueryHit());
+        runThreaded(numQueries, numThreads, [&](std::size_t begin, std::size_t end, PhysicsQueryStack& stack) {
+            for (auto i = begin; i < end; ++i) {
+                sweepQuery(broadphase, &sphere, sweeps[i], hits[i], nullptr, stack);
+            }
+        });
+    });
+    report("sweep batched threaded", ms, numQueries, countHits(hits));
+
+    std::printf("ray batched vs per-call mismatches: %d\n", mismatches);
+
+    for (const auto& obj : objects) {
+        world.removeCollisionObject(obj.get());
+    }
+
+    return (mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Ray picking against a large triangle mesh: whole-mesh AABB test (old picking),
+ * brute force over all triangles and triangle BVH (what 'SubMeshData::testRay' does).
+ * Usage: bench_raypick [grid size] [num rays], mesh is a noisy grid of 2 * size^2 triangles,
+ * brute force only runs the first 'maxBruteRays' rays, it takes tens of ms per ray.
+ */
+
+#include "af3d/BVH.h"
+#include "af3d/Ray.h"
+#include "af3d/Vector3.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace af3d;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const std::size_t maxBruteRays = 100;
+
+    struct Hit
+    {
+        float dist = 0.0f;
+        int faceIdx = -1;
+    };
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void report(const char* name, double ms, std::size_t numRays, int numHits)
+    {
+        std::printf("%-12s %10.2f ms %10.1f ns/ray %12.0f rays/s, %d hits\n", name, ms,
+            ms * 1.0e6 / numRays, numRays / (ms / 1000.0), numHits);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int gridSize = (argc > 1) ? std::atoi(argv[1]) : 700;
+    std::size_t numRays = (argc > 2) ? std::atoi(argv[2]) : 2000;
+
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> noise(-0.3f, 0.3f);
+
+    std::vector<Vector3f> vertices;
+    std::vector<TriFace> faces;
+
+    vertices.reserve((gridSize + 1) * (gridSize + 1));
+    for (int z = 0; z <= gridSize; ++z) {
+        for (int x = 0; x <= gridSize; ++x) {
+            vertices.emplace_back(static_cast<float>(x), noise(rng), static_cast<float>(z));
+        }
+    }
+
+    faces.reserve(gridSize * gridSize * 2);
+    for (int z = 0; z < gridSize; ++z) {
+        for (int x = 0; x < gridSize; ++x) {
+            int i = z * (gridSize + 1) + x;
+            faces.emplace_back(i, i + gridSize + 1, i + 1);
+            faces.emplace_back(i + 1, i + gridSize + 1, i + gridSize + 2);
+        }
+    }
+
+    AABB meshAABB(fromVector3f(vertices[0]), fromVector3f(vertices[0]));
+    for (const auto& v : vertices) {
+        meshAABB.combine(fromVector3f(v));
+    }
+
+    // Rays from above at random angles, some of them miss.
+    std::uniform_real_distribution<float> pos(-0.1f * gridSize, 1.1f * gridSize);
+    std::uniform_real_distribution<float> slope(-0.5f, 0.5f);
+
+    std::vector<Ray> rays;
+    rays.reserve(numRays);
+    for (std::size_t i = 0; i < numRays; ++i) {
+        rays.emplace_back(btVector3(pos(rng), 10.0f, pos(rng)),
+            btVector3(slope(rng), -1.0f, slope(rng)).normalized());
+    }
+
+    std::printf("%d triangles, %d rays\n", static_cast<int>(faces.size()), static_cast<int>(numRays));
+
+    // Old picking, whole mesh AABB only.
+    auto start = Clock::now();
+    int numHits = 0;
+    for (const auto& ray : rays) {
+        numHits += ray.testAABB(meshAABB).first ? 1 : 0;
+    }
+    report("aabb only", elapsedMs(start), numRays, numHits);
+
+    std::size_t numBruteRays = (std::min)(numRays, maxBruteRays);
+    std::vector<Hit> bruteHits(numBruteRays);
+    start = Clock::now();
+    numHits = 0;
+    for (std::size_t r = 0; r < numBruteRays; ++r) {
+        const auto& ray = rays[r];
+        float maxDist = (std::numeric_limits<float>::max)();
+        for (int idx = 0; idx < static_cast<int>(faces.size()); ++idx) {
+            const auto& f = faces[idx];
+            float t, u, v;
+            if (ray.testTriangle(fromVector3f(vertices[f.x()]), fromVector3f(vertices[f.y()]),
+                fromVector3f(vertices[f.z()]), t, u, v) && (t < maxDist)) {
+                maxDist = t;
+                bruteHits[r].dist = t;
+                bruteHits[r].faceIdx = idx;
+            }
+        }
+        numHits += (bruteHits[r].faceIdx >= 0) ? 1 : 0;
+    }
+    report("brute force", elapsedMs(start), numBruteRays, numHits);
+
+    // Same as 'SubMeshData::buildBVH', done once per mesh.
+    start = Clock::now();
+    std::vector<AABB> aabbs;
+    aabbs.reserve(faces.size());
+    for (const auto& f : faces) {
+        AABB aabb(fromVector3f(vertices[f.x()]), fromVector3f(vertices[f.x()]));
+        aabb.combine(fromVector3f(vertices[f.y()]));
+        aabb.combine(fromVector3f(vertices[f.z()]));
+        aabbs.push_back(aabb);
+    }
+    BVH bvh;
+    bvh.build(aabbs);
+    std::printf("%-12s %10.2f ms, %d nodes\n", "bvh build", elapsedMs(start), static_cast<int>(bvh.nodes().size()));
+
+    // Same as 'SubMeshData::testRay'.
+    std::vector<Hit> bvhHits(numRays);
+    start = Clock::now();
+    numHits = 0;
+    for (std::size_t r = 0; r < numRays; ++r) {
+        const auto& ray = rays[r];
+        float maxDist = (std::numeric_limits<float>::max)();
+        auto& hit = bvhHits[r];
+        bvh.traverse([&ray, &maxDist](const AABB& aabb) {
+            if (aabb.contains(ray.pos)) {
+                return true;
+            }
+            auto res = ray.testAABB(aabb);
+            return res.first && (res.second < maxDist);
+        }, [&](int idx) {
+            const auto& f = faces[idx];
+            float t, u, v;
+            if (ray.testTriangle(fromVector3f(vertices[f.x()]), fromVector3f(vertices[f.y()]),
+                fromVector3f(vertices[f.z()]), t, u, v) && (t < maxDist)) {
+                maxDist = t;
+                hit.dist = t;
+                hit.faceIdx = idx;
+            }
+        });
+        numHits += (hit.faceIdx >= 0) ? 1 : 0;
+    }
+    report("bvh", elapsedMs(start), numRays, numHits);
+
+    int mismatches = 0;
+    for (std::size_t r = 0; r < numBruteRays; ++r) {
+        if ((bruteHits[r].faceIdx != bvhHits[r].faceIdx) && (btFabs(bruteHits[r].dist - bvhHits[r].dist) > 1.0e-4f)) {
+            ++mismatches;
+        }
+    }
+    std::printf("bvh vs brute force mismatches: %d\n", mismatches);
+
+    return (mismatches == 0) ? 0 : 1;
+}
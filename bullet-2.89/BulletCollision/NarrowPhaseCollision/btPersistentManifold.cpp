@@ -39,7 +39,9 @@ btPersistentManifold::btPersistentManifold()
 	  m_cachedPoints(0),
 	  m_companionIdA(0),
 	  m_companionIdB(0),
-	  m_index1a(0)
+	  m_index1a(0),
+	  m_userPointer(0),
+	  m_userIndex(-1)
 {
 }
 
@@ -28,7 +28,9 @@
 #include "HardwareResourceManager.h"
 #include "TextureManager.h"
 #include "AssetManager.h"
-#include "Mesh.h"
+#include "MeshManager.h"
+#include "Renderer.h"
+#include "Settings.h"
 #include "Logger.h"
 #include "assimp/postprocess.h"
 #include "log4cplus/ndc.h"
@@ -37,7 +39,8 @@ namespace af3d
 {
     AssimpMeshLoader::AssimpMeshLoader(const std::string& path)
     : path_(path),
-      ignoreTransforms_(assetManager.getAssetModel(path_)->ignoreTransforms())
+      ignoreTransforms_(assetManager.getAssetModel(path_)->ignoreTransforms()),
+      flipUV_(assetManager.getAssetModel(path_)->flipUV())
     {
     }
 
@@ -98,7 +101,7 @@ namespace af3d
             ctx.slices[meshData->mMaterialIndex] = VertexArraySlice();
         }
 
-        HardwareDataBufferPtr vbo[2];
+        HardwareDataBufferPtr* vbo = vbos_;
 
         if (numVertices[0] > 0) {
             vbo[0] = hwManager.createDataBuffer(HardwareBuffer::Usage::StaticDraw, 56);
@@ -107,6 +110,9 @@ namespace af3d
             vbo[1] = hwManager.createDataBuffer(HardwareBuffer::Usage::StaticDraw, 32);
         }
 
+        numVertices_[0] = numVertices[0];
+        numVertices_[1] = numVertices[1];
+
         for (auto& kv : ctx.slices) {
             VertexArrayLayout vaLayout;
             vaLayout.addEntry(VertexArrayEntry(VertexAttribName::Pos, GL_FLOAT_VEC3, 0, 0));
@@ -130,83 +136,187 @@ namespace af3d
         if (node) {
             node->name.clear();
         }
+
+        for (const auto& kv : ctx.slices) {
+            auto& info = slices_[kv.first];
+            info.va = kv.second.va();
+            info.withTangent = ctx.mats[kv.first]->type()->hasNM();
+            info.numIndices = kv.second.count();
+        }
+
+        auto data = buildData(scene_.get());
+
+        if (settings.mesh.keepCPUData) {
+            setupCPUData(*data);
+        }
+
+        scene_.reset();
+
+        std::lock_guard<std::mutex> lock(mtx_);
+        data_ = data;
+
         return node;
     }
 
     void AssimpMeshLoader::load(Resource& res, HardwareContext& ctx)
     {
-        Mesh& mesh = static_cast<Mesh&>(res);
+        std::unique_lock<std::mutex> lock(mtx_);
 
-        if (!scene_) {
-            scene_ = loadScene(ctx.importer());
-            runtime_assert(scene_);
+        if (data_) {
+            auto data = data_;
+            data_.reset();
+            uploadRequested_ = false;
+            lock.unlock();
+            upload(*data, ctx);
+            return;
+        }
+
+        // Geometry has to be re-imported, keep buffers valid but empty until it's done.
+        uploadRequested_ = true;
+        bool startImport = !importing_;
+        importing_ = true;
+        lock.unlock();
+
+        size_t maxSize = 0;
+        for (int i = 0; i < 2; ++i) {
+            if (vbos_[i]) {
+                maxSize = (std::max)(maxSize, static_cast<size_t>(numVertices_[i] * vbos_[i]->elementSize()));
+            }
         }
+        for (const auto& kv : slices_) {
+            maxSize = (std::max)(maxSize, static_cast<size_t>(kv.second.numIndices * kv.second.va->ebo()->elementSize()));
+        }
+
+        if (maxSize > 0) {
+            std::vector<Byte> zeros(maxSize, 0);
+
+            for (int i = 0; i < 2; ++i) {
+                if (vbos_[i]) {
+                    vbos_[i]->reload(numVertices_[i], zeros.data(), ctx);
+                }
+            }
+            for (const auto& kv : slices_) {
+                kv.second.va->ebo()->reload(kv.second.numIndices, zeros.data(), ctx);
+            }
+        }
+
+        if (startImport) {
+            LOG4CPLUS_DEBUG(logger(), "Re-importing " << path_ << "...");
+            auto self = shared_from_this();
+            meshManager.importAsync([self](Assimp::Importer& importer) {
+                MeshDataPtr data;
+                auto scene = self->loadScene(importer);
+                if (scene) {
+                    data = self->buildData(scene.get());
+                } else {
+                    LOG4CPLUS_ERROR(logger(), "Unable to re-import " << self->path_);
+                }
+                self->onImported(data);
+            });
+        }
+    }
+
+    AssimpMeshLoader::MeshDataPtr AssimpMeshLoader::buildData(const aiScene* scene) const
+    {
+        auto data = std::make_shared<MeshData>();
 
         LoadContext lctx;
 
-        lctx.numVertices[0] = 0;
-        lctx.numVertices[1] = 0;
+        for (int i = 0; i < 2; ++i) {
+            data->verts[i].resize(numVertices_[i] * (vbos_[i] ? (vbos_[i]->elementSize() / sizeof(float)) : 0));
+            lctx.allVerts[i] = data->verts[i].empty() ? nullptr : &data->verts[i][0];
+            lctx.numVertices[i] = 0;
+        }
 
-        for (std::uint32_t i = 0; i < scene_->mNumMeshes; ++i) {
-            auto meshData = scene_->mMeshes[i];
-            lctx.slices[meshData->mMaterialIndex] = SubMeshPtr();
+        for (const auto& kv : slices_) {
+            auto& indices = data->indices[kv.first];
+            indices.resize(kv.second.numIndices * kv.second.va->ebo()->elementSize());
+            lctx.allIndices[kv.first] = indices.empty() ? nullptr : &indices[0];
         }
 
-        size_t i = 0;
-        for (auto& kv : lctx.slices) {
-            kv.second = mesh.subMeshes()[i];
-            ++i;
+        loadNode(scene, scene->mRootNode, aiMatrix4x4(), lctx);
+
+        for (int i = 0; i < 2; ++i) {
+            btAssert(lctx.numVertices[i] == numVertices_[i]);
         }
-        btAssert(i == mesh.subMeshes().size());
 
-        HardwareDataBufferPtr vbo[2];
+        return data;
+    }
 
-        for (std::uint32_t i = 0; i < scene_->mNumMeshes; ++i) {
-            auto meshData = scene_->mMeshes[i];
-            if (lctx.slices[meshData->mMaterialIndex]->material()->type()->hasNM()) {
-                lctx.numVertices[0] += meshData->mNumVertices;
-                vbo[0] = lctx.slices[meshData->mMaterialIndex]->vaSlice().va()->vbos()[0];
-            } else {
-                lctx.numVertices[1] += meshData->mNumVertices;
-                vbo[1] = lctx.slices[meshData->mMaterialIndex]->vaSlice().va()->vbos()[0];
+    void AssimpMeshLoader::setupCPUData(const MeshData& data)
+    {
+        std::shared_ptr<std::vector<Vector3f>> positions[2];
+
+        for (int i = 0; i < 2; ++i) {
+            if (!vbos_[i]) {
+                continue;
+            }
+            size_t stride = vbos_[i]->elementSize() / sizeof(float);
+            positions[i] = std::make_shared<std::vector<Vector3f>>();
+            positions[i]->reserve(numVertices_[i]);
+            for (size_t j = 0; j < data.verts[i].size(); j += stride) {
+                positions[i]->emplace_back(data.verts[i][j], data.verts[i][j + 1], data.verts[i][j + 2]);
             }
         }
 
-        float *vertsStart[2];
-        std::map<std::uint32_t, GLvoid*> indicesStart;
+        for (const auto& kv : slices_) {
+            auto vaData = std::make_shared<VertexArrayData>();
+            vaData->positions = positions[kv.second.withTangent ? 0 : 1];
+            vaData->indices.reserve(kv.second.numIndices);
+            const auto& indices = data.indices.at(kv.first);
+            if (kv.second.va->ebo()->dataType() == HardwareIndexBuffer::UInt16) {
+                const std::uint16_t* idx = (const std::uint16_t*)indices.data();
+                vaData->indices.assign(idx, idx + kv.second.numIndices);
+            } else {
+                const std::uint32_t* idx = (const std::uint32_t*)indices.data();
+                vaData->indices.assign(idx, idx + kv.second.numIndices);
+            }
+            kv.second.va->setData(vaData);
+        }
+    }
 
+    void AssimpMeshLoader::upload(const MeshData& data, HardwareContext& ctx)
+    {
         for (int i = 0; i < 2; ++i) {
-            if (vbo[i]) {
-                vbo[i]->resize(lctx.numVertices[i], ctx);
-                lctx.allVerts[i] = vertsStart[i] = (float*)vbo[i]->lock(HardwareBuffer::WriteOnly, ctx);
+            if (vbos_[i]) {
+                vbos_[i]->reload(numVertices_[i], data.verts[i].data(), ctx);
             }
         }
 
-        for (const auto& kv : lctx.slices) {
-            auto ebo = kv.second->vaSlice().va()->ebo();
-            ebo->resize(kv.second->vaSlice().count(), ctx);
-            lctx.allIndices[kv.first] = indicesStart[kv.first] = ebo->lock(HardwareBuffer::WriteOnly, ctx);
+        for (const auto& kv : slices_) {
+            kv.second.va->ebo()->reload(kv.second.numIndices, data.indices.at(kv.first).data(), ctx);
         }
+    }
 
-        lctx.numVertices[0] = 0;
-        lctx.numVertices[1] = 0;
+    void AssimpMeshLoader::onImported(const MeshDataPtr& data)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
 
-        loadNode(scene_->mRootNode, aiMatrix4x4(), lctx);
+        importing_ = false;
 
-        for (int i = 0; i < 2; ++i) {
-            if (vbo[i]) {
-                btAssert((lctx.allVerts[i] - vertsStart[i]) * 4 == vbo[i]->sizeInBytes(ctx));
-                vbo[i]->unlock(ctx);
-            }
+        if (!data) {
+            return;
         }
 
-        for (const auto& kv : lctx.slices) {
-            auto ebo = kv.second->vaSlice().va()->ebo();
-            btAssert(((char*)lctx.allIndices[kv.first] - (char*)indicesStart[kv.first]) == ebo->sizeInBytes(ctx));
-            ebo->unlock(ctx);
+        data_ = data;
+
+        if (!uploadRequested_) {
+            // 'load' is yet to run, it'll pick the data up.
+            return;
         }
 
-        scene_.reset();
+        auto self = shared_from_this();
+        renderer.scheduleHwOp([self](HardwareContext& ctx) {
+            std::unique_lock<std::mutex> lock(self->mtx_);
+            if (!self->data_) {
+                return;
+            }
+            auto data = self->data_;
+            self->data_.reset();
+            self->uploadRequested_ = false;
+            lock.unlock();
+            self->upload(*data, ctx);
+        });
     }
 
     AssimpNodePtr AssimpMeshLoader::createNode(const aiNode* aiN, const aiMatrix4x4& parentXf, InitContext& ctx)
@@ -278,17 +388,18 @@ namespace af3d
         return node;
     }
 
-    void AssimpMeshLoader::loadNode(const aiNode* aiN, const aiMatrix4x4& parentXf, LoadContext& ctx)
+    void AssimpMeshLoader::loadNode(const aiScene* scene, const aiNode* aiN, const aiMatrix4x4& parentXf, LoadContext& ctx) const
     {
         auto xf = ignoreTransforms_ ? parentXf : parentXf * aiN->mTransformation;
 
         for (std::uint32_t i = 0; i < aiN->mNumChildren; ++i) {
-            loadNode(aiN->mChildren[i], xf, ctx);
+            loadNode(scene, aiN->mChildren[i], xf, ctx);
         }
 
         for (std::uint32_t i = 0; i < aiN->mNumMeshes; ++i) {
-            auto meshData = scene_->mMeshes[aiN->mMeshes[i]];
-            bool withTangent = ctx.slices[meshData->mMaterialIndex]->material()->type()->hasNM();
+            auto meshData = scene->mMeshes[aiN->mMeshes[i]];
+            const auto& slice = slices_.at(meshData->mMaterialIndex);
+            bool withTangent = slice.withTangent;
 
             float*& verts = ctx.allVerts[withTangent ? 0 : 1];
 
@@ -328,7 +439,7 @@ namespace af3d
                 }
             }
 
-            auto cva = ctx.slices[meshData->mMaterialIndex]->vaSlice().va();
+            const auto& cva = slice.va;
             std::uint32_t idxOffset = ctx.numVertices[withTangent ? 0 : 1];
 
             if (cva->ebo()->dataType() == HardwareIndexBuffer::UInt16) {
@@ -366,10 +477,10 @@ namespace af3d
         }
     }
 
-    AssimpScenePtr AssimpMeshLoader::loadScene(Assimp::Importer& importer)
+    AssimpScenePtr AssimpMeshLoader::loadScene(Assimp::Importer& importer) const
     {
         std::uint32_t flags = 0;
-        if (assetManager.getAssetModel(path_)->flipUV()) {
+        if (flipUV_) {
             flags |= aiProcess_FlipUVs;
         }
         return assimpImport(importer, path_, flags | aiProcess_CalcTangentSpace |
@@ -30,6 +30,7 @@
 #include "SubMesh.h"
 #include "Utils.h"
 #include "af3d/AABB.h"
+#include <mutex>
 
 namespace af3d
 {
@@ -44,11 +45,17 @@ namespace af3d
         std::vector<AssimpNodePtr> children;
     };
 
-    class AssimpMeshLoader : public ResourceLoader
+    class AssimpMeshLoader : public ResourceLoader,
+        public std::enable_shared_from_this<AssimpMeshLoader>
     {
     public:
         explicit AssimpMeshLoader(const std::string& path);
 
+        /*
+         * Parses the model on calling thread and converts it to GL-ready vertex/index data,
+         * 'load' then only copies that data into GL buffers. When the data is gone
+         * (e.g. on reload) the model is re-imported on mesh manager's import threads.
+         */
         AssimpNodePtr init(Assimp::Importer& importer);
 
         void load(Resource& res, HardwareContext& ctx) override;
@@ -60,19 +67,42 @@ namespace af3d
             std::map<std::uint32_t, VertexArraySlice> slices;
         };
 
+        struct SliceInfo
+        {
+            VertexArrayPtr va;
+            bool withTangent = false;
+            std::uint32_t numIndices = 0;
+        };
+
+        // Vertex/index data ready to be copied into GL buffers.
+        struct MeshData
+        {
+            std::vector<float> verts[2];
+            std::map<std::uint32_t, std::vector<Byte>> indices;
+        };
+
+        using MeshDataPtr = std::shared_ptr<MeshData>;
+
         struct LoadContext
         {
-            std::map<std::uint32_t, SubMeshPtr> slices;
             std::uint32_t numVertices[2];
             float *allVerts[2];
-            std::map<std::uint32_t, GLvoid*> allIndices;
+            std::map<std::uint32_t, Byte*> allIndices;
         };
 
         AssimpNodePtr createNode(const aiNode* aiN, const aiMatrix4x4& parentXf, InitContext& ctx);
 
-        void loadNode(const aiNode* aiN, const aiMatrix4x4& parentXf, LoadContext& ctx);
+        MeshDataPtr buildData(const aiScene* scene) const;
 
-        AssimpScenePtr loadScene(Assimp::Importer& importer);
+        void loadNode(const aiScene* scene, const aiNode* aiN, const aiMatrix4x4& parentXf, LoadContext& ctx) const;
+
+        void setupCPUData(const MeshData& data);
+
+        void upload(const MeshData& data, HardwareContext& ctx);
+
+        void onImported(const MeshDataPtr& data);
+
+        AssimpScenePtr loadScene(Assimp::Importer& importer) const;
 
         MaterialPtr createMaterialBasic(const std::string& matName, aiMaterial* matData);
 
@@ -83,6 +113,16 @@ namespace af3d
         std::string path_;
         AssimpScenePtr scene_;
         bool ignoreTransforms_;
+        bool flipUV_;
+
+        std::map<std::uint32_t, SliceInfo> slices_;
+        std::uint32_t numVertices_[2] = {0, 0};
+        HardwareDataBufferPtr vbos_[2];
+
+        std::mutex mtx_;
+        MeshDataPtr data_; // Converted data waiting to be uploaded.
+        bool importing_ = false;
+        bool uploadRequested_ = false;
     };
 }
 
@@ -82,6 +82,21 @@ namespace af3d
         renderers_[0]->setViewport(value);
     }
 
+    bool Camera::dynamicResolution() const
+    {
+        return renderers_[0]->dynamicResolution();
+    }
+
+    void Camera::setDynamicResolution(bool value)
+    {
+        renderers_[0]->setDynamicResolution(value);
+    }
+
+    float Camera::renderScale() const
+    {
+        return renderers_[0]->renderScale();
+    }
+
     const AttachmentPoints& Camera::clearMask() const
     {
         return renderers_[0]->clearMask();
@@ -98,12 +98,25 @@ namespace af3d
         inline bool canSeeShadows() const { return canSeeShadows_; }
         inline void setCanSeeShadows(bool value) { canSeeShadows_ = value; }
 
+        // Hi-Z occlusion culling of GPU driven geometry, needs a depth prepass and RenderPassHiZ.
+        inline bool occlusionCull() const { return occlusionCull_; }
+        inline void setOcclusionCull(bool value) { occlusionCull_ = value; }
+
+        // Left out of the frame entirely, render targets keep their contents.
+        inline bool skipFrame() const { return skipFrame_; }
+        inline void setSkipFrame(bool value) { skipFrame_ = value; }
+
         int order() const;
         void setOrder(int value);
 
         const AABB2i& viewport() const;
         void setViewport(const AABB2i& value);
 
+        bool dynamicResolution() const;
+        void setDynamicResolution(bool value);
+
+        float renderScale() const;
+
         const AttachmentPoints& clearMask() const;
         void setClearMask(const AttachmentPoints& value);
 
@@ -127,6 +140,8 @@ namespace af3d
         Frustum frustum_;
         Color ambientColor_ = Color(0.2f, 0.2f, 0.2f, 1.0f);
         bool canSeeShadows_ = true;
+        bool occlusionCull_ = false;
+        bool skipFrame_ = false;
         boost::optional<Matrix4f> prevViewProjMat_;
 
         CameraRenderers renderers_;
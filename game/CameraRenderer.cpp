@@ -26,6 +26,7 @@
 #include "CameraRenderer.h"
 #include "LightProbeComponent.h"
 #include "Settings.h"
+#include "Renderer.h"
 
 namespace af3d
 {
@@ -51,6 +52,27 @@ namespace af3d
         viewport_ = value;
     }
 
+    float CameraRenderer::renderScale() const
+    {
+        return dynamicResolution_ ? renderer.renderScale() : 1.0f;
+    }
+
+    AABB2i CameraRenderer::renderViewport() const
+    {
+        const auto& vp = viewport();
+        if (!dynamicResolution_) {
+            return vp;
+        }
+
+        // Same rounding as in shaders that derive the sub-rectangle from 'renderScale'.
+        float scale = renderer.renderScale();
+        Vector2i sz = vp.getSize();
+        sz = Vector2i(std::max(static_cast<int>(sz.x() * scale + 0.5f), 1),
+            std::max(static_cast<int>(sz.y() * scale + 0.5f), 1));
+
+        return AABB2i(vp.lowerBound, vp.lowerBound + sz);
+    }
+
     void CameraRenderer::addRenderPass(const RenderPassPtr& pass, bool run)
     {
         passes_.emplace_back(pass, run);
@@ -76,6 +98,11 @@ namespace af3d
         const Matrix4f& stableProjMat = camera->frustum().projMat();
         const Matrix4f& stableViewMat = camera->frustum().viewMat();
 
+        static const SamplerId clampLinearSampler =
+            SamplerParams(GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR).intern();
+        static const SamplerId clampMipSampler =
+            SamplerParams(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR).intern();
+
         const auto& activeUniforms = material->type()->prog()->activeUniforms();
         const auto& samplers = material->type()->prog()->samplers();
 
@@ -83,22 +110,18 @@ namespace af3d
             SamplerName sName = static_cast<SamplerName>(i);
             if (samplers[sName]) {
                 const auto& tb = material->textureBinding(sName);
-                textures.emplace_back(tb.tex ? tb.tex->hwTex() : HardwareTexturePtr(), tb.params);
+                textures.emplace_back(tb.tex ? tb.tex->hwTex() : HardwareTexturePtr(), tb.samplerId);
                 if ((sName == SamplerName::Irradiance) && !textures.back().tex) {
-                    textures.back() = HardwareTextureBinding(env->irradianceTexture()->hwTex(),
-                        SamplerParams(GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR));
+                    textures.back() = HardwareTextureBinding(env->irradianceTexture()->hwTex(), clampLinearSampler);
                 } else if ((sName == SamplerName::SpecularCM) && !textures.back().tex) {
-                    textures.back() = HardwareTextureBinding(env->specularTexture()->hwTex(),
-                        SamplerParams(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR));
+                    textures.back() = HardwareTextureBinding(env->specularTexture()->hwTex(), clampMipSampler);
                 } else if ((sName == SamplerName::SpecularLUT) && !textures.back().tex) {
                     auto probe = env->globalLightProbe();
                     if (probe) {
-                        textures.back() = HardwareTextureBinding(probe->specularLUTTexture()->hwTex(),
-                            SamplerParams(GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR));
+                        textures.back() = HardwareTextureBinding(probe->specularLUTTexture()->hwTex(), clampLinearSampler);
                     }
                 } else if ((sName == SamplerName::ShadowCSM) && !textures.back().tex) {
-                    textures.back() = HardwareTextureBinding(env->shadowMgr().csmTexture()->hwTex(),
-                        SamplerParams(GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR));
+                    textures.back() = HardwareTextureBinding(env->shadowMgr().csmTexture()->hwTex(), clampLinearSampler);
                 }
             }
         }
@@ -158,7 +181,10 @@ namespace af3d
             params.setUniform(UniformName::EyePos, camera->frustum().transform().getOrigin());
         }
         if (activeUniforms.count(UniformName::ViewportSize) > 0) {
-            params.setUniform(UniformName::ViewportSize, Vector2f::fromVector2i(viewport().getSize()));
+            params.setUniform(UniformName::ViewportSize, Vector2f::fromVector2i(renderViewport().getSize()));
+        }
+        if (activeUniforms.count(UniformName::RenderScale) > 0) {
+            params.setUniform(UniformName::RenderScale, renderScale());
         }
         if (activeUniforms.count(UniformName::Time) > 0) {
             params.setUniform(UniformName::Time, env->time() + material->timeOffset());
@@ -189,6 +215,10 @@ namespace af3d
             storageBuffers.emplace_back(StorageBufferName::ClusterLights, env->lightsSSBO());
         }
 
+        if (ssboNames[StorageBufferName::ClusterEnabledLights]) {
+            storageBuffers.emplace_back(StorageBufferName::ClusterEnabledLights, env->enabledLightsSSBO());
+        }
+
         if (ssboNames[StorageBufferName::ClusterProbes]) {
             storageBuffers.emplace_back(StorageBufferName::ClusterProbes, env->probesSSBO());
         }
@@ -197,6 +227,10 @@ namespace af3d
             storageBuffers.emplace_back(StorageBufferName::ShadowCSM, env->shadowMgr().csmSSBO());
         }
 
+        if (ssboNames[StorageBufferName::IndirectInstances]) {
+            storageBuffers.emplace_back(StorageBufferName::IndirectInstances, env->indirectDrawMgr().instancesSSBO());
+        }
+
         for (const auto& pass : passes_) {
             pass.first->fillParams(material, storageBuffers, params);
         }
@@ -205,7 +239,7 @@ namespace af3d
     RenderNodePtr CameraRenderer::compile(const RenderList& rl) const
     {
         auto mrt = getHardwareMRT();
-        auto rn = std::make_shared<RenderNode>(viewport(), clearMask(), clearColors(), mrt);
+        auto rn = std::make_shared<RenderNode>(renderViewport(), clearMask(), clearColors(), mrt);
         int passIdx = 0;
         for (const auto& pass : passes_) {
             if (pass.second) {
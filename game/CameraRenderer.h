@@ -45,6 +45,17 @@ namespace af3d
         const AABB2i& viewport() const;
         void setViewport(const AABB2i& value);
 
+        /*
+         * Dynamic resolution, render into 'renderScale' sub-rectangle of the viewport,
+         * the rest of the targets is left untouched. 'viewport' stays unscaled.
+         */
+        inline bool dynamicResolution() const { return dynamicResolution_; }
+        inline void setDynamicResolution(bool value) { dynamicResolution_ = value; }
+
+        float renderScale() const;
+
+        AABB2i renderViewport() const;
+
         inline const AttachmentPoints& clearMask() const { return clearMask_; }
         inline void setClearMask(const AttachmentPoints& value) { clearMask_ = value; }
 
@@ -72,6 +83,7 @@ namespace af3d
 
         int order_ = 0;
         mutable AABB2i viewport_ = AABB2i(Vector2i(0, 0), Vector2i(0, 0));
+        bool dynamicResolution_ = false;
         AttachmentPoints clearMask_ = AttachmentPoints(AttachmentPoint::Color0) | AttachmentPoint::Depth;
         AttachmentColors clearColors_;
 
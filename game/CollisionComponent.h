@@ -44,8 +44,12 @@ namespace af3d
             onSetManager(manager_, value);
         }
 
+        // 'isNew' is true the first time a contact is reported, later calls are per-step
+        // updates and only happen if 'wantsContactUpdates' returns true.
         virtual void updateContact(const Contact& contact, bool isNew) = 0;
 
+        virtual bool wantsContactUpdates() const { return false; }
+
         virtual void endContact(const Contact& contact) = 0;
 
         virtual void update(float dt) {}
@@ -26,9 +26,18 @@
 #include "CollisionComponentManager.h"
 #include "CollisionComponent.h"
 #include "SceneObject.h"
+#include <algorithm>
 
 namespace af3d
 {
+    namespace
+    {
+        bool isMultiShape(const btCollisionShape* shape)
+        {
+            return shape->isCompound() && (static_cast<const btCompoundShape*>(shape)->getNumChildShapes() > 1);
+        }
+    }
+
     SceneObject* Contact::getOther(SceneObject* obj) const
     {
         SceneObject* objA = SceneObject::fromShape(shapeA->shape());
@@ -46,11 +55,10 @@ namespace af3d
         return (obj == SceneObject::fromShape(shapeA->shape())) ? shapeA : shapeB;
     }
 
-    CollisionComponentManager::Manifold::Manifold(btPersistentManifold* manifold)
-    : manifold(manifold),
-      objA(SceneObject::fromBody(const_cast<btRigidBody*>(btRigidBody::upcast(manifold->getBody0())))->shared_from_this()),
-      objB(SceneObject::fromBody(const_cast<btRigidBody*>(btRigidBody::upcast(manifold->getBody1())))->shared_from_this())
+    CollisionComponentManager::CollisionComponentManager()
     {
+        gContactStartedCallback = &CollisionComponentManager::onContactChanged;
+        gContactEndedCallback = &CollisionComponentManager::onContactChanged;
     }
 
     CollisionComponentManager::~CollisionComponentManager()
@@ -65,7 +73,13 @@ namespace af3d
         btAssert(frozenComponents_.empty());
 
         manifolds_.clear();
+        freeManifolds_.clear();
+        watchedManifolds_.clear();
+        changedManifolds_.clear();
+        addedComponents_.clear();
+        addedBodies_.clear();
         events_.clear();
+        flushEvents_.clear();
     }
 
     void CollisionComponentManager::addComponent(const ComponentPtr& component)
@@ -76,6 +90,8 @@ namespace af3d
 
         components_.insert(cComponent);
         cComponent->setManager(this);
+
+        addedComponents_.push_back(cComponent);
     }
 
     void CollisionComponentManager::removeComponent(const ComponentPtr& component)
@@ -134,103 +150,253 @@ namespace af3d
         }
     }
 
-    void CollisionComponentManager::step(btCollisionWorld* world)
+    void CollisionComponentManager::adoptManifold(btPersistentManifold* manifold)
     {
-        btDispatcher* dispatcher = world->getDispatcher();
-        int numManifolds = dispatcher->getNumManifolds();
-
-        btAssert(numManifolds >= static_cast<int>(manifolds_.size()));
-
-        for (int i = 0; i < numManifolds; ++i) {
-            btPersistentManifold* cm = dispatcher->getManifoldByIndexInternal(i);
+        manifold->m_userPointer = this;
+        manifold->m_userIndex = -1;
+    }
 
-            auto it = manifolds_.find(cm);
-            if (it == manifolds_.end()) {
-                if (cm->getNumContacts() <= 0) {
-                    continue;
-                }
-                it = manifolds_.emplace(cm, Manifold(cm)).first;
-            }
+    void CollisionComponentManager::step(btCollisionWorld* world)
+    {
+        // Before changed manifolds, so contacts that are new to everybody are reported once.
+        if (!addedComponents_.empty()) {
+            rescanManifolds(world->getDispatcher());
+        }
 
-            addEvents(it->second);
+        for (auto manifold : changedManifolds_) {
+            updateManifold(manifold);
+        }
+        changedManifolds_.clear();
 
-            if (cm->getNumContacts() <= 0) {
-                endContact(cm);
+        for (size_t i = 0; i < watchedManifolds_.size();) {
+            auto manifold = manifolds_[watchedManifolds_[i]].manifold;
+            updateManifold(manifold);
+            if ((i < watchedManifolds_.size()) && (manifolds_[watchedManifolds_[i]].manifold == manifold)) {
+                ++i;
             }
         }
     }
 
     void CollisionComponentManager::flushPending()
     {
-        static ContactEvents events;
-
         while (!events_.empty()) {
-            events.swap(events_);
+            flushEvents_.swap(events_);
 
-            for (const auto& event : events) {
+            for (const auto& event : flushEvents_) {
+                auto cA = event.cA.lock();
+                auto cB = event.cB.lock();
                 if (event.contact.pointCount <= 0) {
-                    if (event.cA && event.cA->manager()) {
-                        event.cA->endContact(event.contact);
+                    if (cA && cA->manager()) {
+                        cA->endContact(event.contact);
                     }
-                    if (event.cB && event.cB->manager()) {
-                        event.cB->endContact(event.contact);
+                    if (cB && cB->manager()) {
+                        cB->endContact(event.contact);
                     }
                 } else {
-                    if (event.cA && event.cA->manager()) {
-                        event.cA->updateContact(event.contact, event.isNew);
+                    if (cA && cA->manager()) {
+                        cA->updateContact(event.contact, event.isNew);
                     }
-                    if (event.cB && event.cB->manager()) {
-                        event.cB->updateContact(event.contact, event.isNew);
+                    if (cB && cB->manager()) {
+                        cB->updateContact(event.contact, event.isNew);
                     }
                 }
             }
 
-            events.clear();
+            flushEvents_.clear();
         }
     }
 
     void CollisionComponentManager::endContact(btPersistentManifold* manifold)
     {
-        auto it = manifolds_.find(manifold);
-        if (it == manifolds_.end()) {
+        changedManifolds_.erase(std::remove(changedManifolds_.begin(), changedManifolds_.end(), manifold),
+            changedManifolds_.end());
+
+        // Manifold is being released, ignore whatever Bullet reports about it from now on.
+        manifold->m_userPointer = nullptr;
+
+        removeManifold(manifold);
+    }
+
+    void CollisionComponentManager::removeManifold(btPersistentManifold* manifold)
+    {
+        int idx = manifold->m_userIndex;
+        if (idx < 0) {
             return;
         }
 
-        btAssert(it->second.manifold->getBody0() == it->second.objA->body());
-        btAssert(it->second.manifold->getBody1() == it->second.objB->body());
-
-        if (!it->second.contacts.empty()) {
-            auto cA = it->second.objA->findComponent<CollisionComponent>();
-            auto cB = it->second.objB->findComponent<CollisionComponent>();
-
-            if (cA || cB) {
-                for (size_t i = 0; i < it->second.contacts.size(); ++i) {
-                    if (it->second.contacts[i].cookie) {
-                        // Contact removed.
-                        events_.emplace_back();
-                        auto& evt = events_.back();
-
-                        evt.contact.cookie = it->second.contacts[i].cookie;
-                        evt.contact.shapeA = it->second.contacts[i].shapeA;
-                        evt.contact.shapeB = it->second.contacts[i].shapeB;
-                        evt.objA = it->second.objA;
-                        evt.objB = it->second.objB;
-                        evt.cA = cA;
-                        evt.cB = cB;
-                    }
-                }
+        auto& m = manifolds_[idx];
+
+        btAssert(m.manifold == manifold);
+        btAssert(m.manifold->getBody0() == m.objA->body());
+        btAssert(m.manifold->getBody1() == m.objB->body());
+
+        auto cA = m.objA->findComponent<CollisionComponent>();
+        auto cB = m.objB->findComponent<CollisionComponent>();
+
+        for (const auto& ci : m.contacts) {
+            if (ci.cookie) {
+                // Contact removed.
+                addEvent(ci, cA, cB, false);
             }
         }
 
-        manifolds_.erase(it);
+        freeManifold(idx);
     }
 
-    void CollisionComponentManager::addEvents(Manifold& m)
+    void CollisionComponentManager::onContactChanged(btPersistentManifold* const& manifold)
     {
-        auto cA = m.objA->findComponent<CollisionComponent>();
-        auto cB = m.objB->findComponent<CollisionComponent>();
-        bool needEvent = cA || cB;
+        auto mgr = static_cast<CollisionComponentManager*>(manifold->m_userPointer);
+        if (mgr) {
+            mgr->changedManifolds_.push_back(manifold);
+        }
+    }
+
+    void CollisionComponentManager::updateManifold(btPersistentManifold* manifold)
+    {
+        int idx = manifold->m_userIndex;
+
+        if (manifold->getNumContacts() <= 0) {
+            if (idx >= 0) {
+                removeManifold(manifold);
+            }
+            return;
+        }
+
+        if (idx < 0) {
+            auto objA = SceneObject::fromBody(const_cast<btRigidBody*>(btRigidBody::upcast(manifold->getBody0())));
+            auto objB = SceneObject::fromBody(const_cast<btRigidBody*>(btRigidBody::upcast(manifold->getBody1())));
+
+            auto cA = objA->findComponent<CollisionComponent>();
+            auto cB = objB->findComponent<CollisionComponent>();
+
+            if (!cA && !cB) {
+                // Nobody's listening.
+                return;
+            }
+
+            idx = allocManifold(manifold);
+
+            auto& m = manifolds_[idx];
+            m.objA = objA;
+            m.objB = objB;
+            m.watch = isMultiShape(manifold->getBody0()->getCollisionShape()) ||
+                isMultiShape(manifold->getBody1()->getCollisionShape());
+            if (m.watch) {
+                watchedManifolds_.push_back(idx);
+            }
+            setUpdates(idx, (cA && cA->wantsContactUpdates()) || (cB && cB->wantsContactUpdates()));
+        }
+
+        addEvents(manifolds_[idx]);
+    }
+
+    void CollisionComponentManager::rescanManifolds(btDispatcher* dispatcher)
+    {
+        for (const auto& wc : addedComponents_) {
+            auto c = wc.lock();
+            // Only the first collision component of an object gets contact events.
+            if (c && (c->manager() == this) && c->parent()->body() &&
+                (c->parent()->findComponent<CollisionComponent>() == c)) {
+                addedBodies_.insert(c->parent()->body());
+            }
+        }
+        addedComponents_.clear();
+
+        if (addedBodies_.empty()) {
+            return;
+        }
+
+        for (int i = 0; i < dispatcher->getNumManifolds(); ++i) {
+            auto manifold = dispatcher->getManifoldByIndexInternal(i);
+            if ((manifold->m_userPointer != this) || (manifold->getNumContacts() <= 0)) {
+                continue;
+            }
+
+            bool newToA = (addedBodies_.count(manifold->getBody0()) > 0);
+            bool newToB = (addedBodies_.count(manifold->getBody1()) > 0);
+            if (!newToA && !newToB) {
+                continue;
+            }
+
+            int idx = manifold->m_userIndex;
+            if (idx < 0) {
+                // Wasn't tracked, so nobody heard of these contacts yet.
+                updateManifold(manifold);
+                continue;
+            }
+
+            auto& m = manifolds_[idx];
+
+            auto cA = m.objA->findComponent<CollisionComponent>();
+            auto cB = m.objB->findComponent<CollisionComponent>();
+            if ((cA && cA->wantsContactUpdates()) || (cB && cB->wantsContactUpdates())) {
+                setUpdates(idx, true);
+            }
+
+            addEvents(m, newToA, newToB);
+        }
+
+        addedBodies_.clear();
+    }
+
+    void CollisionComponentManager::setUpdates(int idx, bool value)
+    {
+        auto& m = manifolds_[idx];
+
+        m.updates = value;
+        if (m.updates && !m.watch) {
+            m.watch = true;
+            watchedManifolds_.push_back(idx);
+        }
+    }
+
+    int CollisionComponentManager::allocManifold(btPersistentManifold* manifold)
+    {
+        int idx;
+        if (freeManifolds_.empty()) {
+            idx = manifolds_.size();
+            manifolds_.emplace_back();
+        } else {
+            idx = freeManifolds_.back();
+            freeManifolds_.pop_back();
+        }
+
+        manifolds_[idx].manifold = manifold;
+        manifold->m_userIndex = idx;
+
+        return idx;
+    }
+
+    void CollisionComponentManager::freeManifold(int idx)
+    {
+        auto& m = manifolds_[idx];
+
+        if (m.watch) {
+            auto it = std::find(watchedManifolds_.begin(), watchedManifolds_.end(), idx);
+            btAssert(it != watchedManifolds_.end());
+            *it = watchedManifolds_.back();
+            watchedManifolds_.pop_back();
+        }
+
+        m.manifold->m_userIndex = -1;
+
+        for (auto& ci : m.contacts) {
+            ci.cookie = 0;
+            ci.shapeA.reset();
+            ci.shapeB.reset();
+            ci.numPoints = 0;
+        }
+        m.manifold = nullptr;
+        m.objA = nullptr;
+        m.objB = nullptr;
+        m.watch = false;
+        m.updates = false;
+
+        freeManifolds_.push_back(idx);
+    }
 
+    void CollisionComponentManager::addEvents(Manifold& m, bool newToA, bool newToB)
+    {
         auto bodyA = m.manifold->getBody0();
         auto bodyB = m.manifold->getBody1();
 
@@ -238,7 +404,7 @@ namespace af3d
         btAssert(bodyB == m.objB->body());
 
         int numNewContacts = 0;
-        static std::array<ContactInfo, MANIFOLD_CACHE_SIZE> newContacts;
+        std::array<ContactInfo, MANIFOLD_CACHE_SIZE> newContacts;
 
         for (int i = 0; i < m.manifold->getNumContacts(); ++i) {
             auto& pt = m.manifold->getContactPoint(i);
@@ -269,7 +435,6 @@ namespace af3d
                 }
 
                 if (!found) {
-                    newContacts[numNewContacts].cookie = nextCookie_++;
                     newContacts[numNewContacts].shapeA = std::static_pointer_cast<CollisionShape>(CollisionShape::fromShape(shapeA)->sharedThis());
                     newContacts[numNewContacts].shapeB = std::static_pointer_cast<CollisionShape>(CollisionShape::fromShape(shapeB)->sharedThis());
                     newContacts[numNewContacts].points[newContacts[numNewContacts].numPoints++] = &pt;
@@ -278,80 +443,76 @@ namespace af3d
             }
         }
 
-        for (size_t i = 0; i < m.contacts.size(); ++i) {
-            if (m.contacts[i].cookie && (m.contacts[i].numPoints <= 0)) {
-                if (needEvent) {
-                    // Contact removed.
-                    events_.emplace_back();
-                    auto& evt = events_.back();
-
-                    evt.contact.cookie = m.contacts[i].cookie;
-                    evt.contact.shapeA = m.contacts[i].shapeA;
-                    evt.contact.shapeB = m.contacts[i].shapeB;
-                    evt.objA = m.objA;
-                    evt.objB = m.objB;
-                    evt.cA = cA;
-                    evt.cB = cB;
-                }
+        bool haveRemoved = false;
+        for (const auto& ci : m.contacts) {
+            if (ci.cookie && (ci.numPoints <= 0)) {
+                haveRemoved = true;
+                break;
+            }
+        }
+
+        if (!haveRemoved && (numNewContacts == 0) && !m.updates && !newToA && !newToB) {
+            // Same contacts as before, nothing to report.
+            for (auto& ci : m.contacts) {
+                ci.numPoints = 0;
+            }
+            return;
+        }
 
-                m.contacts[i].cookie = 0;
-                m.contacts[i].shapeA.reset();
-                m.contacts[i].shapeB.reset();
-            } else if (m.contacts[i].numPoints > 0) {
-                btAssert(m.contacts[i].cookie);
-                if (needEvent) {
+        auto cA = m.objA->findComponent<CollisionComponent>();
+        auto cB = m.objB->findComponent<CollisionComponent>();
+
+        for (auto& ci : m.contacts) {
+            if (ci.cookie && (ci.numPoints <= 0)) {
+                // Contact removed.
+                addEvent(ci, cA, cB, false);
+
+                ci.cookie = 0;
+                ci.shapeA.reset();
+                ci.shapeB.reset();
+            } else if (ci.cookie) {
+                if (newToA || newToB) {
+                    // Contact existed before the component was added.
+                    addEvent(ci, newToA ? cA : CollisionComponentPtr(), newToB ? cB : CollisionComponentPtr(), true);
+                }
+                if (m.updates) {
                     // Contact updated.
-                    events_.emplace_back();
-                    auto& evt = events_.back();
-
-                    evt.contact.cookie = m.contacts[i].cookie;
-                    evt.contact.shapeA = m.contacts[i].shapeA;
-                    evt.contact.shapeB = m.contacts[i].shapeB;
-                    evt.contact.pointCount = m.contacts[i].numPoints;
-                    for (int j = 0; j < evt.contact.pointCount; ++j) {
-                        evt.contact.points[j] = *m.contacts[i].points[j];
-                    }
-                    evt.objA = m.objA;
-                    evt.objB = m.objB;
-                    evt.cA = cA;
-                    evt.cB = cB;
+                    addEvent(ci, newToA ? CollisionComponentPtr() : cA, newToB ? CollisionComponentPtr() : cB, false);
                 }
-                m.contacts[i].numPoints = 0;
             }
+            ci.numPoints = 0;
         }
 
         for (int i = 0; i < numNewContacts; ++i) {
-            bool found = false;
-            for (size_t j = 0; j < m.contacts.size(); ++j) {
-                if (!m.contacts[j].cookie) {
-                    m.contacts[j] = newContacts[i];
-                    if (needEvent) {
-                        // New contact.
-                        events_.emplace_back();
-                        auto& evt = events_.back();
-
-                        evt.contact.cookie = m.contacts[j].cookie;
-                        evt.contact.shapeA = m.contacts[j].shapeA;
-                        evt.contact.shapeB = m.contacts[j].shapeB;
-                        evt.contact.pointCount = m.contacts[j].numPoints;
-                        for (int k = 0; k < evt.contact.pointCount; ++k) {
-                            evt.contact.points[k] = *m.contacts[j].points[k];
-                        }
-                        evt.isNew = true;
-                        evt.objA = m.objA;
-                        evt.objB = m.objB;
-                        evt.cA = cA;
-                        evt.cB = cB;
-                    }
-                    m.contacts[j].numPoints = 0;
-                    found = true;
-                    break;
-                }
-            }
-            btAssert(found);
-            newContacts[i].shapeA.reset();
-            newContacts[i].shapeB.reset();
-            newContacts[i].numPoints = 0;
+            auto it = std::find_if(m.contacts.begin(), m.contacts.end(),
+                [](const ContactInfo& ci) { return ci.cookie == 0; });
+            btAssert(it != m.contacts.end());
+            *it = newContacts[i];
+            it->cookie = nextCookie_++;
+            // New contact.
+            addEvent(*it, cA, cB, true);
+            it->numPoints = 0;
+        }
+    }
+
+    void CollisionComponentManager::addEvent(const ContactInfo& ci, const CollisionComponentPtr& cA, const CollisionComponentPtr& cB, bool isNew)
+    {
+        if (!cA && !cB) {
+            return;
+        }
+
+        events_.emplace_back();
+        auto& evt = events_.back();
+
+        evt.isNew = isNew;
+        evt.contact.cookie = ci.cookie;
+        evt.contact.shapeA = ci.shapeA;
+        evt.contact.shapeB = ci.shapeB;
+        evt.contact.pointCount = ci.numPoints;
+        for (int i = 0; i < ci.numPoints; ++i) {
+            evt.contact.points[i] = *ci.points[i];
         }
+        evt.cA = cA;
+        evt.cB = cB;
     }
 }
@@ -61,7 +61,7 @@ namespace af3d
     class CollisionComponentManager : public ComponentManager
     {
     public:
-        CollisionComponentManager() = default;
+        CollisionComponentManager();
         ~CollisionComponentManager();
 
         void cleanup() override;
@@ -78,6 +78,14 @@ namespace af3d
 
         void debugDraw(RenderList& rl) override;
 
+        // Called by dispatcher for every manifold it creates, that's how
+        // Bullet's contact callbacks find their way back to us.
+        void adoptManifold(btPersistentManifold* manifold);
+
+        // Only process manifolds that changed since last step, that is, the ones that
+        // gained or lost all their points, the ones involving multi-child compounds and
+        // the ones whose components want per-step updates. Manifolds of newly added
+        // components are rescanned once, so resting contacts get reported too.
         void step(btCollisionWorld* world);
 
         void flushPending();
@@ -92,15 +100,10 @@ namespace af3d
             Contact contact;
             bool isNew = false;
 
-            // Keep objects alive for the time
-            // of processing.
-            SceneObjectPtr objA;
-            SceneObjectPtr objB;
-
-            // Keep components alive for the
-            // time of processing.
-            CollisionComponentPtr cA;
-            CollisionComponentPtr cB;
+            // Components may go away while earlier events
+            // are being processed.
+            std::weak_ptr<CollisionComponent> cA;
+            std::weak_ptr<CollisionComponent> cB;
         };
 
         using ContactEvents = std::vector<ContactEvent>;
@@ -118,29 +121,61 @@ namespace af3d
 
         struct Manifold
         {
-            Manifold() = default;
-            explicit Manifold(btPersistentManifold* manifold);
-
             btPersistentManifold* manifold = nullptr;
 
-            SceneObjectPtr objA;
-            SceneObjectPtr objB;
+            // Objects outlive the manifold, it's released
+            // when any of the bodies leaves the world.
+            SceneObject* objA = nullptr;
+            SceneObject* objB = nullptr;
+
+            // Manifolds with multi-child compound shapes can change contacts
+            // without going through zero points, these are checked every step.
+            // Same for manifolds whose components want per-step updates.
+            bool watch = false;
+            bool updates = false;
 
             // Each of those MANIFOLD_CACHE_SIZE points can be for
             // different shape, thus, max MANIFOLD_CACHE_SIZE contacts per manifold.
             std::array<ContactInfo, MANIFOLD_CACHE_SIZE> contacts;
         };
 
-        using Manifolds = std::unordered_map<btPersistentManifold*, Manifold>;
+        static void onContactChanged(btPersistentManifold* const& manifold);
+
+        void updateManifold(btPersistentManifold* manifold);
+
+        void removeManifold(btPersistentManifold* manifold);
+
+        int allocManifold(btPersistentManifold* manifold);
 
-        void addEvents(Manifold& m);
+        void freeManifold(int idx);
+
+        void rescanManifolds(btDispatcher* dispatcher);
+
+        void setUpdates(int idx, bool value);
+
+        // 'newToA'/'newToB' - report all current contacts as new to that side, its component was just added.
+        void addEvents(Manifold& m, bool newToA = false, bool newToB = false);
+
+        void addEvent(const ContactInfo& ci, const CollisionComponentPtr& cA, const CollisionComponentPtr& cB, bool isNew);
 
         std::unordered_set<CollisionComponentPtr> components_;
         std::unordered_set<CollisionComponentPtr> frozenComponents_;
 
-        // Only manifolds with at least some points are in this map.
-        Manifolds manifolds_;
+        // Only manifolds with some points and at least one collision component
+        // are tracked, btPersistentManifold::m_userIndex points here.
+        std::vector<Manifold> manifolds_;
+        std::vector<int> freeManifolds_;
+        std::vector<int> watchedManifolds_;
+
+        // Manifolds reported by Bullet since last step, may contain duplicates.
+        std::vector<btPersistentManifold*> changedManifolds_;
+
+        // Components added since last step, their live manifolds are yet to be reported.
+        std::vector<std::weak_ptr<CollisionComponent>> addedComponents_;
+        std::unordered_set<const btCollisionObject*> addedBodies_;
+
         ContactEvents events_;
+        ContactEvents flushEvents_;
 
         std::uint64_t nextCookie_ = 1;
     };
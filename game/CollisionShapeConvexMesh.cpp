@@ -26,7 +26,6 @@
 #include "CollisionShapeConvexMesh.h"
 #include "MeshManager.h"
 #include "Logger.h"
-#include "PhysicsDebugDraw.h"
 #include "bullet/BulletCollision/CollisionShapes/btConvexPolyhedron.h"
 
 namespace af3d
@@ -164,6 +163,6 @@ namespace af3d
 
     void CollisionShapeConvexMesh::render(PhysicsDebugDraw& dd, const btVector3& c)
     {
-        dd.drawMesh(&shape_, worldTransform(), c);
+        dd.drawMeshCached(&shape_, wireframe_, worldTransform(), c);
     }
 }
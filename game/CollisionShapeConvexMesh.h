@@ -27,6 +27,7 @@
 #define _COLLISIONSHAPECONVEXMESH_H_
 
 #include "CollisionShape.h"
+#include "PhysicsDebugDraw.h"
 
 namespace af3d
 {
@@ -50,6 +51,7 @@ namespace af3d
 
     private:
         btConvexHullShape shape_;
+        PhysicsDebugWireframe wireframe_;
     };
 
     using CollisionShapeConvexMeshPtr = std::shared_ptr<CollisionShapeConvexMesh>;
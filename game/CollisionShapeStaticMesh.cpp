@@ -26,7 +26,6 @@
 #include "CollisionShapeStaticMesh.h"
 #include "MeshManager.h"
 #include "Logger.h"
-#include "PhysicsDebugDraw.h"
 
 namespace af3d
 {
@@ -109,7 +108,7 @@ namespace af3d
 
     void CollisionShapeStaticMesh::render(PhysicsDebugDraw& dd, const btVector3& c)
     {
-        dd.drawMesh(&shape_, worldTransform(), c);
+        dd.drawMeshCached(&shape_, wireframe_, worldTransform(), c);
     }
 
     btTriangleMesh* CollisionShapeStaticMesh::initMesh(const std::vector<APropertyValue>& vertices,
@@ -27,6 +27,7 @@
 #define _COLLISIONSHAPESTATICMESH_H_
 
 #include "CollisionShape.h"
+#include "PhysicsDebugDraw.h"
 
 namespace af3d
 {
@@ -54,6 +55,7 @@ namespace af3d
 
         btTriangleMesh mesh_;
         btBvhTriangleMeshShape shape_;
+        PhysicsDebugWireframe wireframe_;
     };
 
     using CollisionShapeStaticMeshPtr = std::shared_ptr<CollisionShapeStaticMesh>;
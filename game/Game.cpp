@@ -203,6 +203,9 @@ namespace af3d
         std::uint64_t timeUs = getTimeUs();
         std::uint32_t deltaUs;
 
+        // Platform has just delivered input events, they get to the screen with this frame.
+        renderer.setInputTimeUs(timeUs);
+
         if (lastTimeUs_ == 0) {
             lastProfileReportTimeUs_ = timeUs;
             deltaUs = 16000; // pretend that very first frame lasted 16ms
@@ -26,28 +26,109 @@
 #include "GameLogAppender.h"
 #include <log4cplus/streams.h>
 #include <log4cplus/spi/loggingevent.h>
+#include <log4cplus/helpers/property.h>
+#include <chrono>
+#include <cstring>
+#include <sstream>
 #ifdef _WIN32
 #include <windows.h>
 #include <shlobj.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #else
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <errno.h>
 #endif
 
 
 namespace log4cplus
 {
+    /*
+     * Collects one formatted record, keeps its capacity between records.
+     */
+    class GameLogAppender::RecordBuffer : public std::basic_streambuf<tchar>
+    {
+    public:
+        RecordBuffer()
+        {
+            buf_.reserve(1024);
+        }
+
+        inline void clear() { buf_.clear(); }
+
+        inline const tchar* data() const { return buf_.data(); }
+        inline std::size_t size() const { return buf_.size(); }
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                buf_.push_back(traits_type::to_char_type(c));
+            }
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const tchar* s, std::streamsize n) override
+        {
+            buf_.insert(buf_.end(), s, s + n);
+            return n;
+        }
+
+    private:
+        std::vector<tchar> buf_;
+    };
+
+    static const std::size_t defaultRingSize = 1024 * 1024;
+
+    static const int crashSignals[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+    static const int numCrashSignals = sizeof(crashSignals) / sizeof(crashSignals[0]);
+
+#ifdef _WIN32
+    static void (*prevCrashHandlers[numCrashSignals])(int);
+#else
+    static struct sigaction prevCrashActions[numCrashSignals];
+#endif
+
+    // Plain write(2), so it's usable from signal handlers. Gives up on the first error.
+    static void writeAll(int fd, const tchar* data, std::size_t size)
+    {
+        auto ptr = reinterpret_cast<const char*>(data);
+        auto left = size * sizeof(tchar);
+
+        while (left > 0) {
+#ifdef _WIN32
+            int res = ::_write(fd, ptr, static_cast<unsigned int>(left));
+#else
+            ssize_t res = ::write(fd, ptr, left);
+            if ((res < 0) && (errno == EINTR)) {
+                continue;
+            }
+#endif
+            if (res <= 0) {
+                return;
+            }
+            ptr += res;
+            left -= res;
+        }
+    }
+
+    std::atomic<GameLogAppender*> GameLogAppender::crashInstance_{nullptr};
+
     GameLogAppender::GameLogAppender()
-    : buffer_(nullptr)
     {
-        init("log.txt");
+        init("log.txt", defaultRingSize);
     }
 
     GameLogAppender::GameLogAppender(const helpers::Properties& props)
-    : Appender(props),
-      buffer_(nullptr)
+    : Appender(props)
     {
-        init("log.txt");
+        unsigned ringSize = defaultRingSize;
+        props.getUInt(ringSize, LOG4CPLUS_TEXT("BufferSize"));
+        props.getBool(blocking_, LOG4CPLUS_TEXT("Blocking"));
+        init("log.txt", ringSize);
     }
 
     GameLogAppender::GameLogAppender(const GameLogAppender& other)
@@ -67,28 +148,210 @@ namespace log4cplus
     void GameLogAppender::close()
     {
         closed = true;
-        os_.close();
-        delete [] buffer_;
-        buffer_ = nullptr;
+
+        GameLogAppender* self = this;
+        crashInstance_.compare_exchange_strong(self, nullptr);
+
+        if (writerThread_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(writerMtx_);
+                writerStop_ = true;
+            }
+            writerCond_.notify_one();
+            // Writer drains the ring before exiting.
+            writerThread_.join();
+        }
+
+        if (fd_ >= 0) {
+            if (dropped_ > 0) {
+                // Drops that didn't get reported inline, don't lose the count on shutdown.
+                auto str = droppedNote();
+                writeAll(fd_, str.data(), str.size());
+                dropped_ = 0;
+            }
+#ifdef _WIN32
+            ::_close(fd_);
+#else
+            ::close(fd_);
+#endif
+            fd_ = -1;
+        }
     }
 
     void GameLogAppender::append(const spi::InternalLoggingEvent& event)
     {
-        if (!os_.good()) {
+        if (!writerThread_.joinable()) {
             return;
         }
 
-        layout->formatAndAppend(os_, event);
+        record_->clear();
+        layout->formatAndAppend(*recordStream_, event);
+
+        if (dropped_ > 0) {
+            auto str = droppedNote();
+            if ((str.size() + record_->size()) <= (ring_.size() - (head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_acquire)))) {
+                dropped_ = 0;
+                push(str.data(), str.size());
+            }
+        }
+
+        push(record_->data(), record_->size());
+    }
+
+    tstring GameLogAppender::droppedNote() const
+    {
+        tostringstream note;
+        note << LOG4CPLUS_TEXT("... ") << dropped_ << LOG4CPLUS_TEXT(" log records dropped") << std::endl;
+        return note.str();
     }
 
-    void GameLogAppender::init(const std::string& fileName)
+    void GameLogAppender::push(const tchar* data, std::size_t size)
     {
-        int bufferSize = 512;
+        size = std::min(size, ring_.size());
+
+        auto head = head_.load(std::memory_order_relaxed);
 
-        delete [] buffer_;
-        buffer_ = new tchar[bufferSize];
-        os_.rdbuf()->pubsetbuf(buffer_, bufferSize);
+        while ((ring_.size() - (head - tail_.load(std::memory_order_acquire))) < size) {
+            if (!blocking_) {
+                ++dropped_;
+                return;
+            }
+            wakeWriter();
+            std::this_thread::yield();
+        }
 
+        std::size_t idx = head & ringMask_;
+        std::size_t n = std::min(size, ring_.size() - idx);
+
+        std::memcpy(&ring_[idx], data, n * sizeof(tchar));
+        if (n < size) {
+            std::memcpy(&ring_[0], data + n, (size - n) * sizeof(tchar));
+        }
+
+        head_.store(head + size);
+
+        wakeWriter();
+    }
+
+    void GameLogAppender::wakeWriter()
+    {
+        if (writerSleeping_) {
+            std::lock_guard<std::mutex> lock(writerMtx_);
+            writerCond_.notify_one();
+        }
+    }
+
+    void GameLogAppender::writerThread()
+    {
+        while (true) {
+            auto tail = tail_.load(std::memory_order_relaxed);
+            auto head = head_.load(std::memory_order_acquire);
+
+            if (tail != head) {
+                // Write everything that's accumulated in one go, at most two chunks because of wrap.
+                std::size_t idx = tail & ringMask_;
+                std::size_t size = head - tail;
+                std::size_t n = std::min(size, ring_.size() - idx);
+
+                writeAll(fd_, &ring_[idx], n);
+                if (n < size) {
+                    writeAll(fd_, &ring_[0], size - n);
+                }
+
+                tail_.store(head, std::memory_order_release);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(writerMtx_);
+
+            if (writerStop_) {
+                if (head_ == head) {
+                    break;
+                }
+                continue;
+            }
+
+            writerSleeping_ = true;
+            if (head_ == head) {
+                writerCond_.wait_for(lock, std::chrono::milliseconds(100));
+            }
+            writerSleeping_ = false;
+        }
+    }
+
+    void GameLogAppender::crashFlush()
+    {
+        // Writer might be the one that crashed or the crash may be in the middle of 'push', so no
+        // waiting, locking or notifying here, just write out what's published. If the writer is
+        // alive and busy with the same range some records may end up in the file twice.
+        auto tail = tail_.load(std::memory_order_acquire);
+        auto head = head_.load(std::memory_order_acquire);
+
+        std::size_t size = std::min<std::uint64_t>(head - tail, ring_.size());
+        std::size_t idx = (head - size) & ringMask_;
+        std::size_t n = std::min(size, ring_.size() - idx);
+
+        writeAll(fd_, &ring_[idx], n);
+        if (n < size) {
+            writeAll(fd_, &ring_[0], size - n);
+        }
+    }
+
+#ifdef _WIN32
+    void GameLogAppender::crashHandler(int sig)
+    {
+        auto instance = crashInstance_.exchange(nullptr);
+        if (instance) {
+            instance->crashFlush();
+        }
+        for (int i = 0; i < numCrashSignals; ++i) {
+            if (crashSignals[i] != sig) {
+                continue;
+            }
+            auto prev = prevCrashHandlers[i];
+            if ((prev != SIG_DFL) && (prev != SIG_IGN) && (prev != SIG_ERR)) {
+                prev(sig);
+                return;
+            }
+        }
+        std::signal(sig, SIG_DFL);
+        std::raise(sig);
+    }
+#else
+    void GameLogAppender::crashHandler(int sig, siginfo_t* info, void* context)
+    {
+        auto instance = crashInstance_.exchange(nullptr);
+        if (instance) {
+            instance->crashFlush();
+        }
+        for (int i = 0; i < numCrashSignals; ++i) {
+            if (crashSignals[i] != sig) {
+                continue;
+            }
+            const auto& prev = prevCrashActions[i];
+            if (prev.sa_flags & SA_SIGINFO) {
+                prev.sa_sigaction(sig, info, context);
+                return;
+            }
+            if ((prev.sa_handler != SIG_DFL) && (prev.sa_handler != SIG_IGN)) {
+                prev.sa_handler(sig);
+                return;
+            }
+            break;
+        }
+        // Nothing to chain to, fall back to default action. The signal is blocked while we're
+        // in here, so it's delivered right after returning.
+        struct sigaction dfl;
+        std::memset(&dfl, 0, sizeof(dfl));
+        dfl.sa_handler = SIG_DFL;
+        sigemptyset(&dfl.sa_mask);
+        ::sigaction(sig, &dfl, nullptr);
+        ::raise(sig);
+    }
+#endif
+
+    void GameLogAppender::init(const std::string& fileName, std::size_t ringSize)
+    {
 #ifdef _WIN32
         wchar_t buffer[MAX_PATH];
 
@@ -108,9 +371,9 @@ namespace log4cplus
 
         std::wstring fp = /*d + L"/" + */fileNameW;
 
-        os_.open(fp.c_str(), std::ios_base::out | std::ios_base::trunc);
+        fd_ = ::_wopen(fp.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_TEXT, _S_IREAD | _S_IWRITE);
 
-        if (!os_.good()) {
+        if (fd_ < 0) {
             getErrorHandler()->error(LOG4CPLUS_TEXT("Unable to write ") + fileName);
             return;
         }
@@ -131,16 +394,48 @@ namespace log4cplus
 
         std::string fp = /*d + "/" + */fileName;
 
-        mode_t oldMask = ::umask(~(S_IRUSR | S_IWUSR));
-
-        os_.open(fp.c_str(), std::ios_base::out | std::ios_base::trunc);
+        fd_ = ::open(fp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
 
-        ::umask(oldMask);
-
-        if (!os_.good()) {
+        if (fd_ < 0) {
             getErrorHandler()->error(LOG4CPLUS_TEXT("Unable to write ") + fp);
             return;
         }
 #endif
+
+        std::size_t sz = 1024;
+        while (sz < ringSize) {
+            sz <<= 1;
+        }
+
+        ring_.resize(sz);
+        ringMask_ = sz - 1;
+        head_ = 0;
+        tail_ = 0;
+
+        record_.reset(new RecordBuffer());
+        recordStream_.reset(new tostream(record_.get()));
+
+        writerSleeping_ = false;
+        writerStop_ = false;
+        writerThread_ = std::thread(&GameLogAppender::writerThread, this);
+
+        GameLogAppender* expected = nullptr;
+        static bool handlersInstalled = false;
+        if (crashInstance_.compare_exchange_strong(expected, this) && !handlersInstalled) {
+            // Installed once and kept, handler does nothing but chaining when there's no instance.
+            handlersInstalled = true;
+            for (int i = 0; i < numCrashSignals; ++i) {
+#ifdef _WIN32
+                prevCrashHandlers[i] = std::signal(crashSignals[i], &GameLogAppender::crashHandler);
+#else
+                struct sigaction sa;
+                std::memset(&sa, 0, sizeof(sa));
+                sa.sa_sigaction = &GameLogAppender::crashHandler;
+                sa.sa_flags = SA_SIGINFO;
+                sigemptyset(&sa.sa_mask);
+                ::sigaction(crashSignals[i], &sa, &prevCrashActions[i]);
+#endif
+            }
+        }
     }
 }
@@ -28,11 +28,24 @@
 
 #include "af3d/Types.h"
 #include <log4cplus/appender.h>
-#include <log4cplus/fstreams.h>
-#include <fstream>
+#include <atomic>
+#include <csignal>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace log4cplus
 {
+    /*
+     * Records are formatted on the logging thread into a bounded ring buffer,
+     * a background writer thread batches them to the file. Formatting still runs under
+     * log4cplus appender lock, that's what keeps the ring single producer. Properties:
+     * 'BufferSize' - ring size in bytes, rounded up to power of two,
+     * 'Blocking' - when the ring is full wait for the writer instead of dropping records,
+     * with it off drop count is logged with the next record that fits or on close.
+     */
     class GameLogAppender : public Appender
     {
     public:
@@ -49,10 +62,50 @@ namespace log4cplus
         GameLogAppender(const GameLogAppender& other);
         GameLogAppender& operator=(const GameLogAppender& other);
 
-        void init(const std::string& fileName);
+        class RecordBuffer;
 
-        log4cplus::tchar* buffer_;
-        log4cplus::tofstream os_;
+        void init(const std::string& fileName, std::size_t ringSize);
+
+        void push(const tchar* data, std::size_t size);
+
+        tstring droppedNote() const;
+
+        void wakeWriter();
+
+        void writerThread();
+
+        // Called on fatal signals, writes out whatever is in the ring, async-signal-safe.
+        void crashFlush();
+
+#ifdef _WIN32
+        static void crashHandler(int sig);
+#else
+        static void crashHandler(int sig, siginfo_t* info, void* context);
+#endif
+
+        static std::atomic<GameLogAppender*> crashInstance_;
+
+        int fd_ = -1;
+
+        bool blocking_ = true;
+
+        std::unique_ptr<RecordBuffer> record_;
+        std::unique_ptr<tostream> recordStream_;
+        std::uint64_t dropped_ = 0;
+
+        // Single producer, since log4cplus serializes 'append' calls, single consumer - writer thread.
+        // Positions grow monotonically, ring index is 'pos & ringMask_'. Everything before 'tail_'
+        // is already in the file.
+        std::vector<tchar> ring_;
+        std::uint64_t ringMask_ = 0;
+        std::atomic<std::uint64_t> head_;
+        std::atomic<std::uint64_t> tail_;
+
+        std::mutex writerMtx_;
+        std::condition_variable writerCond_;
+        std::atomic<bool> writerSleeping_;
+        std::atomic<bool> writerStop_;
+        std::thread writerThread_;
     };
 }
 
@@ -24,6 +24,7 @@
  */
 
 #include "HardwareBuffer.h"
+#include "HardwareContext.h"
 
 namespace af3d
 {
@@ -39,7 +40,7 @@ namespace af3d
         GLuint id = id_;
         if (id != 0) {
             cleanup([id](HardwareContext& ctx) {
-                ogl.DeleteBuffers(1, &id);
+                ctx.deleteBuffer(id);
             });
         } else {
             cleanup();
@@ -69,6 +70,8 @@ namespace af3d
             return GL_STREAM_DRAW;
         case Usage::StaticCopy:
             return GL_STATIC_COPY;
+        case Usage::DynamicRead:
+            return GL_DYNAMIC_READ;
         default:
             btAssert(false);
         case Usage::StaticDraw:
@@ -38,7 +38,8 @@ namespace af3d
             StaticDraw = 0,
             DynamicDraw,
             StreamDraw,
-            StaticCopy
+            StaticCopy,
+            DynamicRead
         };
 
         enum Access
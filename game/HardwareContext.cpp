@@ -26,23 +26,77 @@
 #include "HardwareContext.h"
 #include "Settings.h"
 #include "HardwareResourceManager.h"
-#include "AssimpIOSystem.h"
 #include "Logger.h"
+#include <algorithm>
+#include <mutex>
 
 namespace af3d
 {
+    namespace
+    {
+        struct SamplerParamsRegistry
+        {
+            SamplerParamsRegistry()
+            {
+                ids.emplace(SamplerParams(), 0);
+                params.push_back(SamplerParams());
+            }
+
+            std::mutex m;
+            std::map<SamplerParams, SamplerId> ids;
+            std::vector<SamplerParams> params;
+        };
+
+        SamplerParamsRegistry& samplerParamsRegistry()
+        {
+            static SamplerParamsRegistry registry;
+            return registry;
+        }
+    }
+
+    SamplerId SamplerParams::intern() const
+    {
+        auto& reg = samplerParamsRegistry();
+        std::lock_guard<std::mutex> lock(reg.m);
+        auto it = reg.ids.find(*this);
+        if (it == reg.ids.end()) {
+            runtime_assert(reg.params.size() <= std::numeric_limits<SamplerId>::max());
+            it = reg.ids.emplace(*this, reg.params.size()).first;
+            reg.params.push_back(*this);
+        }
+        return it->second;
+    }
+
+    SamplerParams SamplerParams::fromId(SamplerId id)
+    {
+        auto& reg = samplerParamsRegistry();
+        std::lock_guard<std::mutex> lock(reg.m);
+        btAssert(id < reg.params.size());
+        return reg.params[id];
+    }
+
+    std::uint32_t SamplerParams::numInterned()
+    {
+        auto& reg = samplerParamsRegistry();
+        std::lock_guard<std::mutex> lock(reg.m);
+        return reg.params.size();
+    }
+
     HardwareContext::HardwareContext()
     {
         GLint numExtensions = 0;
         ogl.GetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
         bool texCompressionS3TCfound = false;
         bool texSRGBfound = false;
+        bool bindlessTextureFound = false;
         for (int i = 0; i < numExtensions; ++i) {
             const char* str = (const char*)ogl.GetStringi(GL_EXTENSIONS, i);
             if (str && (std::strstr(str, "GL_EXT_texture_compression_s3tc") == str)) {
                 texCompressionS3TCfound = true;
             } else if (str && (std::strstr(str, "GL_EXT_texture_sRGB") == str)) {
                 texSRGBfound = true;
+            } else if (str && (std::strstr(str, "GL_ARB_bindless_texture") == str)) {
+                bindlessTextureFound = true;
             }
         }
 
@@ -52,13 +106,17 @@ namespace af3d
         if (!texSRGBfound) {
             LOG4CPLUS_WARN(logger(), "GL_EXT_texture_sRGB is not supported");
         }
+        if (settings.bindlessTextures && (!bindlessTextureFound || !ogl.GetTextureSamplerHandleARB ||
+            !ogl.MakeTextureHandleResidentARB || !ogl.MakeTextureHandleNonResidentARB || !ogl.UniformHandleui64ARB)) {
+            LOG4CPLUS_WARN(logger(), "GL_ARB_bindless_texture is not supported, using texture units");
+            // Runs before shaders are compiled, so it's safe to switch here.
+            settings.bindlessTextures = false;
+        }
 
         LOG4CPLUS_INFO(logger(), "OpenGL vendor: " << ogl.GetString(GL_VENDOR));
         LOG4CPLUS_INFO(logger(), "OpenGL renderer: " << ogl.GetString(GL_RENDERER));
         LOG4CPLUS_INFO(logger(), "OpenGL version: " << ogl.GetString(GL_VERSION));
 
-        importer_.SetIOHandler(new AssimpIOSystem());
-
         ogl.PixelStorei(GL_UNPACK_ALIGNMENT, 1);
         ogl.PixelStorei(GL_PACK_ALIGNMENT, 1);
         ogl.Enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
@@ -71,19 +129,24 @@ namespace af3d
 
         LOG4CPLUS_INFO(logger(), "sample_buffers = " << sampleBuffers << ", samples = " << samples);
         LOG4CPLUS_INFO(logger(), "texture filter: " << (settings.trilinearFilter ? "trilinear" : "bilinear"));
+
+        // Queried just once, all framebuffer switches go through 'setMRT' from now on.
+        ogl.GetIntegerv(GL_FRAMEBUFFER_BINDING, (GLint*)&defaultFbId_);
+        currentFbId_ = defaultFbId_;
+        currentDrawBuffers_ = &defaultDrawBuffers_;
     }
 
     void HardwareContext::setActiveTextureUnit(int unit)
     {
         btAssert(unit < static_cast<int>(texUnits_.size()));
-        activeTexUnit_ = unit;
-        ogl.ActiveTexture(GL_TEXTURE0 + unit);
+        if (stateChange(activeTexUnit_, unit)) {
+            ogl.ActiveTexture(GL_TEXTURE0 + unit);
+        }
     }
 
     void HardwareContext::bindTexture(TextureType texType, GLuint texId)
     {
-        if (texId != texUnits_[activeTexUnit_].texIds[texType]) {
-            texUnits_[activeTexUnit_].texIds[texType] = texId;
+        if (stateChange(texUnits_[activeTexUnit_].texIds[texType], texId)) {
             ogl.BindTexture(HardwareTexture::glType(texType), texId);
         }
     }
@@ -97,99 +160,334 @@ namespace af3d
                 }
             }
         }
+        for (auto it = textureHandles_.lower_bound(std::make_pair(texId, 0U));
+            (it != textureHandles_.end()) && (it->first.first == texId);) {
+            ogl.MakeTextureHandleNonResidentARB(it->second);
+            it = textureHandles_.erase(it);
+        }
+        // Cached framebuffers with this texture are stale, GL may hand the same name out again.
+        for (auto it = framebuffers_.begin(); it != framebuffers_.end();) {
+            bool uses = false;
+            for (size_t i = 0; i < it->first.attachments.size(); ++i) {
+                uses |= (it->first.attachments[i].id == texId) &&
+                    static_cast<bool>(it->second.fb->attachment(static_cast<AttachmentPoint>(i), *this).texType());
+            }
+            if (!uses) {
+                ++it;
+                continue;
+            }
+            if (&it->second.drawBuffers == currentDrawBuffers_) {
+                bindFramebuffer(defaultFbId_, &defaultDrawBuffers_);
+            }
+            it = framebuffers_.erase(it);
+        }
         ogl.DeleteTextures(1, &texId);
     }
 
-    void HardwareContext::bindSampler(int unit, const SamplerParams& params)
+    void HardwareContext::bindSampler(int unit, SamplerId samplerId)
     {
-        auto it = samplers_.find(params);
-        if (it == samplers_.end()) {
-            auto sampler = hwManager.createSampler();
-            sampler->setParameterInt(GL_TEXTURE_MAG_FILTER, params.texMagFilter, *this);
-            if (params.texMinFilter) {
-                sampler->setParameterInt(GL_TEXTURE_MIN_FILTER, *params.texMinFilter, *this);
-            } else if (settings.trilinearFilter) {
-                sampler->setParameterInt(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR, *this);
-            } else {
-                sampler->setParameterInt(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST, *this);
-            }
-            sampler->setParameterInt(GL_TEXTURE_WRAP_S, params.texWrapU, *this);
-            sampler->setParameterInt(GL_TEXTURE_WRAP_T, params.texWrapV, *this);
-            sampler->setParameterInt(GL_TEXTURE_WRAP_R, params.texWrapW, *this);
-            it = samplers_.emplace(params, sampler).first;
+        ++stats_.samplerBinds;
+        auto id = samplerGLId(samplerId);
+        if (stateChange(texUnits_[unit].samplerId, id)) {
+            ogl.BindSampler(unit, id);
         }
-        auto samplerId = it->second->id(*this);
-        if (samplerId != texUnits_[activeTexUnit_].samplerId) {
-            texUnits_[activeTexUnit_].samplerId = samplerId;
-            ogl.BindSampler(activeTexUnit_, samplerId);
+    }
+
+    GLuint64 HardwareContext::textureHandle(const HardwareTexturePtr& tex, SamplerId samplerId)
+    {
+        auto key = std::make_pair(tex->id(*this), samplerGLId(samplerId));
+        btAssert(key.first != 0);
+        auto it = textureHandles_.find(key);
+        if (it == textureHandles_.end()) {
+            GLuint64 handle = ogl.GetTextureSamplerHandleARB(key.first, key.second);
+            ogl.MakeTextureHandleResidentARB(handle);
+            tex->setHasHandle();
+            ++stats_.textureHandles;
+            it = textureHandles_.emplace(key, handle).first;
         }
+        return it->second;
     }
 
-    bool HardwareContext::setMRT(const HardwareMRT& mrt)
+    void HardwareContext::useProgram(GLuint progId)
     {
-        GLuint oldFbId = 0;
-        ogl.GetIntegerv(GL_FRAMEBUFFER_BINDING, (GLint*)&oldFbId);
+        if (stateChange(currentProgId_, progId)) {
+            ogl.UseProgram(progId);
+        }
+    }
 
-        Vector2u sz = mrt.getSize();
+    void HardwareContext::deleteProgram(GLuint progId)
+    {
+        if (currentProgId_ == progId) {
+            currentProgId_ = 0;
+            ogl.UseProgram(0);
+        }
+        ogl.DeleteProgram(progId);
+    }
+
+    void HardwareContext::bindVertexArray(GLuint vaoId)
+    {
+        if (stateChange(currentVaoId_, vaoId)) {
+            ogl.BindVertexArray(vaoId);
+        }
+    }
 
-        HardwareFramebufferPtr fb;
+    void HardwareContext::deleteVertexArray(GLuint vaoId)
+    {
+        if (currentVaoId_ == vaoId) {
+            // Deleting a bound VAO reverts the binding to 0.
+            currentVaoId_ = 0;
+        }
+        ogl.DeleteVertexArrays(1, &vaoId);
+    }
+
+    void HardwareContext::bindStorageBuffer(GLuint index, GLuint bufferId)
+    {
+        btAssert(index < storageBufferIds_.size());
+        if (stateChange(storageBufferIds_[index], bufferId)) {
+            ogl.BindBufferBase(GL_SHADER_STORAGE_BUFFER, index, bufferId);
+        }
+    }
 
-        auto fbIter = framebuffers_.find(sz);
-        if (fbIter != framebuffers_.end()) {
-            for (int i = static_cast<int>(AttachmentPoint::Color0); i <= static_cast<int>(AttachmentPoint::Max); ++i) {
-                AttachmentPoint p = static_cast<AttachmentPoint>(i);
-                fbIter->second.fb->attach(p, mrt.attachment(p), *this);
+    void HardwareContext::deleteBuffer(GLuint bufferId)
+    {
+        for (auto& id : storageBufferIds_) {
+            if (id == bufferId) {
+                id = 0;
             }
-            const auto& dt = mrt.attachment(AttachmentPoint::Depth);
-            if (!dt  && !fbIter->second.targetDepth) {
-                auto rb = hwManager.createRenderbuffer(sz.x(), sz.y());
-                rb->allocate(GL_DEPTH_COMPONENT24, *this);
-                fbIter->second.targetDepth = HardwareRenderTarget(rb);
+        }
+        ogl.DeleteBuffers(1, &bufferId);
+    }
+
+    void HardwareContext::setDepthTest(bool value)
+    {
+        if (stateChange(raster_.depthTest, static_cast<int>(value))) {
+            if (value) {
+                ogl.Enable(GL_DEPTH_TEST);
+            } else {
+                ogl.Disable(GL_DEPTH_TEST);
             }
-            fbIter->second.fb->attach(AttachmentPoint::Depth, (dt ? dt : fbIter->second.targetDepth), *this);
         }
+    }
+
+    void HardwareContext::setDepthFunc(GLenum value)
+    {
+        if (stateChange(raster_.depthFunc, value)) {
+            ogl.DepthFunc(value);
+        }
+    }
+
+    void HardwareContext::setDepthMask(bool value)
+    {
+        if (stateChange(raster_.depthMask, static_cast<int>(value))) {
+            ogl.DepthMask(value ? GL_TRUE : GL_FALSE);
+        }
+    }
 
-        if ((fbIter == framebuffers_.end()) && !sz.isZero()) {
-            LOG4CPLUS_DEBUG(logger(), "hwContext: new framebuffer for " << sz);
-            FramebufferState fbs;
-            fbs.fb = hwManager.createFramebuffer();
-            for (int i = static_cast<int>(AttachmentPoint::Color0); i <= static_cast<int>(AttachmentPoint::Max); ++i) {
-                AttachmentPoint p = static_cast<AttachmentPoint>(i);
-                fbs.fb->attach(p, mrt.attachment(p), *this);
+    void HardwareContext::setBlend(bool value)
+    {
+        if (stateChange(raster_.blend, static_cast<int>(value))) {
+            if (value) {
+                ogl.Enable(GL_BLEND);
+            } else {
+                ogl.Disable(GL_BLEND);
             }
-            const auto& dt = mrt.attachment(AttachmentPoint::Depth);
-            if (!dt) {
-                auto rb = hwManager.createRenderbuffer(sz.x(), sz.y());
-                rb->allocate(GL_DEPTH_COMPONENT24, *this);
-                fbs.targetDepth = HardwareRenderTarget(rb);
+        }
+    }
+
+    void HardwareContext::setBlendFunc(GLenum sfactor, GLenum dfactor, GLenum sfactorAlpha, GLenum dfactorAlpha)
+    {
+        std::array<GLenum, 4> value = {{sfactor, dfactor, sfactorAlpha, dfactorAlpha}};
+        if (stateChange(raster_.blendFunc, value)) {
+            ogl.BlendFuncSeparate(sfactor, dfactor, sfactorAlpha, dfactorAlpha);
+        }
+    }
+
+    void HardwareContext::setCullFace(GLenum mode)
+    {
+        if (stateChange(raster_.cullFace, static_cast<int>(mode != 0))) {
+            if (mode) {
+                ogl.Enable(GL_CULL_FACE);
+            } else {
+                ogl.Disable(GL_CULL_FACE);
             }
-            fbs.fb->attach(AttachmentPoint::Depth, (dt ? dt : fbs.targetDepth), *this);
-            if (!fbs.fb->checkStatus()) {
-                LOG4CPLUS_ERROR(logger(), "hwContext: framebuffer not complete, wtf ???");
+        }
+        if (mode && stateChange(raster_.cullFaceMode, mode)) {
+            ogl.CullFace(mode);
+        }
+    }
+
+    void HardwareContext::setScissorTest(bool value)
+    {
+        if (stateChange(raster_.scissorTest, static_cast<int>(value))) {
+            if (value) {
+                ogl.Enable(GL_SCISSOR_TEST);
+            } else {
+                ogl.Disable(GL_SCISSOR_TEST);
             }
-            fbIter = framebuffers_.emplace(sz, fbs).first;
         }
+    }
+
+    void HardwareContext::setScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        std::array<GLint, 4> value = {{x, y, width, height}};
+        if (stateChange(raster_.scissor, value)) {
+            ogl.Scissor(x, y, width, height);
+        }
+    }
+
+    void HardwareContext::setViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        std::array<GLint, 4> value = {{x, y, width, height}};
+        if (stateChange(raster_.viewport, value)) {
+            ogl.Viewport(x, y, width, height);
+        }
+    }
 
-        if (fbIter != framebuffers_.end()) {
-            if (currentFbId_ == 0) {
-                defaultFbId_ = oldFbId;
+    HardwareContext::FramebufferKey::FramebufferKey(const HardwareMRT& mrt, HardwareContext& ctx)
+    {
+        for (size_t i = 0; i < attachments.size(); ++i) {
+            const auto& target = mrt.attachment(static_cast<AttachmentPoint>(i));
+            if (target) {
+                attachments[i].res = target.res().get();
+                attachments[i].id = target.res()->id(ctx);
+                attachments[i].level = target.level();
+                attachments[i].cubeFace = target.cubeFace();
+                attachments[i].layer = target.layer();
             }
+        }
+    }
+
+    bool HardwareContext::setMRT(const HardwareMRT& mrt)
+    {
+        Vector2u sz = mrt.getSize();
+
+        if (sz.isZero()) {
+            bindFramebuffer(defaultFbId_, &defaultDrawBuffers_);
+            return false;
+        }
+
+        FramebufferKey key(mrt, *this);
+
+        auto fbIter = framebuffers_.find(key);
+        if (fbIter == framebuffers_.end()) {
+            LOG4CPLUS_DEBUG(logger(), "hwContext: new framebuffer for " << sz << ", total = " << (framebuffers_.size() + 1));
+            fbIter = framebuffers_.emplace(key, FramebufferState()).first;
+            fbIter->second.fb = hwManager.createFramebuffer();
+            attachAll(fbIter->second, mrt, sz);
+            ++stats_.fbCreates;
+        } else if (fbIter->second.fb->id(*this) == 0) {
+            // Framebuffer was invalidated, attachments are gone.
+            attachAll(fbIter->second, mrt, sz);
+            ++stats_.fbRevalidations;
+        }
+
+        fbIter->second.lastUsedFrame = frame_;
+
+        bindFramebuffer(fbIter->second.fb->id(*this), &fbIter->second.drawBuffers);
+
+        return true;
+    }
+
+    void HardwareContext::setDrawBuffers(GLsizei numBuffers, const GLenum* buffers)
+    {
+        auto& state = *currentDrawBuffers_;
 
-            GLuint fbId = fbIter->second.fb->id(*this);
-            if (fbId != currentFbId_) {
-                currentFbId_ = fbId;
-                ogl.BindFramebuffer(GL_FRAMEBUFFER, fbId);
+        if ((state.numBuffers == numBuffers) &&
+            std::equal(buffers, buffers + numBuffers, state.buffers.begin())) {
+            return;
+        }
+
+        btAssert(numBuffers <= static_cast<GLsizei>(state.buffers.size()));
+
+        state.numBuffers = numBuffers;
+        std::copy(buffers, buffers + numBuffers, state.buffers.begin());
+
+        ogl.DrawBuffers(numBuffers, buffers);
+        ++stats_.drawBufferChanges;
+    }
+
+    void HardwareContext::frameEnd()
+    {
+        static const std::uint32_t maxIdleFrames = 300;
+
+        ++frame_;
+        ++stats_.numFrames;
+
+        for (auto it = framebuffers_.begin(); it != framebuffers_.end();) {
+            if (((frame_ - it->second.lastUsedFrame) > maxIdleFrames) &&
+                (&it->second.drawBuffers != currentDrawBuffers_)) {
+                it = framebuffers_.erase(it);
             } else {
-                ogl.BindFramebuffer(GL_FRAMEBUFFER, oldFbId);
+                ++it;
             }
-        } else if (currentFbId_ != 0) {
-            currentFbId_ = 0;
-            ogl.BindFramebuffer(GL_FRAMEBUFFER, defaultFbId_);
-            defaultFbId_ = 0;
+        }
+    }
+
+    void HardwareContext::attachAll(FramebufferState& fbs, const HardwareMRT& mrt, const Vector2u& sz)
+    {
+        for (int i = static_cast<int>(AttachmentPoint::Color0); i <= static_cast<int>(AttachmentPoint::Max); ++i) {
+            AttachmentPoint p = static_cast<AttachmentPoint>(i);
+            fbs.fb->attach(p, mrt.attachment(p), *this);
+        }
+
+        const auto& dt = mrt.attachment(AttachmentPoint::Depth);
+        if (dt) {
+            fbs.fb->attach(AttachmentPoint::Depth, dt, *this);
         } else {
-            ogl.BindFramebuffer(GL_FRAMEBUFFER, oldFbId);
+            // Depth-less MRTs of the same size share a single renderbuffer.
+            auto& targetDepth = depthRenderbuffers_[sz];
+            if (!targetDepth) {
+                auto rb = hwManager.createRenderbuffer(sz.x(), sz.y());
+                rb->allocate(GL_DEPTH_COMPONENT24, *this);
+                targetDepth = HardwareRenderTarget(rb);
+            }
+            fbs.fb->attach(AttachmentPoint::Depth, targetDepth, *this);
+        }
+
+        if (!fbs.fb->checkStatus()) {
+            LOG4CPLUS_ERROR(logger(), "hwContext: framebuffer not complete, wtf ???");
         }
 
-        return !sz.isZero();
+        // 'attach' and 'checkStatus' leave the framebuffer bound, GL defaults apply to a fresh one.
+        currentFbId_ = fbs.fb->id(*this);
+        currentDrawBuffers_ = &fbs.drawBuffers;
+        fbs.drawBuffers = DrawBuffersState();
+        ++stats_.fbBinds;
+    }
+
+    void HardwareContext::bindFramebuffer(GLuint fbId, DrawBuffersState* drawBuffers)
+    {
+        if (fbId != currentFbId_) {
+            currentFbId_ = fbId;
+            ogl.BindFramebuffer(GL_FRAMEBUFFER, fbId);
+            ++stats_.fbBinds;
+        }
+        currentDrawBuffers_ = drawBuffers;
+    }
+
+    GLuint HardwareContext::samplerGLId(SamplerId samplerId)
+    {
+        if (samplerId >= samplers_.size()) {
+            samplers_.resize(samplerId + 1);
+        }
+        auto& sampler = samplers_[samplerId];
+        if (!sampler) {
+            // Only the first bind of each id ever gets here, registry lock is fine.
+            auto params = SamplerParams::fromId(samplerId);
+            sampler = hwManager.createSampler();
+            sampler->setParameterInt(GL_TEXTURE_MAG_FILTER, params.texMagFilter, *this);
+            if (params.texMinFilter) {
+                sampler->setParameterInt(GL_TEXTURE_MIN_FILTER, *params.texMinFilter, *this);
+            } else if (settings.trilinearFilter) {
+                sampler->setParameterInt(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR, *this);
+            } else {
+                sampler->setParameterInt(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST, *this);
+            }
+            sampler->setParameterInt(GL_TEXTURE_WRAP_S, params.texWrapU, *this);
+            sampler->setParameterInt(GL_TEXTURE_WRAP_T, params.texWrapV, *this);
+            sampler->setParameterInt(GL_TEXTURE_WRAP_R, params.texWrapW, *this);
+            ++stats_.samplerCreates;
+        }
+        return sampler->id(*this);
     }
 }
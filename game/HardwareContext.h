@@ -30,7 +30,6 @@
 #include "HardwareProgram.h"
 #include "HardwareFramebuffer.h"
 #include "HardwareMRT.h"
-#include "assimp/Importer.hpp"
 #include <boost/noncopyable.hpp>
 #include <boost/optional.hpp>
 #include <sstream>
@@ -38,6 +37,9 @@
 
 namespace af3d
 {
+    // Dense index of interned sampler params, 0 is always default 'SamplerParams()'.
+    using SamplerId = std::uint16_t;
+
     struct SamplerParams
     {
         SamplerParams() = default;
@@ -79,6 +81,17 @@ namespace af3d
             return texMagFilter < other.texMagFilter;
         }
 
+        /*
+         * Interned once at texture binding creation, so that render thread looks samplers up
+         * by index, there's just a handful of distinct params, ids are never released.
+         * Thread-safe.
+         */
+        SamplerId intern() const;
+
+        static SamplerParams fromId(SamplerId id);
+
+        static std::uint32_t numInterned();
+
         inline std::string toString() const
         {
             std::ostringstream os;
@@ -102,20 +115,20 @@ namespace af3d
     {
         HardwareTextureBinding() = default;
         HardwareTextureBinding(const HardwareTexturePtr& tex,
-            const SamplerParams& params)
+            SamplerId samplerId)
         : tex(tex),
-          params(params) {}
+          samplerId(samplerId) {}
 
         inline bool operator<(const HardwareTextureBinding& other) const
         {
             if (tex != other.tex) {
                 return tex < other.tex;
             }
-            return params < other.params;
+            return samplerId < other.samplerId;
         }
 
         HardwareTexturePtr tex;
-        SamplerParams params;
+        SamplerId samplerId = 0;
     };
 
     class HardwareContext : boost::noncopyable
@@ -124,18 +137,115 @@ namespace af3d
         HardwareContext();
         ~HardwareContext() = default;
 
-        inline Assimp::Importer& importer() { return importer_; }
-
         void setActiveTextureUnit(int unit);
 
         void bindTexture(TextureType texType, GLuint texId);
 
         void deleteTexture(GLuint texId);
 
-        void bindSampler(int unit, const SamplerParams& params);
+        void bindSampler(int unit, SamplerId samplerId);
+
+        /*
+         * Resident GL_ARB_bindless_texture handle for texture and sampler pair,
+         * created on first use and kept until the texture is deleted.
+         */
+        GLuint64 textureHandle(const HardwareTexturePtr& tex, SamplerId samplerId);
+
+        /*
+         * GL state shadow, all state changes go through these, calls that don't
+         * change anything are dropped. Deletes must go through here as well, since
+         * GL reuses object names.
+         */
+
+        void useProgram(GLuint progId);
+
+        void deleteProgram(GLuint progId);
+
+        void bindVertexArray(GLuint vaoId);
+
+        void deleteVertexArray(GLuint vaoId);
+
+        void bindStorageBuffer(GLuint index, GLuint bufferId);
+
+        void deleteBuffer(GLuint bufferId);
+
+        void setDepthTest(bool value);
+
+        void setDepthFunc(GLenum value);
+
+        void setDepthMask(bool value);
+
+        void setBlend(bool value);
+
+        void setBlendFunc(GLenum sfactor, GLenum dfactor, GLenum sfactorAlpha, GLenum dfactorAlpha);
+
+        // 0 - disabled.
+        void setCullFace(GLenum mode);
+
+        void setScissorTest(bool value);
+
+        void setScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+
+        void setViewport(GLint x, GLint y, GLsizei width, GLsizei height);
 
         bool setMRT(const HardwareMRT& mrt);
 
+        // Draw buffers of the currently bound framebuffer, skipped if unchanged.
+        void setDrawBuffers(GLsizei numBuffers, const GLenum* buffers);
+
+        /*
+         * Called once per rendered frame, ages out framebuffers whose
+         * attachment sets weren't used for a while.
+         */
+        void frameEnd();
+
+        struct Stats
+        {
+            std::uint32_t numFrames = 0;
+            std::uint32_t fbBinds = 0;
+            std::uint32_t fbCreates = 0;
+            std::uint32_t fbRevalidations = 0;
+            std::uint32_t drawBufferChanges = 0;
+            std::uint32_t stateCalls = 0; // State changes issued through the shadow.
+            std::uint32_t stateCallsFiltered = 0; // Redundant ones dropped by it.
+            std::uint32_t occlusionFrames = 0;
+            std::uint32_t occlusionVisible = 0;
+            std::uint32_t occlusionOccluded = 0;
+            std::uint32_t textureHandles = 0; // Bindless handles created.
+            std::uint32_t samplerBinds = 0; // Dense index lookups, filtered ones included.
+            std::uint32_t samplerCreates = 0;
+            std::uint32_t gpuTimeFrames = 0;
+            std::uint64_t gpuTimeUs = 0;
+            std::uint32_t latencyFrames = 0;
+            std::uint64_t latencyUs = 0; // Input to present.
+            std::uint64_t latencyMaxUs = 0;
+        };
+
+        inline const Stats& stats() const { return stats_; }
+
+        // GPU occlusion culling counts, read back a few frames late.
+        inline void addOcclusionStats(std::uint32_t visible, std::uint32_t occluded)
+        {
+            ++stats_.occlusionFrames;
+            stats_.occlusionVisible += visible;
+            stats_.occlusionOccluded += occluded;
+        }
+
+        // GPU frame time from timer queries, read back a few frames late.
+        inline void addGPUTimeStats(std::uint64_t timeUs)
+        {
+            ++stats_.gpuTimeFrames;
+            stats_.gpuTimeUs += timeUs;
+        }
+
+        inline void addLatencyStats(std::uint64_t timeUs)
+        {
+            ++stats_.latencyFrames;
+            stats_.latencyUs += timeUs;
+            stats_.latencyMaxUs = std::max(stats_.latencyMaxUs, timeUs);
+        }
+        inline void resetStats() { stats_ = Stats(); }
+
     private:
         struct TextureUnit
         {
@@ -143,23 +253,130 @@ namespace af3d
             GLuint samplerId = 0;
         };
 
+        struct DrawBuffersState
+        {
+            GLsizei numBuffers = -1; // -1 - unknown.
+            std::array<GLenum, static_cast<int>(AttachmentPoint::Max) + 1> buffers;
+        };
+
+        /*
+         * Full attachment tuple, raw resource pointers are fine here since
+         * cached framebuffer holds strong refs to its attachments. GL name is
+         * part of the key too, a resource that got a new name needs a new framebuffer.
+         */
+        struct FramebufferKey
+        {
+            struct Attachment
+            {
+                const HardwareResource* res = nullptr;
+                GLuint id = 0;
+                GLint level = 0;
+                int cubeFace = 0;
+                GLint layer = 0;
+
+                inline bool operator<(const Attachment& other) const
+                {
+                    if (res != other.res) {
+                        return res < other.res;
+                    }
+                    if (id != other.id) {
+                        return id < other.id;
+                    }
+                    if (level != other.level) {
+                        return level < other.level;
+                    }
+                    if (cubeFace != other.cubeFace) {
+                        return cubeFace < other.cubeFace;
+                    }
+                    return layer < other.layer;
+                }
+
+                inline bool operator!=(const Attachment& other) const
+                {
+                    return (other < *this) || (*this < other);
+                }
+            };
+
+            FramebufferKey(const HardwareMRT& mrt, HardwareContext& ctx);
+
+            inline bool operator<(const FramebufferKey& other) const
+            {
+                for (size_t i = 0; i < attachments.size(); ++i) {
+                    if (attachments[i] != other.attachments[i]) {
+                        return attachments[i] < other.attachments[i];
+                    }
+                }
+                return false;
+            }
+
+            std::array<Attachment, static_cast<int>(AttachmentPoint::Max) + 1> attachments;
+        };
+
         struct FramebufferState
         {
             HardwareFramebufferPtr fb;
-            HardwareRenderTarget targetDepth;
+            DrawBuffersState drawBuffers;
+            std::uint32_t lastUsedFrame = 0;
         };
 
-        using SamplerMap = std::map<SamplerParams, HardwareSamplerPtr>;
-        using FramebufferMap = BHUnorderedMap<Vector2u, FramebufferState>;
+        using Samplers = std::vector<HardwareSamplerPtr>; // Indexed by 'SamplerId'.
+        using TextureHandleMap = std::map<std::pair<GLuint, GLuint>, GLuint64>; // (texture, sampler) -> handle.
+        using FramebufferMap = std::map<FramebufferKey, FramebufferState>;
+        using DepthRenderbufferMap = BHUnorderedMap<Vector2u, HardwareRenderTarget>;
+
+        void attachAll(FramebufferState& fbs, const HardwareMRT& mrt, const Vector2u& sz);
 
-        Assimp::Importer importer_;
-        SamplerMap samplers_;
+        void bindFramebuffer(GLuint fbId, DrawBuffersState* drawBuffers);
+
+        GLuint samplerGLId(SamplerId samplerId);
+
+        // Returns true if 'state' changed and the call should be issued.
+        template <class T>
+        inline bool stateChange(T& state, const T& value)
+        {
+            if (state == value) {
+                ++stats_.stateCallsFiltered;
+                return false;
+            }
+            state = value;
+            ++stats_.stateCalls;
+            return true;
+        }
+
+        struct RasterState
+        {
+            // -1 - unknown, initial state is never assumed.
+            int depthTest = -1;
+            GLenum depthFunc = 0;
+            int depthMask = -1;
+            int blend = -1;
+            std::array<GLenum, 4> blendFunc = {};
+            int cullFace = -1;
+            GLenum cullFaceMode = 0;
+            int scissorTest = -1;
+            std::array<GLint, 4> scissor = {{-1, -1, -1, -1}};
+            std::array<GLint, 4> viewport = {{-1, -1, -1, -1}};
+        };
+
+        Samplers samplers_;
+        TextureHandleMap textureHandles_;
         FramebufferMap framebuffers_;
+        DepthRenderbufferMap depthRenderbuffers_;
         std::array<TextureUnit, static_cast<int>(SamplerName::Max) + 1> texUnits_;
         int activeTexUnit_ = 0;
 
+        GLuint currentProgId_ = 0;
+        GLuint currentVaoId_ = 0;
+        std::array<GLuint, static_cast<int>(StorageBufferName::Max) + 2> storageBufferIds_ = {};
+        RasterState raster_;
+
         GLuint defaultFbId_ = 0;
         GLuint currentFbId_ = 0;
+        DrawBuffersState defaultDrawBuffers_;
+        DrawBuffersState* currentDrawBuffers_ = nullptr;
+
+        std::uint32_t frame_ = 0;
+        Stats stats_;
     };
 }
 
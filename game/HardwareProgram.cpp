@@ -24,6 +24,7 @@
  */
 
 #include "HardwareProgram.h"
+#include "HardwareContext.h"
 #include "Logger.h"
 #include "af3d/Assert.h"
 
@@ -45,6 +46,7 @@ namespace af3d
         {"color", VertexAttribName::Color},
         {"tangent", VertexAttribName::Tangent},
         {"bitangent", VertexAttribName::Bitangent},
+        {"instanceIdx", VertexAttribName::InstanceIdx},
     };
 
     static const GLint staticVertexAttribLocations[static_cast<int>(VertexAttribName::Max) + 1] = {
@@ -53,7 +55,8 @@ namespace af3d
         2,
         3,
         4,
-        5
+        5,
+        6
     };
 
     static const std::unordered_map<std::string, StorageBufferName> staticStorageBufferMap = {
@@ -63,7 +66,14 @@ namespace af3d
         {"clusterLightsSSBO", StorageBufferName::ClusterLights},
         {"clusterProbeIndicesSSBO", StorageBufferName::ClusterProbeIndices},
         {"clusterProbesSSBO", StorageBufferName::ClusterProbes},
-        {"shadowCSMSSBO", StorageBufferName::ShadowCSM}
+        {"shadowCSMSSBO", StorageBufferName::ShadowCSM},
+        {"clusterEnabledLightsSSBO", StorageBufferName::ClusterEnabledLights},
+        {"clusterActiveSSBO", StorageBufferName::ClusterActive},
+        {"indirectInstancesSSBO", StorageBufferName::IndirectInstances},
+        {"indirectEntriesSSBO", StorageBufferName::IndirectEntries},
+        {"indirectCommandsSSBO", StorageBufferName::IndirectCommands},
+        {"indirectVisibleSSBO", StorageBufferName::IndirectVisible},
+        {"indirectStatsSSBO", StorageBufferName::IndirectStats}
     };
 
     static const GLuint staticStorageBufferIndices[static_cast<int>(StorageBufferName::Max) + 1] = {
@@ -73,7 +83,13 @@ namespace af3d
         4,
         5,
         6,
-        7
+        7,
+        8,
+        9,
+        10,
+        11,
+        12,
+        13
     };
 
     static const std::unordered_map<std::string, UniformName> staticUniformMap = {
@@ -87,6 +103,7 @@ namespace af3d
         {"eyePos", UniformName::EyePos},
         {"ambientColor", UniformName::AmbientColor},
         {"viewportSize", UniformName::ViewportSize},
+        {"renderScale", UniformName::RenderScale},
         {"time", UniformName::Time},
         {"dt", UniformName::Dt},
         {"realDt", UniformName::RealDt},
@@ -115,11 +132,15 @@ namespace af3d
         {"argPrevViewProj", UniformName::ArgPrevViewProjMatrix},
         {"argViewProj", UniformName::ArgViewProjMatrix},
         {"argNearFar", UniformName::ArgNearFar},
+        {"argRenderScale", UniformName::ArgRenderScale},
+        {"prevRenderScale", UniformName::PrevRenderScale},
         {"sampleWeights[0]", UniformName::SampleWeights},
         {"lowpassWeights[0]", UniformName::LowpassWeights},
         {"plusWeights[0]", UniformName::PlusWeights},
         {"normalFormat", UniformName::NormalFormat},
-        {"tLayer", UniformName::TLayer}
+        {"tLayer", UniformName::TLayer},
+        {"frustumPlanes[0]", UniformName::FrustumPlanes},
+        {"layerMask", UniformName::LayerMask}
     };
 
     static const std::unordered_map<std::string, SamplerName> staticSamplerMap = {
@@ -136,7 +157,8 @@ namespace af3d
         {"texSpecularLUT", SamplerName::SpecularLUT},
         {"texPrev", SamplerName::Prev},
         {"texDepth", SamplerName::Depth},
-        {"texShadowCSM", SamplerName::ShadowCSM}
+        {"texShadowCSM", SamplerName::ShadowCSM},
+        {"texVelocity", SamplerName::Velocity}
     };
 
     GLint VariableInfo::sizeInBytes() const
@@ -161,7 +183,7 @@ namespace af3d
                 for (auto sId : shaderIds) {
                     ogl.DetachShader(id, sId);
                 }
-                ogl.DeleteProgram(id);
+                ctx.deleteProgram(id);
             });
         } else {
             cleanup();
@@ -292,6 +314,11 @@ namespace af3d
                 continue;
             }
 
+            if (type == GL_IMAGE_2D) {
+                // Image units are fixed by layout(binding = N) in the shader.
+                continue;
+            }
+
             auto it = staticUniformMap.find(name);
             if (it == staticUniformMap.end()) {
                 LOG4CPLUS_ERROR(logger(), "Bad uniform name: " << name);
@@ -303,15 +330,20 @@ namespace af3d
             activeUniforms_[it->second] = VariableInfo(type, size, location);
         }
 
-        ogl.UseProgram(id_);
+        bindlessSamplers_ = samplers_;
+        bindlessSamplers_ &= bindlessRequested_;
+
+        ctx.useProgram(id_);
         int texUnit = 0;
         for (int i = 0; i <= static_cast<int>(SamplerName::Max); ++i) {
             SamplerName sName = static_cast<SamplerName>(i);
-            if (samplers_[sName]) {
+            if (bindlessSamplers_[sName]) {
+                bindlessLocations_[i] = samplerLocations[i];
+            } else if (samplers_[sName]) {
                 ogl.Uniform1i(samplerLocations[i], texUnit++);
             }
         }
-        ogl.UseProgram(0);
+        ctx.useProgram(0);
 
         return true;
     }
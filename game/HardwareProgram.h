@@ -41,7 +41,8 @@ namespace af3d
         Color, // Unlit shader only!
         Tangent,
         Bitangent,
-        Max = Bitangent
+        InstanceIdx, // Indirect draws only, sourced from GPU culling output.
+        Max = InstanceIdx
     };
 
     enum class UniformName
@@ -56,6 +57,7 @@ namespace af3d
         EyePos,
         AmbientColor,
         ViewportSize,
+        RenderScale, // Dynamic resolution scale of the camera renderer, 1.0 if it's not dynamic.
         Time,
         Dt,
         RealDt,
@@ -86,12 +88,16 @@ namespace af3d
         ArgPrevViewProjMatrix,
         ArgViewProjMatrix,
         ArgNearFar,
+        ArgRenderScale,
+        PrevRenderScale,
         SampleWeights,
         LowpassWeights,
         PlusWeights,
         NormalFormat,
         TLayer,
-        Max = TLayer
+        FrustumPlanes,
+        LayerMask,
+        Max = LayerMask
     };
 
     enum class SamplerName
@@ -110,7 +116,8 @@ namespace af3d
         Prev,
         Depth,
         ShadowCSM,
-        Max = ShadowCSM
+        Velocity,
+        Max = Velocity
     };
 
     enum class StorageBufferName
@@ -122,7 +129,14 @@ namespace af3d
         ClusterProbeIndices,
         ClusterProbes,
         ShadowCSM,
-        Max = ShadowCSM
+        ClusterEnabledLights,
+        ClusterActive,
+        IndirectInstances,
+        IndirectEntries,
+        IndirectCommands,
+        IndirectVisible,
+        IndirectStats,
+        Max = IndirectStats
     };
 
     struct VariableTypeInfo
@@ -180,10 +194,18 @@ namespace af3d
 
         void attachShader(const HardwareShaderPtr& shader, HardwareContext& ctx);
 
+        // Samplers that get bindless handles instead of texture units, must be set before 'link'.
+        inline void setBindlessSamplers(const Samplers& value) { bindlessRequested_ = value; }
+
         bool link(HardwareContext& ctx);
 
         inline const ActiveUniforms& activeUniforms() const { return activeUniforms_; }
         inline const Samplers& samplers() const { return samplers_; }
+
+        // Active samplers set with bindless handles, these have no texture unit.
+        inline const Samplers& bindlessSamplers() const { return bindlessSamplers_; }
+        inline GLint bindlessLocation(SamplerName name) const { return bindlessLocations_[static_cast<int>(name)]; }
+
         inline const StorageBuffers& storageBuffers() const { return storageBuffers_; }
         inline const Outputs& outputs() const { return outputs_; }
 
@@ -200,6 +222,9 @@ namespace af3d
         GLuint id_ = 0;
         ActiveUniforms activeUniforms_;
         Samplers samplers_;
+        Samplers bindlessRequested_;
+        Samplers bindlessSamplers_;
+        std::array<GLint, static_cast<int>(SamplerName::Max) + 1> bindlessLocations_;
         StorageBuffers storageBuffers_;
         Outputs outputs_;
     };
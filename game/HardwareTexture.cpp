@@ -94,9 +94,34 @@ namespace af3d
         }
     }
 
+    GLsizei HardwareTexture::compressedSize(GLint internalFormat, std::uint32_t width, std::uint32_t height)
+    {
+        GLsizei blockSize;
+
+        switch (internalFormat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+            blockSize = 8;
+            break;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RG_RGTC2:
+        case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+            blockSize = 16;
+            break;
+        default:
+            return 0;
+        }
+
+        return ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+    }
+
     void HardwareTexture::doInvalidate(HardwareContext& ctx)
     {
         id_ = 0;
+        hasHandle_ = false;
     }
 
     GLuint HardwareTexture::id(HardwareContext& ctx) const
@@ -106,6 +131,9 @@ namespace af3d
 
     void HardwareTexture::upload(GLint internalFormat, GLenum format, GLenum dataType, const GLvoid* pixels, bool genMipmap, GLint level, HardwareContext& ctx)
     {
+        if (level == 0) {
+            releaseHandles(ctx);
+        }
         createTexture();
         ctx.bindTexture(type_, id_);
         if (type_ == TextureType2D) {
@@ -125,7 +153,12 @@ namespace af3d
             }
         } else if (type_ == TextureTypeCubeMapArray) {
             ogl.TexImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, level, internalFormat, textureMipSize(width_, level), textureMipSize(height_, level), depth_ * 6, 0, format, dataType, pixels);
-            if (genMipmap) {
+            if (genMipmap && (compressedSize(internalFormat, 1, 1) > 0)) {
+                // Compressed formats aren't renderable, just allocate the chain, contents come with 'updateCompressed'.
+                for (GLint mip = level + 1; textureMipSize(width_, mip) > 0; ++mip) {
+                    ogl.TexImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, mip, internalFormat, textureMipSize(width_, mip), textureMipSize(height_, mip), depth_ * 6, 0, format, dataType, nullptr);
+                }
+            } else if (genMipmap) {
                 ogl.GenerateMipmap(GL_TEXTURE_CUBE_MAP_ARRAY);
             }
         } else {
@@ -150,6 +183,9 @@ namespace af3d
 
     void HardwareTexture::uploadCompressed(GLint internalFormat, const GLvoid* data, GLsizei dataSize, bool genMipmap, GLint level, HardwareContext& ctx)
     {
+        if (level == 0) {
+            releaseHandles(ctx);
+        }
         createTexture();
         ctx.bindTexture(type_, id_);
         btAssert(type_ == TextureType2D);
@@ -161,6 +197,7 @@ namespace af3d
 
     void HardwareTexture::update(GLenum format, GLenum dataType, const GLvoid* pixels, GLint level, GLint layer, HardwareContext& ctx)
     {
+        btAssert(!hasHandle_);
         createTexture();
         ctx.bindTexture(type_, id_);
         btAssert(type_ == TextureTypeCubeMapArray);
@@ -168,6 +205,16 @@ namespace af3d
             textureMipSize(width_, level), textureMipSize(height_, level), (TextureCubeFaceMax + 1), format, dataType, pixels);
     }
 
+    void HardwareTexture::updateCompressed(GLint internalFormat, const GLvoid* data, GLsizei dataSize, GLint level, GLint layer, HardwareContext& ctx)
+    {
+        btAssert(!hasHandle_);
+        createTexture();
+        ctx.bindTexture(type_, id_);
+        btAssert(type_ == TextureTypeCubeMapArray);
+        ogl.CompressedTexSubImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, level, 0, 0, layer * (TextureCubeFaceMax + 1),
+            textureMipSize(width_, level), textureMipSize(height_, level), (TextureCubeFaceMax + 1), internalFormat, dataSize, data);
+    }
+
     void HardwareTexture::download(GLenum format, GLenum dataType, GLvoid* pixels, HardwareContext& ctx)
     {
         createTexture();
@@ -176,8 +223,17 @@ namespace af3d
         ogl.GetTexImage(GL_TEXTURE_2D, 0, format, dataType, pixels);
     }
 
+    void HardwareTexture::downloadCubeFace(TextureCubeFace face, GLenum format, GLenum dataType, GLvoid* pixels, GLint level, HardwareContext& ctx)
+    {
+        createTexture();
+        ctx.bindTexture(type_, id_);
+        btAssert(type_ == TextureTypeCubeMap);
+        ogl.GetTexImage(glCubeFace(face), level, format, dataType, pixels);
+    }
+
     void HardwareTexture::generateMipmap(HardwareContext& ctx)
     {
+        btAssert(!hasHandle_);
         createTexture();
         ctx.bindTexture(type_, id_);
         ogl.GenerateMipmap(glType(type_));
@@ -191,4 +247,13 @@ namespace af3d
             setValid();
         }
     }
+
+    void HardwareTexture::releaseHandles(HardwareContext& ctx)
+    {
+        if (hasHandle_) {
+            ctx.deleteTexture(id_);
+            id_ = 0;
+            hasHandle_ = false;
+        }
+    }
 }
@@ -71,6 +71,9 @@ namespace af3d
 
         static GLenum glCubeFace(TextureCubeFace face);
 
+        // Size of a compressed image in bytes, 0 if 'internalFormat' is not compressed.
+        static GLsizei compressedSize(GLint internalFormat, std::uint32_t width, std::uint32_t height);
+
         inline TextureType type() const { return type_; }
 
         inline std::uint32_t width() const { return width_; }
@@ -89,15 +92,26 @@ namespace af3d
 
         void update(GLenum format, GLenum dataType, const GLvoid* pixels, GLint level, GLint layer, HardwareContext& ctx);
 
+        void updateCompressed(GLint internalFormat, const GLvoid* data, GLsizei dataSize, GLint level, GLint layer, HardwareContext& ctx);
+
         void download(GLenum format, GLenum dataType, GLvoid* pixels, HardwareContext& ctx);
 
+        void downloadCubeFace(TextureCubeFace face, GLenum format, GLenum dataType, GLvoid* pixels, GLint level, HardwareContext& ctx);
+
         void generateMipmap(HardwareContext& ctx);
 
+        // Set by HardwareContext once a bindless handle is created, the texture is immutable after that.
+        inline void setHasHandle() { hasHandle_ = true; }
+
     private:
         void doInvalidate(HardwareContext& ctx) override;
 
         void createTexture();
 
+        // Full re-upload of a texture with bindless handles goes into a new texture object,
+        // handles make the old one immutable for good. 'deleteTexture' drops its cached framebuffers.
+        void releaseHandles(HardwareContext& ctx);
+
         void uploadCubeFace(TextureCubeFace face, GLint internalFormat, GLenum format, GLenum dataType, const GLvoid* pixels, bool genMipmap, GLint level, HardwareContext& ctx);
 
         TextureType type_;
@@ -106,6 +120,7 @@ namespace af3d
         std::uint32_t depth_;
         TextureFormat format_;
         GLuint id_ = 0;
+        bool hasHandle_ = false;
     };
 
     using HardwareTexturePtr = std::shared_ptr<HardwareTexture>;
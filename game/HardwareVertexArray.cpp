@@ -24,6 +24,7 @@
  */
 
 #include "HardwareVertexArray.h"
+#include "HardwareContext.h"
 
 namespace af3d
 {
@@ -37,7 +38,7 @@ namespace af3d
         GLuint id = id_;
         if (id != 0) {
             cleanup([id](HardwareContext& ctx) {
-                ogl.DeleteVertexArrays(1, &id);
+                ctx.deleteVertexArray(id);
             });
         } else {
             cleanup();
@@ -63,7 +64,7 @@ namespace af3d
         HardwareContext& ctx)
     {
         if (id_ != 0) {
-            ogl.DeleteVertexArrays(1, &id_);
+            ctx.deleteVertexArray(id_);
             id_ = 0;
         }
 
@@ -76,7 +77,7 @@ namespace af3d
             btAssert(id_ != 0);
             setValid();
         }
-        ogl.BindVertexArray(id_);
+        ctx.bindVertexArray(id_);
 
         for (const auto& entry : layout_.entries()) {
             const auto& vbo = vbos_[entry.bufferIdx];
@@ -96,6 +97,6 @@ namespace af3d
             }
         }
 
-        ogl.BindVertexArray(0);
+        ctx.bindVertexArray(0);
     }
 }
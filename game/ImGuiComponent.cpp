@@ -66,14 +66,17 @@ namespace af3d
             return;
         }
 
-        float depthValue = zOrder();
+        ++frame_;
 
-        MaterialPtr mat;
-        ImTextureID lastTexId;
+        float depthValue = zOrder();
 
         ImVec2 clipOff = drawData->DisplayPos;
         ImVec2 clipScale = drawData->FramebufferScale;
 
+        auto& data = va_.data();
+        data.vertices.reserve(drawData->TotalVtxCount);
+        data.indices.reserve(drawData->TotalIdxCount);
+
         for (int n = 0; n < drawData->CmdListsCount; ++n) {
             const ImDrawList* cmdList = drawData->CmdLists[n];
 
@@ -81,8 +84,15 @@ namespace af3d
                 cmdList->VtxBuffer.Data[i].posZ = 0.0f;
             }
 
-            auto vaSlice = rl.createGeometry((const VertexImm*)cmdList->VtxBuffer.Data, cmdList->VtxBuffer.Size,
-                cmdList->IdxBuffer.Data, cmdList->IdxBuffer.Size);
+            auto startVertices = data.vertices.size();
+            auto startIndices = data.indices.size();
+
+            data.vertices.insert(data.vertices.end(), (const VertexImm*)cmdList->VtxBuffer.Data,
+                (const VertexImm*)cmdList->VtxBuffer.Data + cmdList->VtxBuffer.Size);
+            data.indices.insert(data.indices.end(), cmdList->IdxBuffer.Data,
+                cmdList->IdxBuffer.Data + cmdList->IdxBuffer.Size);
+
+            VertexArraySlice vaSlice(va_.va(), startIndices, cmdList->IdxBuffer.Size, startVertices);
 
             for (int i = 0; i < cmdList->CmdBuffer.Size; ++i) {
                 const ImDrawCmd* pcmd = &cmdList->CmdBuffer[i];
@@ -108,26 +118,23 @@ namespace af3d
                         scissorParams.width = clipRect.z - clipRect.x;
                         scissorParams.height = clipRect.w - clipRect.y;
 
-                        if (!mat || lastTexId != pcmd->TextureId) {
-                            if (mat) {
-                                // FIXME: dirty hack to make different materials render one by one.
-                                // Will fix this once different render list compilers are in place.
-                                depthValue += 1.0f;
-                            }
-                            mat = material_->clone();
-                            mat->setTextureBinding(SamplerName::Main,
-                                TextureBinding(imGuiManager.fromTextureId(pcmd->TextureId), SamplerParams(GL_LINEAR, GL_LINEAR)));
-                        }
-
-                        lastTexId = pcmd->TextureId;
-
-                        rl.addGeometry(mat, vaSlice.subSlice(pcmd->IdxOffset,
+                        rl.addGeometryOrdered(getMaterial(pcmd->TextureId), vaSlice.subSlice(pcmd->IdxOffset,
                             pcmd->ElemCount, pcmd->VtxOffset),
                             GL_TRIANGLES, depthValue, scissorParams);
                     }
                 }
             }
         }
+
+        va_.upload();
+
+        for (auto it = materialCache_.begin(); it != materialCache_.end();) {
+            if (it->second.frame != frame_) {
+                it = materialCache_.erase(it);
+            } else {
+                ++it;
+            }
+        }
     }
 
     void ImGuiComponent::onRegister()
@@ -136,5 +143,26 @@ namespace af3d
 
     void ImGuiComponent::onUnregister()
     {
+        materialCache_.clear();
+    }
+
+    const MaterialPtr& ImGuiComponent::getMaterial(ImTextureID texId)
+    {
+        auto& cached = materialCache_[texId];
+        cached.frame = frame_;
+
+        auto tex = imGuiManager.fromTextureId(texId);
+
+        if (!cached.material) {
+            cached.material = material_->clone();
+        } else if (cached.material->textureBinding(SamplerName::Main).tex == tex) {
+            return cached.material;
+        }
+
+        // New or texture id reused by another texture.
+        cached.material->setTextureBinding(SamplerName::Main,
+            TextureBinding(tex, SamplerParams(GL_LINEAR, GL_LINEAR)));
+
+        return cached.material;
     }
 }
@@ -27,6 +27,8 @@
 #define _IMGUICOMPONENT_H_
 
 #include "UIComponent.h"
+#include "VertexArrayWriter.h"
+#include "imgui.h"
 
 namespace af3d
 {
@@ -50,7 +52,24 @@ namespace af3d
 
         void onUnregister() override;
 
+        const MaterialPtr& getMaterial(ImTextureID texId);
+
+        struct CachedMaterial
+        {
+            MaterialPtr material;
+            std::uint32_t frame;
+        };
+
+        using MaterialCache = std::unordered_map<ImTextureID, CachedMaterial>;
+
         MaterialPtr material_;
+
+        // Per-texture clones of 'material_', dropped once texture is no longer drawn.
+        MaterialCache materialCache_;
+        std::uint32_t frame_ = 0;
+
+        // ImGui geometry goes straight here instead of scene's default VA.
+        VertexArrayWriter va_;
     };
 
     using ImGuiComponentPtr = std::shared_ptr<ImGuiComponent>;
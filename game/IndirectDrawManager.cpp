@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "IndirectDrawManager.h"
+#include "CameraRenderer.h"
+#include "MaterialManager.h"
+#include "HardwareResourceManager.h"
+#include "Renderer.h"
+
+namespace af3d
+{
+    namespace
+    {
+        struct InstancesSSBOUpdate : boost::noncopyable
+        {
+            HardwareDataBufferPtr ssbo;
+            std::vector<ShaderIndirectInstance> instances;
+            std::vector<int> indices; // Empty - full reload.
+        };
+
+        struct CommandsSSBOUpdate : boost::noncopyable
+        {
+            std::vector<HardwareDataBufferPtr> commandSSBOs;
+            std::vector<HardwareDataBufferPtr> visibleSSBOs;
+            std::vector<ShaderDrawCommand> commands;
+            GLsizeiptr numVisible = 0;
+        };
+    }
+
+    IndirectDrawManager::IndirectDrawManager()
+    : instancesSSBO_(hwManager.createDataBuffer(HardwareBuffer::Usage::DynamicDraw, sizeof(ShaderIndirectInstance))),
+      entriesSSBO_(hwManager.createDataBuffer(HardwareBuffer::Usage::StaticDraw, sizeof(std::uint32_t) * 2)),
+      va_(std::make_shared<VertexArray>(hwManager.createVertexArray(), VertexArrayLayout(), VBOList()))
+    {
+        for (auto& ssbo : statsSSBOs_) {
+            ssbo = hwManager.createDataBuffer(HardwareBuffer::Usage::DynamicRead, sizeof(std::uint32_t));
+        }
+    }
+
+    IndirectDrawManager::~IndirectDrawManager()
+    {
+        btAssert(instancesFreeIndices_.size() == instances_.size());
+    }
+
+    bool IndirectDrawManager::canDraw(const MaterialPtr& material, const VertexArraySlice& vaSlice)
+    {
+        return (materialTypeIndirect(material->type()->name()) != material->type()->name()) &&
+            !material->blendingParams().isEnabled() &&
+            vaSlice.va()->ebo() && (vaSlice.count() > 0);
+    }
+
+    int IndirectDrawManager::addInstance(const MaterialPtr& material, const VertexArraySlice& vaSlice,
+        const Matrix4f& modelMat, const AABB& aabb, const CameraLayers& layers)
+    {
+        int idx;
+        if (instancesFreeIndices_.empty()) {
+            idx = instances_.size();
+            instances_.emplace_back();
+            instancesResized_ = true;
+        } else {
+            idx = *instancesFreeIndices_.begin();
+            instancesFreeIndices_.erase(instancesFreeIndices_.begin());
+        }
+
+        auto& inst = instances_[idx];
+        inst.material = material;
+        inst.vaSlice = vaSlice;
+        inst.data.flags[1] = inst.data.flags[2] = inst.data.flags[3] = 0;
+
+        layoutDirty_ = true;
+
+        updateInstance(idx, modelMat, modelMat, aabb, layers);
+
+        return idx;
+    }
+
+    void IndirectDrawManager::updateInstance(int idx, const Matrix4f& modelMat, const Matrix4f& prevModelMat,
+        const AABB& aabb, const CameraLayers& layers)
+    {
+        auto& data = instances_[idx].data;
+        data.model = modelMat;
+        data.prevModel = prevModelMat;
+        data.aabbMin = Vector4f(aabb.lowerBound, 1.0f);
+        data.aabbMax = Vector4f(aabb.upperBound, 1.0f);
+        data.flags[0] = layerMask(layers);
+
+        instancesDirtyIndices_.insert(idx);
+    }
+
+    void IndirectDrawManager::removeInstance(int idx)
+    {
+        btAssert(instances_[idx].material);
+
+        instances_[idx] = Instance();
+        instancesDirtyIndices_.erase(idx);
+        bool res = instancesFreeIndices_.insert(idx).second;
+        btAssert(res);
+
+        layoutDirty_ = true;
+    }
+
+    int IndirectDrawManager::cull(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn,
+        IndirectDrawBinding& binding, const TexturePtr& hiZTex)
+    {
+        binding = IndirectDrawBinding();
+
+        if (layoutDirty_) {
+            rebuild();
+        }
+
+        if (entries_.empty()) {
+            return pass;
+        }
+
+        if (!groupMaterialsSynced_) {
+            syncGroupMaterials();
+            groupMaterialsSynced_ = true;
+        }
+
+        bool occlusion = !!hiZTex;
+
+        auto& cc = cameraCulls_[std::make_pair(rl.camera().get(), occlusion)];
+        if (!cc.commands) {
+            cc.commands = hwManager.createDataBuffer(HardwareBuffer::Usage::StaticCopy, sizeof(ShaderDrawCommand));
+            cc.visible = hwManager.createDataBuffer(HardwareBuffer::Usage::StaticCopy, sizeof(std::uint32_t));
+            cc.cullMaterial = materialManager.createMaterial(occlusion ? MaterialTypeIndirectCullOcclusion : MaterialTypeIndirectCull);
+        }
+
+        binding.commands = cc.commands;
+        binding.instances = cc.visible;
+
+        if ((cc.frame == frame_) && (cc.rn == rn.get())) {
+            // Prepass already did it.
+            return pass;
+        }
+
+        cc.frame = frame_;
+        cc.rn = rn.get();
+
+        RenderNode tmpNode;
+
+        std::vector<HardwareTextureBinding> textures;
+        std::vector<StorageBufferBinding> storageBuffers;
+
+        const auto& matReset = materialManager.matIndirectReset();
+        MaterialParams resetParams(matReset->type(), true);
+        cr.setAutoParams(rl, matReset, 0, textures, storageBuffers, resetParams);
+        storageBuffers.emplace_back(StorageBufferName::IndirectCommands, cc.commands);
+        rn->add(std::move(tmpNode), pass, matReset, va_,
+            std::move(textures), std::move(storageBuffers),
+            Vector3i((commands_.size() + 63) / 64, 1, 1), std::move(resetParams));
+
+        std::vector<Vector4f> planes;
+        for (const auto& plane : rl.camera()->frustum().planes()) {
+            planes.emplace_back(plane.normal, plane.dist);
+        }
+
+        cc.cullMaterial->params().setUniform(UniformName::FrustumPlanes, planes);
+        cc.cullMaterial->params().setUniform(UniformName::LayerMask,
+            static_cast<std::int32_t>(1U << static_cast<int>(rl.camera()->layer())));
+
+        GLbitfield barriers = GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+
+        if (occlusion) {
+            cc.cullMaterial->setTextureBinding(SamplerName::Main,
+                TextureBinding(hiZTex, SamplerParams(GL_NEAREST_MIPMAP_NEAREST, GL_NEAREST)));
+            lastOcclusionFrame_ = frame_;
+            // Stats get mapped for reading later on.
+            barriers |= GL_BUFFER_UPDATE_BARRIER_BIT;
+        }
+
+        MaterialParams cullParams(cc.cullMaterial->type(), true);
+        cr.setAutoParams(rl, cc.cullMaterial, 0, textures, storageBuffers, cullParams);
+        storageBuffers.emplace_back(StorageBufferName::IndirectEntries, entriesSSBO_);
+        storageBuffers.emplace_back(StorageBufferName::IndirectCommands, cc.commands);
+        storageBuffers.emplace_back(StorageBufferName::IndirectVisible, cc.visible);
+        if (occlusion) {
+            storageBuffers.emplace_back(StorageBufferName::IndirectStats, statsSSBOs_[frame_ % numStatsSSBOs]);
+        }
+        rn->add(std::move(tmpNode), pass + 1, cc.cullMaterial, va_,
+            std::move(textures), std::move(storageBuffers),
+            Vector3i((entries_.size() / 2 + 63) / 64, 1, 1), std::move(cullParams),
+            std::vector<HardwareImageBinding>(), barriers);
+
+        return pass + 2;
+    }
+
+    void IndirectDrawManager::preSwap()
+    {
+        for (auto it = cameraCulls_.begin(); it != cameraCulls_.end();) {
+            if (it->second.frame != frame_) {
+                // Camera wasn't rendered this frame, drop its buffers.
+                it = cameraCulls_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        bool statsRecreate = false;
+        for (const auto& ssbo : statsSSBOs_) {
+            statsRecreate |= ssbo->setValid();
+        }
+        if (statsRecreate) {
+            auto ssbos = statsSSBOs_;
+            renderer.scheduleHwOp([ssbos](HardwareContext& ctx) {
+                std::uint32_t zeros[2] = {0, 0};
+                for (const auto& ssbo : ssbos) {
+                    ssbo->reload(2, zeros, ctx);
+                }
+            });
+        } else if ((frame_ - lastOcclusionFrame_) < numStatsSSBOs) {
+            // Runs before this frame's nodes, so this is the oldest one, written 'numStatsSSBOs - 1' frames ago.
+            auto ssbo = statsSSBOs_[(frame_ + 1) % numStatsSSBOs];
+            renderer.scheduleHwOp([ssbo](HardwareContext& ctx) {
+                std::uint32_t counts[2];
+                auto ptr = static_cast<const std::uint32_t*>(ssbo->lock(HardwareBuffer::ReadOnly, ctx));
+                counts[0] = ptr[0];
+                counts[1] = ptr[1];
+                ssbo->unlock(ctx);
+                ctx.addOcclusionStats(counts[0], counts[1]);
+                counts[0] = counts[1] = 0;
+                ssbo->upload(0, 2, counts, ctx);
+            });
+        }
+
+        ++frame_;
+        groupMaterialsSynced_ = false;
+
+        bool recreate = instancesSSBO_->setValid();
+        if ((recreate || instancesResized_ || !instancesDirtyIndices_.empty()) && !instances_.empty()) {
+            auto upd = std::make_shared<InstancesSSBOUpdate>();
+            upd->ssbo = instancesSSBO_;
+            if (recreate || instancesResized_) {
+                upd->instances.reserve(instances_.size());
+                for (const auto& inst : instances_) {
+                    upd->instances.push_back(inst.data);
+                }
+            } else {
+                for (auto idx : instancesDirtyIndices_) {
+                    upd->instances.push_back(instances_[idx].data);
+                    upd->indices.push_back(idx);
+                }
+            }
+
+            renderer.scheduleHwOp([upd](HardwareContext& ctx) {
+                if (upd->indices.empty()) {
+                    upd->ssbo->reload(upd->instances.size(), &upd->instances[0], ctx);
+                } else {
+                    for (size_t i = 0; i < upd->indices.size(); ++i) {
+                        upd->ssbo->upload(upd->indices[i], 1, &upd->instances[i], ctx);
+                    }
+                }
+            });
+        }
+
+        instancesDirtyIndices_.clear();
+        instancesResized_ = false;
+
+        if (entries_.empty()) {
+            layoutChanged_ = false;
+            return;
+        }
+
+        recreate = entriesSSBO_->setValid();
+        if (recreate || layoutChanged_) {
+            auto ssbo = entriesSSBO_;
+            auto entries = std::make_shared<std::vector<std::uint32_t>>(entries_);
+            renderer.scheduleHwOp([ssbo, entries](HardwareContext& ctx) {
+                ssbo->reload(entries->size() / 2, &(*entries)[0], ctx);
+            });
+        }
+
+        auto upd = std::make_shared<CommandsSSBOUpdate>();
+
+        for (auto& kv : cameraCulls_) {
+            bool cmdRecreate = kv.second.commands->setValid();
+            bool visibleRecreate = kv.second.visible->setValid();
+            if (cmdRecreate || visibleRecreate || layoutChanged_) {
+                upd->commandSSBOs.push_back(kv.second.commands);
+                upd->visibleSSBOs.push_back(kv.second.visible);
+            }
+        }
+
+        layoutChanged_ = false;
+
+        if (upd->commandSSBOs.empty()) {
+            return;
+        }
+
+        upd->commands = commands_;
+        upd->numVisible = entries_.size() / 2;
+
+        renderer.scheduleHwOp([upd](HardwareContext& ctx) {
+            for (size_t i = 0; i < upd->commandSSBOs.size(); ++i) {
+                // Reset pass only clears instance counts, the rest is static.
+                upd->commandSSBOs[i]->reload(upd->commands.size(), &upd->commands[0], ctx);
+                upd->visibleSSBOs[i]->resize(upd->numVisible, ctx);
+            }
+        });
+    }
+
+    std::uint32_t IndirectDrawManager::layerMask(const CameraLayers& layers)
+    {
+        std::uint32_t mask = 0;
+        for (int i = 0; i <= static_cast<int>(CameraLayer::Max); ++i) {
+            if (layers[static_cast<CameraLayer>(i)]) {
+                mask |= (1U << i);
+            }
+        }
+        return mask;
+    }
+
+    void IndirectDrawManager::rebuild()
+    {
+        layoutDirty_ = false;
+        layoutChanged_ = true;
+
+        std::vector<int> sorted;
+        for (int i = 0; i < static_cast<int>(instances_.size()); ++i) {
+            if (instances_[i].material) {
+                sorted.push_back(i);
+            }
+        }
+
+        std::sort(sorted.begin(), sorted.end(), [this](int a, int b) {
+            const auto& ia = instances_[a];
+            const auto& ib = instances_[b];
+            if (ia.material != ib.material) {
+                return ia.material < ib.material;
+            }
+            if (ia.vaSlice.va() != ib.vaSlice.va()) {
+                return ia.vaSlice.va() < ib.vaSlice.va();
+            }
+            if (ia.vaSlice.start() != ib.vaSlice.start()) {
+                return ia.vaSlice.start() < ib.vaSlice.start();
+            }
+            if (ia.vaSlice.count() != ib.vaSlice.count()) {
+                return ia.vaSlice.count() < ib.vaSlice.count();
+            }
+            return ia.vaSlice.baseVertex() < ib.vaSlice.baseVertex();
+        });
+
+        // Keep indirect materials of surviving groups.
+        std::unordered_map<Material*, MaterialPtr> indirectMaterials;
+        for (const auto& group : groups_) {
+            indirectMaterials.emplace(group.material.get(), group.indirectMaterial);
+        }
+
+        groups_.clear();
+        commands_.clear();
+        entries_.clear();
+
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            const auto& inst = instances_[sorted[i]];
+
+            bool newGroup = groups_.empty() ||
+                (groups_.back().material != inst.material) || (groups_.back().va != inst.vaSlice.va());
+
+            if (newGroup) {
+                Group group;
+                group.material = inst.material;
+                auto it = indirectMaterials.find(inst.material.get());
+                if (it != indirectMaterials.end()) {
+                    group.indirectMaterial = it->second;
+                } else {
+                    group.indirectMaterial = inst.material->convert(materialTypeIndirect(inst.material->type()->name()));
+                }
+                group.va = inst.vaSlice.va();
+                group.firstCmd = commands_.size();
+                groups_.push_back(group);
+            }
+
+            const auto& prevSlice = instances_[sorted[(i > 0) ? (i - 1) : 0]].vaSlice;
+
+            if (newGroup || (prevSlice.start() != inst.vaSlice.start()) ||
+                (prevSlice.count() != inst.vaSlice.count()) || (prevSlice.baseVertex() != inst.vaSlice.baseVertex())) {
+                ShaderDrawCommand cmd;
+                cmd.count = inst.vaSlice.count();
+                cmd.instanceCount = 0;
+                cmd.firstIndex = inst.vaSlice.start();
+                cmd.baseVertex = inst.vaSlice.baseVertex();
+                // Visible instances of a command go to [baseInstance, baseInstance + instanceCount).
+                cmd.baseInstance = i;
+                commands_.push_back(cmd);
+                ++groups_.back().numCmds;
+            }
+
+            entries_.push_back(sorted[i]);
+            entries_.push_back(commands_.size() - 1);
+        }
+    }
+
+    void IndirectDrawManager::syncGroupMaterials()
+    {
+        for (auto& group : groups_) {
+            group.material->params().convert(group.indirectMaterial->params());
+            const auto& samplers = group.indirectMaterial->type()->prog()->samplers();
+            for (int i = 0; i <= static_cast<int>(SamplerName::Max); ++i) {
+                SamplerName sName = static_cast<SamplerName>(i);
+                if (samplers[sName]) {
+                    group.indirectMaterial->setTextureBinding(sName, group.material->textureBinding(sName));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _INDIRECT_DRAW_MANAGER_H_
+#define _INDIRECT_DRAW_MANAGER_H_
+
+#include "RenderNode.h"
+#include "CameraLayer.h"
+#include "ShaderDataTypes.h"
+#include "Texture.h"
+#include "af3d/AABB.h"
+#include <set>
+#include <map>
+
+namespace af3d
+{
+    class CameraRenderer;
+    class RenderList;
+    class Camera;
+
+    /*
+     * Keeps static mesh instances resident on GPU, culls them per camera in a compute pass
+     * and exposes them as multi-draw-indirect groups, one per material and vertex array. This
+     * way CPU side cost of geometry, prepass and CSM passes depends on the number of materials,
+     * not on the number of instances.
+     */
+    class IndirectDrawManager : boost::noncopyable
+    {
+    public:
+        struct Group
+        {
+            MaterialPtr material; // Source material, render state comes from it.
+            MaterialPtr indirectMaterial; // Indirect variant, params and textures are synced from source each frame.
+            VertexArrayPtr va;
+            std::uint32_t firstCmd = 0;
+            std::uint32_t numCmds = 0;
+        };
+
+        using Groups = std::vector<Group>;
+
+        IndirectDrawManager();
+        ~IndirectDrawManager();
+
+        // Only opaque indexed geometry with an indirect material type variant qualifies.
+        static bool canDraw(const MaterialPtr& material, const VertexArraySlice& vaSlice);
+
+        int addInstance(const MaterialPtr& material, const VertexArraySlice& vaSlice,
+            const Matrix4f& modelMat, const AABB& aabb, const CameraLayers& layers);
+
+        // 'layers' should be empty for hidden instances.
+        void updateInstance(int idx, const Matrix4f& modelMat, const Matrix4f& prevModelMat,
+            const AABB& aabb, const CameraLayers& layers);
+
+        void removeInstance(int idx);
+
+        inline bool empty() const { return instancesFreeIndices_.size() == instances_.size(); }
+
+        /*
+         * Adds reset and cull dispatches for 'rl' camera at 'pass' and 'pass + 1', returns next pass.
+         * Cull results are reused if this camera was already culled into 'rn' this frame, 'pass' is
+         * returned as is in that case. 'binding.commands' is null when there's nothing to draw.
+         * With 'hiZTex' instances are also occlusion culled against it, results are kept separately
+         * from frustum only ones.
+         */
+        int cull(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn,
+            IndirectDrawBinding& binding, const TexturePtr& hiZTex = TexturePtr());
+
+        inline const Groups& groups() const { return groups_; }
+
+        inline const HardwareDataBufferPtr& instancesSSBO() const { return instancesSSBO_; }
+
+        void preSwap();
+
+    private:
+        struct Instance
+        {
+            MaterialPtr material;
+            VertexArraySlice vaSlice;
+            ShaderIndirectInstance data;
+        };
+
+        struct CameraCull
+        {
+            HardwareDataBufferPtr commands;
+            HardwareDataBufferPtr visible;
+            MaterialPtr cullMaterial;
+            std::uint64_t frame = 0;
+            const RenderNode* rn = nullptr;
+            bool needReload = true;
+        };
+
+        using IndexSet = std::set<int>;
+        using CameraCulls = std::map<std::pair<const Camera*, bool>, CameraCull>;
+
+        // Occlusion stats are read back this many frames late, so that readback doesn't stall.
+        static const int numStatsSSBOs = 3;
+
+        static std::uint32_t layerMask(const CameraLayers& layers);
+
+        void rebuild();
+
+        void syncGroupMaterials();
+
+        std::vector<Instance> instances_;
+        IndexSet instancesFreeIndices_;
+        IndexSet instancesDirtyIndices_;
+        bool instancesResized_ = false;
+
+        // Layout, rebuilt when instances are added or removed.
+        bool layoutDirty_ = false;
+        bool layoutChanged_ = false;
+        Groups groups_;
+        std::vector<ShaderDrawCommand> commands_;
+        std::vector<std::uint32_t> entries_; // instance index, command index pairs.
+
+        HardwareDataBufferPtr instancesSSBO_;
+        HardwareDataBufferPtr entriesSSBO_;
+        VertexArrayPtr va_;
+
+        CameraCulls cameraCulls_;
+        std::array<HardwareDataBufferPtr, numStatsSSBOs> statsSSBOs_; // visible, occluded counters.
+        std::uint64_t lastOcclusionFrame_ = 0;
+        std::uint64_t frame_ = 1;
+        bool groupMaterialsSynced_ = false;
+    };
+}
+
+#endif
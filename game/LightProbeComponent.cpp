@@ -35,13 +35,35 @@
 #include "Const.h"
 #include "PhysicsDebugDraw.h"
 #include "af3d/ImageWriter.h"
+#include "af3d/BC6H.h"
 #include <fstream>
+#include <cstring>
 
 namespace af3d
 {
     ACLASS_DEFINE_BEGIN(LightProbeComponent, PhasedComponent)
     ACLASS_DEFINE_END(LightProbeComponent)
 
+    namespace
+    {
+        // Compact probe file is this header followed by compressed specular mips,
+        // all faces of a mip one after another.
+        struct ProbeFileHeader
+        {
+            char magic[4];
+            std::uint32_t version;
+            std::uint32_t specularFormat;
+            std::uint32_t specularResolution;
+            std::uint32_t specularMipLevels;
+            float sh[9][3];
+        };
+
+        const char probeFileMagic[4] = {'A', 'F', 'L', 'P'};
+        const std::uint32_t probeFileVersion = 1;
+    }
+
+    const GLint LightProbeComponent::compactSpecularFormat;
+
     LightProbeComponent::LightProbeComponent(const boost::optional<AABB>& bounds, bool spherical,
         const Color& ambientColor, const Color& specularColor)
     : PhasedComponent(AClass_LightProbeComponent, phasePreRender),
@@ -70,85 +92,54 @@ namespace af3d
         }
 
         if (irrCube2equirectFilter_ && (irrCube2equirectFilter_->numFramesRendered() > 0)) {
-            auto tex = irrCube2equirectFilter_->camera()->renderTarget().texture();
-            std::vector<Byte> pixels(tex->width() * tex->height() * 3 * sizeof(float));
-            tex->download(GL_RGB, GL_FLOAT, pixels);
-
-            {
-                std::string fname = platform->assetsPath() + "/" + getIrradianceTexName();
-                std::ofstream os(fname,
-                    std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
-                ImageWriter writer(fname, os);
-                writer.writeHDR(tex->width(), tex->height(), 3, pixels);
-            }
+            irrReadback_ = TextureReadback::texture2D(irrCube2equirectFilter_->camera()->renderTarget().texture(), GL_RGB, GL_FLOAT);
 
             startSpecularGen();
 
             stopIrradianceGen();
+        } else if (irrCaptureTexture_ && (irrGenFilters_[0]->numFramesRendered() > 0)) {
+            irrReadback_ = TextureReadback::cube(irrCaptureTexture_, GL_RGB, GL_FLOAT, 0);
 
-            btAssert(!irrEquirect2cube_);
-            auto equirectTex = textureManager.loadTexture(getIrradianceTexName(), false);
-            equirectTex->invalidate();
-            equirectTex->load();
-            irrEquirect2cube_ = std::make_shared<Equirect2CubeComponent>(equirectTex, rt_.irradianceTexture, rt_.index, camOrderLightProbe);
-            parent()->addComponent(irrEquirect2cube_);
+            startSpecularGen();
+
+            stopIrradianceGen();
         } else if (!specularCube2EquirectFilters_.empty() && (specularCube2EquirectFilters_[0]->numFramesRendered() > 0)) {
             btAssert(settings.lightProbe.specularMipLevels == specularCube2EquirectFilters_.size());
-            auto mip0Tex = specularCube2EquirectFilters_[0]->camera()->renderTarget().texture();
-
-            std::uint32_t numPixels = 0;
-            for (std::uint32_t mip = 0; mip < settings.lightProbe.specularMipLevels; ++mip) {
-                numPixels += textureMipSize(mip0Tex->width(), mip) * textureMipSize(mip0Tex->height(), mip);
+            for (const auto& filter : specularCube2EquirectFilters_) {
+                specularReadbacks_.push_back(TextureReadback::texture2D(filter->camera()->renderTarget().texture(), GL_RGB, GL_FLOAT));
             }
-            std::uint32_t height = (numPixels + mip0Tex->width() - 1) / mip0Tex->width();
-
-            std::vector<Byte> pixels(mip0Tex->width() * height * 3 * sizeof(float), 0);
-            numPixels = 0;
-            for (std::uint32_t mip = 0; mip < settings.lightProbe.specularMipLevels; ++mip) {
-                auto tex = specularCube2EquirectFilters_[mip]->camera()->renderTarget().texture();
-                tex->download(GL_RGB, GL_FLOAT, &pixels[0] + (numPixels * 3 * sizeof(float)));
-                numPixels += textureMipSize(mip0Tex->width(), mip) * textureMipSize(mip0Tex->height(), mip);
+            if (specularLUTGenFilter_) {
+                specularLUTReadback_ = TextureReadback::texture2D(specularLUTTexture_, GL_RGB, GL_FLOAT);
             }
 
-            {
-                std::string fname = platform->assetsPath() + "/" + getSpecularTexName();
-                std::ofstream os(fname,
-                    std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
-                ImageWriter writer(fname, os);
-                writer.writeHDR(mip0Tex->width(), height, 3, pixels);
+            stopSpecularGen();
+        } else if (specularCaptureTexture_ && (specularGenFilters_.back()->numFramesRendered() > 0)) {
+            for (std::uint32_t mip = 0; mip < settings.lightProbe.specularMipLevels; ++mip) {
+                specularReadbacks_.push_back(TextureReadback::cube(specularCaptureTexture_, GL_RGB, GL_FLOAT, mip));
             }
-
-            bool lutReload = false;
-
             if (specularLUTGenFilter_) {
-                auto tex = specularLUTGenFilter_->camera()->renderTarget().texture();
-                pixels.resize(tex->width() * tex->height() * 3 * sizeof(float));
-                tex->download(GL_RGB, GL_FLOAT, pixels);
-                pixels.resize(specularLUTSize * specularLUTSize * 3 * sizeof(float));
-
-                std::string fname = platform->assetsPath() + "/" + getSpecularLUTTexName();
-                std::ofstream os(fname,
-                    std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
-                ImageWriter writer(fname, os);
-                writer.writeHDR(specularLUTSize, specularLUTSize, 3, pixels);
-                lutReload = true;
+                specularLUTReadback_ = TextureReadback::texture2D(specularLUTTexture_, GL_RGB, GL_FLOAT);
             }
 
             stopSpecularGen();
+        }
 
-            btAssert(!specularEquirect2cube_);
-            auto equirectTex = textureManager.loadTexture(getSpecularTexName(), false);
-            equirectTex->invalidate();
-            equirectTex->load();
-            specularEquirect2cube_ = std::make_shared<Equirect2CubeComponent>(equirectTex, rt_.specularTexture, rt_.index, camOrderLightProbe, settings.lightProbe.specularMipLevels);
-            parent()->addComponent(specularEquirect2cube_);
+        if (irrReadback_ && irrReadback_->ready()) {
+            processIrradiance();
+        }
 
-            if (lutReload) {
-                specularLUTTexture_->invalidate();
-                specularLUTTexture_->load();
+        if (!specularReadbacks_.empty()) {
+            bool ready = true;
+            for (const auto& rb : specularReadbacks_) {
+                ready &= rb->ready();
+            }
+            if (ready) {
+                processSpecular();
             }
+        }
 
-            LOG4CPLUS_INFO(logger(), "LightProbe(" << parent()->name() << "): done");
+        if (specularLUTReadback_ && specularLUTReadback_->ready()) {
+            processSpecularLUT();
         }
     }
 
@@ -156,7 +147,7 @@ namespace af3d
     {
         btAssert(scene());
 
-        if (irrCube2equirectFilter_ || !specularCube2EquirectFilters_.empty()) {
+        if (baking()) {
             LOG4CPLUS_WARN(logger(), "LightProbe(" << parent()->name() << "): recreation still in progress...");
             return false;
         }
@@ -168,6 +159,12 @@ namespace af3d
         return true;
     }
 
+    bool LightProbeComponent::baking() const
+    {
+        return sceneCaptureCameras_[0] || !specularGenFilters_.empty() ||
+            irrReadback_ || !specularReadbacks_.empty() || specularLUTReadback_ || (pendingSaves_ > 0);
+    }
+
     bool LightProbeComponent::resetDirty()
     {
         bool wasDirty = dirty_;
@@ -184,22 +181,43 @@ namespace af3d
         cProbe.cubeIdx = rt_.index;
         cProbe.spherical = spherical_;
         cProbe.enabled = 1;
+        if (hasSH_) {
+            std::copy(sh_.begin(), sh_.end(), cProbe.sh);
+        } else {
+            Color color = gammaToLinear(ambientColor_);
+            cProbe.sh[0] = Vector4f(color.x(), color.y(), color.z(), 0.0f);
+            std::fill(cProbe.sh + 1, cProbe.sh + sh_.size(), Vector4f_zero);
+        }
+    }
+
+    void LightProbeComponent::reloadSpecular()
+    {
+        for (size_t mip = 0; mip < specularMips_.size(); ++mip) {
+            auto data = specularMips_[mip];
+            rt_.specularTexture->updateCompressed(compactSpecularFormat, std::move(data), mip, rt_.index);
+        }
     }
 
     void LightProbeComponent::onRegister()
     {
         rt_ = scene()->addLightProbe(this);
         prevXf_ = parent()->smoothTransform();
-        auto tex = textureManager.loadTexture(getIrradianceTexName(), false);
-        if (tex) {
-            irrEquirect2cube_ = std::make_shared<Equirect2CubeComponent>(tex, rt_.irradianceTexture, rt_.index, camOrderLightProbe);
-            parent()->addComponent(irrEquirect2cube_);
-        }
+        if (settings.lightProbe.compact) {
+            if (loadProbeFile()) {
+                reloadSpecular();
+            }
+        } else {
+            auto tex = textureManager.loadTexture(getIrradianceTexName(), false);
+            if (tex) {
+                irrEquirect2cube_ = std::make_shared<Equirect2CubeComponent>(tex, rt_.irradianceTexture, rt_.index, camOrderLightProbe);
+                parent()->addComponent(irrEquirect2cube_);
+            }
 
-        tex = textureManager.loadTexture(getSpecularTexName(), false);
-        if (tex) {
-            specularEquirect2cube_ = std::make_shared<Equirect2CubeComponent>(tex, rt_.specularTexture, rt_.index, camOrderLightProbe, settings.lightProbe.specularMipLevels);
-            parent()->addComponent(specularEquirect2cube_);
+            tex = textureManager.loadTexture(getSpecularTexName(), false);
+            if (tex) {
+                specularEquirect2cube_ = std::make_shared<Equirect2CubeComponent>(tex, rt_.specularTexture, rt_.index, camOrderLightProbe, settings.lightProbe.specularMipLevels);
+                parent()->addComponent(specularEquirect2cube_);
+            }
         }
 
         specularLUTTexture_ = textureManager.loadTexture(getSpecularLUTTexName(), false);
@@ -236,6 +254,12 @@ namespace af3d
         scene()->removeLightProbe(this);
         stopIrradianceGen();
         stopSpecularGen();
+        // Drop bake results still in flight.
+        ++bakeId_;
+        pendingSaves_ = 0;
+        irrReadback_.reset();
+        specularReadbacks_.clear();
+        specularLUTReadback_.reset();
         if (irrEquirect2cube_) {
             irrEquirect2cube_->removeFromParent();
             irrEquirect2cube_.reset();
@@ -264,6 +288,14 @@ namespace af3d
             specularEquirect2cube_->removeFromParent();
             specularEquirect2cube_.reset();
         }
+        hasSH_ = false;
+        specularMips_.clear();
+        dirty_ = true;
+
+        if (settings.lightProbe.compact) {
+            irrCaptureTexture_ = textureManager.createRenderTexture(TextureTypeCubeMap,
+                settings.lightProbe.irradianceResolution, settings.lightProbe.irradianceResolution, 0, GL_RGB16F, GL_RGB, GL_FLOAT);
+        }
 
         auto sceneCaptureTexture = textureManager.createRenderTexture(TextureTypeCubeMap,
             sceneCaptureSize, sceneCaptureSize, 0, GL_RGB16F, GL_RGB, GL_FLOAT);
@@ -299,10 +331,16 @@ namespace af3d
             irrGenFilters_[i]->camera()->setFov(btRadians(90.0f));
             irrGenFilters_[i]->camera()->setAspect(1.0f);
             irrGenFilters_[i]->camera()->setTransform(btTransform(textureCubeFaceBasis(face)));
-            irrGenFilters_[i]->camera()->setRenderTarget(AttachmentPoint::Color0, RenderTarget(rt_.irradianceTexture, 0, face, rt_.index));
+            irrGenFilters_[i]->camera()->setRenderTarget(AttachmentPoint::Color0, irrCaptureTexture_ ?
+                RenderTarget(irrCaptureTexture_, 0, face) : RenderTarget(rt_.irradianceTexture, 0, face, rt_.index));
             parent()->addComponent(irrGenFilters_[i]);
         }
 
+        if (irrCaptureTexture_) {
+            // Projected onto SH on CPU, no equirect needed.
+            return;
+        }
+
         auto equirectSz = cubeSize2equirect(rt_.irradianceTexture->width());
         irrCube2equirectFilter_ = std::make_shared<RenderFilterComponent>(MaterialTypeFilterCube2Equirect);
         irrCube2equirectFilter_->material()->setTextureBinding(SamplerName::Main,
@@ -318,9 +356,12 @@ namespace af3d
 
     void LightProbeComponent::stopIrradianceGen()
     {
-        if (irrCube2equirectFilter_) {
-            irrCube2equirectFilter_->removeFromParent();
-            irrCube2equirectFilter_.reset();
+        if (sceneCaptureCameras_[0]) {
+            if (irrCube2equirectFilter_) {
+                irrCube2equirectFilter_->removeFromParent();
+                irrCube2equirectFilter_.reset();
+            }
+            irrCaptureTexture_.reset();
             for (size_t i = 0; i < irrGenFilters_.size(); ++i) {
                 irrGenFilters_[i]->removeFromParent();
                 irrGenFilters_[i].reset();
@@ -348,6 +389,11 @@ namespace af3d
 
         auto equirectSz0 = cubeSize2equirect(settings.lightProbe.specularResolution);
 
+        if (settings.lightProbe.compact) {
+            specularCaptureTexture_ = textureManager.createRenderTexture(TextureTypeCubeMap,
+                settings.lightProbe.specularResolution, settings.lightProbe.specularResolution, 0, GL_RGB16F, GL_RGB, GL_FLOAT, true);
+        }
+
         for (std::uint32_t mip = 0; mip < settings.lightProbe.specularMipLevels; ++mip) {
             float roughness = (float)mip / (float)(settings.lightProbe.specularMipLevels - 1);
 
@@ -361,11 +407,17 @@ namespace af3d
                 filter->camera()->setFov(btRadians(90.0f));
                 filter->camera()->setAspect(1.0f);
                 filter->camera()->setTransform(btTransform(textureCubeFaceBasis(face)));
-                filter->camera()->setRenderTarget(AttachmentPoint::Color0, RenderTarget(rt_.specularTexture, mip, face, rt_.index));
+                filter->camera()->setRenderTarget(AttachmentPoint::Color0, specularCaptureTexture_ ?
+                    RenderTarget(specularCaptureTexture_, mip, face) : RenderTarget(rt_.specularTexture, mip, face, rt_.index));
                 parent()->addComponent(filter);
                 specularGenFilters_.push_back(filter);
             }
 
+            if (specularCaptureTexture_) {
+                // Compressed straight from cube faces, no equirect needed.
+                continue;
+            }
+
             auto filter = std::make_shared<RenderFilterComponent>(MaterialTypeFilterCube2Equirect);
             filter->material()->setTextureBinding(SamplerName::Main,
                 TextureBinding(rt_.specularTexture,
@@ -389,7 +441,8 @@ namespace af3d
 
     void LightProbeComponent::stopSpecularGen()
     {
-        if (!specularCube2EquirectFilters_.empty()) {
+        if (!specularGenFilters_.empty()) {
+            specularCaptureTexture_.reset();
             if (specularLUTGenFilter_) {
                 specularLUTGenFilter_->removeFromParent();
                 specularLUTGenFilter_.reset();
@@ -405,6 +458,299 @@ namespace af3d
         }
     }
 
+    void LightProbeComponent::processIrradiance()
+    {
+        auto rb = irrReadback_;
+        irrReadback_.reset();
+
+        if (rb->data().empty()) {
+            LOG4CPLUS_WARN(logger(), "LightProbe(" << parent()->name() << "): irradiance readback lost");
+            checkDone();
+            return;
+        }
+
+        if (settings.lightProbe.compact) {
+            projectSH(rb->data(), rb->width());
+            hasSH_ = true;
+            dirty_ = true;
+            checkDone();
+            return;
+        }
+
+        std::string fname = platform->assetsPath() + "/" + getIrradianceTexName();
+
+        saveAsync([rb, fname]() {
+            std::ofstream os(fname,
+                std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+            ImageWriter writer(fname, os);
+            writer.writeHDR(rb->width(), rb->height(), 3, rb->data());
+        }, [this]() {
+            btAssert(!irrEquirect2cube_);
+            auto equirectTex = textureManager.loadTexture(getIrradianceTexName(), false);
+            equirectTex->invalidate();
+            equirectTex->load();
+            irrEquirect2cube_ = std::make_shared<Equirect2CubeComponent>(equirectTex, rt_.irradianceTexture, rt_.index, camOrderLightProbe);
+            parent()->addComponent(irrEquirect2cube_);
+        });
+    }
+
+    void LightProbeComponent::processSpecular()
+    {
+        std::vector<TextureReadbackPtr> rbs;
+        rbs.swap(specularReadbacks_);
+
+        for (const auto& rb : rbs) {
+            if (rb->data().empty()) {
+                LOG4CPLUS_WARN(logger(), "LightProbe(" << parent()->name() << "): specular readback lost");
+                checkDone();
+                return;
+            }
+        }
+
+        if (settings.lightProbe.compact) {
+            // BC6H encoding is slow, keep it off both main and render threads.
+            auto mips = std::make_shared<std::vector<std::vector<Byte>>>(rbs.size());
+
+            saveAsync([rbs, mips]() {
+                for (size_t mip = 0; mip < rbs.size(); ++mip) {
+                    const auto& rb = rbs[mip];
+                    auto facePixels = rb->width() * rb->height() * 3;
+                    auto faceSize = bc6hSize(rb->width(), rb->height());
+                    auto& data = (*mips)[mip];
+                    data.resize(faceSize * (TextureCubeFaceMax + 1));
+                    for (int i = 0; i <= TextureCubeFaceMax; ++i) {
+                        bc6hEncode(reinterpret_cast<const float*>(&rb->data()[0]) + i * facePixels,
+                            rb->width(), rb->height(), &data[0] + i * faceSize);
+                    }
+                }
+            }, [this, mips]() {
+                specularMips_.swap(*mips);
+
+                saveProbeFile();
+
+                reloadSpecular();
+            });
+            return;
+        }
+
+        std::string fname = platform->assetsPath() + "/" + getSpecularTexName();
+
+        saveAsync([rbs, fname]() {
+            // All mips stacked into a single equirect.
+            auto width = rbs[0]->width();
+            std::uint32_t numPixels = 0;
+            for (const auto& rb : rbs) {
+                numPixels += rb->width() * rb->height();
+            }
+            std::uint32_t height = (numPixels + width - 1) / width;
+
+            std::vector<Byte> pixels(width * height * 3 * sizeof(float), 0);
+            auto ptr = &pixels[0];
+            for (const auto& rb : rbs) {
+                std::memcpy(ptr, &rb->data()[0], rb->data().size());
+                ptr += rb->data().size();
+            }
+
+            std::ofstream os(fname,
+                std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+            ImageWriter writer(fname, os);
+            writer.writeHDR(width, height, 3, pixels);
+        }, [this]() {
+            btAssert(!specularEquirect2cube_);
+            auto equirectTex = textureManager.loadTexture(getSpecularTexName(), false);
+            equirectTex->invalidate();
+            equirectTex->load();
+            specularEquirect2cube_ = std::make_shared<Equirect2CubeComponent>(equirectTex, rt_.specularTexture, rt_.index, camOrderLightProbe, settings.lightProbe.specularMipLevels);
+            parent()->addComponent(specularEquirect2cube_);
+        });
+    }
+
+    void LightProbeComponent::processSpecularLUT()
+    {
+        auto rb = specularLUTReadback_;
+        specularLUTReadback_.reset();
+
+        if (rb->data().empty()) {
+            LOG4CPLUS_WARN(logger(), "LightProbe(" << parent()->name() << "): specular LUT readback lost");
+            checkDone();
+            return;
+        }
+
+        rb->data().resize(specularLUTSize * specularLUTSize * 3 * sizeof(float));
+
+        std::string fname = platform->assetsPath() + "/" + getSpecularLUTTexName();
+
+        saveAsync([rb, fname]() {
+            std::ofstream os(fname,
+                std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+            ImageWriter writer(fname, os);
+            writer.writeHDR(specularLUTSize, specularLUTSize, 3, rb->data());
+        }, [this]() {
+            specularLUTTexture_->invalidate();
+            specularLUTTexture_->load();
+        });
+    }
+
+    void LightProbeComponent::saveAsync(const std::function<void()>& fn, const std::function<void()>& doneFn)
+    {
+        ++pendingSaves_;
+
+        std::weak_ptr<LightProbeComponent> weakThis = shared_from_this();
+        auto bakeId = bakeId_;
+
+        scene()->saveLightProbeAsync(fn, [weakThis, bakeId, doneFn]() {
+            auto self = weakThis.lock();
+            if (!self || (self->bakeId_ != bakeId)) {
+                // Unregistered meanwhile.
+                return;
+            }
+            --self->pendingSaves_;
+            doneFn();
+            self->checkDone();
+        });
+    }
+
+    void LightProbeComponent::checkDone()
+    {
+        if (!baking()) {
+            LOG4CPLUS_INFO(logger(), "LightProbe(" << parent()->name() << "): done");
+        }
+    }
+
+    void LightProbeComponent::projectSH(const std::vector<Byte>& pixels, std::uint32_t size)
+    {
+        // Irradiance is already convolved, so it's a plain projection onto L2 basis. Each coefficient is
+        // multiplied by its basis constant once more, so that 'pbr.frag' only needs polynomials in N.
+        static const std::array<float, 9> basisConst = {
+            0.282095f, 0.488603f, 0.488603f, 0.488603f, 1.092548f, 1.092548f, 0.315392f, 1.092548f, 0.546274f
+        };
+
+        std::array<btVector3, 9> sums;
+        sums.fill(btVector3_zero);
+        float totalWeight = 0.0f;
+
+        const float* data = reinterpret_cast<const float*>(&pixels[0]);
+
+        for (int i = 0; i <= TextureCubeFaceMax; ++i) {
+            for (std::uint32_t y = 0; y < size; ++y) {
+                for (std::uint32_t x = 0; x < size; ++x, data += 3) {
+                    float sc = (x + 0.5f) / size * 2.0f - 1.0f;
+                    float tc = (y + 0.5f) / size * 2.0f - 1.0f;
+
+                    // Texel direction as per GL cube map face selection rules.
+                    btVector3 dir;
+                    switch (static_cast<TextureCubeFace>(i)) {
+                    case TextureCubeXN: dir = btVector3(-1.0f, -tc, sc); break;
+                    case TextureCubeYP: dir = btVector3(sc, 1.0f, tc); break;
+                    case TextureCubeYN: dir = btVector3(sc, -1.0f, -tc); break;
+                    case TextureCubeZP: dir = btVector3(sc, -tc, 1.0f); break;
+                    case TextureCubeZN: dir = btVector3(-sc, -tc, -1.0f); break;
+                    default: dir = btVector3(1.0f, -tc, -sc); break;
+                    }
+
+                    // Texel solid angle, up to a constant factor.
+                    float len = dir.length();
+                    float weight = 1.0f / (len * len * len);
+                    dir /= len;
+
+                    btVector3 color(data[0], data[1], data[2]);
+                    color *= weight;
+
+                    sums[0] += color;
+                    sums[1] += color * dir.y();
+                    sums[2] += color * dir.z();
+                    sums[3] += color * dir.x();
+                    sums[4] += color * (dir.x() * dir.y());
+                    sums[5] += color * (dir.y() * dir.z());
+                    sums[6] += color * (3.0f * dir.z() * dir.z() - 1.0f);
+                    sums[7] += color * (dir.x() * dir.z());
+                    sums[8] += color * (dir.x() * dir.x() - dir.y() * dir.y());
+
+                    totalWeight += weight;
+                }
+            }
+        }
+
+        // Weights must add up to full sphere.
+        float norm = 4.0f * SIMD_PI / totalWeight;
+
+        for (size_t i = 0; i < sh_.size(); ++i) {
+            sh_[i] = Vector4f(sums[i] * (basisConst[i] * basisConst[i] * norm), 0.0f);
+        }
+    }
+
+    bool LightProbeComponent::loadProbeFile()
+    {
+        PlatformIFStream is(getProbeFileName());
+
+        ProbeFileHeader hdr;
+        if (!is.read(reinterpret_cast<char*>(&hdr), sizeof(hdr))) {
+            return false;
+        }
+
+        if ((std::memcmp(hdr.magic, probeFileMagic, sizeof(probeFileMagic)) != 0) || (hdr.version != probeFileVersion)) {
+            LOG4CPLUS_ERROR(logger(), "LightProbe(" << parent()->name() << "): bad probe file " << getProbeFileName());
+            return false;
+        }
+
+        if ((hdr.specularFormat != static_cast<std::uint32_t>(compactSpecularFormat)) ||
+            (hdr.specularResolution != settings.lightProbe.specularResolution) ||
+            (hdr.specularMipLevels != settings.lightProbe.specularMipLevels)) {
+            LOG4CPLUS_WARN(logger(), "LightProbe(" << parent()->name() << "): probe file " << getProbeFileName() << " doesn't match settings, needs recreation");
+            return false;
+        }
+
+        std::vector<std::vector<Byte>> mips(hdr.specularMipLevels);
+        for (std::uint32_t mip = 0; mip < hdr.specularMipLevels; ++mip) {
+            auto sz = textureMipSize(hdr.specularResolution, mip);
+            mips[mip].resize(HardwareTexture::compressedSize(compactSpecularFormat, sz, sz) * (TextureCubeFaceMax + 1));
+            if (!is.read(reinterpret_cast<char*>(&mips[mip][0]), mips[mip].size())) {
+                LOG4CPLUS_ERROR(logger(), "LightProbe(" << parent()->name() << "): probe file " << getProbeFileName() << " is truncated");
+                return false;
+            }
+        }
+
+        for (size_t i = 0; i < sh_.size(); ++i) {
+            sh_[i] = Vector4f(hdr.sh[i][0], hdr.sh[i][1], hdr.sh[i][2], 0.0f);
+        }
+        hasSH_ = true;
+        specularMips_.swap(mips);
+
+        return true;
+    }
+
+    void LightProbeComponent::saveProbeFile()
+    {
+        auto hdr = std::make_shared<ProbeFileHeader>();
+        std::memcpy(hdr->magic, probeFileMagic, sizeof(probeFileMagic));
+        hdr->version = probeFileVersion;
+        hdr->specularFormat = compactSpecularFormat;
+        hdr->specularResolution = settings.lightProbe.specularResolution;
+        hdr->specularMipLevels = specularMips_.size();
+        for (size_t i = 0; i < sh_.size(); ++i) {
+            hdr->sh[i][0] = sh_[i].x();
+            hdr->sh[i][1] = sh_[i].y();
+            hdr->sh[i][2] = sh_[i].z();
+        }
+
+        auto mips = std::make_shared<std::vector<std::vector<Byte>>>(specularMips_);
+
+        std::string fname = platform->assetsPath() + "/" + getProbeFileName();
+
+        saveAsync([hdr, mips, fname]() {
+            std::ofstream os(fname,
+                std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+            os.write(reinterpret_cast<const char*>(hdr.get()), sizeof(*hdr));
+            for (const auto& data : *mips) {
+                os.write(reinterpret_cast<const char*>(&data[0]), data.size());
+            }
+
+            if (!os) {
+                LOG4CPLUS_ERROR(logger(), "LightProbe: cannot write " << fname);
+            }
+        }, []() {});
+    }
+
     std::string LightProbeComponent::getIrradianceTexName()
     {
         return "lp_" + scene()->name() + "_" + (isGlobal() ? "global" : parent()->name()) + "_irr.hdr";
@@ -420,6 +766,11 @@ namespace af3d
         return "lp_spec_lut.hdr";
     }
 
+    std::string LightProbeComponent::getProbeFileName()
+    {
+        return "lp_" + scene()->name() + "_" + (isGlobal() ? "global" : parent()->name()) + ".probe";
+    }
+
     void LightProbeComponent::renderBounds(RenderList& rl)
     {
         auto w = scene()->workspace();
@@ -32,6 +32,7 @@
 #include "RenderProxyComponent.h"
 #include "Equirect2CubeComponent.h"
 #include "Texture.h"
+#include "TextureReadback.h"
 #include "ShaderDataTypes.h"
 #include <boost/optional.hpp>
 
@@ -41,6 +42,9 @@ namespace af3d
         public PhasedComponent
     {
     public:
+        // Specular cube map format of compact probes.
+        static const GLint compactSpecularFormat = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+
         explicit LightProbeComponent(const boost::optional<AABB>& bounds = boost::optional<AABB>(), bool spherical = false,
             const Color& ambientColor = Color_one, const Color& specularColor = Color_zero);
         ~LightProbeComponent() = default;
@@ -55,18 +59,24 @@ namespace af3d
 
         bool recreate();
 
+        // Capture, readbacks or file saves still in progress.
+        bool baking() const;
+
         bool resetDirty();
 
         void setupCluster(ShaderClusterProbe& cProbe);
 
+        // Re-uploads baked specular of a compact probe, no-op otherwise.
+        void reloadSpecular();
+
         inline int index() const { return rt_.index; }
 
         inline bool isGlobal() const { return !bounds_; }
 
         inline const AABB& bounds() const { return bounds_ ? *bounds_ : AABB_empty; }
 
-        inline bool hasIrradiance() const { return !!irrEquirect2cube_; }
-        inline bool hasSpecular() const { return !!specularEquirect2cube_; }
+        inline bool hasIrradiance() const { return irrEquirect2cube_ || hasSH_; }
+        inline bool hasSpecular() const { return specularEquirect2cube_ || !specularMips_.empty(); }
         inline const TexturePtr& specularLUTTexture() const { return specularLUTTexture_; }
 
         inline const Color& ambientColor() const { return ambientColor_; }
@@ -88,12 +98,33 @@ namespace af3d
 
         void stopSpecularGen();
 
+        void processIrradiance();
+
+        void processSpecular();
+
+        void processSpecularLUT();
+
+        // Runs 'fn' on scene's light probe save thread, 'doneFn' runs back on main thread
+        // unless the probe got unregistered meanwhile.
+        void saveAsync(const std::function<void()>& fn, const std::function<void()>& doneFn);
+
+        void checkDone();
+
+        // Projects downloaded irradiance cube onto 'sh_'.
+        void projectSH(const std::vector<Byte>& pixels, std::uint32_t size);
+
+        bool loadProbeFile();
+
+        void saveProbeFile();
+
         std::string getIrradianceTexName();
 
         std::string getSpecularTexName();
 
         std::string getSpecularLUTTexName();
 
+        std::string getProbeFileName();
+
         void renderBounds(RenderList& rl);
 
         bool dirty_ = true;
@@ -118,6 +149,21 @@ namespace af3d
         Equirect2CubeComponentPtr irrEquirect2cube_;
         Equirect2CubeComponentPtr specularEquirect2cube_;
 
+        // Compact probes only, baking goes into these instead of probe cube map arrays.
+        TexturePtr irrCaptureTexture_;
+        TexturePtr specularCaptureTexture_;
+
+        bool hasSH_ = false;
+        std::array<Vector4f, 9> sh_;
+        std::vector<std::vector<Byte>> specularMips_; // Compressed, all faces of a mip one after another.
+
+        // Bake results are read back asynchronously, files get written on a separate thread.
+        TextureReadbackPtr irrReadback_;
+        std::vector<TextureReadbackPtr> specularReadbacks_;
+        TextureReadbackPtr specularLUTReadback_;
+        int pendingSaves_ = 0;
+        std::uint32_t bakeId_ = 0;
+
         RenderMeshComponentPtr markerRc_;
         RenderProxyComponentPtr boundsRc_;
     };
@@ -85,6 +85,11 @@ namespace af3d
         setUniformImpl(name, reinterpret_cast<const Byte*>(value.v), GL_FLOAT, 4, 1, quiet);
     }
 
+    void MaterialParams::setUniform(UniformName name, const std::vector<Vector4f>& value, bool quiet)
+    {
+        setUniformImpl(name, reinterpret_cast<const Byte*>(&value[0].v), GL_FLOAT, 4, value.size(), quiet);
+    }
+
     void MaterialParams::setUniform(UniformName name, const Matrix3f& value, bool quiet)
     {
         setUniformImpl(name, reinterpret_cast<const Byte*>(value.v), GL_FLOAT, 9, 1, quiet);
@@ -50,6 +50,7 @@ namespace af3d
         void setUniform(UniformName name, const std::vector<Vector3f>& value, bool quiet = false);
         void setUniform(UniformName name, const btVector3& value, bool quiet = false);
         void setUniform(UniformName name, const Vector4f& value, bool quiet = false);
+        void setUniform(UniformName name, const std::vector<Vector4f>& value, bool quiet = false);
         void setUniform(UniformName name, const Matrix3f& value, bool quiet = false);
         void setUniform(UniformName name, const Matrix4f& value, bool quiet = false);
 
@@ -138,10 +139,12 @@ namespace af3d
         explicit TextureBinding(const TexturePtr& tex,
             const SamplerParams& params = SamplerParams())
         : tex(tex),
-          params(params) {}
+          params(params),
+          samplerId(params.intern()) {}
 
         TexturePtr tex;
         SamplerParams params;
+        SamplerId samplerId = 0;
     };
 
     class Material;
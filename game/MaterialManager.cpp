@@ -74,7 +74,30 @@ namespace af3d
         {"shaders/filter.vert", "shaders/filter-ssao-blur.frag", nullptr, nullptr},
         {"shaders/prepass1.vert", nullptr, nullptr, "#define SHADOW 1\n"},
         {"shaders/prepass2.vert", nullptr, nullptr, "#define SHADOW 1\n"},
-        {"shaders/prepass-ws.vert", nullptr, nullptr, "#define SHADOW 1\n"}
+        {"shaders/prepass-ws.vert", nullptr, nullptr, "#define SHADOW 1\n"},
+        {nullptr, nullptr, "shaders/cluster-mark.comp", nullptr},
+        {nullptr, nullptr, "shaders/cluster-mark.comp", "#define MARK_FRONT 1\n"},
+        {nullptr, nullptr, "shaders/cluster-mark.comp", "#define MARK_ALL 1\n"},
+        {nullptr, nullptr, "shaders/bloom.comp", "#define DOWNSAMPLE 1\n#define PREFILTER 1\n"},
+        {nullptr, nullptr, "shaders/bloom.comp", "#define DOWNSAMPLE 1\n#define PREFILTER 1\n#define KARIS 1\n"},
+        {nullptr, nullptr, "shaders/bloom.comp", "#define DOWNSAMPLE 1\n"},
+        {nullptr, nullptr, "shaders/bloom.comp", "#define UPSAMPLE 1\n"},
+        {nullptr, nullptr, "shaders/ssao.comp", "#define SSAO_AO 1\n"},
+        {nullptr, nullptr, "shaders/ssao.comp", "#define SSAO_TEMPORAL 1\n"},
+        {nullptr, nullptr, "shaders/ssao.comp", "#define SSAO_UPSAMPLE 1\n"},
+        {nullptr, nullptr, "shaders/indirect-cull.comp", "#define RESET 1\n"},
+        {nullptr, nullptr, "shaders/indirect-cull.comp", nullptr},
+        {"shaders/prepass2.vert", "shaders/prepass.frag", nullptr, "#define INDIRECT 1\n"},
+        {"shaders/prepass2.vert", nullptr, nullptr, "#define SHADOW 1\n#define INDIRECT 1\n"},
+        {"shaders/basic.vert", "shaders/basic.frag", nullptr, "#define INDIRECT 1\n"},
+        {"shaders/basic.vert", "shaders/basic.frag", nullptr, "#define NM 1\n#define INDIRECT 1\n"},
+        {"shaders/basic.vert", "shaders/pbr.frag", nullptr, "#define INDIRECT 1\n"},
+        {"shaders/basic.vert", "shaders/pbr.frag", nullptr, "#define NM 1\n#define INDIRECT 1\n"},
+        {"shaders/basic.vert", "shaders/pbr.frag", nullptr, "#define FAST 1\n#define INDIRECT 1\n"},
+        {"shaders/basic.vert", "shaders/pbr.frag", nullptr, "#define FAST 1\n#define NM 1\n#define INDIRECT 1\n"},
+        {nullptr, nullptr, "shaders/indirect-cull.comp", "#define OCCLUSION 1\n"},
+        {nullptr, nullptr, "shaders/hiz.comp", "#define BUILD 1\n"},
+        {nullptr, nullptr, "shaders/hiz.comp", nullptr}
     };
 
     MaterialManager materialManager;
@@ -99,9 +122,14 @@ namespace af3d
         glslCommonHeader_ += "#define CLUSTER_CULL_X " + std::to_string(settings.cluster.gridSize.x() / settings.cluster.cullNumGroups.x()) + "\n";
         glslCommonHeader_ += "#define CLUSTER_CULL_Y " + std::to_string(settings.cluster.gridSize.y() / settings.cluster.cullNumGroups.y()) + "\n";
         glslCommonHeader_ += "#define CLUSTER_CULL_Z " + std::to_string(settings.cluster.gridSize.z() / settings.cluster.cullNumGroups.z()) + "\n";
+        glslCommonHeader_ += "#define CLUSTER_MAX_LIGHTS " + std::to_string(settings.cluster.maxLights) + "\n";
+        glslCommonHeader_ += "#define CLUSTER_MAX_LIGHTS_PER_TILE " + std::to_string(settings.cluster.maxLightsPerTile) + "\n";
         glslCommonHeader_ += "#define SPECULAR_CM_LEVELS " + std::to_string(settings.lightProbe.specularMipLevels - 1) + "\n";
         glslCommonHeader_ += "#define MAX_IMM_CAMERAS " + std::to_string(settings.maxImmCameras) + "\n";
         glslCommonHeader_ += "#define CSM_NUM_SPLITS " + std::to_string(settings.csm.numSplits) + "\n";
+        if (settings.lightProbe.compact) {
+            glslCommonHeader_ += "#define PROBE_SH 1\n";
+        }
         glslCommonHeader_ += "#line 1\n";
 
         for (int i = MaterialTypeFirst; i <= MaterialTypeMax; ++i) {
@@ -125,12 +153,17 @@ namespace af3d
         matOutlineHovered_.reset();
         matOutlineSelected_.reset();
         matClusterCull_.reset();
+        matClusterMarkAll_.reset();
         matPrepassWS_.reset();
         matPrepass_[0].reset();
         matPrepass_[1].reset();
         matShadowWS_.reset();
         matShadow_[0].reset();
         matShadow_[1].reset();
+        matIndirectReset_.reset();
+        matIndirectCull_.reset();
+        matPrepassIndirect_.reset();
+        matShadowIndirect_.reset();
 
         runtime_assert(immediateMaterials_.empty());
         cachedMaterials_.clear();
@@ -209,6 +242,17 @@ namespace af3d
                     }
                 }
 
+                if (settings.bindlessTextures && materialTypeBindless(mat->name()) && !fragSource.empty()) {
+                    // Render target samplers stay on texture units, these get re-specified on resize.
+                    HardwareProgram::Samplers bindlessSamplers;
+                    for (auto sName : {SamplerName::Main, SamplerName::Normal, SamplerName::Specular,
+                        SamplerName::Roughness, SamplerName::Metalness, SamplerName::AO, SamplerName::Emissive}) {
+                        bindlessSamplers.set(sName);
+                    }
+                    mat->prog()->setBindlessSamplers(bindlessSamplers);
+                    fragSource = "#extension GL_ARB_bindless_texture : require\n#define BINDLESS 1\n" + fragSource;
+                }
+
                 vertSource = glslCommonHeader_ + vertSource;
                 if (!fragSource.empty()) {
                     fragSource = glslCommonHeader_ + fragSource;
@@ -278,6 +322,7 @@ namespace af3d
             matOutlineSelected_->setBlendingParams(BlendingParams(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 
             matClusterCull_ = createMaterial(MaterialTypeClusterCull);
+            matClusterMarkAll_ = createMaterial(MaterialTypeClusterMarkAll);
 
             matPrepassWS_ = createMaterial(MaterialTypePrepassWS);
             matPrepass_[0] = createMaterial(MaterialTypePrepass1);
@@ -286,6 +331,11 @@ namespace af3d
             matShadowWS_ = createMaterial(MaterialTypeShadowWS);
             matShadow_[0] = createMaterial(MaterialTypeShadow1);
             matShadow_[1] = createMaterial(MaterialTypeShadow2);
+
+            matIndirectReset_ = createMaterial(MaterialTypeIndirectReset);
+            matIndirectCull_ = createMaterial(MaterialTypeIndirectCull);
+            matPrepassIndirect_ = createMaterial(MaterialTypePrepassIndirect);
+            matShadowIndirect_ = createMaterial(MaterialTypeShadowIndirect);
         }
 
         return true;
@@ -67,10 +67,15 @@ namespace af3d
         inline const MaterialPtr& matOutlineHovered() const { return matOutlineHovered_; }
         inline const MaterialPtr& matOutlineSelected() const { return matOutlineSelected_; }
         inline const MaterialPtr& matClusterCull() const { return matClusterCull_; }
+        inline const MaterialPtr& matClusterMarkAll() const { return matClusterMarkAll_; }
         inline const MaterialPtr& matPrepassWS() const { return matPrepassWS_; }
         inline const MaterialPtr& matPrepass(int i) const { return matPrepass_[i]; }
         inline const MaterialPtr& matShadowWS() const { return matShadowWS_; }
         inline const MaterialPtr& matShadow(int i) const { return matShadow_[i]; }
+        inline const MaterialPtr& matIndirectReset() const { return matIndirectReset_; }
+        inline const MaterialPtr& matIndirectCull() const { return matIndirectCull_; }
+        inline const MaterialPtr& matPrepassIndirect() const { return matPrepassIndirect_; }
+        inline const MaterialPtr& matShadowIndirect() const { return matShadowIndirect_; }
 
     private:
         using MaterialTypes = std::array<MaterialTypePtr, MaterialTypeMax + 1>;
@@ -89,10 +94,15 @@ namespace af3d
         MaterialPtr matOutlineHovered_;
         MaterialPtr matOutlineSelected_;
         MaterialPtr matClusterCull_;
+        MaterialPtr matClusterMarkAll_;
         MaterialPtr matPrepassWS_;
         MaterialPtr matPrepass_[2];
         MaterialPtr matShadowWS_;
         MaterialPtr matShadow_[2];
+        MaterialPtr matIndirectReset_;
+        MaterialPtr matIndirectCull_;
+        MaterialPtr matPrepassIndirect_;
+        MaterialPtr matShadowIndirect_;
     };
 
     extern MaterialManager materialManager;
@@ -67,6 +67,29 @@ namespace af3d
             "Shadow1",
             "Shadow2",
             "ShadowWS",
+            "ClusterMark",
+            "ClusterMarkFront",
+            "ClusterMarkAll",
+            "BloomPrefilter",
+            "BloomPrefilterKaris",
+            "BloomDownsample",
+            "BloomUpsample",
+            "SSAOCompute",
+            "SSAOTemporal",
+            "SSAOUpsample",
+            "IndirectReset",
+            "IndirectCull",
+            "PrepassIndirect",
+            "ShadowIndirect",
+            "BasicIndirect",
+            "BasicNMIndirect",
+            "PBRIndirect",
+            "PBRNMIndirect",
+            "FastPBRIndirect",
+            "FastPBRNMIndirect",
+            "IndirectCullOcclusion",
+            "HiZBuild",
+            "HiZDownsample",
         }
     };
 
@@ -79,6 +102,32 @@ namespace af3d
             return MaterialTypePBRNM;
         case MaterialTypeFastPBR:
             return MaterialTypeFastPBRNM;
+        case MaterialTypeBasicIndirect:
+            return MaterialTypeBasicNMIndirect;
+        case MaterialTypePBRIndirect:
+            return MaterialTypePBRNMIndirect;
+        case MaterialTypeFastPBRIndirect:
+            return MaterialTypeFastPBRNMIndirect;
+        default:
+            return matTypeName;
+        }
+    }
+
+    MaterialTypeName materialTypeIndirect(MaterialTypeName matTypeName)
+    {
+        switch (matTypeName) {
+        case MaterialTypeBasic:
+            return MaterialTypeBasicIndirect;
+        case MaterialTypeBasicNM:
+            return MaterialTypeBasicNMIndirect;
+        case MaterialTypePBR:
+            return MaterialTypePBRIndirect;
+        case MaterialTypePBRNM:
+            return MaterialTypePBRNMIndirect;
+        case MaterialTypeFastPBR:
+            return MaterialTypeFastPBRIndirect;
+        case MaterialTypeFastPBRNM:
+            return MaterialTypeFastPBRNMIndirect;
         default:
             return matTypeName;
         }
@@ -90,6 +139,30 @@ namespace af3d
         case MaterialTypeBasicNM:
         case MaterialTypePBRNM:
         case MaterialTypeFastPBRNM:
+        case MaterialTypeBasicNMIndirect:
+        case MaterialTypePBRNMIndirect:
+        case MaterialTypeFastPBRNMIndirect:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool materialTypeBindless(MaterialTypeName matTypeName)
+    {
+        switch (matTypeName) {
+        case MaterialTypeBasic:
+        case MaterialTypeBasicNM:
+        case MaterialTypePBR:
+        case MaterialTypePBRNM:
+        case MaterialTypeFastPBR:
+        case MaterialTypeFastPBRNM:
+        case MaterialTypeBasicIndirect:
+        case MaterialTypeBasicNMIndirect:
+        case MaterialTypePBRIndirect:
+        case MaterialTypePBRNMIndirect:
+        case MaterialTypeFastPBRIndirect:
+        case MaterialTypeFastPBRNMIndirect:
             return true;
         default:
             return false;
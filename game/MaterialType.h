@@ -75,14 +75,43 @@ namespace af3d
         MaterialTypeShadow1 = 33,
         MaterialTypeShadow2 = 34,
         MaterialTypeShadowWS = 35,
+        MaterialTypeClusterMark = 36,      // Marks clusters occupied by depth prepass samples.
+        MaterialTypeClusterMarkFront = 37, // Same as above, but also marks all clusters in front of the samples.
+        MaterialTypeClusterMarkAll = 38,   // Marks all clusters, used when there's no depth prepass.
+        MaterialTypeBloomPrefilter = 39,      // Compute bloom, thresholded 13-tap downsample of the scene into mip 0.
+        MaterialTypeBloomPrefilterKaris = 40, // Same as above, with Karis average against fireflies.
+        MaterialTypeBloomDownsample = 41,     // Compute bloom, 13-tap downsample into the next mip.
+        MaterialTypeBloomUpsample = 42,       // Compute bloom, tent upsample added to the previous mip.
+        MaterialTypeSSAOCompute = 43,         // Compute SSAO, half resolution AO and linear depth.
+        MaterialTypeSSAOTemporal = 44,        // Compute SSAO, reprojected accumulation into the history.
+        MaterialTypeSSAOUpsample = 45,        // Compute SSAO, depth-aware upsample to full resolution.
+        MaterialTypeIndirectReset = 46,       // GPU culling, clears per-camera draw command instance counts.
+        MaterialTypeIndirectCull = 47,        // GPU culling, frustum test per instance, appends to draw commands.
+        MaterialTypePrepassIndirect = 48,     // Indirect variants below read model matrices from instance SSBO.
+        MaterialTypeShadowIndirect = 49,
+        MaterialTypeBasicIndirect = 50,
+        MaterialTypeBasicNMIndirect = 51,
+        MaterialTypePBRIndirect = 52,
+        MaterialTypePBRNMIndirect = 53,
+        MaterialTypeFastPBRIndirect = 54,
+        MaterialTypeFastPBRNMIndirect = 55,
+        MaterialTypeIndirectCullOcclusion = 56, // GPU culling, frustum and Hi-Z occlusion test per instance.
+        MaterialTypeHiZBuild = 57,            // Hi-Z, max depth of 2x2 depth buffer texels into mip 0.
+        MaterialTypeHiZDownsample = 58,       // Hi-Z, max of 2x2 texels into the next mip.
         MaterialTypeFirst = MaterialTypeBasic,
-        MaterialTypeMax = MaterialTypeShadowWS
+        MaterialTypeMax = MaterialTypeHiZDownsample
     };
 
     MaterialTypeName materialTypeWithNM(MaterialTypeName matTypeName);
 
+    // Returns 'matTypeName' if there's no indirect draw variant.
+    MaterialTypeName materialTypeIndirect(MaterialTypeName matTypeName);
+
     bool materialTypeHasNM(MaterialTypeName matTypeName);
 
+    // Lit types, material samplers of these use bindless handles when 'settings.bindlessTextures' is on.
+    bool materialTypeBindless(MaterialTypeName matTypeName);
+
     extern const APropertyTypeEnumImpl<MaterialTypeName, MaterialTypeMax + 1> APropertyType_MaterialTypeName;
 
     class MaterialType : boost::noncopyable
@@ -35,21 +35,80 @@ namespace af3d
     ACLASS_DEFINE_END(Mesh)
 
     SubMeshData::SubMeshData()
-    : loaded_(false)
+    : loaded_(false),
+      bvhBuilt_(false)
     {
     }
 
     void SubMeshData::invalidate()
     {
+        std::lock_guard<std::mutex> lock(bvhMutex_);
+        bvhBuilt_ = false;
+        bvh_.clear();
         loaded_ = false;
         vertices_.clear();
         faces_.clear();
     }
 
+    bool SubMeshData::testRay(const Ray& ray, float maxDist, MeshRayHit& hit)
+    {
+        if (!bvhBuilt_) {
+            buildBVH();
+        }
+
+        bool res = false;
+
+        bvh_.traverse([&ray, &maxDist](const AABB& aabb) {
+            if (aabb.contains(ray.pos)) {
+                return true;
+            }
+            auto r = ray.testAABB(aabb);
+            return r.first && (r.second < maxDist);
+        }, [this, &ray, &maxDist, &hit, &res](int idx) {
+            const auto& f = faces_[idx];
+            float t, u, v;
+            if (ray.testTriangle(fromVector3f(vertices_[f.x()]), fromVector3f(vertices_[f.y()]),
+                fromVector3f(vertices_[f.z()]), t, u, v) && (t < maxDist)) {
+                maxDist = t;
+                hit.dist = t;
+                hit.faceIdx = idx;
+                hit.barycentric.setValue(1.0f - u - v, u, v);
+                res = true;
+            }
+        });
+
+        return res;
+    }
+
+    void SubMeshData::buildBVH()
+    {
+        std::lock_guard<std::mutex> lock(bvhMutex_);
+        if (bvhBuilt_) {
+            return;
+        }
+
+        std::vector<AABB> aabbs;
+        aabbs.reserve(faces_.size());
+        for (const auto& f : faces_) {
+            AABB aabb(fromVector3f(vertices_[f.x()]), fromVector3f(vertices_[f.x()]));
+            aabb.combine(fromVector3f(vertices_[f.y()]));
+            aabb.combine(fromVector3f(vertices_[f.z()]));
+            aabbs.push_back(aabb);
+        }
+
+        bvh_.build(aabbs);
+        bvhBuilt_ = true;
+    }
+
     void SubMeshData::load(const VertexArraySlice& vaSlice)
     {
         bool old = false;
         if (loaded_.compare_exchange_strong(old, true)) {
+            const auto& data = vaSlice.va()->data();
+            if (data) {
+                loadFromData(vaSlice, *data);
+                return;
+            }
             renderer.scheduleHwOpSync([this, &vaSlice](HardwareContext& ctx) {
                 const auto& entries = vaSlice.va()->layout().entries();
                 for (const auto& entry : entries) {
@@ -113,6 +172,43 @@ namespace af3d
         }
     }
 
+    void SubMeshData::loadFromData(const VertexArraySlice& vaSlice, const VertexArrayData& data)
+    {
+        const auto& positions = *data.positions;
+
+        int minIdx = (std::numeric_limits<int>::max)();
+        int maxIdx = 0;
+
+        if (!data.indices.empty()) {
+            std::uint32_t cnt = vaSlice.count() ? vaSlice.count() : (data.indices.size() - vaSlice.start());
+            const std::uint32_t* indices = &data.indices[vaSlice.start()];
+            faces_.reserve(cnt / 3);
+            for (std::uint32_t i = 0; i < cnt; i += 3) {
+                faces_.emplace_back(vaSlice.baseVertex() + indices[i],
+                    vaSlice.baseVertex() + indices[i + 1],
+                    vaSlice.baseVertex() + indices[i + 2]);
+                minIdx = btMin(minIdx, btMin(faces_.back().x(), btMin(faces_.back().y(), faces_.back().z())));
+                maxIdx = btMax(maxIdx, btMax(faces_.back().x(), btMax(faces_.back().y(), faces_.back().z())));
+            }
+            for (auto& face : faces_) {
+                face.setValue(face.x() - minIdx,
+                    face.y() - minIdx,
+                    face.z() - minIdx);
+            }
+        } else {
+            minIdx = vaSlice.start();
+            maxIdx = vaSlice.count() ? (vaSlice.start() + vaSlice.count()) : positions.size();
+            --maxIdx;
+            for (int i = 0; i < (maxIdx - minIdx + 1); i += 3) {
+                faces_.emplace_back(i, i + 1, i + 2);
+            }
+        }
+
+        if (minIdx <= maxIdx) {
+            vertices_.assign(positions.begin() + minIdx, positions.begin() + maxIdx + 1);
+        }
+    }
+
     Mesh::Mesh(MeshManager* mgr,
         const std::string& name,
         const AABB& aabb,
@@ -176,4 +272,22 @@ namespace af3d
         subMeshesData_[idx]->load(subMeshes_[idx]->vaSlice());
         return subMeshesData_[idx];
     }
+
+    bool Mesh::testRay(const Ray& ray, MeshRayHit& hit)
+    {
+        bool res = false;
+        float maxDist = (std::numeric_limits<float>::max)();
+
+        for (int i = 0; i < static_cast<int>(subMeshes_.size()); ++i) {
+            MeshRayHit tmp;
+            if (getSubMeshData(i)->testRay(ray, maxDist, tmp)) {
+                maxDist = tmp.dist;
+                hit = tmp;
+                hit.subMeshIdx = i;
+                res = true;
+            }
+        }
+
+        return res;
+    }
 }
@@ -29,6 +29,9 @@
 #include "Resource.h"
 #include "SubMesh.h"
 #include "af3d/AABB.h"
+#include "af3d/BVH.h"
+#include "af3d/Ray.h"
+#include <mutex>
 
 namespace af3d
 {
@@ -37,6 +40,15 @@ namespace af3d
 
     using MeshPtr = std::shared_ptr<Mesh>;
 
+    struct MeshRayHit
+    {
+        float dist = 0.0f;
+        int subMeshIdx = -1;
+        int faceIdx = -1;
+        // Barycentrics of hit point relative to face vertices.
+        btVector3 barycentric = btVector3_zero;
+    };
+
     class SubMeshData : boost::noncopyable
     {
     public:
@@ -45,16 +57,31 @@ namespace af3d
 
         void invalidate();
 
+        // Uses VA's CPU-side data if present, reads geometry back from GPU otherwise.
         void load(const VertexArraySlice& vaSlice);
 
         inline const std::vector<Vector3f>& vertices() const { return vertices_; }
 
         inline const std::vector<TriFace>& faces() const { return faces_; }
 
+        /*
+         * Exact ray vs. triangles test in model space, 'load' must be called first.
+         * Triangle BVH is built on first call and shared by all mesh instances.
+         */
+        bool testRay(const Ray& ray, float maxDist, MeshRayHit& hit);
+
     private:
+        void buildBVH();
+
+        void loadFromData(const VertexArraySlice& vaSlice, const VertexArrayData& data);
+
         std::atomic<bool> loaded_;
         std::vector<Vector3f> vertices_;
         std::vector<TriFace> faces_;
+
+        std::mutex bvhMutex_;
+        std::atomic<bool> bvhBuilt_;
+        BVH bvh_;
     };
 
     using SubMeshDataPtr = std::shared_ptr<SubMeshData>;
@@ -93,6 +120,9 @@ namespace af3d
 
         SubMeshDataPtr getSubMeshData(int idx);
 
+        // 'ray' is in model space, returns closest hit among all submeshes.
+        bool testRay(const Ray& ray, MeshRayHit& hit);
+
     private:
         MeshManager* mgr_;
         AABB aabb_;
@@ -28,6 +28,7 @@
 #include "HardwareResourceManager.h"
 #include "Logger.h"
 #include "Platform.h"
+#include "Settings.h"
 #include "AssimpIOSystem.h"
 #include "af3d/Assert.h"
 #include <cstring>
@@ -49,12 +50,26 @@ namespace af3d
     {
         LOG4CPLUS_DEBUG(logger(), "meshManager: init...");
         importer_.SetIOHandler(new AssimpIOSystem());
+        importStop_ = false;
+        for (std::uint32_t i = 0; i < (std::max)(settings.mesh.importThreads, 1U); ++i) {
+            importThreads_.emplace_back(&MeshManager::importThreadFn, this);
+        }
         return true;
     }
 
     void MeshManager::shutdown()
     {
         LOG4CPLUS_DEBUG(logger(), "meshManager: shutdown...");
+        {
+            std::lock_guard<std::mutex> lock(importMtx_);
+            importStop_ = true;
+            importQueue_.clear();
+        }
+        importCond_.notify_all();
+        for (auto& t : importThreads_) {
+            t.join();
+        }
+        importThreads_.clear();
         runtime_assert(immediateMeshes_.empty());
         cachedMeshes_.clear();
     }
@@ -237,6 +252,38 @@ namespace af3d
         immediateMeshes_.erase(mesh);
     }
 
+    void MeshManager::importAsync(const ImportFn& fn)
+    {
+        {
+            std::lock_guard<std::mutex> lock(importMtx_);
+            if (importStop_) {
+                return;
+            }
+            importQueue_.push_back(fn);
+        }
+        importCond_.notify_one();
+    }
+
+    void MeshManager::importThreadFn()
+    {
+        Assimp::Importer importer;
+        importer.SetIOHandler(new AssimpIOSystem());
+
+        while (true) {
+            ImportFn fn;
+            {
+                std::unique_lock<std::mutex> lock(importMtx_);
+                importCond_.wait(lock, [this]() { return importStop_ || !importQueue_.empty(); });
+                if (importStop_) {
+                    return;
+                }
+                fn = std::move(importQueue_.front());
+                importQueue_.pop_front();
+            }
+            fn(importer);
+        }
+    }
+
     void MeshManager::processAssimpNode(const AssimpNodePtr& node, const std::string& parentPath, ModelNode& modelNode)
     {
         auto mesh = std::make_shared<Mesh>(this, parentPath + node->name, node->aabb, node->subMeshes);
@@ -32,6 +32,9 @@
 #include "af3d/Single.h"
 #include <unordered_map>
 #include <unordered_set>
+#include <condition_variable>
+#include <deque>
+#include <thread>
 
 namespace af3d
 {
@@ -45,6 +48,8 @@ namespace af3d
             std::vector<ModelNode> children;
         };
 
+        using ImportFn = std::function<void(Assimp::Importer&)>;
+
         MeshManager() = default;
         ~MeshManager();
 
@@ -78,6 +83,9 @@ namespace af3d
 
         void onMeshDestroy(Mesh* mesh);
 
+        // Runs 'fn' on one of the import threads, each one has its own importer.
+        void importAsync(const ImportFn& fn);
+
     private:
         using CachedModels = std::unordered_map<std::string, ModelNode>;
         using CachedMeshes = std::unordered_map<std::string, MeshPtr>;
@@ -85,11 +93,19 @@ namespace af3d
 
         void processAssimpNode(const AssimpNodePtr& node, const std::string& parentPath, ModelNode& modelNode);
 
+        void importThreadFn();
+
         CachedModels cachedModels_;
         CachedMeshes cachedMeshes_;
         ImmediateMeshes immediateMeshes_;
 
         Assimp::Importer importer_;
+
+        std::vector<std::thread> importThreads_;
+        std::mutex importMtx_;
+        std::condition_variable importCond_;
+        std::deque<ImportFn> importQueue_;
+        bool importStop_ = false;
     };
 
     extern MeshManager meshManager;
@@ -24,6 +24,7 @@
  */
 
 #include "MotionState.h"
+#include "SceneObject.h"
 
 namespace af3d
 {
@@ -40,6 +41,14 @@ namespace af3d
 
     void MotionState::setWorldTransform(const btTransform& worldTrans)
     {
-        smoothXf = worldTrans * centerOfMassXf.inverse();
+        btTransform xf = worldTrans * centerOfMassXf.inverse();
+        if (xf == smoothXf) {
+            // Sleeping bodies get synced every step too, don't mark them.
+            return;
+        }
+        smoothXf = xf;
+        if (owner) {
+            owner->markTransformDirty();
+        }
     }
 }
@@ -31,6 +31,8 @@
 
 namespace af3d
 {
+    class SceneObject;
+
     class MotionState : public btMotionState
     {
     public:
@@ -43,6 +45,8 @@ namespace af3d
 
         btTransform centerOfMassXf;
         btTransform smoothXf;
+
+        SceneObject* owner = nullptr;
     };
 }
 
@@ -116,6 +116,18 @@ namespace af3d
             GLenum format,
             GLenum type,
             const void* data);
+        void (GLAPIENTRY* CompressedTexSubImage3D)(GLenum target,
+            GLint level,
+            GLint xoffset,
+            GLint yoffset,
+            GLint zoffset,
+            GLsizei width,
+            GLsizei height,
+            GLsizei depth,
+            GLenum format,
+            GLsizei imageSize,
+            const void* data);
+        void (GLAPIENTRY* GetCompressedTexImage)(GLenum target, GLint level, void* img);
         void (GLAPIENTRY* TexParameteri)(GLenum target, GLenum pname, GLint param);
         void (GLAPIENTRY* ClearColor)(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
         void (GLAPIENTRY* Clear)(GLbitfield mask);
@@ -184,6 +196,25 @@ namespace af3d
         void (GLAPIENTRY* BindBufferBase)(GLenum target, GLuint index, GLuint buffer);
         void (GLAPIENTRY* DispatchCompute)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
         void (GLAPIENTRY* MemoryBarrier)(GLbitfield barriers);
+        void (GLAPIENTRY* BindImageTexture)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+        void (GLAPIENTRY* VertexAttribIPointer)(GLuint index, GLint size, GLenum type, GLsizei stride, const GLvoid* pointer);
+        void (GLAPIENTRY* VertexAttribDivisor)(GLuint index, GLuint divisor);
+        void (GLAPIENTRY* MultiDrawElementsIndirect)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+        void (GLAPIENTRY* GenQueries)(GLsizei n, GLuint* ids);
+        void (GLAPIENTRY* DeleteQueries)(GLsizei n, const GLuint* ids);
+        void (GLAPIENTRY* BeginQuery)(GLenum target, GLuint id);
+        void (GLAPIENTRY* EndQuery)(GLenum target);
+        void (GLAPIENTRY* GetQueryObjectiv)(GLuint id, GLenum pname, GLint* params);
+        void (GLAPIENTRY* GetQueryObjectui64v)(GLuint id, GLenum pname, GLuint64* params);
+        GLsync (GLAPIENTRY* FenceSync)(GLenum condition, GLbitfield flags);
+        GLenum (GLAPIENTRY* ClientWaitSync)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+        void (GLAPIENTRY* DeleteSync)(GLsync sync);
+
+        // GL_ARB_bindless_texture, optional, null when not supported.
+        GLuint64 (GLAPIENTRY* GetTextureSamplerHandleARB)(GLuint texture, GLuint sampler);
+        void (GLAPIENTRY* MakeTextureHandleResidentARB)(GLuint64 handle);
+        void (GLAPIENTRY* MakeTextureHandleNonResidentARB)(GLuint64 handle);
+        void (GLAPIENTRY* UniformHandleui64ARB)(GLint location, GLuint64 value);
     };
 
     extern OGL ogl;
@@ -68,7 +68,7 @@ namespace af3d
             const btVector3& p2_;
             const RayCastFn& fn_;
         };
-    };
+    }
 
     PhysicsComponentManager::CollisionDispatcher::CollisionDispatcher(CollisionComponentManager* collisionMgr,
         btCollisionConfiguration* collisionConfiguration)
@@ -77,6 +77,13 @@ namespace af3d
     {
     }
 
+    btPersistentManifold* PhysicsComponentManager::CollisionDispatcher::getNewManifold(const btCollisionObject* b0, const btCollisionObject* b1)
+    {
+        auto manifold = btCollisionDispatcher::getNewManifold(b0, b1);
+        collisionMgr_->adoptManifold(manifold);
+        return manifold;
+    }
+
     void PhysicsComponentManager::CollisionDispatcher::releaseManifold(btPersistentManifold* manifold)
     {
         collisionMgr_->endContact(manifold);
@@ -122,6 +129,10 @@ namespace af3d
 
         world_.getPairCache()->setOverlapFilterCallback(filterCallback);
 
+        for (std::uint32_t i = 0; i < settings.physics.queryThreads; ++i) {
+            queryThreads_.emplace_back(&PhysicsComponentManager::queryThreadFn, this);
+        }
+
         //world_.getSolverInfo().m_numIterations = 10;
     }
 
@@ -129,6 +140,7 @@ namespace af3d
     {
         btAssert(components_.empty());
         btAssert(frozenComponents_.empty());
+        btAssert(queryThreads_.empty());
     }
 
     PhysicsComponentManager* PhysicsComponentManager::fromWorld(btDynamicsWorld* world)
@@ -140,6 +152,17 @@ namespace af3d
     {
         btAssert(components_.empty());
         btAssert(frozenComponents_.empty());
+
+        {
+            std::lock_guard<std::mutex> lock(queryMtx_);
+            btAssert(queryQueue_.empty());
+            queryStop_ = true;
+        }
+        queryCond_.notify_all();
+        for (auto& t : queryThreads_) {
+            t.join();
+        }
+        queryThreads_.clear();
     }
 
     void PhysicsComponentManager::addComponent(const ComponentPtr& component)
@@ -198,4 +221,89 @@ namespace af3d
         cb.m_flags |= btTriangleRaycastCallback::kF_UseGjkConvexCastRaytest;
         world_.rayTest(p1, p2, cb);
     }
+
+    template <class Fn>
+    void PhysicsComponentManager::runBatch(std::size_t numQueries, const Fn& fn) const
+    {
+        std::size_t numWorkers = std::min<std::size_t>(queryThreads_.size(),
+            numQueries / std::max<std::size_t>(settings.physics.queryThreadMinBatch, 1));
+        std::size_t chunk = (numQueries + numWorkers) / (numWorkers + 1);
+
+        std::size_t pending = 0;
+
+        if (numWorkers > 0) {
+            {
+                std::lock_guard<std::mutex> lock(queryMtx_);
+                for (std::size_t i = 1; i <= numWorkers; ++i) {
+                    std::size_t begin = i * chunk;
+                    std::size_t end = std::min(begin + chunk, numQueries);
+                    if (begin >= end) {
+                        break;
+                    }
+                    queryQueue_.push_back(QueryTask{[&fn, begin, end](PhysicsQueryStack& stack) {
+                        fn(begin, end, stack);
+                    }, &pending});
+                    ++pending;
+                }
+            }
+            queryCond_.notify_all();
+        }
+
+        PhysicsQueryStack stack;
+        fn(0, std::min(chunk, numQueries), stack);
+
+        if (numWorkers > 0) {
+            std::unique_lock<std::mutex> lock(queryMtx_);
+            queryDoneCond_.wait(lock, [&pending]() { return pending == 0; });
+        }
+    }
+
+    void PhysicsComponentManager::queryThreadFn()
+    {
+        PhysicsQueryStack stack;
+
+        while (true) {
+            QueryTask task;
+            {
+                std::unique_lock<std::mutex> lock(queryMtx_);
+                queryCond_.wait(lock, [this]() { return queryStop_ || !queryQueue_.empty(); });
+                if (queryStop_) {
+                    return;
+                }
+                task = std::move(queryQueue_.front());
+                queryQueue_.pop_front();
+            }
+            task.fn(stack);
+            {
+                std::lock_guard<std::mutex> lock(queryMtx_);
+                --*task.pending;
+            }
+            queryDoneCond_.notify_all();
+        }
+    }
+
+    void PhysicsComponentManager::rayCastBatch(const std::vector<RayCastQuery>& queries, std::vector<QueryHit>& hits,
+        const btCollisionObject* ignore) const
+    {
+        hits.assign(queries.size(), QueryHit());
+
+        runBatch(queries.size(), [this, &queries, &hits, ignore](std::size_t begin, std::size_t end, PhysicsQueryStack& stack) {
+            for (auto i = begin; i < end; ++i) {
+                rayCastQuery(broadphase_, queries[i], hits[i], ignore, stack);
+            }
+        });
+    }
+
+    void PhysicsComponentManager::sweepBatch(const btConvexShape* shape, const std::vector<SweepQuery>& queries, std::vector<QueryHit>& hits,
+        const btCollisionObject* ignore) const
+    {
+        hits.assign(queries.size(), QueryHit());
+
+        runBatch(queries.size(), [this, shape, &queries, &hits, ignore](std::size_t begin, std::size_t end, PhysicsQueryStack& stack) {
+            for (auto i = begin; i < end; ++i) {
+                sweepQuery(broadphase_, shape, queries[i], hits[i], ignore, stack);
+            }
+        });
+    }
+
 }
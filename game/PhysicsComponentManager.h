@@ -27,7 +27,12 @@
 #define _PHYSICSCOMPONENTMANAGER_H_
 
 #include "ComponentManager.h"
+#include "PhysicsQuery.h"
 #include <unordered_set>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "bullet/btBulletDynamicsCommon.h"
 
 namespace af3d
@@ -65,15 +70,44 @@ namespace af3d
 
         void rayCast(const btVector3& p1, const btVector3& p2, const RayCastFn& fn) const;
 
+        /*
+         * Closest hit for each query, 'hits' is resized to match 'queries'. Broadphase
+         * is traversed directly with a reusable stack per worker, large batches are split
+         * across 'physics.queryThreads' pool threads. Must not be called while the world is stepping.
+         */
+        void rayCastBatch(const std::vector<RayCastQuery>& queries, std::vector<QueryHit>& hits,
+            const btCollisionObject* ignore = nullptr) const;
+
+        /*
+         * Same as above, but sweeps 'shape' along each query.
+         */
+        void sweepBatch(const btConvexShape* shape, const std::vector<SweepQuery>& queries, std::vector<QueryHit>& hits,
+            const btCollisionObject* ignore = nullptr) const;
+
         inline btDiscreteDynamicsWorld& world() { return world_; }
 
     private:
+        using QueryFn = std::function<void(PhysicsQueryStack&)>;
+
+        struct QueryTask
+        {
+            QueryFn fn;
+            std::size_t* pending;
+        };
+
+        template <class Fn>
+        void runBatch(std::size_t numQueries, const Fn& fn) const;
+
+        void queryThreadFn();
+
         class CollisionDispatcher : public btCollisionDispatcher
         {
         public:
             CollisionDispatcher(CollisionComponentManager* collisionMgr,
                 btCollisionConfiguration* collisionConfiguration);
 
+            btPersistentManifold* getNewManifold(const btCollisionObject* b0, const btCollisionObject* b1) override;
+
             void releaseManifold(btPersistentManifold* manifold) override;
 
         private:
@@ -108,6 +142,14 @@ namespace af3d
 
         std::unordered_set<PhysicsComponentPtr> components_;
         std::unordered_set<PhysicsComponentPtr> frozenComponents_;
+
+        // Batch query workers, started once, each one keeps its own broadphase stack.
+        std::vector<std::thread> queryThreads_;
+        mutable std::mutex queryMtx_;
+        mutable std::condition_variable queryCond_;
+        mutable std::condition_variable queryDoneCond_;
+        mutable std::deque<QueryTask> queryQueue_;
+        bool queryStop_ = false;
     };
 }
 
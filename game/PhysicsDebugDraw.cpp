@@ -26,6 +26,8 @@
 #include "PhysicsDebugDraw.h"
 #include "MaterialManager.h"
 #include "RenderList.h"
+#include "HardwareResourceManager.h"
+#include "Renderer.h"
 #include "Logger.h"
 #include "bullet/BulletCollision/CollisionShapes/btConvexPolyhedron.h"
 
@@ -174,4 +176,71 @@ namespace af3d
             convexMesh->getMeshInterface()->InternalProcessAllTriangles(&drawCallback, aabbMin, aabbMax);
         }
     }
+
+    void PhysicsDebugDraw::drawMeshCached(btCollisionShape* shape, PhysicsDebugWireframe& wireframe,
+        const btTransform& worldTransform, const btVector3& color)
+    {
+        btAssert(rl_);
+
+        if (!wireframe.vbo) {
+            VertexArrayLayout vaLayout;
+
+            vaLayout.addEntry(VertexArrayEntry(VertexAttribName::Pos, GL_FLOAT_VEC3, 0, 0));
+            vaLayout.addEntry(VertexArrayEntry(VertexAttribName::UV, GL_FLOAT_VEC2, 12, 0));
+            vaLayout.addEntry(VertexArrayEntry(VertexAttribName::Color, GL_UNSIGNED_INT8_VEC4_NV, 20, 0, true));
+
+            wireframe.vbo = hwManager.createDataBuffer(HardwareBuffer::Usage::StaticDraw, sizeof(VertexImm));
+            VBOList vbos{wireframe.vbo};
+            wireframe.vaSlice = VertexArraySlice(std::make_shared<VertexArray>(hwManager.createVertexArray(), vaLayout, vbos, HardwareIndexBufferPtr()), 0, 0, 0);
+        }
+
+        // Also true on first use and after context loss.
+        if (wireframe.vbo->setValid() || (wireframe.scale != shape->getLocalScaling())) {
+            wireframe.scale = shape->getLocalScaling();
+
+            PhysicsDebugDraw dd;
+            dd.drawMesh(shape, btTransform::getIdentity(), btVector3_one);
+
+            auto vertices = std::make_shared<std::vector<VertexImm>>();
+            vertices->reserve(dd.lines_.size() * 2);
+            for (const auto& line : dd.lines_) {
+                vertices->emplace_back(line.from, Vector2f_zero, toPackedColor(Color_one));
+                vertices->emplace_back(line.to, Vector2f_zero, toPackedColor(Color_one));
+            }
+
+            wireframe.vaSlice = VertexArraySlice(wireframe.vaSlice.va(), 0, vertices->size(), 0);
+
+            auto vbo = wireframe.vbo;
+            renderer.scheduleHwOp([vbo, vertices](HardwareContext& ctx) {
+                if (!vertices->empty()) {
+                    vbo->reload(vertices->size(), &(*vertices)[0], ctx);
+                }
+            });
+        }
+
+        if (wireframe.vaSlice.count() == 0) {
+            return;
+        }
+
+        // Material params are shared by all render lists of a frame, so each color gets its own material.
+        Color c(color, alpha_);
+        auto pc = toPackedColor(c);
+        std::uint32_t key = (static_cast<std::uint32_t>(pc.x()) << 24) | (static_cast<std::uint32_t>(pc.y()) << 16) |
+            (static_cast<std::uint32_t>(pc.z()) << 8) | static_cast<std::uint32_t>(pc.w());
+
+        auto& material = wireframe.materials[key];
+        if (!material) {
+            material = materialManager.createMaterial(MaterialTypeUnlit);
+            material->setBlendingParams(BlendingParams(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+            material->setDepthTest(false);
+            material->setCullFaceMode(0);
+            material->params().setUniform(UniformName::MainColor, gammaToLinear(c));
+        }
+
+        btVector3 aabbMin, aabbMax;
+        shape->getAabb(worldTransform, aabbMin, aabbMax);
+
+        Matrix4f modelMat(worldTransform);
+        rl_->addGeometry(modelMat, modelMat, AABB(aabbMin, aabbMax), material, wireframe.vaSlice, GL_LINES);
+    }
 }
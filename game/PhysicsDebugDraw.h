@@ -26,9 +26,13 @@
 #ifndef _PHYSICS_DEBUG_DRAW_H_
 #define _PHYSICS_DEBUG_DRAW_H_
 
+#include "Material.h"
+#include "VertexArraySlice.h"
+#include "HardwareDataBuffer.h"
 #include "af3d/Types.h"
 #include "af3d/Vector4.h"
 #include <boost/noncopyable.hpp>
+#include <unordered_map>
 #include "bullet/LinearMath/btIDebugDraw.h"
 #include "bullet/btBulletCollisionCommon.h"
 
@@ -36,6 +40,16 @@ namespace af3d
 {
     class RenderList;
 
+    // Line list of a collision shape in shape space, kept by the shape and drawn with a model matrix.
+    struct PhysicsDebugWireframe
+    {
+        HardwareDataBufferPtr vbo;
+        VertexArraySlice vaSlice;
+        btVector3 scale = btVector3_zero; // Rebuilt when shape scale changes.
+        // One per packed color, shapes are drawn with only a handful of colors.
+        std::unordered_map<std::uint32_t, MaterialPtr> materials;
+    };
+
     class PhysicsDebugDraw : public btIDebugDraw,
         boost::noncopyable
     {
@@ -65,6 +79,10 @@ namespace af3d
 
         void drawMesh(btCollisionShape* shape, const btTransform& worldTransform, const btVector3& color);
 
+        // Same as above, but lines are uploaded into 'wireframe' once instead of streaming them every frame.
+        void drawMeshCached(btCollisionShape* shape, PhysicsDebugWireframe& wireframe,
+            const btTransform& worldTransform, const btVector3& color);
+
         inline void setRenderList(RenderList* value) { rl_ = value; }
 
         inline void setAlpha(float value) { alpha_ = value; }
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PhysicsQuery.h"
+#include "bullet/BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
+#include "bullet/LinearMath/btTransformUtil.h"
+
+namespace af3d
+{
+    namespace
+    {
+        // Same as 'SceneObject::getBodyShape', this file only depends on Bullet.
+        const btCollisionShape* getBodyShape(const btCollisionObject* body, int childIdx)
+        {
+            auto shape = body->getCollisionShape();
+            if (shape->isCompound()) {
+                auto cShape = static_cast<const btCompoundShape*>(shape);
+                btAssert(childIdx >= 0);
+                btAssert(childIdx < cShape->getNumChildShapes());
+                shape = cShape->getChildShape(childIdx);
+            }
+            return shape;
+        }
+
+        struct BroadphaseTester : public btDbvt::ICollide
+        {
+        public:
+            explicit BroadphaseTester(btBroadphaseRayCallback& cb)
+            : cb_(cb) {}
+
+            void Process(const btDbvtNode* leaf) override
+            {
+                cb_.process(static_cast<btDbvtProxy*>(leaf->data));
+            }
+
+        private:
+            btBroadphaseRayCallback& cb_;
+        };
+
+        /*
+         * Same as btCollisionWorld::rayTest/convexSweepTest broadphase part, but
+         * with caller provided stack, so it's safe to run from several threads at once.
+         */
+        void broadphaseRayTest(const btDbvtBroadphase& broadphase, const btVector3& from, const btVector3& to,
+            const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseRayCallback& cb, PhysicsQueryStack& stack)
+        {
+            btVector3 rayDir = (to - from).normalized();
+
+            cb.m_rayDirectionInverse[0] = (rayDir[0] == 0.0f) ? BT_LARGE_FLOAT : 1.0f / rayDir[0];
+            cb.m_rayDirectionInverse[1] = (rayDir[1] == 0.0f) ? BT_LARGE_FLOAT : 1.0f / rayDir[1];
+            cb.m_rayDirectionInverse[2] = (rayDir[2] == 0.0f) ? BT_LARGE_FLOAT : 1.0f / rayDir[2];
+            cb.m_signs[0] = cb.m_rayDirectionInverse[0] < 0.0f;
+            cb.m_signs[1] = cb.m_rayDirectionInverse[1] < 0.0f;
+            cb.m_signs[2] = cb.m_rayDirectionInverse[2] < 0.0f;
+            cb.m_lambda_max = rayDir.dot(to - from);
+
+            BroadphaseTester tester(cb);
+
+            for (int i = 0; i < btDbvtBroadphase::STAGECOUNT; ++i) {
+                broadphase.m_sets[i].rayTestInternal(broadphase.m_sets[i].m_root, from, to,
+                    cb.m_rayDirectionInverse, cb.m_signs, cb.m_lambda_max,
+                    aabbMin, aabbMax, stack, tester);
+            }
+        }
+
+        struct BatchRayCallback : public btBroadphaseRayCallback
+        {
+        public:
+            BatchRayCallback(const RayCastQuery& query, QueryHit& hit, const btCollisionObject* ignore)
+            : result_(query, hit),
+              ignore_(ignore)
+            {
+                result_.m_flags |= btTriangleRaycastCallback::kF_UseGjkConvexCastRaytest;
+                fromXf_.setIdentity();
+                fromXf_.setOrigin(query.p1);
+                toXf_.setIdentity();
+                toXf_.setOrigin(query.p2);
+            }
+
+            bool process(const btBroadphaseProxy* proxy) override
+            {
+                if (result_.m_closestHitFraction == 0.0f) {
+                    return false;
+                }
+
+                auto obj = static_cast<btCollisionObject*>(proxy->m_clientObject);
+                if ((obj != ignore_) && result_.needsCollision(obj->getBroadphaseHandle())) {
+                    btCollisionWorld::rayTestSingle(fromXf_, toXf_, obj, obj->getCollisionShape(),
+                        obj->getWorldTransform(), result_);
+                }
+
+                return true;
+            }
+
+        private:
+            struct Result : public btCollisionWorld::RayResultCallback
+            {
+            public:
+                Result(const RayCastQuery& query, QueryHit& hit)
+                : query_(query),
+                  hit_(hit) {}
+
+                float addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace) override
+                {
+                    m_closestHitFraction = rayResult.m_hitFraction;
+                    m_collisionObject = rayResult.m_collisionObject;
+
+                    hit_.collisionObject = rayResult.m_collisionObject;
+                    hit_.shape = const_cast<btCollisionShape*>(getBodyShape(rayResult.m_collisionObject, m_childIdx));
+                    if (normalInWorldSpace) {
+                        hit_.normal = rayResult.m_hitNormalLocal;
+                    } else {
+                        hit_.normal = rayResult.m_collisionObject->getWorldTransform().getBasis() * rayResult.m_hitNormalLocal;
+                    }
+                    hit_.point.setInterpolate3(query_.p1, query_.p2, rayResult.m_hitFraction);
+                    hit_.fraction = rayResult.m_hitFraction;
+
+                    return m_closestHitFraction;
+                }
+
+            private:
+                const RayCastQuery& query_;
+                QueryHit& hit_;
+            };
+
+            Result result_;
+            const btCollisionObject* ignore_;
+            btTransform fromXf_;
+            btTransform toXf_;
+        };
+
+        struct BatchSweepCallback : public btBroadphaseRayCallback
+        {
+        public:
+            BatchSweepCallback(const btConvexShape* shape, const SweepQuery& query, QueryHit& hit, const btCollisionObject* ignore)
+            : shape_(shape),
+              query_(query),
+              result_(hit),
+              ignore_(ignore) {}
+
+            bool process(const btBroadphaseProxy* proxy) override
+            {
+                if (result_.m_closestHitFraction == 0.0f) {
+                    return false;
+                }
+
+                auto obj = static_cast<btCollisionObject*>(proxy->m_clientObject);
+                if ((obj != ignore_) && result_.needsCollision(obj->getBroadphaseHandle())) {
+                    btCollisionWorld::objectQuerySingle(shape_, query_.from, query_.to, obj, obj->getCollisionShape(),
+                        obj->getWorldTransform(), result_, 0.0f);
+                }
+
+                return true;
+            }
+
+        private:
+            struct Result : public btCollisionWorld::ConvexResultCallback
+            {
+            public:
+                explicit Result(QueryHit& hit)
+                : hit_(hit) {}
+
+                float addSingleResult(btCollisionWorld::LocalConvexResult& convexResult, bool normalInWorldSpace) override
+                {
+                    m_closestHitFraction = convexResult.m_hitFraction;
+
+                    hit_.collisionObject = convexResult.m_hitCollisionObject;
+                    hit_.shape = const_cast<btCollisionShape*>(getBodyShape(convexResult.m_hitCollisionObject, m_childIdx));
+                    if (normalInWorldSpace) {
+                        hit_.normal = convexResult.m_hitNormalLocal;
+                    } else {
+                        hit_.normal = convexResult.m_hitCollisionObject->getWorldTransform().getBasis() * convexResult.m_hitNormalLocal;
+                    }
+                    hit_.point = convexResult.m_hitPointLocal;
+                    hit_.fraction = convexResult.m_hitFraction;
+
+                    return m_closestHitFraction;
+                }
+
+            private:
+                QueryHit& hit_;
+            };
+
+            const btConvexShape* shape_;
+            const SweepQuery& query_;
+            Result result_;
+            const btCollisionObject* ignore_;
+        };
+    }
+
+    void rayCastQuery(const btDbvtBroadphase& broadphase, const RayCastQuery& query, QueryHit& hit,
+        const btCollisionObject* ignore, PhysicsQueryStack& stack)
+    {
+        if ((query.p2 - query.p1).fuzzyZero()) {
+            return;
+        }
+
+        btVector3 zero(0.0f, 0.0f, 0.0f);
+        BatchRayCallback cb(query, hit, ignore);
+        broadphaseRayTest(broadphase, query.p1, query.p2, zero, zero, cb, stack);
+    }
+
+    void sweepQuery(const btDbvtBroadphase& broadphase, const btConvexShape* shape, const SweepQuery& query, QueryHit& hit,
+        const btCollisionObject* ignore, PhysicsQueryStack& stack)
+    {
+        if ((query.to.getOrigin() - query.from.getOrigin()).fuzzyZero()) {
+            return;
+        }
+
+        btVector3 zero(0.0f, 0.0f, 0.0f);
+        btVector3 linVel, angVel;
+        btTransformUtil::calculateVelocity(query.from, query.to, 1.0f, linVel, angVel);
+        btTransform rotXf = btTransform::getIdentity();
+        rotXf.setRotation(query.from.getRotation());
+        btVector3 aabbMin, aabbMax;
+        shape->calculateTemporalAabb(rotXf, zero, angVel, 1.0f, aabbMin, aabbMax);
+
+        BatchSweepCallback cb(shape, query, hit, ignore);
+        broadphaseRayTest(broadphase, query.from.getOrigin(), query.to.getOrigin(), aabbMin, aabbMax, cb, stack);
+    }
+}
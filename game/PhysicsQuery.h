@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _PHYSICSQUERY_H_
+#define _PHYSICSQUERY_H_
+
+#include "bullet/btBulletCollisionCommon.h"
+
+namespace af3d
+{
+    struct RayCastQuery
+    {
+        RayCastQuery() = default;
+        RayCastQuery(const btVector3& p1, const btVector3& p2)
+        : p1(p1),
+          p2(p2) {}
+
+        btVector3 p1 = btVector3(0.0f, 0.0f, 0.0f);
+        btVector3 p2 = btVector3(0.0f, 0.0f, 0.0f);
+    };
+
+    struct SweepQuery
+    {
+        SweepQuery() = default;
+        SweepQuery(const btTransform& from, const btTransform& to)
+        : from(from),
+          to(to) {}
+
+        btTransform from = btTransform::getIdentity();
+        btTransform to = btTransform::getIdentity();
+    };
+
+    struct QueryHit
+    {
+        inline bool hit() const { return shape != nullptr; }
+
+        const btCollisionObject* collisionObject = nullptr;
+        btCollisionShape* shape = nullptr;
+        btVector3 point = btVector3(0.0f, 0.0f, 0.0f);
+        btVector3 normal = btVector3(0.0f, 0.0f, 0.0f);
+        float fraction = 1.0f;
+    };
+
+    // Broadphase traversal stack, reused between queries, one per thread.
+    using PhysicsQueryStack = btAlignedObjectArray<const btDbvtNode*>;
+
+    /*
+     * Closest hit of a single query, same as btCollisionWorld::rayTest/convexSweepTest, but
+     * traverses 'broadphase' directly with caller provided stack, so it's safe to run from
+     * several threads at once while the world isn't stepping. Depends on Bullet only,
+     * 'bench_physics_query' builds it standalone.
+     */
+    void rayCastQuery(const btDbvtBroadphase& broadphase, const RayCastQuery& query, QueryHit& hit,
+        const btCollisionObject* ignore, PhysicsQueryStack& stack);
+
+    void sweepQuery(const btDbvtBroadphase& broadphase, const btConvexShape* shape, const SweepQuery& query, QueryHit& hit,
+        const btCollisionObject* ignore, PhysicsQueryStack& stack);
+}
+
+#endif
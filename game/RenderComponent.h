@@ -50,8 +50,30 @@ namespace af3d
         inline bool renderAlways() const { return renderAlways_; }
         inline void setRenderAlways(bool value) { renderAlways_ = value; }
 
+        /*
+         * Components that don't need 'update' every frame should clear this
+         * before registering, they then get updated only when parent
+         * object moves or when they call 'requestUpdate'.
+         */
+        inline bool updateAlways() const { return updateAlways_; }
+        inline void setUpdateAlways(bool value) { updateAlways_ = value; }
+
+        inline void requestUpdate()
+        {
+            if (manager_) {
+                manager_->requestUpdate(this);
+            }
+        }
+
         inline bool visible() const { return visible_; }
-        inline void setVisible(bool value) { visible_ = value; }
+        inline void setVisible(bool value)
+        {
+            if (visible_ != value) {
+                visible_ = value;
+                // GPU driven components sync visibility on update.
+                requestUpdate();
+            }
+        }
 
         inline const CameraFilter& cameraFilter() const { return camFilter_; }
         inline CameraFilter& cameraFilter() { return camFilter_; }
@@ -72,6 +94,7 @@ namespace af3d
 
     private:
         bool renderAlways_;
+        bool updateAlways_ = true;
         bool visible_ = true;
         CameraFilter camFilter_;
         RenderComponentManager* manager_ = nullptr;
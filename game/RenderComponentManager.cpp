@@ -26,6 +26,8 @@
 #include "RenderComponentManager.h"
 #include "RenderComponent.h"
 #include "Settings.h"
+#include "SceneTransforms.h"
+#include "Scene.h"
 
 namespace af3d
 {
@@ -38,12 +40,27 @@ namespace af3d
     void RenderComponentManager::CollideCull::Process(const btDbvtNode* node)
     {
         auto nd = (NodeData*)node->data;
-        cullResults_[nd->component].push_back(nd->data);
+        if (!nd->gpuDriven) {
+            cullResults_[nd->component].push_back(nd->data);
+        }
     }
 
     bool RenderComponentManager::CollideCull::Descent(const btDbvtNode* node)
     {
-        return frustum_.isVisible(AABB(node->volume.Mins(), node->volume.Maxs()));
+        return descent(AABB(node->volume.Mins(), node->volume.Maxs()));
+    }
+
+    void RenderComponentManager::CollideCull::process(const NodeData* nd)
+    {
+        // Static tree leaves hold several nodes, check each one.
+        if (!nd->gpuDriven && frustum_.isVisible(nd->aabb)) {
+            cullResults_[nd->component].push_back(nd->data);
+        }
+    }
+
+    bool RenderComponentManager::CollideCull::descent(const AABB& aabb) const
+    {
+        return frustum_.isVisible(aabb);
     }
 
     RenderComponentManager::CollideRayCast::CollideRayCast(const Frustum& frustum, const Ray& ray, const RayCastRenderFn& fn)
@@ -55,7 +72,16 @@ namespace af3d
 
     void RenderComponentManager::CollideRayCast::Process(const btDbvtNode* node)
     {
-        auto nd = (NodeData*)node->data;
+        process((NodeData*)node->data);
+    }
+
+    bool RenderComponentManager::CollideRayCast::Descent(const btDbvtNode* node)
+    {
+        return descent(AABB(node->volume.Mins(), node->volume.Maxs()));
+    }
+
+    void RenderComponentManager::CollideRayCast::process(const NodeData* nd)
+    {
         auto res = nd->component->testRay(frustum_, ray_, nd->data);
         if (!res.first || (res.second >= maxT_)) {
             return;
@@ -66,12 +92,11 @@ namespace af3d
         }
     }
 
-    bool RenderComponentManager::CollideRayCast::Descent(const btDbvtNode* node)
+    bool RenderComponentManager::CollideRayCast::descent(const AABB& aabb) const
     {
         if (maxT_ <= 0.0f) {
             return false;
         }
-        AABB aabb(node->volume.Mins(), node->volume.Maxs());
         if (aabb.contains(ray_.pos)) {
             return true;
         }
@@ -101,7 +126,13 @@ namespace af3d
         btAssert(!component->manager());
 
         components_.insert(renderComponent);
+        if (renderComponent->updateAlways() || renderComponent->renderAlways()) {
+            alwaysComponents_.insert(renderComponent.get());
+        }
         renderComponent->setManager(this);
+        if (!renderComponent->updateAlways()) {
+            pendingUpdates_.insert(renderComponent.get());
+        }
     }
 
     void RenderComponentManager::removeComponent(const ComponentPtr& component)
@@ -110,6 +141,8 @@ namespace af3d
 
         if (components_.erase(renderComponent) ||
             frozenComponents_.erase(renderComponent)) {
+            alwaysComponents_.erase(renderComponent.get());
+            pendingUpdates_.erase(renderComponent.get());
             renderComponent->setManager(nullptr);
         }
     }
@@ -119,6 +152,8 @@ namespace af3d
         auto renderComponent = std::static_pointer_cast<RenderComponent>(component);
 
         components_.erase(renderComponent);
+        alwaysComponents_.erase(renderComponent.get());
+        pendingUpdates_.erase(renderComponent.get());
         frozenComponents_.insert(renderComponent);
         component->onFreeze();
     }
@@ -129,6 +164,12 @@ namespace af3d
 
         frozenComponents_.erase(renderComponent);
         components_.insert(renderComponent);
+        if (renderComponent->updateAlways() || renderComponent->renderAlways()) {
+            alwaysComponents_.insert(renderComponent.get());
+        }
+        if (!renderComponent->updateAlways()) {
+            pendingUpdates_.insert(renderComponent.get());
+        }
         component->onThaw();
     }
 
@@ -136,15 +177,45 @@ namespace af3d
     {
         cullResults_.clear();
 
-        for (const auto& c : components_) {
-            c->update(dt);
+        const auto& transforms = scene()->transforms();
+        for (auto slot : transforms.movedSlots()) {
+            auto obj = transforms.object(slot);
+            if (!obj) {
+                continue;
+            }
+            for (const auto& c : obj->components()) {
+                if (c->manager() == this) {
+                    requestUpdate(static_cast<RenderComponent*>(c.get()));
+                }
+            }
+        }
+
+        tmpUpdates_.assign(pendingUpdates_.begin(), pendingUpdates_.end());
+        pendingUpdates_.clear();
+
+        for (auto c : tmpUpdates_) {
+            if (!c->updateAlways()) {
+                c->update(dt);
+            }
+        }
+
+        tmpUpdates_.clear();
+
+        for (auto c : alwaysComponents_) {
+            if (c->updateAlways()) {
+                c->update(dt);
+            }
             if (c->renderAlways()) {
-                cullResults_[c.get()].push_back(nullptr);
+                cullResults_[c].push_back(nullptr);
             }
         }
 
         tree_.optimizeIncremental(1);
 
+        if (staticTreeDirty_) {
+            rebuildStaticTree();
+        }
+
         return true;
     }
 
@@ -157,7 +228,8 @@ namespace af3d
 
     RenderCookie* RenderComponentManager::addAABB(RenderComponent* component,
         const AABB& aabb,
-        void* data)
+        void* data,
+        bool gpuDriven)
     {
         auto it = nodeDataList_.insert(nodeDataList_.end(), NodeData());
 
@@ -166,8 +238,16 @@ namespace af3d
         nd.it = it;
         nd.component = component;
         nd.data = data;
+        nd.aabb = aabb;
+        nd.gpuDriven = gpuDriven;
+
+        if (component->parent() && (component->parent()->bodyType() == BodyType::Static)) {
+            addStatic(&nd);
+        } else {
+            nd.node = tree_.insert(btDbvtVolume::FromMM(aabb.lowerBound, aabb.upperBound), &nd);
+        }
 
-        return (RenderCookie*)tree_.insert(btDbvtVolume::FromMM(aabb.lowerBound, aabb.upperBound), &nd);
+        return (RenderCookie*)&nd;
     }
 
     void RenderComponentManager::moveAABB(RenderCookie* cookie,
@@ -175,7 +255,19 @@ namespace af3d
         const AABB& aabb,
         const btVector3& displacement)
     {
-        auto node = (btDbvtNode*)cookie;
+        auto nd = (NodeData*)cookie;
+
+        nd->aabb = aabb;
+
+        if (!nd->node) {
+            // Static stuff moves (editor, scripts), promote to dynamic tree for good,
+            // we don't want to rebuild static tree every frame while it's being dragged.
+            removeStatic(nd);
+            nd->node = tree_.insert(btDbvtVolume::FromMM(aabb.lowerBound, aabb.upperBound), nd);
+            return;
+        }
+
+        auto node = nd->node;
         auto bv = btDbvtVolume::FromMM(aabb.lowerBound, aabb.upperBound);
 
         if (Intersect(node->volume, bv)) {
@@ -194,12 +286,23 @@ namespace af3d
 
     void RenderComponentManager::removeAABB(RenderCookie* cookie)
     {
-        auto node = (btDbvtNode*)cookie;
-        auto nd = (NodeData*)node->data;
+        auto nd = (NodeData*)cookie;
+
+        if (nd->node) {
+            tree_.remove(nd->node);
+        } else {
+            removeStatic(nd);
+        }
 
         nodeDataList_.erase(nd->it);
+    }
 
-        tree_.remove(node);
+    void RenderComponentManager::requestUpdate(RenderComponent* component)
+    {
+        if (component->parent() && component->parent()->frozen()) {
+            return;
+        }
+        pendingUpdates_.insert(component);
     }
 
     void RenderComponentManager::render(RenderList& rl) const
@@ -216,6 +319,15 @@ namespace af3d
             CollideCull collide(rl.camera()->frustum(), cr);
             btDbvt::collideTU(tree_.m_root, collide);
 
+            if (staticTreeDirty_) {
+                rebuildStaticTree();
+            }
+            staticTree_.traverse([&collide](const AABB& aabb) {
+                return collide.descent(aabb);
+            }, [this, &collide](int idx) {
+                collide.process(staticNodes_[idx]);
+            });
+
             for (const auto& kv : cr) {
                 if (kv.first->visible() &&
                     kv.first->getCameraFilterWithFixup().visibleTo(rl.camera())) {
@@ -230,5 +342,42 @@ namespace af3d
         CollideRayCast collide(frustum, ray, fn);
 
         btDbvt::collideTU(tree_.m_root, collide);
+
+        if (staticTreeDirty_) {
+            rebuildStaticTree();
+        }
+        staticTree_.traverse([&collide](const AABB& aabb) {
+            return collide.descent(aabb);
+        }, [this, &collide](int idx) {
+            collide.process(staticNodes_[idx]);
+        });
+    }
+
+    void RenderComponentManager::addStatic(NodeData* nd)
+    {
+        nd->staticIdx = staticNodes_.size();
+        staticNodes_.push_back(nd);
+        staticTreeDirty_ = true;
+    }
+
+    void RenderComponentManager::removeStatic(NodeData* nd)
+    {
+        btAssert(nd->staticIdx >= 0);
+        staticNodes_[nd->staticIdx] = staticNodes_.back();
+        staticNodes_[nd->staticIdx]->staticIdx = nd->staticIdx;
+        staticNodes_.pop_back();
+        nd->staticIdx = -1;
+        staticTreeDirty_ = true;
+    }
+
+    void RenderComponentManager::rebuildStaticTree() const
+    {
+        tmpAABBs_.resize(staticNodes_.size());
+        for (size_t i = 0; i < staticNodes_.size(); ++i) {
+            tmpAABBs_[i] = staticNodes_[i]->aabb;
+        }
+        staticTree_.build(tmpAABBs_);
+        tmpAABBs_.clear();
+        staticTreeDirty_ = false;
     }
 }
@@ -29,6 +29,7 @@
 #include "ComponentManager.h"
 #include "Camera.h"
 #include "af3d/Ray.h"
+#include "af3d/BVH.h"
 #include "bullet/BulletCollision/BroadphaseCollision/btDbvt.h"
 #include <unordered_set>
 #include <list>
@@ -62,9 +63,14 @@ namespace af3d
 
         virtual void debugDraw(RenderList& rl) override;
 
+        /*
+         * 'gpuDriven' nodes are drawn by IndirectDrawManager, they're kept for
+         * ray casts only and never passed to 'render'.
+         */
         RenderCookie* addAABB(RenderComponent* component,
             const AABB& aabb,
-            void* data);
+            void* data,
+            bool gpuDriven = false);
 
         void moveAABB(RenderCookie* cookie,
             const AABB& prevAABB,
@@ -73,6 +79,9 @@ namespace af3d
 
         void removeAABB(RenderCookie* cookie);
 
+        // Call 'component->update' once during next 'update', no-op for frozen components.
+        void requestUpdate(RenderComponent* component);
+
         void render(RenderList& rl) const;
 
         void rayCast(const Frustum& frustum, const Ray& ray, const RayCastRenderFn& fn) const;
@@ -83,6 +92,10 @@ namespace af3d
             std::list<NodeData>::iterator it;
             RenderComponent* component;
             void* data;
+            AABB aabb;
+            btDbvtNode* node = nullptr; // Dynamic tree leaf, null when in static tree.
+            int staticIdx = -1;
+            bool gpuDriven = false;
         };
 
         using NodeDataList = std::list<NodeData>;
@@ -97,6 +110,9 @@ namespace af3d
             void Process(const btDbvtNode* node);
             bool Descent(const btDbvtNode* node);
 
+            void process(const NodeData* nd);
+            bool descent(const AABB& aabb) const;
+
         private:
             const Frustum& frustum_;
             CullResultList& cullResults_;
@@ -111,6 +127,9 @@ namespace af3d
             void Process(const btDbvtNode* node);
             bool Descent(const btDbvtNode* node);
 
+            void process(const NodeData* nd);
+            bool descent(const AABB& aabb) const;
+
         private:
             const Frustum& frustum_;
             const Ray& ray_;
@@ -118,13 +137,32 @@ namespace af3d
             float maxT_ = (std::numeric_limits<float>::max)();
         };
 
+        void addStatic(NodeData* nd);
+
+        void removeStatic(NodeData* nd);
+
+        void rebuildStaticTree() const;
+
         std::unordered_set<RenderComponentPtr> components_;
         std::unordered_set<RenderComponentPtr> frozenComponents_;
 
+        // Components with 'updateAlways' or 'renderAlways' set.
+        std::unordered_set<RenderComponent*> alwaysComponents_;
+        std::unordered_set<RenderComponent*> pendingUpdates_;
+        std::vector<RenderComponent*> tmpUpdates_;
+
         NodeDataList nodeDataList_;
 
+        // Moving stuff, refit incrementally.
         btDbvt tree_;
 
+        // Static stuff, rebuilt lazily on edits. Static nodes that move are
+        // promoted to dynamic tree.
+        std::vector<NodeData*> staticNodes_;
+        mutable BVH staticTree_;
+        mutable bool staticTreeDirty_ = false;
+        mutable std::vector<AABB> tmpAABBs_;
+
         CullResultList cullResults_;
     };
 }
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "RenderGraph.h"
+#include "TextureManager.h"
+#include "Logger.h"
+#include <algorithm>
+
+namespace af3d
+{
+    RenderGraph::ResourceId RenderGraph::createTexture(const std::string& name, float scale, GLint internalFormat, GLenum format, GLenum dataType, bool genMipmap)
+    {
+        btAssert(!compiled_);
+
+        Resource res;
+        res.name = name;
+        res.desc.scale = scale;
+        res.desc.internalFormat = internalFormat;
+        res.desc.format = format;
+        res.desc.dataType = dataType;
+        res.desc.genMipmap = genMipmap;
+        resources_.push_back(res);
+
+        return static_cast<ResourceId>(resources_.size() - 1);
+    }
+
+    RenderGraph::ResourceId RenderGraph::createVirtual(const std::string& name)
+    {
+        btAssert(!compiled_);
+
+        Resource res;
+        res.name = name;
+        res.isVirtual = true;
+        resources_.push_back(res);
+
+        return static_cast<ResourceId>(resources_.size() - 1);
+    }
+
+    void RenderGraph::setOutput(ResourceId id)
+    {
+        resources_.at(id).isOutput = true;
+    }
+
+    void RenderGraph::addPass(const std::string& name, int orderBegin, int orderEnd,
+        const ResourceIds& reads, const ResourceIds& writes, const SetupFn& setupFn)
+    {
+        btAssert(!compiled_);
+        btAssert(orderBegin <= orderEnd);
+        btAssert(!writes.empty());
+
+        Pass pass;
+        pass.name = name;
+        pass.orderBegin = orderBegin;
+        pass.orderEnd = orderEnd;
+        pass.reads = reads;
+        pass.writes = writes;
+        pass.setupFn = setupFn;
+        passes_.push_back(pass);
+    }
+
+    void RenderGraph::compile()
+    {
+        btAssert(!compiled_);
+        compiled_ = true;
+
+        cull();
+        allocate();
+
+        for (const auto& pass : passes_) {
+            if (pass.live) {
+                pass.setupFn(*this);
+            }
+        }
+
+        // Setup functions hold on to what they need.
+        for (auto& pass : passes_) {
+            pass.setupFn = SetupFn();
+        }
+    }
+
+    const TexturePtr& RenderGraph::texture(ResourceId id) const
+    {
+        btAssert(compiled_);
+        const auto& res = resources_.at(id);
+        btAssert(res.isVirtual || res.tex);
+        return res.tex;
+    }
+
+    void RenderGraph::cull()
+    {
+        std::vector<size_t> sorted(passes_.size());
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            sorted[i] = i;
+        }
+
+        // Walk back from the last pass, a pass is live if something live reads what it writes.
+        std::stable_sort(sorted.begin(), sorted.end(), [this](size_t a, size_t b) {
+            return passes_[a].orderBegin > passes_[b].orderBegin;
+        });
+
+        std::vector<bool> needed(resources_.size(), false);
+        for (size_t i = 0; i < resources_.size(); ++i) {
+            needed[i] = resources_[i].isOutput;
+        }
+
+        for (auto idx : sorted) {
+            auto& pass = passes_[idx];
+            for (auto id : pass.writes) {
+                if (needed[id]) {
+                    pass.live = true;
+                    break;
+                }
+            }
+            if (!pass.live) {
+                LOG4CPLUS_DEBUG(logger(), "renderGraph: culled pass " << pass.name);
+                continue;
+            }
+            for (auto id : pass.reads) {
+                needed[id] = true;
+            }
+        }
+
+        for (const auto& pass : passes_) {
+            if (!pass.live) {
+                continue;
+            }
+            for (auto id : pass.reads) {
+                auto& res = resources_[id];
+                res.firstUse = std::min(res.firstUse, pass.orderBegin);
+                res.lastUse = std::max(res.lastUse, pass.orderEnd);
+            }
+            for (auto id : pass.writes) {
+                auto& res = resources_[id];
+                res.firstUse = std::min(res.firstUse, pass.orderBegin);
+                res.lastUse = std::max(res.lastUse, pass.orderEnd);
+            }
+        }
+
+        for (auto& res : resources_) {
+            if (res.isOutput) {
+                res.lastUse = std::numeric_limits<int>::max();
+            }
+        }
+    }
+
+    void RenderGraph::allocate()
+    {
+        std::vector<size_t> sorted;
+        for (size_t i = 0; i < resources_.size(); ++i) {
+            const auto& res = resources_[i];
+            if (!res.isVirtual && (res.firstUse <= res.lastUse)) {
+                sorted.push_back(i);
+            }
+        }
+
+        std::stable_sort(sorted.begin(), sorted.end(), [this](size_t a, size_t b) {
+            return resources_[a].firstUse < resources_[b].firstUse;
+        });
+
+        std::vector<PhysicalTexture> pool;
+
+        for (auto idx : sorted) {
+            auto& res = resources_[idx];
+
+            // Lifetimes touching at the same order can't share, the pass may read one and write the other.
+            PhysicalTexture* phys = nullptr;
+            for (auto& p : pool) {
+                if ((p.desc == res.desc) && (p.lastUse < res.firstUse)) {
+                    phys = &p;
+                    break;
+                }
+            }
+
+            if (phys) {
+                LOG4CPLUS_DEBUG(logger(), "renderGraph: " << res.name << " [" << res.firstUse << ", " << res.lastUse << "] aliased");
+            } else {
+                PhysicalTexture p;
+                p.desc = res.desc;
+                p.tex = textureManager.createRenderTextureScaled(TextureType2D,
+                    res.desc.scale, 0, res.desc.internalFormat, res.desc.format, res.desc.dataType, res.desc.genMipmap);
+                pool.push_back(p);
+                phys = &pool.back();
+                LOG4CPLUS_DEBUG(logger(), "renderGraph: " << res.name << " [" << res.firstUse << ", " << res.lastUse << "] new texture");
+            }
+
+            phys->lastUse = res.lastUse;
+            res.tex = phys->tex;
+        }
+
+        LOG4CPLUS_INFO(logger(), "renderGraph: " << sorted.size() << " textures in " << pool.size() << " physical textures");
+    }
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RENDER_GRAPH_H_
+#define _RENDER_GRAPH_H_
+
+#include "Texture.h"
+#include <boost/noncopyable.hpp>
+#include <functional>
+#include <limits>
+
+namespace af3d
+{
+    /*
+     * Build-time graph of the scene's render chain. Passes declare the camera order range
+     * they render at and the textures they read and write. On 'compile' passes that don't
+     * contribute to the outputs are culled, texture lifetimes are computed from the remaining
+     * passes and textures with equal formats and non-overlapping lifetimes share the same
+     * physical texture. Setup functions of live passes are then called in declaration order
+     * to create the actual cameras and filters.
+     *
+     * Transient textures hold no data across frames, a pass must fully overwrite everything
+     * it writes before reading it back.
+     */
+    class RenderGraph : boost::noncopyable
+    {
+    public:
+        using ResourceId = int;
+        using ResourceIds = std::vector<ResourceId>;
+        using SetupFn = std::function<void(const RenderGraph&)>;
+
+        RenderGraph() = default;
+        ~RenderGraph() = default;
+
+        // Screen sized texture, see TextureManager::createRenderTextureScaled.
+        ResourceId createTexture(const std::string& name, float scale, GLint internalFormat, GLenum format, GLenum dataType, bool genMipmap = false);
+
+        // Dependency only, no texture behind it. For side effects and outputs like the backbuffer.
+        ResourceId createVirtual(const std::string& name);
+
+        void setOutput(ResourceId id);
+
+        void addPass(const std::string& name, int orderBegin, int orderEnd,
+            const ResourceIds& reads, const ResourceIds& writes, const SetupFn& setupFn);
+
+        void compile();
+
+        const TexturePtr& texture(ResourceId id) const;
+
+    private:
+        struct TextureDesc
+        {
+            float scale = 1.0f;
+            GLint internalFormat = 0;
+            GLenum format = 0;
+            GLenum dataType = 0;
+            bool genMipmap = false;
+
+            inline bool operator==(const TextureDesc& other) const
+            {
+                return (scale == other.scale) &&
+                    (internalFormat == other.internalFormat) &&
+                    (format == other.format) &&
+                    (dataType == other.dataType) &&
+                    (genMipmap == other.genMipmap);
+            }
+        };
+
+        struct Resource
+        {
+            std::string name;
+            bool isVirtual = false;
+            bool isOutput = false;
+            TextureDesc desc;
+            int firstUse = std::numeric_limits<int>::max();
+            int lastUse = std::numeric_limits<int>::min();
+            TexturePtr tex;
+        };
+
+        struct Pass
+        {
+            std::string name;
+            int orderBegin = 0;
+            int orderEnd = 0;
+            ResourceIds reads;
+            ResourceIds writes;
+            SetupFn setupFn;
+            bool live = false;
+        };
+
+        struct PhysicalTexture
+        {
+            TextureDesc desc;
+            int lastUse = 0;
+            TexturePtr tex;
+        };
+
+        void cull();
+
+        void allocate();
+
+        std::vector<Resource> resources_;
+        std::vector<Pass> passes_;
+        bool compiled_ = false;
+    };
+}
+
+#endif
@@ -408,6 +408,14 @@ namespace af3d
         return RenderImm(material, primitiveMode, depthValue, scissorParams, *this);
     }
 
+    void RenderList::addGeometryOrdered(const MaterialPtr& material,
+        const VertexArraySlice& vaSlice, GLenum primitiveMode, float depthValue,
+        const ScissorParams& scissorParams)
+    {
+        geomList_.emplace_back(material, vaSlice, primitiveMode, depthValue, scissorParams);
+        geomList_.back().ordered = true;
+    }
+
     VertexArraySlice RenderList::createGeometry(const VertexImm* vertices, std::uint32_t numVertices,
         const std::uint16_t* indices, std::uint32_t numIndices)
     {
@@ -140,13 +140,14 @@ namespace af3d
 
             Matrix4f modelMat;
             Matrix4f prevModelMat;
-            AABB aabb;
+            AABB aabb = AABB_empty; // Empty for geometry without model matrix.
             MaterialPtr material;
             VertexArraySlice vaSlice;
             GLenum primitiveMode;
             float depthValue;
             ScissorParams scissorParams;
             bool flipCull = false;
+            bool ordered = false;
         };
 
         using GeometryList = std::vector<Geometry>;
@@ -176,6 +177,13 @@ namespace af3d
             float depthValue = 0.0f,
             const ScissorParams& scissorParams = ScissorParams());
 
+        // Draws in call order with other ordered geometry of the same material type and depth value,
+        // even if textures differ, for UI.
+        void addGeometryOrdered(const MaterialPtr& material,
+            const VertexArraySlice& vaSlice, GLenum primitiveMode,
+            float depthValue = 0.0f,
+            const ScissorParams& scissorParams = ScissorParams());
+
         // Create immediate geometry by using default VAO, use only for small stuff like UI!
         VertexArraySlice createGeometry(const VertexImm* vertices, std::uint32_t numVertices,
             const std::uint16_t* indices = nullptr, std::uint32_t numIndices = 0);
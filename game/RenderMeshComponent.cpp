@@ -26,6 +26,8 @@
 #include "RenderMeshComponent.h"
 #include "MaterialManager.h"
 #include "Scene.h"
+#include "Settings.h"
+#include "IndirectDrawManager.h"
 
 namespace af3d
 {
@@ -39,6 +41,7 @@ namespace af3d
     RenderMeshComponent::RenderMeshComponent()
     : RenderComponent(AClass_RenderMeshComponent)
     {
+        setUpdateAlways(false);
     }
 
     const AClass& RenderMeshComponent::staticKlass()
@@ -59,7 +62,21 @@ namespace af3d
             prevModelMat_ = *modelMat_;
         }
 
-        if ((parent()->smoothTransform() == prevParentXf_) && !dirty_) {
+        if (!parent()->transformMoved() && !dirty_) {
+            // Catch up 'prevModel' and visibility.
+            updateIndirect(indirectModelMat_);
+            return;
+        }
+
+        if (dirty_ && (!indirectIdx_.empty() || indirectAllowed())) {
+            // Sub-meshes may have changed, re-register everything.
+            dirty_ = false;
+            removeIndirect();
+            manager()->removeAABB(cookie_);
+            prevAABB_ = calcAABB();
+            addIndirect();
+            cookie_ = manager()->addAABB(this, prevAABB_, nullptr, indirectOnly_);
+            requestUpdate();
             return;
         }
 
@@ -67,17 +84,23 @@ namespace af3d
 
         AABB aabb = calcAABB();
 
-        btVector3 displacement = parent()->smoothTransform().getOrigin() - prevParentXf_.getOrigin();
+        btVector3 displacement = parent()->worldTransform().getOrigin() - parent()->prevWorldTransform().getOrigin();
 
         manager()->moveAABB(cookie_, prevAABB_, aabb, displacement);
 
-        prevParentXf_ = parent()->smoothTransform();
         prevAABB_ = aabb;
+
+        auto prevModelMat = indirectModelMat_;
+        indirectModelMat_ = Matrix4f(parent()->worldTransform() * xf_).scaled(scale_);
+        updateIndirect(prevModelMat);
+
+        // One more update next frame to catch up 'prevModelMat_'.
+        requestUpdate();
     }
 
     void RenderMeshComponent::render(RenderList& rl, void* const* parts, size_t numParts)
     {
-        modelMat_ = Matrix4f(parent()->smoothTransform() * xf_).scaled(scale_);
+        modelMat_ = Matrix4f(parent()->worldTransform() * xf_).scaled(scale_);
 
         render(rl, MaterialPtr());
 
@@ -106,6 +129,15 @@ namespace af3d
 
     std::pair<AObjectPtr, float> RenderMeshComponent::testRay(const Frustum& frustum, const Ray& ray, void* part)
     {
+        if (settings.editor.exactPicking) {
+            MeshRayHit hit;
+            if (testRayExact(ray, hit)) {
+                return std::make_pair(sharedThis(), hit.dist);
+            } else {
+                return std::make_pair(AObjectPtr(), 0.0f);
+            }
+        }
+
         auto res = ray.testAABB(prevAABB_);
         if (res.first) {
             return std::make_pair(sharedThis(), res.second);
@@ -114,48 +146,130 @@ namespace af3d
         }
     }
 
+    bool RenderMeshComponent::testRayExact(const Ray& ray, MeshRayHit& hit)
+    {
+        if (!prevAABB_.contains(ray.pos) && !ray.testAABB(prevAABB_).first) {
+            return false;
+        }
+
+        // Model space ray, 't' is preserved since the mapping is affine.
+        auto modelRay = ray.getTransformed((parent()->worldTransform() * xf_).inverse());
+        modelRay.pos = modelRay.pos / scale_;
+        modelRay.dir = modelRay.dir / scale_;
+
+        return mesh_->testRay(modelRay, hit);
+    }
+
     void RenderMeshComponent::setMesh(const MeshPtr& value)
     {
         mesh_ = value;
         dirty_ = true;
+        requestUpdate();
     }
 
     void RenderMeshComponent::setTransform(const btTransform& value)
     {
         xf_ = value;
         dirty_ = true;
+        requestUpdate();
     }
 
     void RenderMeshComponent::setScale(const btVector3& value)
     {
         scale_ = value;
         dirty_ = true;
+        requestUpdate();
     }
 
     void RenderMeshComponent::onRegister()
     {
-        prevParentXf_ = parent()->smoothTransform();
         prevAABB_ = calcAABB();
-        cookie_ = manager()->addAABB(this, prevAABB_, nullptr);
+        dirty_ = false;
+        addIndirect();
+        cookie_ = manager()->addAABB(this, prevAABB_, nullptr, indirectOnly_);
     }
 
     void RenderMeshComponent::onUnregister()
     {
+        removeIndirect();
         manager()->removeAABB(cookie_);
     }
 
     AABB RenderMeshComponent::calcAABB() const
     {
-        return mesh_->aabb().scaledAt0(scale_).getTransformed(parent()->smoothTransform() * xf_);
+        return mesh_->aabb().scaledAt0(scale_).getTransformed(parent()->worldTransform() * xf_);
     }
 
     void RenderMeshComponent::render(RenderList& rl, const MaterialPtr& material)
     {
         auto prevModelMat = (!material && prevModelMat_) ? *prevModelMat_ : *modelMat_;
-        for (const auto& subMesh : mesh_->subMeshes()) {
+        for (size_t i = 0; i < mesh_->subMeshes().size(); ++i) {
+            const auto& subMesh = mesh_->subMeshes()[i];
+            if (!material && (i < indirectIdx_.size()) && (indirectIdx_[i] >= 0)) {
+                continue;
+            }
             rl.addGeometry(*modelMat_, prevModelMat, prevAABB_,
                 (material ? material : subMesh->material()), subMesh->vaSlice(),
                 GL_TRIANGLES);
         }
     }
+
+    bool RenderMeshComponent::indirectAllowed() const
+    {
+        return settings.gpuDriven && !settings.editor.enabled &&
+            (parent()->bodyType() == BodyType::Static) && cameraFilter().cookies().empty();
+    }
+
+    void RenderMeshComponent::addIndirect()
+    {
+        indirectIdx_.clear();
+        indirectOnly_ = false;
+
+        if (!indirectAllowed()) {
+            return;
+        }
+
+        indirectModelMat_ = Matrix4f(parent()->worldTransform() * xf_).scaled(scale_);
+
+        auto layers = visible() ? getCameraFilterWithFixup().layers() : CameraLayers();
+        auto& mgr = scene()->indirectDrawMgr();
+
+        indirectOnly_ = !mesh_->subMeshes().empty();
+        for (const auto& subMesh : mesh_->subMeshes()) {
+            if (IndirectDrawManager::canDraw(subMesh->material(), subMesh->vaSlice())) {
+                indirectIdx_.push_back(mgr.addInstance(subMesh->material(), subMesh->vaSlice(),
+                    indirectModelMat_, prevAABB_, layers));
+            } else {
+                indirectIdx_.push_back(-1);
+                indirectOnly_ = false;
+            }
+        }
+    }
+
+    void RenderMeshComponent::removeIndirect()
+    {
+        auto& mgr = scene()->indirectDrawMgr();
+        for (auto idx : indirectIdx_) {
+            if (idx >= 0) {
+                mgr.removeInstance(idx);
+            }
+        }
+        indirectIdx_.clear();
+        indirectOnly_ = false;
+    }
+
+    void RenderMeshComponent::updateIndirect(const Matrix4f& prevModelMat)
+    {
+        if (indirectIdx_.empty()) {
+            return;
+        }
+
+        auto layers = visible() ? getCameraFilterWithFixup().layers() : CameraLayers();
+        auto& mgr = scene()->indirectDrawMgr();
+        for (auto idx : indirectIdx_) {
+            if (idx >= 0) {
+                mgr.updateInstance(idx, indirectModelMat_, prevModelMat, prevAABB_, layers);
+            }
+        }
+    }
 }
@@ -51,6 +51,9 @@ namespace af3d
 
         std::pair<AObjectPtr, float> testRay(const Frustum& frustum, const Ray& ray, void* part) override;
 
+        // Triangle-accurate ray test, 'ray' is in world space.
+        bool testRayExact(const Ray& ray, MeshRayHit& hit);
+
         inline const MeshPtr& mesh() const { return mesh_; }
         void setMesh(const MeshPtr& value);
 
@@ -71,11 +74,11 @@ namespace af3d
 
         APropertyValue propertyWorldTransformGet(const std::string&) const
         {
-            return prevParentXf_ * transform();
+            return parent() ? parent()->worldTransform() * transform() : transform();
         }
         void propertyWorldTransformSet(const std::string&, const APropertyValue& value)
         {
-            setTransform(prevParentXf_.inverse() * value.toTransform());
+            setTransform(parent() ? parent()->worldTransform().inverse() * value.toTransform() : value.toTransform());
         }
 
         APropertyValue propertyScaleGet(const std::string&) const { return scale(); }
@@ -90,12 +93,20 @@ namespace af3d
 
         void render(RenderList& rl, const MaterialPtr& material);
 
+        // Static meshes go to IndirectDrawManager outside of the editor.
+        bool indirectAllowed() const;
+
+        void addIndirect();
+
+        void removeIndirect();
+
+        void updateIndirect(const Matrix4f& prevModelMat);
+
         MeshPtr mesh_;
         btTransform xf_ = btTransform::getIdentity();
         btVector3 scale_ = btVector3_one;
         bool dirty_ = false;
 
-        btTransform prevParentXf_ = btTransform::getIdentity();
         AABB prevAABB_;
         RenderCookie* cookie_ = nullptr;
 
@@ -103,6 +114,11 @@ namespace af3d
 
         boost::optional<Matrix4f> prevModelMat_;
         boost::optional<Matrix4f> modelMat_;
+
+        // Per sub-mesh IndirectDrawManager instance index, -1 when drawn on CPU side.
+        std::vector<int> indirectIdx_;
+        Matrix4f indirectModelMat_ = Matrix4f::getIdentity();
+        bool indirectOnly_ = false;
     };
 
     using RenderMeshComponentPtr = std::shared_ptr<RenderMeshComponent>;
@@ -73,10 +73,12 @@ namespace af3d
         GLenum depthFunc, float depthValue, bool flipCull,
         std::vector<HardwareTextureBinding>&& textures, std::vector<StorageBufferBinding>&& storageBuffers,
         const VertexArraySlice& vaSlice, GLenum primitiveMode, const ScissorParams& scissorParams,
-        MaterialParams&& materialParamsAuto)
+        MaterialParams&& materialParamsAuto, bool ordered)
     {
         btAssert(type_ == Type::Root);
 
+        auto bindless = takeBindless(matType, textures);
+
         RenderNode* node = this;
 
         node = node->insertPass(std::move(tmpNode), pass);
@@ -94,11 +96,20 @@ namespace af3d
 
         node = node->insertCullFace(std::move(tmpNode), matCullFaceMode);
         node = node->insertMaterialType(std::move(tmpNode), matType);
+
+        std::vector<HardwareTextureBinding> drawTextures;
+        if (ordered) {
+            // Textures are bound per draw, so that draws differing only in them stay in submission order.
+            drawTextures = std::move(textures);
+            textures.clear();
+        }
+
         node = node->insertTextures(std::move(tmpNode), std::move(textures));
         node = node->insertVertexArray(std::move(tmpNode), vaSlice.va(), std::move(storageBuffers));
         node = node->insertDraw(std::move(tmpNode), numDraws_++);
 
         node->va_ = vaSlice.va();
+        node->textures_ = std::move(drawTextures);
         node->scissorParams_ = scissorParams;
         node->materialParams_ = matParams;
         node->materialParamsAuto_ = std::move(materialParamsAuto);
@@ -108,13 +119,58 @@ namespace af3d
         node->draw_.count = vaSlice.count();
         node->draw_.baseVertex = vaSlice.baseVertex();
         node->draw_.depthWrite = matDepthWrite;
+        node->bindless_ = std::move(bindless);
+    }
+
+    void RenderNode::add(RenderNode&& tmpNode, int pass, const DrawBufferBinding& drawBufferBinding,
+        const MaterialTypePtr& matType,
+        const MaterialParams& matParams,
+        const BlendingParams& matBlendingParams,
+        bool matDepthTest,
+        bool matDepthWrite,
+        GLenum matCullFaceMode,
+        GLenum depthFunc,
+        std::vector<HardwareTextureBinding>&& textures, std::vector<StorageBufferBinding>&& storageBuffers,
+        const VertexArrayPtr& va, GLenum primitiveMode,
+        const IndirectDrawBinding& indirect, MaterialParams&& materialParamsAuto)
+    {
+        btAssert(type_ == Type::Root);
+        btAssert(va->ebo());
+
+        auto bindless = takeBindless(matType, textures);
+
+        RenderNode* node = this;
+
+        node = node->insertPass(std::move(tmpNode), pass);
+        node = node->insertDepthTest(std::move(tmpNode), matDepthTest, depthFunc);
+        node = node->insertDepth(std::move(tmpNode), 0.0f);
+        node = node->insertBlendingParams(std::move(tmpNode), matBlendingParams);
+        node = node->insertCullFace(std::move(tmpNode), matCullFaceMode);
+        node = node->insertMaterialType(std::move(tmpNode), matType);
+        node = node->insertTextures(std::move(tmpNode), std::move(textures));
+        node = node->insertVertexArray(std::move(tmpNode), va, std::move(storageBuffers));
+        node = node->insertDraw(std::move(tmpNode), numDraws_++);
+
+        node->va_ = va;
+        node->materialParams_ = matParams;
+        node->materialParamsAuto_ = std::move(materialParamsAuto);
+        node->draw_.bufferBinding = drawBufferBinding;
+        node->draw_.primitiveMode = primitiveMode;
+        node->draw_.start = 0;
+        node->draw_.count = 0;
+        node->draw_.baseVertex = 0;
+        node->draw_.depthWrite = matDepthWrite;
+        node->indirect_ = indirect;
+        node->bindless_ = std::move(bindless);
     }
 
     void RenderNode::add(RenderNode&& tmpNode, int pass, const MaterialPtr& material,
         const VertexArrayPtr& va,
-        std::vector<StorageBufferBinding>&& storageBuffers,
+        std::vector<HardwareTextureBinding>&& textures, std::vector<StorageBufferBinding>&& storageBuffers,
         const Vector3i& computeNumGroups,
-        MaterialParams&& materialParamsAuto)
+        MaterialParams&& materialParamsAuto,
+        std::vector<HardwareImageBinding>&& images,
+        GLbitfield barriers)
     {
         btAssert(type_ == Type::Root);
         btAssert(material->type()->isCompute());
@@ -127,13 +183,15 @@ namespace af3d
         node = node->insertBlendingParams(std::move(tmpNode), BlendingParams());
         node = node->insertCullFace(std::move(tmpNode), 0);
         node = node->insertMaterialType(std::move(tmpNode), material->type());
-        node = node->insertTextures(std::move(tmpNode), std::vector<HardwareTextureBinding>{});
+        node = node->insertTextures(std::move(tmpNode), std::move(textures));
         node = node->insertVertexArray(std::move(tmpNode), va, std::move(storageBuffers));
         node = node->insertDraw(std::move(tmpNode), numDraws_++);
 
         node->materialParams_ = material->params();
         node->materialParamsAuto_ = std::move(materialParamsAuto);
         node->computeNumGroups_ = computeNumGroups;
+        node->images_ = std::move(images);
+        node->barriers_ = barriers;
     }
 
     bool RenderNode::operator<(const RenderNode& other) const
@@ -251,6 +309,38 @@ namespace af3d
         return draw_.idx < other.draw_.idx;
     }
 
+    std::vector<BindlessTextureBinding> RenderNode::takeBindless(const MaterialTypePtr& matType,
+        std::vector<HardwareTextureBinding>& textures)
+    {
+        std::vector<BindlessTextureBinding> res;
+
+        const auto& prog = matType->prog();
+        if (prog->bindlessSamplers().empty()) {
+            return res;
+        }
+
+        // 'textures' are in active sampler order, units skip bindless ones, see HardwareProgram::fillUniforms.
+        size_t k = 0, numUnits = 0;
+        for (int i = 0; (i <= static_cast<int>(SamplerName::Max)) && (k < textures.size()); ++i) {
+            SamplerName sName = static_cast<SamplerName>(i);
+            if (!prog->samplers()[sName]) {
+                continue;
+            }
+            if (prog->bindlessSamplers()[sName]) {
+                res.emplace_back(prog->bindlessLocation(sName), std::move(textures[k]));
+            } else {
+                if (numUnits != k) {
+                    textures[numUnits] = std::move(textures[k]);
+                }
+                ++numUnits;
+            }
+            ++k;
+        }
+        textures.resize(numUnits);
+
+        return res;
+    }
+
     RenderNode* RenderNode::insertPass(RenderNode&& tmpNode, int pass)
     {
         tmpNode.type_ = Type::Pass;
@@ -326,11 +416,14 @@ namespace af3d
     {
         //LOG4CPLUS_DEBUG(logger(), "draw(" << numDraws_ << ")");
         bool haveFb = ctx.setMRT(mrt_);
-        ogl.Viewport(viewport_.lowerBound[0], viewport_.lowerBound[1],
+        ctx.setViewport(viewport_.lowerBound[0], viewport_.lowerBound[1],
             viewport_.upperBound[0] - viewport_.lowerBound[0],
             viewport_.upperBound[1] - viewport_.lowerBound[1]);
+        // Clears obey scissor test and depth mask, these are left as the last draw set them.
+        ctx.setScissorTest(false);
         GLbitfield mask = 0;
         if (clearMask_[AttachmentPoint::Depth]) {
+            ctx.setDepthMask(true);
             mask |= GL_DEPTH_BUFFER_BIT;
         }
         if (clearMask_[AttachmentPoint::Stencil]) {
@@ -344,7 +437,7 @@ namespace af3d
             if (clearMask_[p]) {
                 if (haveFb) {
                     GLenum buffer = glAttachmentPoint(p);
-                    ogl.DrawBuffers(1, &buffer);
+                    ctx.setDrawBuffers(1, &buffer);
                 } else {
                     btAssert(p == AttachmentPoint::Color0);
                 }
@@ -362,11 +455,9 @@ namespace af3d
     void RenderNode::applyDepthTest(HardwareContext& ctx) const
     {
         if (depthTest_) {
-            ogl.DepthFunc(depthFunc_);
-            ogl.Enable(GL_DEPTH_TEST);
-        } else {
-            ogl.Disable(GL_DEPTH_TEST);
+            ctx.setDepthFunc(depthFunc_);
         }
+        ctx.setDepthTest(depthTest_);
     }
 
     void RenderNode::applyDepth(HardwareContext& ctx) const
@@ -376,40 +467,35 @@ namespace af3d
     void RenderNode::applyBlendingParams(HardwareContext& ctx) const
     {
         if (blendingParams_.isEnabled()) {
-            ogl.BlendFuncSeparate(blendingParams_.blendSfactor, blendingParams_.blendDfactor,
+            ctx.setBlendFunc(blendingParams_.blendSfactor, blendingParams_.blendDfactor,
                 blendingParams_.blendSfactorAlpha, blendingParams_.blendDfactorAlpha);
-            ogl.Enable(GL_BLEND);
-        } else {
-            ogl.Disable(GL_BLEND);
         }
+        ctx.setBlend(blendingParams_.isEnabled());
     }
 
     void RenderNode::applyCullFace(HardwareContext& ctx) const
     {
-        if (cullFaceMode_) {
-            ogl.CullFace(cullFaceMode_);
-            ogl.Enable(GL_CULL_FACE);
-        } else {
-            ogl.Disable(GL_CULL_FACE);
-        }
+        ctx.setCullFace(cullFaceMode_);
     }
 
     void RenderNode::applyMaterialType(HardwareContext& ctx) const
     {
-        ogl.UseProgram(materialType_->prog()->id(ctx));
+        ctx.useProgram(materialType_->prog()->id(ctx));
     }
 
     void RenderNode::applyTextures(HardwareContext& ctx) const
     {
+        static const SamplerId nearestSampler = SamplerParams(GL_NEAREST, GL_NEAREST).intern();
+
         for (int i = 0; i < static_cast<int>(textures_.size()); ++i) {
             ctx.setActiveTextureUnit(i);
             GLuint id = textures_[i].tex ? textures_[i].tex->id(ctx) : 0;
             if (id == 0) {
                 id = textureManager.white1x1()->hwTex()->id(ctx);
-                ctx.bindSampler(i, SamplerParams(GL_NEAREST, GL_NEAREST));
+                ctx.bindSampler(i, nearestSampler);
                 ctx.bindTexture(textureManager.white1x1()->type(), id);
             } else {
-                ctx.bindSampler(i, textures_[i].params);
+                ctx.bindSampler(i, textures_[i].samplerId);
                 ctx.bindTexture(textures_[i].tex->type(), id);
             }
         }
@@ -417,16 +503,16 @@ namespace af3d
 
     void RenderNode::applyVertexArray(HardwareContext& ctx) const
     {
-        ogl.BindVertexArray(va_->vao(ctx)->id(ctx));
+        ctx.bindVertexArray(va_->vao(ctx)->id(ctx));
         for (const auto& bb : storageBuffers_) {
-            ogl.BindBufferBase(GL_SHADER_STORAGE_BUFFER,
-                HardwareProgram::getStorageBufferIndex(bb.first), bb.second->id(ctx));
+            ctx.bindStorageBuffer(HardwareProgram::getStorageBufferIndex(bb.first), bb.second->id(ctx));
         }
     }
 
     void RenderNode::applyVertexArrayDone(HardwareContext& ctx) const
     {
-        ogl.BindVertexArray(0);
+        // Buffer uploads bind GL_ELEMENT_ARRAY_BUFFER, keep them off the VAO.
+        ctx.bindVertexArray(0);
     }
 
     void RenderNode::applyDraw(HardwareContext& ctx) const
@@ -435,25 +521,61 @@ namespace af3d
         materialParams_.apply(ctx);
 
         if (computeNumGroups_) {
+            for (size_t i = 0; i < images_.size(); ++i) {
+                const auto& img = images_[i];
+                ogl.BindImageTexture(i, img.tex->id(ctx), img.level, GL_FALSE, 0, img.access, img.format);
+            }
             ogl.DispatchCompute(computeNumGroups_->x(), computeNumGroups_->y(), computeNumGroups_->z());
-            ogl.MemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            if (images_.empty()) {
+                ogl.MemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | barriers_);
+            } else {
+                // Image writes are usually sampled next, by the following dispatch or a filter.
+                ogl.MemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | barriers_);
+            }
             return;
         }
 
         if (scissorParams_.enabled) {
-            ogl.Scissor(scissorParams_.x, scissorParams_.y, scissorParams_.width, scissorParams_.height);
-            ogl.Enable(GL_SCISSOR_TEST);
+            ctx.setScissor(scissorParams_.x, scissorParams_.y, scissorParams_.width, scissorParams_.height);
         }
+        ctx.setScissorTest(scissorParams_.enabled);
 
-        if (!draw_.depthWrite) {
-            ogl.DepthMask(GL_FALSE);
+        ctx.setDepthMask(draw_.depthWrite);
+
+        if (!textures_.empty()) {
+            applyTextures(ctx);
+        }
+
+        static const SamplerId nearestSampler = SamplerParams(GL_NEAREST, GL_NEAREST).intern();
+
+        for (const auto& b : bindless_) {
+            const auto& tb = b.second;
+            GLuint64 handle;
+            if (tb.tex && (tb.tex->id(ctx) != 0)) {
+                handle = ctx.textureHandle(tb.tex, tb.samplerId);
+            } else {
+                handle = ctx.textureHandle(textureManager.white1x1()->hwTex(), nearestSampler);
+            }
+            ogl.UniformHandleui64ARB(b.first, handle);
         }
 
         if (draw_.bufferBinding.numBuffers >= 0) {
-            ogl.DrawBuffers(draw_.bufferBinding.numBuffers, &draw_.bufferBinding.buffers[0]);
+            ctx.setDrawBuffers(draw_.bufferBinding.numBuffers, &draw_.bufferBinding.buffers[0]);
         }
 
-        if (draw_.count == 0) {
+        if (indirect_.commands) {
+            GLint instanceIdxLocation = HardwareProgram::getVertexAttribLocation(VertexAttribName::InstanceIdx);
+            ogl.BindBuffer(GL_ARRAY_BUFFER, indirect_.instances->id(ctx));
+            ogl.VertexAttribIPointer(instanceIdxLocation, 1, GL_UNSIGNED_INT, 0, nullptr);
+            ogl.VertexAttribDivisor(instanceIdxLocation, 1);
+            ogl.EnableVertexAttribArray(instanceIdxLocation);
+            ogl.BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_.commands->id(ctx));
+            ogl.MultiDrawElementsIndirect(draw_.primitiveMode, va_->ebo()->glDataType(),
+                (const void*)(indirect_.commands->elementSize() * indirect_.first), indirect_.count, 0);
+            ogl.BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            ogl.DisableVertexAttribArray(instanceIdxLocation);
+            ogl.VertexAttribDivisor(instanceIdxLocation, 0);
+        } else if (draw_.count == 0) {
             if (va_->ebo()) {
                 ogl.DrawElements(draw_.primitiveMode, va_->ebo()->count(ctx),
                     va_->ebo()->glDataType(),
@@ -470,13 +592,5 @@ namespace af3d
                 ogl.DrawArrays(draw_.primitiveMode, draw_.start, draw_.count);
             }
         }
-
-        if (!draw_.depthWrite) {
-            ogl.DepthMask(GL_TRUE);
-        }
-
-        if (scissorParams_.enabled) {
-            ogl.Disable(GL_SCISSOR_TEST);
-        }
     }
 }
@@ -29,6 +29,7 @@
 #include "Material.h"
 #include "VertexArraySlice.h"
 #include "HardwareMRT.h"
+#include "HardwareDataBuffer.h"
 #include "af3d/AABB2.h"
 #include <set>
 #include <boost/optional.hpp>
@@ -57,6 +58,47 @@ namespace af3d
 
     using StorageBufferBinding = std::pair<StorageBufferName, HardwareDataBufferPtr>;
 
+    // Uniform location and texture for samplers set with bindless handles.
+    using BindlessTextureBinding = std::pair<GLint, HardwareTextureBinding>;
+
+    // Compute only, image unit is the index in the binding list.
+    struct HardwareImageBinding
+    {
+        HardwareImageBinding() = default;
+        HardwareImageBinding(const HardwareTexturePtr& tex,
+            GLint level,
+            GLenum access,
+            GLenum format)
+        : tex(tex),
+          level(level),
+          access(access),
+          format(format) {}
+
+        HardwareTexturePtr tex;
+        GLint level = 0;
+        GLenum access = GL_WRITE_ONLY;
+        GLenum format = GL_RGBA16F;
+    };
+
+    // Multi-draw-indirect, command range and visible instance indices are written by GPU culling.
+    struct IndirectDrawBinding
+    {
+        IndirectDrawBinding() = default;
+        IndirectDrawBinding(const HardwareDataBufferPtr& commands,
+            const HardwareDataBufferPtr& instances,
+            std::uint32_t first,
+            std::uint32_t count)
+        : commands(commands),
+          instances(instances),
+          first(first),
+          count(count) {}
+
+        HardwareDataBufferPtr commands;
+        HardwareDataBufferPtr instances; // Fed to 'instanceIdx' attribute, offset by each command's 'baseInstance'.
+        std::uint32_t first = 0;
+        std::uint32_t count = 0;
+    };
+
     struct DrawBufferBinding
     {
         DrawBufferBinding() = default;
@@ -88,13 +130,29 @@ namespace af3d
             GLenum depthFunc, float depthValue, bool flipCull,
             std::vector<HardwareTextureBinding>&& textures, std::vector<StorageBufferBinding>&& storageBuffers,
             const VertexArraySlice& vaSlice, GLenum primitiveMode,
-            const ScissorParams& scissorParams, MaterialParams&& materialParamsAuto);
+            const ScissorParams& scissorParams, MaterialParams&& materialParamsAuto,
+            bool ordered = false);
+
+        void add(RenderNode&& tmpNode, int pass, const DrawBufferBinding& drawBufferBinding,
+            const MaterialTypePtr& matType,
+            const MaterialParams& matParams,
+            const BlendingParams& matBlendingParams,
+            bool matDepthTest,
+            bool matDepthWrite,
+            GLenum matCullFaceMode,
+            GLenum depthFunc,
+            std::vector<HardwareTextureBinding>&& textures, std::vector<StorageBufferBinding>&& storageBuffers,
+            const VertexArrayPtr& va, GLenum primitiveMode,
+            const IndirectDrawBinding& indirect, MaterialParams&& materialParamsAuto);
 
+        // 'barriers' are added to the default post-dispatch memory barrier.
         void add(RenderNode&& tmpNode, int pass, const MaterialPtr& material,
             const VertexArrayPtr& va,
-            std::vector<StorageBufferBinding>&& storageBuffers,
+            std::vector<HardwareTextureBinding>&& textures, std::vector<StorageBufferBinding>&& storageBuffers,
             const Vector3i& computeNumGroups,
-            MaterialParams&& materialParamsAuto);
+            MaterialParams&& materialParamsAuto,
+            std::vector<HardwareImageBinding>&& images = std::vector<HardwareImageBinding>(),
+            GLbitfield barriers = 0);
 
         bool operator<(const RenderNode& other) const;
 
@@ -117,6 +175,13 @@ namespace af3d
 
         using Children = std::set<RenderNode>;
 
+        /*
+         * Moves textures of 'matType' bindless samplers out of 'textures', the rest stay
+         * in texture unit order, so materials that differ only in these share a Textures node.
+         */
+        static std::vector<BindlessTextureBinding> takeBindless(const MaterialTypePtr& matType,
+            std::vector<HardwareTextureBinding>& textures);
+
         bool comparePass(const RenderNode& other) const;
         bool compareDepthTest(const RenderNode& other) const;
         bool compareDepth(const RenderNode& other) const;
@@ -201,7 +266,7 @@ namespace af3d
         // Type::MaterialType
         MaterialTypePtr materialType_;
 
-        // Type::Textures
+        // Type::Textures and ordered Type::Draw
         std::vector<HardwareTextureBinding> textures_;
 
         // Type::VertexArray
@@ -215,6 +280,10 @@ namespace af3d
         MaterialParams materialParams_;
         MaterialParams materialParamsAuto_;
         boost::optional<Vector3i> computeNumGroups_;
+        std::vector<HardwareImageBinding> images_;
+        GLbitfield barriers_ = 0;
+        IndirectDrawBinding indirect_;
+        std::vector<BindlessTextureBinding> bindless_;
 
         Children children_;
     };
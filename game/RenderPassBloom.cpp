@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "RenderPassBloom.h"
+#include "CameraRenderer.h"
+#include "HardwareResourceManager.h"
+#include "MaterialManager.h"
+
+namespace af3d
+{
+    RenderPassBloom::RenderPassBloom(const TexturePtr& inputTex, const TexturePtr& mipsTex,
+        int numMips, float brightnessThreshold, bool karisAverage)
+    : mipsTex_(mipsTex),
+      numMips_(numMips)
+    {
+        btAssert(numMips_ >= 1);
+
+        matPrefilter_ = materialManager.createMaterial(karisAverage ? MaterialTypeBloomPrefilterKaris : MaterialTypeBloomPrefilter);
+        matPrefilter_->setTextureBinding(SamplerName::Main,
+            TextureBinding(inputTex,
+                SamplerParams(GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR)));
+        matPrefilter_->params().setUniform(UniformName::Threshold, brightnessThreshold);
+        matPrefilter_->params().setUniform(UniformName::MipLevel, 0.0f);
+
+        for (int i = 0; i + 1 < numMips_; ++i) {
+            auto mat = materialManager.createMaterial(MaterialTypeBloomDownsample);
+            mat->setTextureBinding(SamplerName::Main,
+                TextureBinding(mipsTex_,
+                    SamplerParams(GL_LINEAR_MIPMAP_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR)));
+            mat->params().setUniform(UniformName::MipLevel, static_cast<float>(i));
+            matsDown_.push_back(mat);
+
+            mat = materialManager.createMaterial(MaterialTypeBloomUpsample);
+            mat->setTextureBinding(SamplerName::Main,
+                TextureBinding(mipsTex_,
+                    SamplerParams(GL_LINEAR_MIPMAP_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR)));
+            mat->params().setUniform(UniformName::MipLevel, static_cast<float>(i + 1));
+            matsUp_.push_back(mat);
+        }
+    }
+
+    int RenderPassBloom::compile(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn)
+    {
+        if (!va_) {
+            va_ = std::make_shared<VertexArray>(hwManager.createVertexArray(), VertexArrayLayout(), VBOList());
+        }
+
+        // Don't go below 8x8, texture could've been resized since construction.
+        int numMips = 1;
+        while ((numMips < numMips_) &&
+            ((mipsTex_->width() >> numMips) >= 8) && ((mipsTex_->height() >> numMips) >= 8)) {
+            ++numMips;
+        }
+
+        addDispatch(cr, rl, pass++, rn, matPrefilter_, 0, GL_WRITE_ONLY);
+
+        for (int i = 0; i + 1 < numMips; ++i) {
+            addDispatch(cr, rl, pass++, rn, matsDown_[i], i + 1, GL_WRITE_ONLY);
+        }
+
+        for (int i = numMips - 2; i >= 0; --i) {
+            addDispatch(cr, rl, pass++, rn, matsUp_[i], i, GL_READ_WRITE);
+        }
+
+        return pass;
+    }
+
+    void RenderPassBloom::addDispatch(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn,
+        const MaterialPtr& material, GLint level, GLenum access) const
+    {
+        RenderNode tmpNode;
+
+        std::vector<HardwareTextureBinding> textures;
+        std::vector<StorageBufferBinding> storageBuffers;
+        MaterialParams params(material->type(), true);
+        cr.setAutoParams(rl, material, 0, textures, storageBuffers, params);
+
+        std::vector<HardwareImageBinding> images;
+        images.emplace_back(mipsTex_->hwTex(), level, access, GL_R11F_G11F_B10F);
+
+        std::uint32_t width = std::max(mipsTex_->width() >> level, 1U);
+        std::uint32_t height = std::max(mipsTex_->height() >> level, 1U);
+
+        // 8x8 local size, one invocation per output texel.
+        Vector3i numGroups((width + 7) / 8, (height + 7) / 8, 1);
+
+        rn->add(std::move(tmpNode), pass, material, va_,
+            std::move(textures), std::move(storageBuffers), numGroups, std::move(params), std::move(images));
+    }
+}
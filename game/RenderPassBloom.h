@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RENDERPASS_BLOOM_H_
+#define _RENDERPASS_BLOOM_H_
+
+#include "RenderPass.h"
+#include "Texture.h"
+
+namespace af3d
+{
+    /*
+     * Compute bloom, dispatches only, the camera renderer needs no render targets.
+     * Thresholded scene color is downsampled with a 13-tap filter into 'mipsTex' mip 0,
+     * then down the mip chain, then tent upsampled back up while accumulating, so that
+     * mip 0 ends up holding the bloom. 'mipsTex' must be mipmapped R11F_G11F_B10F.
+     */
+    class RenderPassBloom : public RenderPass
+    {
+    public:
+        RenderPassBloom(const TexturePtr& inputTex, const TexturePtr& mipsTex,
+            int numMips, float brightnessThreshold, bool karisAverage);
+        ~RenderPassBloom() = default;
+
+        // Samples the scene color, TAA rebinds its input.
+        inline const MaterialPtr& prefilterMaterial() const { return matPrefilter_; }
+
+        int compile(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn) override;
+
+    private:
+        void addDispatch(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn,
+            const MaterialPtr& material, GLint level, GLenum access) const;
+
+        TexturePtr mipsTex_;
+        int numMips_;
+        VertexArrayPtr va_; // empty VA, needed for VAO.
+        MaterialPtr matPrefilter_;
+        std::vector<MaterialPtr> matsDown_; // Sources mip 'i', writes mip 'i + 1'.
+        std::vector<MaterialPtr> matsUp_; // Sources mip 'i + 1', accumulates into mip 'i'.
+    };
+
+    using RenderPassBloomPtr = std::shared_ptr<RenderPassBloom>;
+}
+
+#endif
@@ -44,6 +44,31 @@ namespace af3d
         AttachmentPoints prepassDrawBuffers;
         prepassDrawBuffers.set(AttachmentPoint::Depth);
 
+        auto& indirectMgr = rl.env()->indirectDrawMgr();
+        IndirectDrawBinding indirect;
+        pass = indirectMgr.cull(cr, rl, pass, rn, indirect);
+
+        if (indirect.commands) {
+            const auto& mat = materialManager.matShadowIndirect();
+            DrawBufferBinding drawBufferBinding(prepassDrawBuffers, mat->type()->prog()->outputs());
+            for (const auto& group : indirectMgr.groups()) {
+                MaterialParams params(mat->type(), true);
+                cr.setAutoParams(rl, mat, drawBufferBinding.mask, textures, storageBuffers, params);
+                rn->add(std::move(tmpNode), pass, drawBufferBinding,
+                    mat->type(),
+                    mat->params(),
+                    mat->blendingParams(),
+                    group.material->depthTest(),
+                    group.material->depthWrite(),
+                    group.material->cullFaceMode(),
+                    GL_LESS,
+                    std::move(textures), std::move(storageBuffers),
+                    group.va, GL_TRIANGLES,
+                    IndirectDrawBinding(indirect.commands, indirect.instances, group.firstCmd, group.numCmds),
+                    std::move(params));
+            }
+        }
+
         for (const auto& geom : rl.geomList()) {
             if ((geom.material->type()->name() != MaterialTypeSkyBox) && !geom.material->blendingParams().isEnabled()) {
                 const auto& activeUniforms = geom.material->type()->prog()->activeUniforms();
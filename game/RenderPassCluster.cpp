@@ -33,14 +33,22 @@
 
 namespace af3d
 {
+    RenderPassCluster::RenderPassCluster(bool zPrepassed)
+    : zPrepassed_(zPrepassed)
+    {
+    }
+
     int RenderPassCluster::compile(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn)
     {
         bool needClusterData = false;
+        bool needFrontClusters = false;
         for (const auto& geom : rl.geomList()) {
-            if (!needClusterData) {
-                const auto& ssbos = geom.material->type()->prog()->storageBuffers();
-                if (ssbos[StorageBufferName::ClusterTileData]) {
-                    needClusterData = true;
+            const auto& ssbos = geom.material->type()->prog()->storageBuffers();
+            if (ssbos[StorageBufferName::ClusterTileData]) {
+                needClusterData = true;
+                if (geom.material->blendingParams().isEnabled()) {
+                    // Transparent geometry isn't in depth buffer, it can be anywhere in front of it.
+                    needFrontClusters = true;
                     break;
                 }
             }
@@ -65,6 +73,9 @@ namespace af3d
         if (!probeIndicesSSBO_) {
             probeIndicesSSBO_ = hwManager.createDataBuffer(HardwareBuffer::Usage::StaticCopy, sizeof(std::uint32_t));
         }
+        if (!activeSSBO_) {
+            activeSSBO_ = hwManager.createDataBuffer(HardwareBuffer::Usage::StaticCopy, sizeof(std::uint32_t));
+        }
         if (tilesSSBO_->setValid()) {
             auto ssbo = tilesSSBO_;
             renderer.scheduleHwOp([ssbo](HardwareContext& ctx) {
@@ -80,7 +91,7 @@ namespace af3d
         if (lightIndicesSSBO_->setValid()) {
             auto ssbo = lightIndicesSSBO_;
             renderer.scheduleHwOp([ssbo](HardwareContext& ctx) {
-                ssbo->resize(settings.cluster.numTiles * settings.cluster.maxLightsPerTile, ctx);
+                ssbo->resize(settings.cluster.maxLightIndices, ctx);
             });
         }
         if (probeIndicesSSBO_->setValid()) {
@@ -89,6 +100,14 @@ namespace af3d
                 ssbo->resize(settings.cluster.numTiles * settings.cluster.maxProbesPerTile, ctx);
             });
         }
+        if (activeSSBO_->setValid()) {
+            auto ssbo = activeSSBO_;
+            renderer.scheduleHwOp([ssbo](HardwareContext& ctx) {
+                // Cull pass clears the flags it consumes, so they must start out cleared.
+                std::vector<std::uint32_t> data(settings.cluster.numTiles + 1, 0);
+                ssbo->reload(data.size(), &data[0], ctx);
+            });
+        }
 
         RenderNode tmpNode;
 
@@ -102,16 +121,39 @@ namespace af3d
             MaterialParams params(material->type(), true);
             cr.setAutoParams(rl, material, 0, textures, storageBuffers, params);
             rn->add(std::move(tmpNode), pass, material, va_,
-                std::move(storageBuffers), settings.cluster.gridSize, std::move(params));
+                std::move(textures), std::move(storageBuffers), settings.cluster.gridSize, std::move(params));
+        }
+
+        const auto& depthTarget = cr.renderTarget(AttachmentPoint::Depth);
+
+        if (zPrepassed_ && depthTarget.texture()) {
+            auto& mat = needFrontClusters ? matMarkFront_ : matMark_;
+            if (!mat) {
+                mat = materialManager.createMaterial(needFrontClusters ? MaterialTypeClusterMarkFront : MaterialTypeClusterMark);
+                mat->setTextureBinding(SamplerName::Depth,
+                    TextureBinding(depthTarget.texture(), SamplerParams(GL_NEAREST, GL_NEAREST)));
+            }
+            MaterialParams params(mat->type(), true);
+            cr.setAutoParams(rl, mat, 0, textures, storageBuffers, params);
+            // 8x8 local size, one invocation per depth sample.
+            Vector3i numGroups((depthTarget.width() + 7) / 8, (depthTarget.height() + 7) / 8, 1);
+            rn->add(std::move(tmpNode), pass + 1, mat, va_,
+                std::move(textures), std::move(storageBuffers), numGroups, std::move(params));
+        } else {
+            auto material = materialManager.matClusterMarkAll();
+            MaterialParams params(material->type(), true);
+            cr.setAutoParams(rl, material, 0, textures, storageBuffers, params);
+            rn->add(std::move(tmpNode), pass + 1, material, va_,
+                std::move(textures), std::move(storageBuffers), Vector3i(1, 1, settings.cluster.gridSize.z()), std::move(params));
         }
 
         auto material = materialManager.matClusterCull();
         MaterialParams params(material->type(), true);
         cr.setAutoParams(rl, material, 0, textures, storageBuffers, params);
-        rn->add(std::move(tmpNode), pass + 1, material, va_,
-            std::move(storageBuffers), settings.cluster.cullNumGroups, std::move(params));
+        rn->add(std::move(tmpNode), pass + 2, material, va_,
+            std::move(textures), std::move(storageBuffers), settings.cluster.cullNumGroups, std::move(params));
 
-        return pass + 2;
+        return pass + 3;
     }
 
     void RenderPassCluster::fillParams(const MaterialPtr& material, std::vector<StorageBufferBinding>& storageBuffers, MaterialParams& params) const
@@ -133,6 +175,11 @@ namespace af3d
             storageBuffers.emplace_back(StorageBufferName::ClusterLightIndices, lightIndicesSSBO_);
         }
 
+        if (ssboNames[StorageBufferName::ClusterActive]) {
+            btAssert(activeSSBO_);
+            storageBuffers.emplace_back(StorageBufferName::ClusterActive, activeSSBO_);
+        }
+
         if (ssboNames[StorageBufferName::ClusterProbeIndices]) {
             btAssert(probeIndicesSSBO_);
             storageBuffers.emplace_back(StorageBufferName::ClusterProbeIndices, probeIndicesSSBO_);
@@ -33,7 +33,9 @@ namespace af3d
     class RenderPassCluster : public RenderPass
     {
     public:
-        RenderPassCluster() = default;
+        // 'zPrepassed' - depth buffer is filled by a prepass before this pass runs, use it
+        // to only cull lights for occupied clusters.
+        explicit RenderPassCluster(bool zPrepassed = false);
         ~RenderPassCluster() = default;
 
         int compile(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn) override;
@@ -41,11 +43,15 @@ namespace af3d
         void fillParams(const MaterialPtr& material, std::vector<StorageBufferBinding>& storageBuffers, MaterialParams& params) const override;
 
     private:
+        bool zPrepassed_ = false;
+        MaterialPtr matMark_;
+        MaterialPtr matMarkFront_;
         Matrix4f prevProjMat_ = Matrix4f::getIdentity();
         VertexArrayPtr va_; // empty VA, needed for VAO.
         HardwareDataBufferPtr tilesSSBO_; // tile grid built for 'proj' matrix.
         HardwareDataBufferPtr tileDataSSBO_; // tile data obtained by culling lights.
-        HardwareDataBufferPtr lightIndicesSSBO_; // indices of lights being used.
+        HardwareDataBufferPtr lightIndicesSSBO_; // indices of lights being used, allocated by atomic offset.
+        HardwareDataBufferPtr activeSSBO_; // light index counter followed by active cluster flags.
         HardwareDataBufferPtr probeIndicesSSBO_; // indices of probes being used.
     };
 
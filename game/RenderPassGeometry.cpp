@@ -28,11 +28,66 @@
 
 namespace af3d
 {
-    RenderPassGeometry::RenderPassGeometry(const AttachmentPoints& colorAttachments, bool withOpaque, bool withTransparent, bool zPrepassed)
+    // Consecutive sorted geometry that ends up under the same state nodes.
+    static bool sameBatch(const RenderList::Geometry& a, const RenderList::Geometry& b)
+    {
+        if ((a.vaSlice.va() != b.vaSlice.va()) || (a.flipCull != b.flipCull)) {
+            return false;
+        }
+        if (a.material == b.material) {
+            return true;
+        }
+        // Ordered geometry binds textures per draw, the rest of the state must match.
+        const auto& ma = *a.material;
+        const auto& mb = *b.material;
+        return a.ordered && b.ordered && (ma.type() == mb.type()) &&
+            !(ma.blendingParams() < mb.blendingParams()) && !(mb.blendingParams() < ma.blendingParams()) &&
+            (ma.depthTest() == mb.depthTest()) && (ma.cullFaceMode() == mb.cullFaceMode());
+    }
+
+    static void addGeometry(const CameraRenderer& cr, const RenderList& rl, const RenderList::Geometry& geom,
+        const AttachmentPoints& drawBuffers, bool zPrepassed, int basePass, float depthValue, const RenderNodePtr& rn, RenderNode& tmpNode)
+    {
+        std::vector<HardwareTextureBinding> textures;
+        std::vector<StorageBufferBinding> storageBuffers;
+
+        bool transparent = geom.material->blendingParams().isEnabled();
+        DrawBufferBinding drawBufferBinding(drawBuffers, geom.material->type()->prog()->outputs());
+        MaterialParams params(geom.material->type(), true);
+        cr.setAutoParams(rl, geom, drawBufferBinding.mask, textures, storageBuffers, params);
+
+        int pass;
+        if (geom.material->type()->name() == MaterialTypeSkyBox) {
+            pass = basePass + 1;
+        } else if (transparent) {
+            pass = basePass + 2;
+        } else {
+            pass = basePass;
+        }
+
+        // Prepass only covers opaque geometry.
+        GLenum depthFunc = (zPrepassed && (pass == basePass)) ? GL_EQUAL : GL_LEQUAL;
+
+        rn->add(std::move(tmpNode), pass, drawBufferBinding,
+            geom.material->type(),
+            geom.material->params(),
+            geom.material->blendingParams(),
+            geom.material->depthTest(),
+            zPrepassed ? false : geom.material->depthWrite(),
+            geom.material->cullFaceMode(),
+            depthFunc, depthValue, geom.flipCull,
+            std::move(textures), std::move(storageBuffers),
+            geom.vaSlice, geom.primitiveMode, geom.scissorParams,
+            std::move(params), geom.ordered);
+    }
+
+    RenderPassGeometry::RenderPassGeometry(const AttachmentPoints& colorAttachments, bool withOpaque, bool withTransparent, bool zPrepassed,
+        const RenderPassHiZPtr& hiZ)
     : colorAttachments_(colorAttachments),
       withOpaque_(withOpaque),
       withTransparent_(withTransparent),
-      zPrepassed_(zPrepassed)
+      zPrepassed_(zPrepassed),
+      hiZ_(hiZ)
     {
     }
 
@@ -48,10 +103,44 @@ namespace af3d
 
         RenderNode tmpNode;
 
-        std::vector<HardwareTextureBinding> textures;
-        std::vector<StorageBufferBinding> storageBuffers;
+        if (withOpaque_) {
+            std::vector<HardwareTextureBinding> textures;
+            std::vector<StorageBufferBinding> storageBuffers;
+
+            auto& indirectMgr = rl.env()->indirectDrawMgr();
+            IndirectDrawBinding indirect;
+            basePass = indirectMgr.cull(cr, rl, basePass, rn, indirect,
+                (hiZ_ && hiZ_->active()) ? hiZ_->texture() : TexturePtr());
+
+            if (indirect.commands) {
+                for (const auto& group : indirectMgr.groups()) {
+                    const auto& mat = group.indirectMaterial;
+                    DrawBufferBinding drawBufferBinding(drawBuffers, mat->type()->prog()->outputs());
+                    MaterialParams params(mat->type(), true);
+                    cr.setAutoParams(rl, mat, drawBufferBinding.mask, textures, storageBuffers, params);
+                    rn->add(std::move(tmpNode), basePass, drawBufferBinding,
+                        mat->type(),
+                        mat->params(),
+                        group.material->blendingParams(),
+                        group.material->depthTest(),
+                        zPrepassed_ ? false : group.material->depthWrite(),
+                        group.material->cullFaceMode(),
+                        zPrepassed_ ? GL_EQUAL : GL_LEQUAL,
+                        std::move(textures), std::move(storageBuffers),
+                        group.va, GL_TRIANGLES,
+                        IndirectDrawBinding(indirect.commands, indirect.instances, group.firstCmd, group.numCmds),
+                        std::move(params));
+                }
+            }
+        }
+
+        transparentQueue_.clear();
+
+        const auto& cameraXf = rl.camera()->transform();
+        btVector3 cameraForward = cameraXf.getBasis() * btVector3_forward;
 
-        for (const auto& geom : rl.geomList()) {
+        for (std::uint32_t i = 0; i < rl.geomList().size(); ++i) {
+            const auto& geom = rl.geomList()[i];
             bool transparent = geom.material->blendingParams().isEnabled();
             if (transparent && !withTransparent_) {
                 continue;
@@ -59,54 +148,26 @@ namespace af3d
             if (!transparent && !withOpaque_) {
                 continue;
             }
-            DrawBufferBinding drawBufferBinding(drawBuffers, geom.material->type()->prog()->outputs());
-            MaterialParams params(geom.material->type(), true);
-            cr.setAutoParams(rl, geom, drawBufferBinding.mask, textures, storageBuffers, params);
-            if (zPrepassed_) {
-                int pass;
-                GLenum depthFunc;
-                if (geom.material->type()->name() == MaterialTypeSkyBox) {
-                    pass = basePass + 1;
-                    depthFunc = GL_LEQUAL;
-                } else if (transparent) {
-                    pass = basePass + 2;
-                    depthFunc = GL_LEQUAL;
-                } else {
-                    pass = basePass;
-                    depthFunc = GL_EQUAL;
-                }
-                rn->add(std::move(tmpNode), pass, drawBufferBinding,
-                    geom.material->type(),
-                    geom.material->params(),
-                    geom.material->blendingParams(),
-                    geom.material->depthTest(),
-                    false,
-                    geom.material->cullFaceMode(),
-                    depthFunc, geom.depthValue, geom.flipCull,
-                    std::move(textures), std::move(storageBuffers),
-                    geom.vaSlice, geom.primitiveMode, geom.scissorParams,
-                    std::move(params));
-            } else {
-                int pass;
-                if (geom.material->type()->name() == MaterialTypeSkyBox) {
-                    pass = basePass + 1;
-                } else if (transparent) {
-                    pass = basePass + 2;
-                } else {
-                    pass = basePass;
-                }
-                rn->add(std::move(tmpNode), pass, drawBufferBinding,
-                    geom.material->type(),
-                    geom.material->params(),
-                    geom.material->blendingParams(),
-                    geom.material->depthTest(),
-                    geom.material->depthWrite(),
-                    geom.material->cullFaceMode(),
-                    GL_LEQUAL, geom.depthValue, geom.flipCull,
-                    std::move(textures), std::move(storageBuffers),
-                    geom.vaSlice, geom.primitiveMode, geom.scissorParams,
-                    std::move(params));
+            if (transparent && (geom.material->type()->name() != MaterialTypeSkyBox)) {
+                float viewDepth = geom.aabb.empty() ? 0.0f : (geom.aabb.getCenter() - cameraXf.getOrigin()).dot(cameraForward);
+                transparentQueue_.add(geom.depthValue, viewDepth, rl.camera()->farDist(), i);
+                continue;
+            }
+            addGeometry(cr, rl, geom, drawBuffers, zPrepassed_, basePass, geom.depthValue, rn, tmpNode);
+        }
+
+        transparentQueue_.sort();
+
+        const RenderList::Geometry* prevGeom = nullptr;
+        int batch = -1;
+
+        for (const auto& entry : transparentQueue_.entries()) {
+            const auto& geom = rl.geomList()[entry.idx];
+            if (!prevGeom || !sameBatch(*prevGeom, geom)) {
+                ++batch;
             }
+            prevGeom = &geom;
+            addGeometry(cr, rl, geom, drawBuffers, zPrepassed_, basePass, static_cast<float>(batch), rn, tmpNode);
         }
 
         return basePass + 3;
@@ -26,14 +26,17 @@
 #ifndef _RENDERPASS_GEOMETRY_H_
 #define _RENDERPASS_GEOMETRY_H_
 
-#include "RenderPass.h"
+#include "RenderPassHiZ.h"
+#include "RenderSortQueue.h"
 
 namespace af3d
 {
     class RenderPassGeometry : public RenderPass
     {
     public:
-        RenderPassGeometry(const AttachmentPoints& colorAttachments, bool withOpaque, bool withTransparent, bool zPrepassed);
+        // 'hiZ' - when active, GPU driven opaque geometry is occlusion culled against its pyramid.
+        RenderPassGeometry(const AttachmentPoints& colorAttachments, bool withOpaque, bool withTransparent, bool zPrepassed,
+            const RenderPassHiZPtr& hiZ = RenderPassHiZPtr());
         ~RenderPassGeometry() = default;
 
         int compile(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn) override;
@@ -43,6 +46,13 @@ namespace af3d
         bool withOpaque_;
         bool withTransparent_;
         bool zPrepassed_;
+        RenderPassHiZPtr hiZ_;
+
+        /*
+         * Blended geometry, sorted back-to-front every compile, consecutive draws with the same
+         * state form a batch and batch index is used as 'depthValue' of their render nodes.
+         */
+        RenderSortQueue transparentQueue_;
     };
 
     using RenderPassGeometryPtr = std::shared_ptr<RenderPassGeometry>;
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "RenderPassHiZ.h"
+#include "CameraRenderer.h"
+#include "HardwareResourceManager.h"
+#include "MaterialManager.h"
+
+namespace af3d
+{
+    RenderPassHiZ::RenderPassHiZ(const TexturePtr& hiZTex)
+    : hiZTex_(hiZTex)
+    {
+    }
+
+    int RenderPassHiZ::compile(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn)
+    {
+        const auto& depthTarget = cr.renderTarget(AttachmentPoint::Depth);
+
+        active_ = rl.camera()->occlusionCull() && depthTarget.texture() && !rl.env()->indirectDrawMgr().empty();
+        if (!active_) {
+            return pass;
+        }
+
+        if (!va_) {
+            va_ = std::make_shared<VertexArray>(hwManager.createVertexArray(), VertexArrayLayout(), VBOList());
+        }
+
+        if (!matBuild_) {
+            matBuild_ = materialManager.createMaterial(MaterialTypeHiZBuild);
+            matBuild_->setTextureBinding(SamplerName::Depth,
+                TextureBinding(depthTarget.texture(), SamplerParams(GL_NEAREST, GL_NEAREST)));
+        }
+
+        // All the way down to 1x1, texture could've been resized since last time.
+        int numMips = 1;
+        while (((hiZTex_->width() >> numMips) >= 1) || ((hiZTex_->height() >> numMips) >= 1)) {
+            ++numMips;
+        }
+
+        while (static_cast<int>(matsDown_.size()) + 1 < numMips) {
+            auto mat = materialManager.createMaterial(MaterialTypeHiZDownsample);
+            mat->setTextureBinding(SamplerName::Main,
+                TextureBinding(hiZTex_, SamplerParams(GL_NEAREST_MIPMAP_NEAREST, GL_NEAREST)));
+            mat->params().setUniform(UniformName::MipLevel, static_cast<float>(matsDown_.size()));
+            matsDown_.push_back(mat);
+        }
+
+        addDispatch(cr, rl, pass++, rn, matBuild_, 0);
+
+        for (int i = 0; i + 1 < numMips; ++i) {
+            addDispatch(cr, rl, pass++, rn, matsDown_[i], i + 1);
+        }
+
+        return pass;
+    }
+
+    void RenderPassHiZ::addDispatch(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn,
+        const MaterialPtr& material, GLint level) const
+    {
+        RenderNode tmpNode;
+
+        std::vector<HardwareTextureBinding> textures;
+        std::vector<StorageBufferBinding> storageBuffers;
+        MaterialParams params(material->type(), true);
+        cr.setAutoParams(rl, material, 0, textures, storageBuffers, params);
+
+        std::vector<HardwareImageBinding> images;
+        images.emplace_back(hiZTex_->hwTex(), level, GL_WRITE_ONLY, GL_R32F);
+
+        std::uint32_t width = std::max(hiZTex_->width() >> level, 1U);
+        std::uint32_t height = std::max(hiZTex_->height() >> level, 1U);
+
+        // 8x8 local size, one invocation per output texel.
+        Vector3i numGroups((width + 7) / 8, (height + 7) / 8, 1);
+
+        rn->add(std::move(tmpNode), pass, material, va_,
+            std::move(textures), std::move(storageBuffers), numGroups, std::move(params), std::move(images));
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RENDERPASS_HIZ_H_
+#define _RENDERPASS_HIZ_H_
+
+#include "RenderPass.h"
+#include "Texture.h"
+
+namespace af3d
+{
+    /*
+     * Builds a max depth pyramid from the camera renderer's depth target, dispatches only.
+     * Must go after the depth prepass, RenderPassGeometry then uses it to occlusion cull
+     * GPU driven instances. Does nothing for cameras without 'occlusionCull'.
+     * 'hiZTex' must be mipmapped R32F, half the size of the depth target.
+     */
+    class RenderPassHiZ : public RenderPass
+    {
+    public:
+        explicit RenderPassHiZ(const TexturePtr& hiZTex);
+        ~RenderPassHiZ() = default;
+
+        inline const TexturePtr& texture() const { return hiZTex_; }
+
+        // Pyramid was built by last 'compile'.
+        inline bool active() const { return active_; }
+
+        int compile(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn) override;
+
+    private:
+        void addDispatch(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn,
+            const MaterialPtr& material, GLint level) const;
+
+        TexturePtr hiZTex_;
+        bool active_ = false;
+        VertexArrayPtr va_; // empty VA, needed for VAO.
+        MaterialPtr matBuild_;
+        std::vector<MaterialPtr> matsDown_; // Sources mip 'i', writes mip 'i + 1'.
+    };
+
+    using RenderPassHiZPtr = std::shared_ptr<RenderPassHiZ>;
+}
+
+#endif
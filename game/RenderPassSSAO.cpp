@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "RenderPassSSAO.h"
+#include "CameraRenderer.h"
+#include "HardwareResourceManager.h"
+#include "MaterialManager.h"
+#include "TextureManager.h"
+#include "Utils.h"
+
+namespace af3d
+{
+    RenderPassSSAO::RenderPassSSAO(const TexturePtr& depthTex, const TexturePtr& normalTex, const TexturePtr& velocityTex,
+        const TexturePtr& outTex, const TexturePtr& rawTex, int ksize)
+    : outTex_(outTex),
+      rawTex_(rawTex)
+    {
+        // Zeroed, zero depth never passes the history test.
+        for (int i = 0; i < 2; ++i) {
+            std::vector<Byte> data(rawTex_->width() * rawTex_->height() * 2 * sizeof(float));
+            historyTex_[i] = textureManager.createRenderTextureScaled(TextureType2D, 2.0f, 0, GL_RG16F, GL_RG, GL_FLOAT, false, std::move(data));
+        }
+
+        matAO_ = materialManager.createMaterial(MaterialTypeSSAOCompute);
+        matAO_->setTextureBinding(SamplerName::Depth,
+            TextureBinding(depthTex,
+                SamplerParams(GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST)));
+        matAO_->setTextureBinding(SamplerName::Normal,
+            TextureBinding(normalTex,
+                SamplerParams(GL_NEAREST, GL_NEAREST)));
+        setSSAOKernelParams(matAO_->params(), ksize);
+        matAO_->params().setUniform(UniformName::Radius, 0.5f);
+
+        matTemporal_ = materialManager.createMaterial(MaterialTypeSSAOTemporal);
+        matTemporal_->params().setUniform(UniformName::PrevRenderScale, 1.0f);
+        matTemporal_->setTextureBinding(SamplerName::Main,
+            TextureBinding(rawTex_,
+                SamplerParams(GL_NEAREST, GL_NEAREST)));
+        matTemporal_->setTextureBinding(SamplerName::Velocity,
+            TextureBinding(velocityTex,
+                SamplerParams(GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR)));
+
+        matUpsample_ = materialManager.createMaterial(MaterialTypeSSAOUpsample);
+        matUpsample_->setTextureBinding(SamplerName::Depth,
+            TextureBinding(depthTex,
+                SamplerParams(GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST)));
+    }
+
+    void RenderPassSSAO::update(const Frustum& srcFrustum)
+    {
+        std::swap(historyTex_[0], historyTex_[1]);
+
+        matTemporal_->setTextureBinding(SamplerName::Prev,
+            TextureBinding(historyTex_[1],
+                SamplerParams(GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR)));
+        matUpsample_->setTextureBinding(SamplerName::Main,
+            TextureBinding(historyTex_[0],
+                SamplerParams(GL_NEAREST, GL_NEAREST)));
+
+        Vector2f nearFar(srcFrustum.nearDist(), srcFrustum.farDist());
+
+        matAO_->params().setUniform(UniformName::ArgViewProjMatrix, srcFrustum.jitteredViewProjMat());
+        matAO_->params().setUniform(UniformName::ArgNearFar, nearFar);
+        matUpsample_->params().setUniform(UniformName::ArgNearFar, nearFar);
+    }
+
+    int RenderPassSSAO::compile(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn)
+    {
+        if (!va_) {
+            va_ = std::make_shared<VertexArray>(hwManager.createVertexArray(), VertexArrayLayout(), VBOList());
+        }
+
+        addDispatch(cr, rl, pass++, rn, matAO_, rawTex_, GL_RG16F);
+        addDispatch(cr, rl, pass++, rn, matTemporal_, historyTex_[0], GL_RG16F);
+        addDispatch(cr, rl, pass++, rn, matUpsample_, outTex_, GL_R16F);
+
+        // History written this frame is sampled with this scale next frame.
+        matTemporal_->params().setUniform(UniformName::PrevRenderScale, cr.renderScale());
+
+        return pass;
+    }
+
+    void RenderPassSSAO::addDispatch(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn,
+        const MaterialPtr& material, const TexturePtr& imgTex, GLenum format) const
+    {
+        RenderNode tmpNode;
+
+        std::vector<HardwareTextureBinding> textures;
+        std::vector<StorageBufferBinding> storageBuffers;
+        MaterialParams params(material->type(), true);
+        cr.setAutoParams(rl, material, 0, textures, storageBuffers, params);
+
+        std::vector<HardwareImageBinding> images;
+        images.emplace_back(imgTex->hwTex(), 0, GL_WRITE_ONLY, format);
+
+        // 8x8 local size, one invocation per output texel of the dynamic resolution sub-rectangle.
+        float scale = cr.renderScale();
+        int width = std::max(static_cast<int>(imgTex->width() * scale + 0.5f), 1);
+        int height = std::max(static_cast<int>(imgTex->height() * scale + 0.5f), 1);
+        Vector3i numGroups((width + 7) / 8, (height + 7) / 8, 1);
+
+        rn->add(std::move(tmpNode), pass, material, va_,
+            std::move(textures), std::move(storageBuffers), numGroups, std::move(params), std::move(images));
+    }
+}
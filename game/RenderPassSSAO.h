@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RENDERPASS_SSAO_H_
+#define _RENDERPASS_SSAO_H_
+
+#include "RenderPass.h"
+#include "Texture.h"
+#include "af3d/Frustum.h"
+
+namespace af3d
+{
+    /*
+     * Compute SSAO, dispatches only, the camera renderer needs no render targets.
+     * AO is computed at half resolution into 'rawTex' (AO, linear depth), blended with the
+     * reprojected history using the velocity buffer and then depth-aware upsampled into 'outTex'.
+     * 'rawTex' must be RG16F, 'outTex' R16F.
+     */
+    class RenderPassSSAO : public RenderPass
+    {
+    public:
+        RenderPassSSAO(const TexturePtr& depthTex, const TexturePtr& normalTex, const TexturePtr& velocityTex,
+            const TexturePtr& outTex, const TexturePtr& rawTex, int ksize);
+        ~RenderPassSSAO() = default;
+
+        // Must be called once per frame before rendering, flips the history.
+        void update(const Frustum& srcFrustum);
+
+        int compile(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn) override;
+
+    private:
+        void addDispatch(const CameraRenderer& cr, const RenderList& rl, int pass, const RenderNodePtr& rn,
+            const MaterialPtr& material, const TexturePtr& imgTex, GLenum format) const;
+
+        TexturePtr outTex_;
+        TexturePtr rawTex_;
+        TexturePtr historyTex_[2]; // Written this frame, written last frame.
+        VertexArrayPtr va_; // empty VA, needed for VAO.
+        MaterialPtr matAO_;
+        MaterialPtr matTemporal_;
+        MaterialPtr matUpsample_;
+    };
+
+    using RenderPassSSAOPtr = std::shared_ptr<RenderPassSSAO>;
+}
+
+#endif
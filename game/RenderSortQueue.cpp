@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "RenderSortQueue.h"
+#include <cstring>
+#include <algorithm>
+
+namespace af3d
+{
+    static const int digitBits = 8;
+    static const int numDigits = 64 / digitBits;
+    static const int digitSize = 1 << digitBits;
+
+    void RenderSortQueue::add(float depthValue, float viewDepth, float farDist, std::uint32_t idx)
+    {
+        // Float bits that compare the same as floats when treated as unsigned.
+        std::uint32_t dv;
+        std::memcpy(&dv, &depthValue, sizeof(dv));
+        dv = (dv & 0x80000000U) ? ~dv : (dv | 0x80000000U);
+
+        // 24-bit view depth, inverted for back-to-front, high byte stays 0 and its pass is skipped.
+        float t = (farDist > 0.0f) ? btClamped(viewDepth / farDist, 0.0f, 1.0f) : 0.0f;
+        std::uint32_t q = 0xFFFFFFU - static_cast<std::uint32_t>(t * 16777215.0f);
+
+        entries_.emplace_back((static_cast<std::uint64_t>(dv) << 32) | q, idx);
+    }
+
+    void RenderSortQueue::sort()
+    {
+        if (entries_.size() < 2) {
+            return;
+        }
+
+        std::uint32_t counts[numDigits][digitSize] = {};
+
+        for (const auto& e : entries_) {
+            for (int d = 0; d < numDigits; ++d) {
+                ++counts[d][(e.key >> (d * digitBits)) & (digitSize - 1)];
+            }
+        }
+
+        tmp_.resize(entries_.size());
+
+        for (int d = 0; d < numDigits; ++d) {
+            auto& c = counts[d];
+            if (c[(entries_[0].key >> (d * digitBits)) & (digitSize - 1)] == entries_.size()) {
+                // Same digit everywhere, order unchanged.
+                continue;
+            }
+
+            std::uint32_t offset = 0;
+            for (int i = 0; i < digitSize; ++i) {
+                auto n = c[i];
+                c[i] = offset;
+                offset += n;
+            }
+
+            for (const auto& e : entries_) {
+                tmp_[c[(e.key >> (d * digitBits)) & (digitSize - 1)]++] = e;
+            }
+
+            entries_.swap(tmp_);
+        }
+    }
+}
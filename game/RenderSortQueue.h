@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RENDER_SORT_QUEUE_H_
+#define _RENDER_SORT_QUEUE_H_
+
+#include "af3d/Types.h"
+#include <vector>
+
+namespace af3d
+{
+    /*
+     * Back-to-front order for blended geometry: explicit depth value first (UI and gizmo layering),
+     * then quantized view depth, farthest first, ties keep submission order. Stable LSD radix sort
+     * on 64-bit keys, passes whose digit is the same for all entries are skipped.
+     */
+    class RenderSortQueue
+    {
+    public:
+        struct Entry
+        {
+            Entry() = default;
+            Entry(std::uint64_t key, std::uint32_t idx)
+            : key(key),
+              idx(idx) {}
+
+            std::uint64_t key;
+            std::uint32_t idx;
+        };
+
+        using Entries = std::vector<Entry>;
+
+        RenderSortQueue() = default;
+        ~RenderSortQueue() = default;
+
+        inline void clear() { entries_.clear(); }
+
+        inline bool empty() const { return entries_.empty(); }
+
+        // Sorted after 'sort'.
+        inline const Entries& entries() const { return entries_; }
+
+        // 'viewDepth' is clamped to [0, 'farDist'].
+        void add(float depthValue, float viewDepth, float farDist, std::uint32_t idx);
+
+        void sort();
+
+    private:
+        Entries entries_;
+        Entries tmp_;
+    };
+}
+
+#endif
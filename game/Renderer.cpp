@@ -29,6 +29,7 @@
 #include "Logger.h"
 #include <thread>
 #include <chrono>
+#include <cmath>
 
 namespace af3d
 {
@@ -164,10 +165,21 @@ namespace af3d
             }
 
             rendering_ = true;
-            ops_.push_back([this, rnl](HardwareContext& ctx) {
+            auto inputTimeUs = inputTimeUs_;
+            ops_.push_back([this, rnl, inputTimeUs](HardwareContext& ctx) {
+                // Make room for this frame.
+                retireFrameFences(ctx, settings.framesInFlight - 1);
+                if (settings.dynamicResolution.enabled) {
+                    beginGPUTimer(ctx);
+                }
                 for (const auto& rn : rnl) {
                     doRender(rn, ctx);
                 }
+                if (settings.dynamicResolution.enabled) {
+                    endGPUTimer();
+                }
+                ctx.frameEnd();
+                presentInputTimeUs_ = inputTimeUs;
                 {
                     ScopedLockA lock(mtx_);
                     rendering_ = false;
@@ -178,6 +190,10 @@ namespace af3d
         }
 
         cond_.notify_one();
+
+        if (settings.dynamicResolution.enabled) {
+            updateRenderScale();
+        }
     }
 
     void Renderer::cancelSwap(HardwareContext& ctx)
@@ -197,6 +213,15 @@ namespace af3d
 
     bool Renderer::render(HardwareContext& ctx)
     {
+        if (presentInputTimeUs_ != 0) {
+            // Buffers of the last frame were swapped by now, fence goes after that.
+            FrameFence fence;
+            fence.sync = ogl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            fence.inputTimeUs = presentInputTimeUs_;
+            frameFences_.push_back(fence);
+            presentInputTimeUs_ = 0;
+        }
+
         while (true) {
             RenderOpFn fn;
 
@@ -213,6 +238,10 @@ namespace af3d
                     lock.unlock();
 
                     hwManager.invalidate(ctx);
+                    resetGPUTimer();
+                    // Context is gone, so are the fences.
+                    frameFences_.clear();
+                    presentInputTimeUs_ = 0;
 
                     lock.lock();
                     RenderOpList ops;
@@ -243,6 +272,11 @@ namespace af3d
 
                 lastTimeUs_ = timeUs;
 
+                if ((timeUs - lastReportTimeUs_) > settings.profileReportTimeoutMs * 1000) {
+                    lastReportTimeUs_ = timeUs;
+                    reportStats(ctx);
+                }
+
                 break;
             }
         }
@@ -260,8 +294,142 @@ namespace af3d
         cond_.notify_one();
     }
 
+    void Renderer::reportStats(HardwareContext& ctx)
+    {
+        const auto& stats = ctx.stats();
+        if (stats.numFrames == 0) {
+            return;
+        }
+
+        LOG4CPLUS_TRACE(logger(),
+            "FB binds/frame: " << static_cast<float>(stats.fbBinds) / stats.numFrames
+            << " DrawBuffers/frame: " << static_cast<float>(stats.drawBufferChanges) / stats.numFrames
+            << " FB creates: " << stats.fbCreates
+            << " FB revalidations: " << stats.fbRevalidations
+            << " State calls/frame: " << static_cast<float>(stats.stateCalls) / stats.numFrames
+            << " filtered/frame: " << static_cast<float>(stats.stateCallsFiltered) / stats.numFrames
+            << " Texture handles: " << stats.textureHandles
+            << " Sampler binds/frame: " << static_cast<float>(stats.samplerBinds) / stats.numFrames
+            << " Samplers: " << stats.samplerCreates << "/" << SamplerParams::numInterned());
+
+        if (stats.latencyFrames > 0) {
+            LOG4CPLUS_TRACE(logger(),
+                "Input to present ms/frame: " << static_cast<float>(stats.latencyUs) / stats.latencyFrames / 1000.0f
+                << " max: " << static_cast<float>(stats.latencyMaxUs) / 1000.0f);
+        }
+
+        if (stats.gpuTimeFrames > 0) {
+            LOG4CPLUS_TRACE(logger(),
+                "GPU ms/frame: " << static_cast<float>(stats.gpuTimeUs) / stats.gpuTimeFrames / 1000.0f);
+        }
+
+        if (stats.occlusionFrames > 0) {
+            LOG4CPLUS_TRACE(logger(),
+                "Occlusion visible/frame: " << static_cast<float>(stats.occlusionVisible) / stats.occlusionFrames
+                << " occluded/frame: " << static_cast<float>(stats.occlusionOccluded) / stats.occlusionFrames);
+        }
+
+        ctx.resetStats();
+    }
+
     void Renderer::doRender(const RenderNodePtr& rn, HardwareContext& ctx)
     {
         rn->apply(ctx);
     }
+
+    void Renderer::retireFrameFences(HardwareContext& ctx, std::size_t maxPending)
+    {
+        while (!frameFences_.empty()) {
+            const auto& fence = frameFences_.front();
+            bool mustWait = (frameFences_.size() > maxPending);
+
+            GLenum res = ogl.ClientWaitSync(fence.sync, GL_SYNC_FLUSH_COMMANDS_BIT,
+                (mustWait ? frameFenceTimeoutNs : 0));
+
+            if ((res == GL_ALREADY_SIGNALED) || (res == GL_CONDITION_SATISFIED)) {
+                // Non-blocking checks are done once a frame, so this is a frame late at most.
+                ctx.addLatencyStats(getTimeUs() - fence.inputTimeUs);
+            } else if (!mustWait) {
+                break;
+            }
+
+            ogl.DeleteSync(fence.sync);
+            frameFences_.pop_front();
+        }
+    }
+
+    void Renderer::beginGPUTimer(HardwareContext& ctx)
+    {
+        auto& q = timerQueries_[timerQueryIdx_];
+
+        if (q.id == 0) {
+            ogl.GenQueries(1, &q.id);
+        } else if (q.pending) {
+            GLint available = 0;
+            ogl.GetQueryObjectiv(q.id, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 ns = 0;
+                ogl.GetQueryObjectui64v(q.id, GL_QUERY_RESULT, &ns);
+                gpuFrameMs_ = static_cast<float>(ns) / 1000000.0f;
+                ctx.addGPUTimeStats(ns / 1000);
+            }
+            // Otherwise GPU is more than 'numTimerQueries' frames behind, drop the sample.
+        }
+
+        q.pending = false;
+        ogl.BeginQuery(GL_TIME_ELAPSED, q.id);
+    }
+
+    void Renderer::endGPUTimer()
+    {
+        ogl.EndQuery(GL_TIME_ELAPSED);
+        timerQueries_[timerQueryIdx_].pending = true;
+        timerQueryIdx_ = (timerQueryIdx_ + 1) % numTimerQueries;
+    }
+
+    void Renderer::resetGPUTimer()
+    {
+        // Context is gone, so are the queries.
+        timerQueries_.fill(TimerQuery());
+        timerQueryIdx_ = 0;
+    }
+
+    void Renderer::updateRenderScale()
+    {
+        const auto& dr = settings.dynamicResolution;
+
+        float ms = gpuFrameMs_.exchange(0.0f);
+        if (ms <= 0.0f) {
+            return;
+        }
+
+        // Peak hold, spikes take effect right away, recovery is smoothed.
+        if (ms > gpuFrameMsFiltered_) {
+            gpuFrameMsFiltered_ = ms;
+        } else {
+            gpuFrameMsFiltered_ += (ms - gpuFrameMsFiltered_) * 0.1f;
+        }
+
+        if (scaleHoldFrames_ > 0) {
+            // Samples in flight were taken at the previous scale.
+            --scaleHoldFrames_;
+            return;
+        }
+
+        float ratio = dr.targetFrameMs / gpuFrameMsFiltered_;
+        if (std::abs(ratio - 1.0f) < 0.05f) {
+            return;
+        }
+
+        // GPU time is roughly proportional to the pixel count, i.e. to scale squared.
+        // Go down fast and up slowly, so that we don't oscillate around the target.
+        float step = std::min(std::max(std::sqrt(ratio), 0.85f), 1.02f);
+        float scale = std::min(std::max(renderScale_ * step, dr.minScale), dr.maxScale);
+
+        if (scale != renderScale_) {
+            renderScale_ = scale;
+            gpuFrameMsFiltered_ = 0.0f;
+            scaleHoldFrames_ = numTimerQueries;
+        }
+    }
 }
@@ -32,6 +32,9 @@
 #include <mutex>
 #include <condition_variable>
 #include <list>
+#include <deque>
+#include <atomic>
+#include <array>
 
 namespace af3d
 {
@@ -51,18 +54,56 @@ namespace af3d
 
         void scheduleHwOp(const HwOpFn& hwOp); // Will get executed in 'render'.
         void scheduleHwOpSync(HwOpFn hwOp); // Will get executed in 'render'.
+
+        // Main thread, time the input for the next 'swap' was sampled at, for latency stats.
+        inline void setInputTimeUs(std::uint64_t value) { inputTimeUs_ = value; }
+
         void swap(const RenderNodeList& rnl);
         void cancelSwap(HardwareContext& ctx);
 
         bool render(HardwareContext& ctx);
         void cancelRender();
 
+        /*
+         * Dynamic resolution scale of the main camera targets, main thread only,
+         * constant between 'swap' calls. Always 1.0 when dynamic resolution is disabled.
+         */
+        inline float renderScale() const { return renderScale_; }
+
     private:
         using RenderOpFn = std::function<bool(HardwareContext&)>;
         using RenderOpList = std::list<RenderOpFn>;
 
+        struct TimerQuery
+        {
+            GLuint id = 0;
+            bool pending = false;
+        };
+
+        // Results are read back this many frames late, so that we never stall.
+        static const int numTimerQueries = 3;
+
+        struct FrameFence
+        {
+            GLsync sync = nullptr;
+            std::uint64_t inputTimeUs = 0;
+        };
+
+        // Don't wait forever on a lost GPU.
+        static const GLuint64 frameFenceTimeoutNs = 100000000;
+
         void doRender(const RenderNodePtr& rn, HardwareContext& ctx);
 
+        void retireFrameFences(HardwareContext& ctx, std::size_t maxPending);
+
+        void beginGPUTimer(HardwareContext& ctx);
+        void endGPUTimer();
+        void resetGPUTimer();
+
+        void updateRenderScale();
+
+        void reportStats(HardwareContext& ctx);
+
         std::mutex mtx_;
         std::condition_variable cond_;
         bool cancelSwap_ = false;
@@ -70,6 +111,22 @@ namespace af3d
         bool rendering_ = false;
         RenderOpList ops_;
         std::uint64_t lastTimeUs_ = 0;
+        std::uint64_t lastReportTimeUs_ = 0;
+
+        // Render thread.
+        std::array<TimerQuery, numTimerQueries> timerQueries_;
+        int timerQueryIdx_ = 0;
+        std::deque<FrameFence> frameFences_; // Oldest first.
+        std::uint64_t presentInputTimeUs_ = 0; // Frame rendered, fenced after swap buffers.
+
+        // Last GPU frame time read back, 0 when consumed by 'updateRenderScale'.
+        std::atomic<float> gpuFrameMs_{0.0f};
+
+        // Main thread.
+        std::uint64_t inputTimeUs_ = 0;
+        float renderScale_ = 1.0f;
+        float gpuFrameMsFiltered_ = 0.0f;
+        int scaleHoldFrames_ = 0;
     };
 
     extern Renderer renderer;
@@ -26,6 +26,8 @@
 #include "SSAOComponent.h"
 #include "TextureManager.h"
 #include "SceneObject.h"
+#include "Scene.h"
+#include "CameraRenderer.h"
 #include "Const.h"
 
 namespace af3d
@@ -36,17 +38,18 @@ namespace af3d
     SSAOComponent::SSAOComponent(const CameraPtr& srcCamera,
         const TexturePtr& depthTexture,
         const TexturePtr& normalTexture,
+        const TexturePtr& outTexture,
+        const TexturePtr& tmpTexture,
         int ksize, int camOrder)
     : PhasedComponent(AClass_SSAOComponent, phasePreRender, phaseOrderSSAO),
-      srcCamera_(srcCamera)
+      srcCamera_(srcCamera),
+      outTex_(outTexture)
     {
         int blurKSize = 11;
         float blurSigma = 2.0f;
 
-        auto outTex1 = textureManager.createRenderTextureScaled(TextureType2D,
-            2.0f, 0, GL_R16F, GL_RED, GL_FLOAT);
-        auto outTex2 = textureManager.createRenderTextureScaled(TextureType2D,
-            2.0f, 0, GL_R16F, GL_RED, GL_FLOAT);
+        const auto& outTex1 = outTexture;
+        const auto& outTex2 = tmpTexture;
 
         ssaoFilter_ = std::make_shared<RenderFilterComponent>(MaterialTypeFilterSSAO);
         ssaoFilter_->material()->setTextureBinding(SamplerName::Depth,
@@ -60,6 +63,7 @@ namespace af3d
                 SamplerParams(GL_NEAREST, GL_NEAREST)));
         ssaoFilter_->camera()->setOrder(camOrder);
         ssaoFilter_->camera()->setRenderTarget(AttachmentPoint::Color0, RenderTarget(outTex1));
+        ssaoFilter_->camera()->setDynamicResolution(srcCamera->dynamicResolution());
         setSSAOKernelParams(ssaoFilter_->material()->params(), ksize);
         ssaoFilter_->material()->params().setUniform(UniformName::Radius, 0.5f);
 
@@ -72,6 +76,7 @@ namespace af3d
                 SamplerParams(GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST)));
         blurFilter_[0]->camera()->setOrder(camOrder + 1);
         blurFilter_[0]->camera()->setRenderTarget(AttachmentPoint::Color0, RenderTarget(outTex2));
+        blurFilter_[0]->camera()->setDynamicResolution(srcCamera->dynamicResolution());
         setGaussianBlurParams(blurFilter_[0]->material()->params(), blurKSize, blurSigma, false);
 
         blurFilter_[1] = std::make_shared<RenderFilterComponent>(MaterialTypeFilterSSAOBlur);
@@ -83,9 +88,34 @@ namespace af3d
                 SamplerParams(GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_NEAREST)));
         blurFilter_[1]->camera()->setOrder(camOrder + 2);
         blurFilter_[1]->camera()->setRenderTarget(AttachmentPoint::Color0, RenderTarget(outTex1));
+        blurFilter_[1]->camera()->setDynamicResolution(srcCamera->dynamicResolution());
         setGaussianBlurParams(blurFilter_[1]->material()->params(), blurKSize, blurSigma, true);
     }
 
+    SSAOComponent::SSAOComponent(const CameraPtr& srcCamera,
+        const TexturePtr& depthTexture,
+        const TexturePtr& normalTexture,
+        const TexturePtr& velocityTexture,
+        const TexturePtr& outTexture,
+        const TexturePtr& rawTexture,
+        int ksize, int camOrder)
+    : PhasedComponent(AClass_SSAOComponent, phasePreRender, phaseOrderSSAO),
+      srcCamera_(srcCamera),
+      outTex_(outTexture)
+    {
+        rpSSAO_ = std::make_shared<RenderPassSSAO>(depthTexture, normalTexture, velocityTexture, outTexture, rawTexture, ksize);
+
+        auto r = std::make_shared<CameraRenderer>();
+        r->setOrder(camOrder);
+        r->setClearMask(AttachmentPoints());
+        r->setDynamicResolution(srcCamera->dynamicResolution());
+        r->addRenderPass(rpSSAO_);
+
+        computeCamera_ = std::make_shared<Camera>(false);
+        computeCamera_->setLayer(CameraLayer::Filter);
+        computeCamera_->addRenderer(r);
+    }
+
     const AClass& SSAOComponent::staticKlass()
     {
         return AClass_SSAOComponent;
@@ -98,6 +128,11 @@ namespace af3d
 
     void SSAOComponent::preRender(float dt)
     {
+        if (rpSSAO_) {
+            rpSSAO_->update(srcCamera_->frustum());
+            return;
+        }
+
         ssaoFilter_->material()->params().setUniform(UniformName::ArgViewProjMatrix, srcCamera_->frustum().jitteredViewProjMat());
 
         Vector2f nearFar(srcCamera_->frustum().nearDist(), srcCamera_->frustum().farDist());
@@ -109,6 +144,11 @@ namespace af3d
 
     void SSAOComponent::onRegister()
     {
+        if (computeCamera_) {
+            scene()->addCamera(computeCamera_);
+            return;
+        }
+
         parent()->addComponent(ssaoFilter_);
         parent()->addComponent(blurFilter_[0]);
         parent()->addComponent(blurFilter_[1]);
@@ -116,6 +156,11 @@ namespace af3d
 
     void SSAOComponent::onUnregister()
     {
+        if (computeCamera_) {
+            scene()->removeCamera(computeCamera_);
+            return;
+        }
+
         parent()->removeComponent(ssaoFilter_);
         parent()->removeComponent(blurFilter_[0]);
         parent()->removeComponent(blurFilter_[1]);
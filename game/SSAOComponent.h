@@ -28,6 +28,7 @@
 
 #include "PhasedComponent.h"
 #include "RenderFilterComponent.h"
+#include "RenderPassSSAO.h"
 #include "Camera.h"
 
 namespace af3d
@@ -39,10 +40,24 @@ namespace af3d
         SSAOComponent(const CameraPtr& srcCamera,
             const TexturePtr& depthTexture,
             const TexturePtr& normalTexture,
+            const TexturePtr& outTexture,
+            const TexturePtr& tmpTexture,
+            int ksize,
+            int camOrder);
+        // Compute path, 'rawTexture' is half resolution RG16F, 'outTexture' is full resolution R16F.
+        SSAOComponent(const CameraPtr& srcCamera,
+            const TexturePtr& depthTexture,
+            const TexturePtr& normalTexture,
+            const TexturePtr& velocityTexture,
+            const TexturePtr& outTexture,
+            const TexturePtr& rawTexture,
             int ksize,
             int camOrder);
         ~SSAOComponent() = default;
 
+        static const int numCameras = 3;
+        static const int numComputeCameras = 1;
+
         static const AClass& staticKlass();
 
         static AObjectPtr create(const APropertyValueMap& propVals);
@@ -51,7 +66,7 @@ namespace af3d
 
         void preRender(float dt) override;
 
-        inline const TexturePtr& outTexture() const { return blurFilter_[1]->camera()->renderTarget().texture(); }
+        inline const TexturePtr& outTexture() const { return outTex_; }
 
     private:
         void onRegister() override;
@@ -59,8 +74,13 @@ namespace af3d
         void onUnregister() override;
 
         CameraPtr srcCamera_;
+        TexturePtr outTex_;
+
         RenderFilterComponentPtr ssaoFilter_;
         RenderFilterComponentPtr blurFilter_[2];
+
+        RenderPassSSAOPtr rpSSAO_;
+        CameraPtr computeCamera_;
     };
 
     using SSAOComponentPtr = std::shared_ptr<SSAOComponent>;
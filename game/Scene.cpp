@@ -29,6 +29,7 @@
 #include "SceneObject.h"
 #include "SceneObjectFactory.h"
 #include "SceneEnvironment.h"
+#include "SceneTransforms.h"
 #include "Logger.h"
 #include "InputManager.h"
 #include "GameShell.h"
@@ -61,6 +62,9 @@
 #include "RenderPassPrepass.h"
 #include "RenderPassCluster.h"
 #include "RenderPassGeometry.h"
+#include "RenderPassHiZ.h"
+#include "RenderPassBloom.h"
+#include "RenderGraph.h"
 #include "editor/Playbar.h"
 #include <Rocket/Core/ElementDocument.h>
 #include <cmath>
@@ -77,6 +81,10 @@ namespace af3d
 
     namespace
     {
+        // Threshold, downscale and two blurs per mip, composite.
+        const int bloomNumPasses = 5;
+        const int bloomNumCameras = 1 + bloomNumPasses * 3 + 1;
+
         class OverlapFilterCallback : public btOverlapFilterCallback
         {
         public:
@@ -217,6 +225,7 @@ namespace af3d
         ConstraintJointMap constraintToJoint_;
         PhysicsDebugDraw debugDraw_;
         SceneEnvironmentPtr env_;
+        SceneTransforms transforms_;
         std::unique_ptr<PhasedComponentManager> phasedComponentManager_;
         std::unique_ptr<CollisionComponentManager> collisionComponentManager_;
         std::unique_ptr<PhysicsComponentManager> physicsComponentManager_;
@@ -281,111 +290,218 @@ namespace af3d
 
         dummy_ = std::make_shared<SceneObject>();
 
-        auto velocityTex = textureManager.createRenderTextureScaled(TextureType2D,
-            1.0f, 0, GL_RG16F, GL_RG, GL_FLOAT);
-        auto depthTex = textureManager.createRenderTextureScaled(TextureType2D,
-            1.0f, 0, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT);
-        auto screenTex = textureManager.createRenderTextureScaled(TextureType2D,
-            1.0f, 0, GL_RGB16F, GL_RGB, GL_FLOAT);
+        RenderGraph graph;
+
+        auto velocityRes = graph.createTexture("velocity", 1.0f, GL_RG16F, GL_RG, GL_FLOAT);
+        auto depthRes = graph.createTexture("depth", 1.0f, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT);
+        auto screenRes = graph.createTexture("screen", 1.0f, GL_RGB16F, GL_RGB, GL_FLOAT);
+        auto backbufferRes = graph.createVirtual("backbuffer");
+        graph.setOutput(backbufferRes);
 
         auto mc = std::make_shared<Camera>(false);
 
-        if (settings.ssao) {
-            auto colorTex = textureManager.createRenderTextureScaled(TextureType2D,
-                1.0f, 0, GL_RGB16F, GL_RGB, GL_FLOAT);
-            auto normalTex = textureManager.createRenderTextureScaled(TextureType2D,
-                1.0f, 0, GL_RGB16F, GL_RGB, GL_FLOAT);
-            auto ambientTex = textureManager.createRenderTextureScaled(TextureType2D,
-                1.0f, 0, GL_RGB16F, GL_RGB, GL_FLOAT);
-
-            auto rpCluster = std::make_shared<RenderPassCluster>();
-
-            auto r = std::make_shared<CameraRenderer>();
-            r->addRenderPass(std::make_shared<RenderPassPrepass>(AttachmentPoint::Color1));
-            r->addRenderPass(rpCluster);
-            r->addRenderPass(std::make_shared<RenderPassGeometry>(
-                AttachmentPoints(AttachmentPoint::Color0) | AttachmentPoint::Color2 | AttachmentPoint::Color3, true, false, true));
-            r->setOrder(camOrderMain);
-            r->setRenderTarget(AttachmentPoint::Color0, RenderTarget(colorTex));
-            r->setRenderTarget(AttachmentPoint::Color1, RenderTarget(velocityTex));
-            r->setRenderTarget(AttachmentPoint::Color2, RenderTarget(normalTex));
-            r->setRenderTarget(AttachmentPoint::Color3, RenderTarget(ambientTex));
-            r->setRenderTarget(AttachmentPoint::Depth, RenderTarget(depthTex));
-            r->setClearMask(r->clearMask() | AttachmentPoint::Color1 | AttachmentPoint::Color2 | AttachmentPoint::Color3);
-            r->setClearColor(AttachmentPoint::Color1, linearToGamma(Color(65535.0f, 65535.0f, 65535.0f, 65535.0f)));
-            r->setClearColor(AttachmentPoint::Color2, linearToGamma(Color_zero));
-            r->setClearColor(AttachmentPoint::Color3, linearToGamma(Color_zero));
-            mc->addRenderer(r);
-
-            auto ssaoTex = postProcessSSAO(camOrderMain + 1, mc, depthTex, normalTex);
-
-            auto compositeFilter = std::make_shared<RenderFilterComponent>(MaterialTypeFilterComposite);
-            compositeFilter->material()->setTextureBinding(SamplerName::Main,
-                TextureBinding(ambientTex,
-                    SamplerParams(GL_NEAREST, GL_NEAREST)));
-            compositeFilter->material()->setTextureBinding(SamplerName::Specular,
-                TextureBinding(colorTex,
-                    SamplerParams(GL_NEAREST, GL_NEAREST)));
-            compositeFilter->material()->setTextureBinding(SamplerName::AO,
-                TextureBinding(ssaoTex,
-                    SamplerParams(GL_LINEAR)));
-            compositeFilter->camera()->setOrder(camOrderMain + 5);
-            compositeFilter->camera()->setRenderTarget(AttachmentPoint::Color0, RenderTarget(screenTex));
-            dummy_->addComponent(compositeFilter);
-
-            r = std::make_shared<CameraRenderer>();
-            r->addRenderPass(rpCluster, false);
-            r->addRenderPass(std::make_shared<RenderPassGeometry>(AttachmentPoint::Color0, false, true, true));
-            r->setOrder(camOrderMain + 6);
-            r->setRenderTarget(AttachmentPoint::Color0, RenderTarget(screenTex));
-            r->setRenderTarget(AttachmentPoint::Depth, RenderTarget(depthTex));
-            r->setClearMask(AttachmentPoints());
-            mc->addRenderer(r);
+        // Hi-Z pyramid of the prepass depth, occlusion culls GPU driven geometry of the main camera.
+        RenderGraph::ResourceIds hiZWrites;
+        if (settings.gpuDriven) {
+            hiZWrites.push_back(graph.createTexture("hi-z", 2.0f, GL_R32F, GL_RED, GL_FLOAT, true));
+        }
+
+        if (settings.ssao != Settings::SSAOMode::None) {
+            auto colorRes = graph.createTexture("color", 1.0f, GL_RGB16F, GL_RGB, GL_FLOAT);
+            auto normalRes = graph.createTexture("normal", 1.0f, GL_RGB16F, GL_RGB, GL_FLOAT);
+            auto ambientRes = graph.createTexture("ambient", 1.0f, GL_RGB16F, GL_RGB, GL_FLOAT);
+            auto ssaoRes = (settings.ssao == Settings::SSAOMode::Compute) ?
+                graph.createTexture("ssao", 1.0f, GL_R16F, GL_RED, GL_FLOAT) :
+                graph.createTexture("ssao", 2.0f, GL_R16F, GL_RED, GL_FLOAT);
+
+            auto rpCluster = std::make_shared<RenderPassCluster>(true);
+
+            RenderGraph::ResourceIds opaqueWrites{colorRes, velocityRes, normalRes, ambientRes, depthRes};
+            opaqueWrites.insert(opaqueWrites.end(), hiZWrites.begin(), hiZWrites.end());
+
+            graph.addPass("opaque", camOrderMain, camOrderMain,
+                {}, opaqueWrites,
+                [mc, rpCluster, colorRes, velocityRes, normalRes, ambientRes, depthRes, hiZWrites](const RenderGraph& g) {
+                auto r = std::make_shared<CameraRenderer>();
+                r->addRenderPass(std::make_shared<RenderPassPrepass>(AttachmentPoint::Color1));
+                RenderPassHiZPtr rpHiZ;
+                if (!hiZWrites.empty()) {
+                    rpHiZ = std::make_shared<RenderPassHiZ>(g.texture(hiZWrites[0]));
+                    r->addRenderPass(rpHiZ);
+                }
+                r->addRenderPass(rpCluster);
+                r->addRenderPass(std::make_shared<RenderPassGeometry>(
+                    AttachmentPoints(AttachmentPoint::Color0) | AttachmentPoint::Color2 | AttachmentPoint::Color3, true, false, true, rpHiZ));
+                r->setOrder(camOrderMain);
+                r->setRenderTarget(AttachmentPoint::Color0, RenderTarget(g.texture(colorRes)));
+                r->setRenderTarget(AttachmentPoint::Color1, RenderTarget(g.texture(velocityRes)));
+                r->setRenderTarget(AttachmentPoint::Color2, RenderTarget(g.texture(normalRes)));
+                r->setRenderTarget(AttachmentPoint::Color3, RenderTarget(g.texture(ambientRes)));
+                r->setRenderTarget(AttachmentPoint::Depth, RenderTarget(g.texture(depthRes)));
+                r->setClearMask(r->clearMask() | AttachmentPoint::Color1 | AttachmentPoint::Color2 | AttachmentPoint::Color3);
+                r->setClearColor(AttachmentPoint::Color1, linearToGamma(Color(65535.0f, 65535.0f, 65535.0f, 65535.0f)));
+                r->setClearColor(AttachmentPoint::Color2, linearToGamma(Color_zero));
+                r->setClearColor(AttachmentPoint::Color3, linearToGamma(Color_zero));
+                r->setDynamicResolution(settings.dynamicResolution.enabled);
+                mc->addRenderer(r);
+            });
+
+            if (settings.ssao == Settings::SSAOMode::Compute) {
+                auto ssaoRawRes = graph.createTexture("ssao raw", 2.0f, GL_RG16F, GL_RG, GL_FLOAT);
+
+                graph.addPass("ssao", camOrderMain + 1, camOrderMain + SSAOComponent::numComputeCameras,
+                    {depthRes, normalRes, velocityRes}, {ssaoRes, ssaoRawRes},
+                    [this, mc, depthRes, normalRes, velocityRes, ssaoRes, ssaoRawRes](const RenderGraph& g) {
+                    postProcessSSAOCompute(camOrderMain + 1, mc, g.texture(depthRes), g.texture(normalRes),
+                        g.texture(velocityRes), g.texture(ssaoRes), g.texture(ssaoRawRes));
+                });
+            } else {
+                auto ssaoTmpRes = graph.createTexture("ssao tmp", 2.0f, GL_R16F, GL_RED, GL_FLOAT);
+
+                graph.addPass("ssao", camOrderMain + 1, camOrderMain + SSAOComponent::numCameras,
+                    {depthRes, normalRes}, {ssaoRes, ssaoTmpRes},
+                    [this, mc, depthRes, normalRes, ssaoRes, ssaoTmpRes](const RenderGraph& g) {
+                    postProcessSSAO(camOrderMain + 1, mc, g.texture(depthRes), g.texture(normalRes),
+                        g.texture(ssaoRes), g.texture(ssaoTmpRes));
+                });
+            }
+
+            graph.addPass("composite", camOrderMain + 5, camOrderMain + 5,
+                {ambientRes, colorRes, ssaoRes}, {screenRes},
+                [this, ambientRes, colorRes, ssaoRes, screenRes](const RenderGraph& g) {
+                auto compositeFilter = std::make_shared<RenderFilterComponent>(MaterialTypeFilterComposite);
+                compositeFilter->material()->setTextureBinding(SamplerName::Main,
+                    TextureBinding(g.texture(ambientRes),
+                        SamplerParams(GL_NEAREST, GL_NEAREST)));
+                compositeFilter->material()->setTextureBinding(SamplerName::Specular,
+                    TextureBinding(g.texture(colorRes),
+                        SamplerParams(GL_NEAREST, GL_NEAREST)));
+                compositeFilter->material()->setTextureBinding(SamplerName::AO,
+                    TextureBinding(g.texture(ssaoRes),
+                        SamplerParams(GL_LINEAR)));
+                compositeFilter->camera()->setOrder(camOrderMain + 5);
+                compositeFilter->camera()->setRenderTarget(AttachmentPoint::Color0, RenderTarget(g.texture(screenRes)));
+                compositeFilter->camera()->setDynamicResolution(settings.dynamicResolution.enabled);
+                dummy_->addComponent(compositeFilter);
+            });
+
+            graph.addPass("transparent", camOrderMain + 6, camOrderMain + 6,
+                {screenRes, depthRes}, {screenRes},
+                [mc, rpCluster, screenRes, depthRes](const RenderGraph& g) {
+                auto r = std::make_shared<CameraRenderer>();
+                r->addRenderPass(rpCluster, false);
+                r->addRenderPass(std::make_shared<RenderPassGeometry>(AttachmentPoint::Color0, false, true, true));
+                r->setOrder(camOrderMain + 6);
+                r->setRenderTarget(AttachmentPoint::Color0, RenderTarget(g.texture(screenRes)));
+                r->setRenderTarget(AttachmentPoint::Depth, RenderTarget(g.texture(depthRes)));
+                r->setClearMask(AttachmentPoints());
+                r->setDynamicResolution(settings.dynamicResolution.enabled);
+                mc->addRenderer(r);
+            });
         } else {
-            auto r = std::make_shared<CameraRenderer>();
-            r->addRenderPass(std::make_shared<RenderPassPrepass>(AttachmentPoint::Color1));
-            r->addRenderPass(std::make_shared<RenderPassCluster>());
-            r->addRenderPass(std::make_shared<RenderPassGeometry>(AttachmentPoint::Color0, true, true, true));
-            r->setOrder(camOrderMain);
-            r->setRenderTarget(AttachmentPoint::Color0, RenderTarget(screenTex));
-            r->setRenderTarget(AttachmentPoint::Color1, RenderTarget(velocityTex));
-            r->setRenderTarget(AttachmentPoint::Depth, RenderTarget(depthTex));
-            r->setClearMask(r->clearMask() | AttachmentPoint::Color1);
-            r->setClearColor(AttachmentPoint::Color1, linearToGamma(Color(65535.0f, 65535.0f, 65535.0f, 65535.0f)));
-            mc->addRenderer(r);
+            RenderGraph::ResourceIds mainWrites{screenRes, velocityRes, depthRes};
+            mainWrites.insert(mainWrites.end(), hiZWrites.begin(), hiZWrites.end());
+
+            graph.addPass("main", camOrderMain, camOrderMain,
+                {}, mainWrites,
+                [mc, screenRes, velocityRes, depthRes, hiZWrites](const RenderGraph& g) {
+                auto r = std::make_shared<CameraRenderer>();
+                r->addRenderPass(std::make_shared<RenderPassPrepass>(AttachmentPoint::Color1));
+                RenderPassHiZPtr rpHiZ;
+                if (!hiZWrites.empty()) {
+                    rpHiZ = std::make_shared<RenderPassHiZ>(g.texture(hiZWrites[0]));
+                    r->addRenderPass(rpHiZ);
+                }
+                r->addRenderPass(std::make_shared<RenderPassCluster>(true));
+                r->addRenderPass(std::make_shared<RenderPassGeometry>(AttachmentPoint::Color0, true, true, true, rpHiZ));
+                r->setOrder(camOrderMain);
+                r->setRenderTarget(AttachmentPoint::Color0, RenderTarget(g.texture(screenRes)));
+                r->setRenderTarget(AttachmentPoint::Color1, RenderTarget(g.texture(velocityRes)));
+                r->setRenderTarget(AttachmentPoint::Depth, RenderTarget(g.texture(depthRes)));
+                r->setClearMask(r->clearMask() | AttachmentPoint::Color1);
+                r->setClearColor(AttachmentPoint::Color1, linearToGamma(Color(65535.0f, 65535.0f, 65535.0f, 65535.0f)));
+                r->setDynamicResolution(settings.dynamicResolution.enabled);
+                mc->addRenderer(r);
+            });
         }
 
-        mc->setLayer(CameraLayer::Main);
-        mc->setAspect(settings.viewAspect);
-        addCamera(mc);
+        // TAA swaps its output into the materials that sample the scene color, it doesn't write 'screen' itself.
+        RenderGraph::ResourceIds hdrReads{screenRes};
+        if (settings.aaMode == Settings::AAMode::TAA) {
+            hdrReads.push_back(graph.createVirtual("taa"));
+        }
+        auto taaDestMats = std::make_shared<std::vector<MaterialPtr>>();
 
-        if (settings.bloom) {
-            std::vector<MaterialPtr> mats;
-            auto tex = postProcessBloom(camOrderPostProcess + 1, screenTex, 1.0f, 11, 2.0f, 0.5f, mats);
-            if (settings.aaMode == Settings::AAMode::TAA) {
-                postProcessTAA(camOrderPostProcess, mc, screenTex, velocityTex, depthTex, mats);
-            }
-            auto filter = postProcessToneMapping(camOrderPostProcess + 100, tex);
-            if (settings.aaMode == Settings::AAMode::FXAA) {
-                auto toneMappedTex = textureManager.createRenderTextureScaled(TextureType2D,
-                    1.0f, 0, GL_RGB, GL_RGB, GL_UNSIGNED_BYTE);
-                filter->camera()->setRenderTarget(AttachmentPoint::Color0, RenderTarget(toneMappedTex));
-                filter = postProcessFXAA(camOrderPostProcess + 200, filter->camera()->renderTarget().texture());
-            }
-            ppCamera_ = filter->camera();
+        // Always declared, culled when nothing reads it.
+        auto bloomRes = graph.createTexture("bloom", 1.0f, GL_RGB16F, GL_RGB, GL_FLOAT);
+
+        if (settings.bloom == Settings::BloomMode::Compute) {
+            auto bloomMipsRes = graph.createTexture("bloom mips", 2.0f, GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, true);
+
+            graph.addPass("bloom", camOrderPostProcess + 1, camOrderPostProcess + 2,
+                hdrReads, {bloomRes, bloomMipsRes},
+                [this, screenRes, bloomRes, bloomMipsRes, taaDestMats](const RenderGraph& g) {
+                postProcessBloomCompute(camOrderPostProcess + 1, g.texture(screenRes),
+                    g.texture(bloomRes), g.texture(bloomMipsRes), 1.0f, 0.5f, *taaDestMats);
+            });
         } else {
-            auto filter = postProcessToneMapping(camOrderPostProcess + 100, screenTex);
-            if (settings.aaMode == Settings::AAMode::TAA) {
-                postProcessTAA(camOrderPostProcess, mc, screenTex, velocityTex, depthTex, {filter->material()});
-            } else if (settings.aaMode == Settings::AAMode::FXAA) {
-                auto toneMappedTex = textureManager.createRenderTextureScaled(TextureType2D,
-                    1.0f, 0, GL_RGB, GL_RGB, GL_UNSIGNED_BYTE);
-                filter->camera()->setRenderTarget(AttachmentPoint::Color0, RenderTarget(toneMappedTex));
-                filter = postProcessFXAA(camOrderPostProcess + 200, filter->camera()->renderTarget().texture());
+            auto bloomTmp1Res = graph.createTexture("bloom tmp1", 2.0f, GL_RGB16F, GL_RGB, GL_FLOAT, true);
+            auto bloomTmp2Res = graph.createTexture("bloom tmp2", 2.0f, GL_RGB16F, GL_RGB, GL_FLOAT, true);
+
+            graph.addPass("bloom", camOrderPostProcess + 1, camOrderPostProcess + bloomNumCameras,
+                hdrReads, {bloomRes, bloomTmp1Res, bloomTmp2Res},
+                [this, screenRes, bloomRes, bloomTmp1Res, bloomTmp2Res, taaDestMats](const RenderGraph& g) {
+                postProcessBloom(camOrderPostProcess + 1, g.texture(screenRes),
+                    g.texture(bloomRes), g.texture(bloomTmp1Res), g.texture(bloomTmp2Res),
+                    1.0f, 11, 2.0f, 0.5f, *taaDestMats);
+            });
+        }
+
+        bool bloomEnabled = (settings.bloom != Settings::BloomMode::None);
+        auto toneMapInRes = bloomEnabled ? bloomRes : screenRes;
+        auto toneMapOutRes = backbufferRes;
+
+        if (settings.aaMode == Settings::AAMode::FXAA) {
+            toneMapOutRes = graph.createTexture("tone mapped", 1.0f, GL_RGB, GL_RGB, GL_UNSIGNED_BYTE);
+
+            graph.addPass("fxaa", camOrderPostProcess + 200, camOrderPostProcess + 200,
+                {toneMapOutRes}, {backbufferRes},
+                [this, toneMapOutRes](const RenderGraph& g) {
+                ppCamera_ = postProcessFXAA(camOrderPostProcess + 200, g.texture(toneMapOutRes))->camera();
+            });
+        }
+
+        graph.addPass("tone mapping", camOrderPostProcess + 100, camOrderPostProcess + 100,
+            (bloomEnabled ? RenderGraph::ResourceIds{bloomRes} : hdrReads), {toneMapOutRes},
+            [this, toneMapInRes, toneMapOutRes, screenRes, backbufferRes, taaDestMats](const RenderGraph& g) {
+            auto filter = postProcessToneMapping(camOrderPostProcess + 100, g.texture(toneMapInRes));
+            if (toneMapInRes == screenRes) {
+                taaDestMats->push_back(filter->material());
             }
-            ppCamera_ = filter->camera();
+            if (toneMapOutRes == backbufferRes) {
+                ppCamera_ = filter->camera();
+            } else {
+                filter->camera()->setRenderTarget(AttachmentPoint::Color0, RenderTarget(g.texture(toneMapOutRes)));
+            }
+        });
+
+        if (settings.aaMode == Settings::AAMode::TAA) {
+            // Declared last, setup needs the materials collected above.
+            graph.addPass("taa", camOrderPostProcess, camOrderPostProcess,
+                {screenRes, velocityRes, depthRes}, {hdrReads.back()},
+                [this, mc, screenRes, velocityRes, depthRes, taaDestMats](const RenderGraph& g) {
+                postProcessTAA(camOrderPostProcess, mc, g.texture(screenRes),
+                    g.texture(velocityRes), g.texture(depthRes), *taaDestMats);
+            });
         }
 
+        graph.compile();
+
+        mc->setLayer(CameraLayer::Main);
+        mc->setOcclusionCull(true);
+        mc->setAspect(settings.viewAspect);
+        addCamera(mc);
+
         ppCamera_->setViewport(AABB2i(Vector2i(settings.viewX, settings.viewY),
             Vector2i(settings.viewX + settings.viewWidth, settings.viewY + settings.viewHeight)));
 
@@ -578,6 +694,7 @@ namespace af3d
             * just culls the scene. However, ui component manager update is more than render preparations,
             * it can run custom logic...
             */
+            impl_->transforms_.update();
             impl_->renderComponentManager_->update(dt);
         } else {
             ppCamera_->setViewport(AABB2i(Vector2i(settings.viewX, settings.viewY),
@@ -585,6 +702,7 @@ namespace af3d
 
             impl_->uiComponentManager_->update(dt);
             if (forceUpdateRender) {
+                impl_->transforms_.update();
                 impl_->renderComponentManager_->update(dt);
             }
         }
@@ -593,6 +711,9 @@ namespace af3d
         std::vector<std::pair<CameraRendererPtr, size_t>> crs;
 
         for (const auto& cam : cameras_) {
+            if (cam->skipFrame()) {
+                continue;
+            }
             size_t idx = rls.size();
             for (const auto& cr : cam->renderers()) {
                 crs.emplace_back(cr, idx);
@@ -742,17 +863,11 @@ namespace af3d
         dummy_->addComponent(taa);
     }
 
-    TexturePtr Scene::postProcessBloom(int order, const TexturePtr& inputTex,
+    void Scene::postProcessBloom(int order, const TexturePtr& inputTex,
+        const TexturePtr& outTex, const TexturePtr& tex1, const TexturePtr& tex2,
         float brightnessThreshold, int blurKSize, float blurSigma, float compositeStrength,
         std::vector<MaterialPtr>& mats)
     {
-        auto tex1 = textureManager.createRenderTextureScaled(TextureType2D,
-            2.0f, 0, GL_RGB16F, GL_RGB, GL_FLOAT, true);
-        auto tex2 = textureManager.createRenderTextureScaled(TextureType2D,
-            2.0f, 0, GL_RGB16F, GL_RGB, GL_FLOAT, true);
-        auto outTex = textureManager.createRenderTextureScaled(TextureType2D,
-            1.0f, 0, GL_RGB16F, GL_RGB, GL_FLOAT);
-
         auto ppFilter = std::make_shared<RenderFilterComponent>(MaterialTypeFilterBloomPass1);
         ppFilter->material()->setTextureBinding(SamplerName::Main,
             TextureBinding(inputTex,
@@ -763,7 +878,7 @@ namespace af3d
         dummy_->addComponent(ppFilter);
         mats.push_back(ppFilter->material());
 
-        const int numPasses = 5;
+        const int numPasses = bloomNumPasses;
 
         for (int i = 0; i < numPasses; ++i) {
             auto ppFilter = std::make_shared<RenderFilterComponent>(MaterialTypeFilterDownscale);
@@ -811,8 +926,43 @@ namespace af3d
         ppFilter->material()->params().setUniform(UniformName::MipLevel, static_cast<float>(numPasses));
         dummy_->addComponent(ppFilter);
         mats.push_back(ppFilter->material());
+    }
 
-        return outTex;
+    void Scene::postProcessBloomCompute(int order, const TexturePtr& inputTex,
+        const TexturePtr& outTex, const TexturePtr& mipsTex,
+        float brightnessThreshold, float compositeStrength,
+        std::vector<MaterialPtr>& mats)
+    {
+        bool high = (settings.bloomQuality == Settings::BloomQuality::High);
+
+        auto rpBloom = std::make_shared<RenderPassBloom>(inputTex, mipsTex, (high ? 6 : 4), brightnessThreshold, high);
+
+        // The whole mip chain is a single filter layer camera with compute dispatches only.
+        auto r = std::make_shared<CameraRenderer>();
+        r->setOrder(order++);
+        r->setClearMask(AttachmentPoints());
+        r->addRenderPass(rpBloom);
+
+        auto cam = std::make_shared<Camera>(false);
+        cam->setLayer(CameraLayer::Filter);
+        cam->addRenderer(r);
+        addCamera(cam);
+        mats.push_back(rpBloom->prefilterMaterial());
+
+        // Upsample accumulates the whole chain into mip 0, so composite reads just that.
+        auto ppFilter = std::make_shared<RenderFilterComponent>(MaterialTypeFilterBloomPass2);
+        ppFilter->material()->setTextureBinding(SamplerName::Main,
+            TextureBinding(inputTex,
+                SamplerParams(GL_LINEAR, GL_LINEAR)));
+        ppFilter->material()->setTextureBinding(SamplerName::Specular,
+            TextureBinding(mipsTex,
+                SamplerParams(GL_LINEAR_MIPMAP_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR)));
+        ppFilter->camera()->setOrder(order++);
+        ppFilter->camera()->setRenderTarget(AttachmentPoint::Color0, RenderTarget(outTex));
+        ppFilter->material()->params().setUniform(UniformName::Strength, compositeStrength);
+        ppFilter->material()->params().setUniform(UniformName::MipLevel, 1.0f);
+        dummy_->addComponent(ppFilter);
+        mats.push_back(ppFilter->material());
     }
 
     RenderFilterComponentPtr Scene::postProcessToneMapping(int order, const TexturePtr& inputTex)
@@ -837,11 +987,19 @@ namespace af3d
         return ppFilter;
     }
 
-    TexturePtr Scene::postProcessSSAO(int order, const CameraPtr& inputCamera, const TexturePtr& depthTexture, const TexturePtr& normalTexture)
+    void Scene::postProcessSSAO(int order, const CameraPtr& inputCamera, const TexturePtr& depthTexture, const TexturePtr& normalTexture,
+        const TexturePtr& outTexture, const TexturePtr& tmpTexture)
+    {
+        auto ssao = std::make_shared<SSAOComponent>(inputCamera, depthTexture, normalTexture, outTexture, tmpTexture, 16, order);
+        dummy_->addComponent(ssao);
+    }
+
+    void Scene::postProcessSSAOCompute(int order, const CameraPtr& inputCamera, const TexturePtr& depthTexture, const TexturePtr& normalTexture,
+        const TexturePtr& velocityTexture, const TexturePtr& outTexture, const TexturePtr& rawTexture)
     {
-        auto ssao = std::make_shared<SSAOComponent>(inputCamera, depthTexture, normalTexture, 16, order);
+        // Half the kernel, temporal accumulation makes up for it.
+        auto ssao = std::make_shared<SSAOComponent>(inputCamera, depthTexture, normalTexture, velocityTexture, outTexture, rawTexture, 8, order);
         dummy_->addComponent(ssao);
-        return ssao->outTexture();
     }
 
     void Scene::addJoint(const JointPtr& joint)
@@ -942,6 +1100,48 @@ namespace af3d
         impl_->physicsComponentManager_->rayCast(p1, p2, fn);
     }
 
+    void Scene::rayCastBatch(const std::vector<RayCastQuery>& queries, std::vector<QueryHit>& hits,
+        const btCollisionObject* ignore) const
+    {
+        impl_->physicsComponentManager_->rayCastBatch(queries, hits, ignore);
+    }
+
+    void Scene::sweepBatch(const btConvexShape* shape, const std::vector<SweepQuery>& queries, std::vector<QueryHit>& hits,
+        const btCollisionObject* ignore) const
+    {
+        impl_->physicsComponentManager_->sweepBatch(shape, queries, hits, ignore);
+    }
+
+    std::vector<QueryHit> Scene::script_rayCastBatch(const std::vector<btVector3>& p1s, const std::vector<btVector3>& p2s,
+        const SceneObjectPtr& ignore) const
+    {
+        std::vector<RayCastQuery> queries;
+        queries.reserve(p1s.size());
+        for (std::size_t i = 0; i < std::min(p1s.size(), p2s.size()); ++i) {
+            queries.emplace_back(p1s[i], p2s[i]);
+        }
+
+        std::vector<QueryHit> hits;
+        rayCastBatch(queries, hits, ignore ? ignore->body() : nullptr);
+        return hits;
+    }
+
+    std::vector<QueryHit> Scene::script_sphereSweepBatch(float radius, const std::vector<btVector3>& p1s, const std::vector<btVector3>& p2s,
+        const SceneObjectPtr& ignore) const
+    {
+        std::vector<SweepQuery> queries;
+        queries.reserve(p1s.size());
+        for (std::size_t i = 0; i < std::min(p1s.size(), p2s.size()); ++i) {
+            queries.emplace_back(toTransform(p1s[i]), toTransform(p2s[i]));
+        }
+
+        btSphereShape shape(radius);
+
+        std::vector<QueryHit> hits;
+        sweepBatch(&shape, queries, hits, ignore ? ignore->body() : nullptr);
+        return hits;
+    }
+
     bool Scene::collidesWith(btCollisionObject* thisObj, btCollisionObject* other) const
     {
         return impl_->filterCallback_.needBroadphaseCollision(thisObj->getBroadphaseHandle(), other->getBroadphaseHandle());
@@ -979,11 +1179,31 @@ namespace af3d
         impl_->env_->removeLightProbe(probe);
     }
 
+    void Scene::saveLightProbeAsync(const std::function<void()>& fn, const std::function<void()>& doneFn)
+    {
+        impl_->env_->saveLightProbeAsync(fn, doneFn);
+    }
+
+    std::uint32_t Scene::lightProbesBaked() const
+    {
+        return impl_->env_->lightProbesBaked();
+    }
+
+    std::uint32_t Scene::lightProbesToBake() const
+    {
+        return impl_->env_->lightProbesToBake();
+    }
+
     bool Scene::addShadowMap(ShadowMapCSM* csm)
     {
         return impl_->env_->shadowMgr().addShadowMap(csm);
     }
 
+    IndirectDrawManager& Scene::indirectDrawMgr()
+    {
+        return impl_->env_->indirectDrawMgr();
+    }
+
     int Scene::getImmCameraIdx(ACookie camCookie)
     {
         return impl_->env_->allocImmCameraIdx(camCookie);
@@ -1092,11 +1312,26 @@ namespace af3d
         impl_->env_->updateLightProbes();
     }
 
+    SceneTransforms& Scene::transforms()
+    {
+        return impl_->transforms_;
+    }
+
+    void Scene::onEnter(SceneObject* obj)
+    {
+        btAssert(obj->transformSlot() < 0);
+        obj->setTransformSlot(impl_->transforms_.add(obj));
+    }
+
     void Scene::onLeave(SceneObject* obj)
     {
         if (obj->body()) {
             impl_->onBodyLeave(obj->body());
         }
+        if (obj->transformSlot() >= 0) {
+            impl_->transforms_.remove(obj->transformSlot());
+            obj->setTransformSlot(-1);
+        }
     }
 
     void Scene::worldPreTickCallback(btDynamicsWorld* world, btScalar timeStep)
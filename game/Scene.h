@@ -42,6 +42,8 @@ namespace af3d
     class LightProbeComponent;
     class Light;
     class ShadowMapCSM;
+    class IndirectDrawManager;
+    class SceneTransforms;
 
     class Scene : public SceneObjectManager
     {
@@ -106,6 +108,18 @@ namespace af3d
 
         void rayCast(const btVector3& p1, const btVector3& p2, const RayCastFn& fn) const;
 
+        void rayCastBatch(const std::vector<RayCastQuery>& queries, std::vector<QueryHit>& hits,
+            const btCollisionObject* ignore = nullptr) const;
+
+        void sweepBatch(const btConvexShape* shape, const std::vector<SweepQuery>& queries, std::vector<QueryHit>& hits,
+            const btCollisionObject* ignore = nullptr) const;
+
+        std::vector<QueryHit> script_rayCastBatch(const std::vector<btVector3>& p1s, const std::vector<btVector3>& p2s,
+            const SceneObjectPtr& ignore) const;
+
+        std::vector<QueryHit> script_sphereSweepBatch(float radius, const std::vector<btVector3>& p1s, const std::vector<btVector3>& p2s,
+            const SceneObjectPtr& ignore) const;
+
         bool collidesWith(btCollisionObject* thisObj, btCollisionObject* other) const;
 
         inline const editor::WorkspacePtr& workspace() const { return workspace_; }
@@ -126,8 +140,16 @@ namespace af3d
 
         void removeLightProbe(LightProbeComponent* probe);
 
+        void saveLightProbeAsync(const std::function<void()>& fn, const std::function<void()>& doneFn);
+
+        // Light probe recreation progress, both are 0 when nothing is queued.
+        std::uint32_t lightProbesBaked() const;
+        std::uint32_t lightProbesToBake() const;
+
         bool addShadowMap(ShadowMapCSM* csm);
 
+        IndirectDrawManager& indirectDrawMgr();
+
         // -1 if no more indices available.
         int getImmCameraIdx(ACookie camCookie);
 
@@ -188,7 +210,10 @@ namespace af3d
         APropertyValue propertyUpdateLightProbesGet(const std::string&) const { return false; }
         void propertyUpdateLightProbesSet(const std::string&, const APropertyValue& value);
 
+        SceneTransforms& transforms();
+
         // Internal, do not call.
+        void onEnter(SceneObject* obj);
         void onLeave(SceneObject* obj);
 
     private:
@@ -215,11 +240,18 @@ namespace af3d
             const TexturePtr& velocityTexture,
             const TexturePtr& depthTexture,
             const std::vector<MaterialPtr>& destMaterials);
-        TexturePtr postProcessBloom(int order, const TexturePtr& inputTex,
+        void postProcessBloom(int order, const TexturePtr& inputTex,
+            const TexturePtr& outTex, const TexturePtr& tex1, const TexturePtr& tex2,
             float brightnessThreshold, int blurKSize, float blurSigma, float compositeStrength, std::vector<MaterialPtr>& mats);
+        void postProcessBloomCompute(int order, const TexturePtr& inputTex,
+            const TexturePtr& outTex, const TexturePtr& mipsTex,
+            float brightnessThreshold, float compositeStrength, std::vector<MaterialPtr>& mats);
         RenderFilterComponentPtr postProcessToneMapping(int order, const TexturePtr& inputTex);
         RenderFilterComponentPtr postProcessFXAA(int order, const TexturePtr& inputTex);
-        TexturePtr postProcessSSAO(int order, const CameraPtr& inputCamera, const TexturePtr& depthTexture, const TexturePtr& normalTexture);
+        void postProcessSSAO(int order, const CameraPtr& inputCamera, const TexturePtr& depthTexture, const TexturePtr& normalTexture,
+            const TexturePtr& outTexture, const TexturePtr& tmpTexture);
+        void postProcessSSAOCompute(int order, const CameraPtr& inputCamera, const TexturePtr& depthTexture, const TexturePtr& normalTexture,
+            const TexturePtr& velocityTexture, const TexturePtr& outTexture, const TexturePtr& rawTexture);
 
         class Impl;
         std::unique_ptr<Impl> impl_;
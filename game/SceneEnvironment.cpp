@@ -32,6 +32,8 @@
 #include "Settings.h"
 #include "Logger.h"
 #include "ShaderDataTypes.h"
+#include "af3d/BC6H.h"
+#include <array>
 
 namespace af3d
 {
@@ -43,6 +45,9 @@ namespace af3d
             bool recreate = false;
             std::pair<int, int> indexRange{(std::numeric_limits<int>::max)(), 0};
             std::vector<std::pair<int, ShaderClusterLightImpl>> lights;
+            HardwareDataBufferPtr enabledSSBO;
+            bool enabledRecreate = false;
+            std::vector<std::uint32_t> enabled; // count followed by indices.
         };
 
         struct ProbesSSBOUpdate : boost::noncopyable
@@ -56,12 +61,17 @@ namespace af3d
 
     SceneEnvironment::SceneEnvironment()
     : lightsSSBO_(hwManager.createDataBuffer(HardwareBuffer::Usage::DynamicDraw, sizeof(ShaderClusterLight) + sizeof(std::uint32_t) * (settings.maxImmCameras + 1))),
+      enabledLightsSSBO_(hwManager.createDataBuffer(HardwareBuffer::Usage::DynamicDraw, sizeof(std::uint32_t))),
       probesSSBO_(hwManager.createDataBuffer(HardwareBuffer::Usage::DynamicDraw, sizeof(ShaderClusterProbe))),
-      irradianceTexture_(textureManager.createRenderTexture(TextureTypeCubeMapArray,
-          settings.lightProbe.irradianceResolution, settings.lightProbe.irradianceResolution, settings.cluster.maxProbes, GL_RGB16F, GL_RGB, GL_FLOAT)),
       specularTexture_(textureManager.createRenderTexture(TextureTypeCubeMapArray,
-          settings.lightProbe.specularResolution, settings.lightProbe.specularResolution, settings.cluster.maxProbes, GL_RGB16F, GL_RGB, GL_FLOAT, true))
+          settings.lightProbe.specularResolution, settings.lightProbe.specularResolution, settings.cluster.maxProbes,
+          (settings.lightProbe.compact ? LightProbeComponent::compactSpecularFormat : GL_RGB16F), GL_RGB, GL_FLOAT, true))
     {
+        if (!settings.lightProbe.compact) {
+            // Compact probes keep irradiance in probes SSBO.
+            irradianceTexture_ = textureManager.createRenderTexture(TextureTypeCubeMapArray,
+                settings.lightProbe.irradianceResolution, settings.lightProbe.irradianceResolution, settings.cluster.maxProbes, GL_RGB16F, GL_RGB, GL_FLOAT);
+        }
         for (int i = 0; i < static_cast<int>(settings.cluster.maxLights); ++i) {
             lightsFreeIndices_.insert(i);
         }
@@ -73,6 +83,15 @@ namespace af3d
 
     SceneEnvironment::~SceneEnvironment()
     {
+        {
+            std::lock_guard<std::mutex> lock(saveMtx_);
+            saveStop_ = true;
+        }
+        saveCond_.notify_all();
+        if (saveThread_.joinable()) {
+            // Pending saves still get written.
+            saveThread_.join();
+        }
         btAssert(lights_.empty());
         btAssert(probes_.empty());
         btAssert(globalProbe_ == nullptr);
@@ -86,6 +105,17 @@ namespace af3d
 
         immCameras_.clear();
         immCameras_[0] = 0; // 0 is special, all cameras without an imm index map into it.
+
+        std::vector<SaveFn> saveDone;
+        {
+            std::lock_guard<std::mutex> lock(saveMtx_);
+            saveDone.swap(saveDone_);
+        }
+        for (const auto& fn : saveDone) {
+            fn();
+        }
+
+        updateBake();
     }
 
     void SceneEnvironment::preSwap()
@@ -94,6 +124,7 @@ namespace af3d
         preSwapLights();
         preSwapProbes();
         shadowMgr_.preSwap();
+        indirectDrawMgr_.preSwap();
     }
 
     int SceneEnvironment::addLight(Light* light)
@@ -142,6 +173,14 @@ namespace af3d
 
     void SceneEnvironment::removeLightProbe(LightProbeComponent* probe)
     {
+        auto it = std::find(bakeQueue_.begin(), bakeQueue_.end(), probe);
+        if (it != bakeQueue_.end()) {
+            bakeQueue_.erase(it);
+            --bakeTotal_;
+        } else if (bakeActive_.erase(probe) > 0) {
+            --bakeTotal_;
+        }
+
         if (probe == globalProbe_) {
             globalProbe_ = nullptr;
             probesNeedUpdate_ = true;
@@ -159,16 +198,34 @@ namespace af3d
 
     void SceneEnvironment::updateLightProbes()
     {
+        if (bakeTotal_ > 0) {
+            LOG4CPLUS_WARN(logger(), "Light probes baking still in progress (" << bakeDone_ << "/" << bakeTotal_ << ")...");
+            return;
+        }
+
         if (globalProbe_) {
-            if (globalProbe_->recreate()) {
-                updateProbeTextures(globalProbe_);
-            }
+            bakeQueue_.push_back(globalProbe_);
         }
         for (auto probe : probes_) {
-            if (probe->recreate()) {
-                updateProbeTextures(probe);
-            }
+            bakeQueue_.push_back(probe);
         }
+
+        bakeDone_ = 0;
+        bakeTotal_ = bakeQueue_.size();
+
+        LOG4CPLUS_INFO(logger(), "Baking " << bakeTotal_ << " light probes...");
+    }
+
+    void SceneEnvironment::saveLightProbeAsync(const SaveFn& fn, const SaveFn& doneFn)
+    {
+        {
+            std::lock_guard<std::mutex> lock(saveMtx_);
+            saveQueue_.emplace_back(fn, doneFn);
+        }
+        if (!saveThread_.joinable()) {
+            saveThread_ = std::thread(&SceneEnvironment::saveThreadFn, this);
+        }
+        saveCond_.notify_one();
     }
 
     int SceneEnvironment::allocImmCameraIdx(ACookie camCookie)
@@ -198,20 +255,31 @@ namespace af3d
     void SceneEnvironment::preSwapLights()
     {
         bool recreate = lightsSSBO_->setValid();
-        if (lights_.empty() && lightsRemovedIndices_.empty() && !recreate) {
+        bool enabledRecreate = enabledLightsSSBO_->setValid();
+        if (lights_.empty() && lightsRemovedIndices_.empty() && !recreate && !enabledRecreate) {
             return;
         }
 
         auto upd = std::make_shared<LightsSSBOUpdate>();
         upd->ssbo = lightsSSBO_;
         upd->recreate = recreate;
+        upd->enabledSSBO = enabledLightsSSBO_;
+        upd->enabledRecreate = enabledRecreate;
         upd->lights.reserve(lights_.size() + lightsRemovedIndices_.size());
+        upd->enabled.reserve(lights_.size() + 1);
+        upd->enabled.push_back(0);
         for (auto light : lights_) {
             upd->indexRange.first = (std::min)(upd->indexRange.first, light->index());
             upd->indexRange.second = (std::max)(upd->indexRange.second, light->index());
             upd->lights.emplace_back(light->index(), ShaderClusterLightImpl());
             light->setupCluster(upd->lights.back().second);
+            if (upd->lights.back().second.enabled) {
+                upd->enabled.push_back(light->index());
+            }
         }
+        // Keep cull shader reads of 'clusterLights' in index order.
+        std::sort(upd->enabled.begin() + 1, upd->enabled.end());
+        upd->enabled[0] = upd->enabled.size() - 1;
         for (auto idx : lightsRemovedIndices_) {
             upd->indexRange.first = (std::min)(upd->indexRange.first, idx);
             upd->indexRange.second = (std::max)(upd->indexRange.second, idx);
@@ -219,6 +287,15 @@ namespace af3d
         }
         lightsRemovedIndices_.clear();
         renderer.scheduleHwOp([upd](HardwareContext& ctx) {
+            if (upd->enabledRecreate) {
+                upd->enabledSSBO->resize(settings.cluster.maxLights + 1, ctx);
+            }
+            upd->enabledSSBO->upload(0, upd->enabled.size(), &upd->enabled[0], ctx);
+
+            if (upd->lights.empty() && !upd->recreate) {
+                return;
+            }
+
             char* ptr;
             if (upd->recreate) {
                 upd->ssbo->resize(settings.cluster.maxLights, ctx);
@@ -243,13 +320,15 @@ namespace af3d
 
     void SceneEnvironment::preSwapProbes()
     {
-        if (irradianceTexture_->generation() != irradianceTextureGeneration_) {
+        if (specularTexture_->generation() != probeTexturesGeneration_) {
             // Need to re-upload default textures.
-            irradianceTextureGeneration_ = irradianceTexture_->generation();
+            probeTexturesGeneration_ = specularTexture_->generation();
             if (globalProbe_) {
+                globalProbe_->reloadSpecular();
                 updateProbeTextures(globalProbe_);
             }
             for (auto probe : probes_) {
+                probe->reloadSpecular();
                 updateProbeTextures(probe);
             }
         } else {
@@ -305,8 +384,88 @@ namespace af3d
         });
     }
 
+    void SceneEnvironment::updateBake()
+    {
+        if (bakeTotal_ == 0) {
+            return;
+        }
+
+        for (auto it = bakeActive_.begin(); it != bakeActive_.end();) {
+            if ((*it)->baking()) {
+                ++it;
+            } else {
+                ++bakeDone_;
+                it = bakeActive_.erase(it);
+            }
+        }
+
+        while (!bakeQueue_.empty() && (bakeActive_.size() < (std::max)(settings.lightProbe.maxConcurrentProbeBakes, 1U))) {
+            auto probe = bakeQueue_.front();
+            bakeQueue_.pop_front();
+            if (probe->recreate()) {
+                updateProbeTextures(probe);
+                bakeActive_.insert(probe);
+            } else {
+                ++bakeDone_;
+            }
+        }
+
+        if (bakeDone_ >= bakeTotal_) {
+            LOG4CPLUS_INFO(logger(), "Light probes baked (" << bakeDone_ << ")");
+            bakeDone_ = 0;
+            bakeTotal_ = 0;
+        }
+    }
+
+    void SceneEnvironment::saveThreadFn()
+    {
+        while (true) {
+            std::pair<SaveFn, SaveFn> fns;
+            {
+                std::unique_lock<std::mutex> lock(saveMtx_);
+                saveCond_.wait(lock, [this]() { return saveStop_ || !saveQueue_.empty(); });
+                if (saveQueue_.empty()) {
+                    return;
+                }
+                fns = std::move(saveQueue_.front());
+                saveQueue_.pop_front();
+            }
+            fns.first();
+            {
+                std::lock_guard<std::mutex> lock(saveMtx_);
+                saveDone_.push_back(std::move(fns.second));
+            }
+        }
+    }
+
     void SceneEnvironment::updateProbeTextures(LightProbeComponent* probe)
     {
+        if (settings.lightProbe.compact) {
+            // Irradiance SH are set up in 'LightProbeComponent::setupCluster'.
+            if (!probe->hasSpecular()) {
+                Color color = gammaToLinear(probe->specularColor());
+                // Solid color, so encode a single block and repeat it.
+                std::array<float, 4 * 4 * 3> pixels;
+                for (size_t i = 0; i < pixels.size(); i += 3) {
+                    pixels[i + 0] = color.x();
+                    pixels[i + 1] = color.y();
+                    pixels[i + 2] = color.z();
+                }
+                std::array<Byte, 16> block;
+                btAssert(bc6hSize(4, 4) == block.size());
+                bc6hEncode(&pixels[0], 4, 4, &block[0]);
+                std::uint32_t mip = 0;
+                while (std::uint32_t sz = textureMipSize(settings.lightProbe.specularResolution, mip)) {
+                    std::vector<Byte> data(bc6hSize(sz, sz) * (TextureCubeFaceMax + 1));
+                    for (size_t i = 0; i < data.size(); i += block.size()) {
+                        std::copy(block.begin(), block.end(), &data[i]);
+                    }
+                    specularTexture_->updateCompressed(LightProbeComponent::compactSpecularFormat, std::move(data), mip, probe->index());
+                    ++mip;
+                }
+            }
+            return;
+        }
         if (!probe->hasIrradiance()) {
             Color color = gammaToLinear(probe->ambientColor());
             std::vector<Byte> data(settings.lightProbe.irradianceResolution * settings.lightProbe.irradianceResolution * 3 * (TextureCubeFaceMax + 1) * sizeof(float));
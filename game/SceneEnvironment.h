@@ -29,6 +29,11 @@
 #include "VertexArrayWriter.h"
 #include "RenderTarget.h"
 #include "ShadowManager.h"
+#include "IndirectDrawManager.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 namespace af3d
 {
@@ -38,6 +43,8 @@ namespace af3d
     class SceneEnvironment : boost::noncopyable
     {
     public:
+        using SaveFn = std::function<void()>;
+
         SceneEnvironment();
         ~SceneEnvironment();
 
@@ -48,6 +55,7 @@ namespace af3d
         inline VertexArrayWriter& defaultVa() { return defaultVa_; }
         inline LightProbeComponent* globalLightProbe() { return globalProbe_; }
         inline ShadowManager& shadowMgr() { return shadowMgr_; }
+        inline IndirectDrawManager& indirectDrawMgr() { return indirectDrawMgr_; }
 
         void update(float realDt, float dt);
 
@@ -61,8 +69,17 @@ namespace af3d
 
         void removeLightProbe(LightProbeComponent* probe);
 
+        // Queues all probes for recreation, up to 'settings.lightProbe.maxConcurrentProbeBakes'
+        // of them are baked at once.
         void updateLightProbes();
 
+        // Light probe recreation progress, both are 0 when nothing is queued.
+        inline std::uint32_t lightProbesBaked() const { return bakeDone_; }
+        inline std::uint32_t lightProbesToBake() const { return bakeTotal_; }
+
+        // Runs 'fn' on light probe save thread, then 'doneFn' on main thread from 'update()'.
+        void saveLightProbeAsync(const SaveFn& fn, const SaveFn& doneFn);
+
         // -1 if no more indices available.
         int allocImmCameraIdx(ACookie camCookie);
 
@@ -71,8 +88,12 @@ namespace af3d
 
         inline const HardwareDataBufferPtr& lightsSSBO() const { return lightsSSBO_; }
 
+        // Compacted list of enabled light indices: {count, indices[count]}.
+        inline const HardwareDataBufferPtr& enabledLightsSSBO() const { return enabledLightsSSBO_; }
+
         inline const HardwareDataBufferPtr& probesSSBO() const { return probesSSBO_; }
 
+        // Null with compact light probes.
         inline const TexturePtr& irradianceTexture() const { return irradianceTexture_; }
 
         inline const TexturePtr& specularTexture() const { return specularTexture_; }
@@ -87,15 +108,20 @@ namespace af3d
 
         void updateProbeTextures(LightProbeComponent* probe);
 
+        void updateBake();
+
+        void saveThreadFn();
+
         float realDt_ = 0.0f;
         float dt_ = 0.0f;
         float time_ = 0.0f;
         VertexArrayWriter defaultVa_;
         HardwareDataBufferPtr lightsSSBO_;
+        HardwareDataBufferPtr enabledLightsSSBO_;
         HardwareDataBufferPtr probesSSBO_;
         TexturePtr irradianceTexture_;
-        std::uint32_t irradianceTextureGeneration_ = (std::numeric_limits<std::uint32_t>::max)();
         TexturePtr specularTexture_;
+        std::uint32_t probeTexturesGeneration_ = (std::numeric_limits<std::uint32_t>::max)();
 
         std::unordered_set<Light*> lights_;
         IndexSet lightsFreeIndices_;
@@ -107,8 +133,22 @@ namespace af3d
         std::unordered_set<LightProbeComponent*> probesToCheck_;
         bool probesNeedUpdate_ = true;
 
+        std::deque<LightProbeComponent*> bakeQueue_;
+        std::unordered_set<LightProbeComponent*> bakeActive_;
+        std::uint32_t bakeDone_ = 0;
+        std::uint32_t bakeTotal_ = 0;
+
+        std::thread saveThread_;
+        std::mutex saveMtx_;
+        std::condition_variable saveCond_;
+        std::deque<std::pair<SaveFn, SaveFn>> saveQueue_;
+        std::vector<SaveFn> saveDone_;
+        bool saveStop_ = false;
+
         ShadowManager shadowMgr_;
 
+        IndirectDrawManager indirectDrawMgr_;
+
         ImmCameras immCameras_;
     };
 
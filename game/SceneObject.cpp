@@ -27,6 +27,7 @@
 #include "PhysicsBodyComponent.h"
 #include "MotionState.h"
 #include "Scene.h"
+#include "SceneTransforms.h"
 #include "Utils.h"
 #include "Settings.h"
 #include "Logger.h"
@@ -266,6 +267,8 @@ namespace af3d
         body_ = value;
         body_->setUserPointer(this);
         bodyMs_ = static_cast<MotionState*>(body_->getMotionState());
+        bodyMs_->owner = this;
+        markTransformDirty();
 
         if (bodyType() == BodyType::Kinematic) {
             if (!bodyCi_.linearVelocity.fuzzyZero() || !bodyCi_.angularVelocity.fuzzyZero()) {
@@ -444,6 +447,8 @@ namespace af3d
             bodyCi_.xf.getBasis().getRotation(q);
             bodyCi_.xf.getBasis().setRotation(q);
         }
+
+        markTransformDirty();
     }
 
     void SceneObject::setTransformRecursive(const btVector3& pos, const btQuaternion& rot, bool withEditable)
@@ -476,6 +481,24 @@ namespace af3d
         }
     }
 
+    const btTransform& SceneObject::worldTransform() const
+    {
+        if (transformSlot_ >= 0) {
+            return scene()->transforms().world(transformSlot_);
+        } else {
+            return smoothTransform();
+        }
+    }
+
+    const btTransform& SceneObject::prevWorldTransform() const
+    {
+        if (transformSlot_ >= 0) {
+            return scene()->transforms().prevWorld(transformSlot_);
+        } else {
+            return smoothTransform();
+        }
+    }
+
     const btVector3& SceneObject::pos() const
     {
         return transform().getOrigin();
@@ -557,6 +580,7 @@ namespace af3d
             bodyMs_->centerOfMassXf = t;
             setTransform(xf);
             bodyMs_->smoothXf = smoothXf;
+            markTransformDirty();
         }
     }
 
@@ -911,6 +935,18 @@ namespace af3d
         objs.insert(shared_from_this());
     }
 
+    bool SceneObject::transformMoved()
+    {
+        return (transformSlot_ >= 0) && scene()->transforms().moved(transformSlot_);
+    }
+
+    void SceneObject::markTransformDirty()
+    {
+        if (transformSlot_ >= 0) {
+            scene()->transforms().markDirty(transformSlot_);
+        }
+    }
+
     bool SceneObject::collidesWith(btCollisionObject* other)
     {
         btAssert(body_);
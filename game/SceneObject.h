@@ -173,6 +173,12 @@ namespace af3d
 
         const btTransform& smoothTransform() const;
 
+        // 'smoothTransform' as of last scene transforms update, same as 'smoothTransform' when not in scene.
+        const btTransform& worldTransform() const;
+
+        // 'worldTransform' before last scene transforms update, equals 'worldTransform' if not moved.
+        const btTransform& prevWorldTransform() const;
+
         const btVector3& pos() const;
         void setPos(const btVector3& value);
 
@@ -270,6 +276,9 @@ namespace af3d
 
         void collectIslandObjects(std::unordered_set<SceneObjectPtr>& objs);
 
+        // True if world transform changed during last scene transforms update.
+        bool transformMoved();
+
         bool collidesWith(btCollisionObject* other);
 
         /*
@@ -279,6 +288,11 @@ namespace af3d
         void freeze();
         void thaw();
 
+        inline int transformSlot() const { return transformSlot_; }
+        inline void setTransformSlot(int value) { transformSlot_ = value; }
+
+        void markTransformDirty();
+
         /*
          * @}
          */
@@ -376,6 +390,8 @@ namespace af3d
 
         float freezeRadius_ = 0.0f;
 
+        int transformSlot_ = -1;
+
         std::vector<ComponentPtr> components_;
         CollisionFilterPtr collisionFilter_;
 
@@ -183,6 +183,13 @@ namespace af3d
                 scene_->onLeave(obj);
             }
         }
+        if (value && (value != scene_)) {
+            scene_ = value;
+            auto obj = aobjectCast<SceneObject>(this);
+            if (obj) {
+                scene_->onEnter(obj);
+            }
+        }
         scene_ = value;
     }
 
@@ -95,7 +95,7 @@ namespace af3d
         inline SceneObjectManager* parent() { return parent_; }
         inline void setParent(SceneObjectManager* value) { parent_ = value; }
 
-        inline Scene* scene() { return scene_; }
+        inline Scene* scene() const { return scene_; }
         void setScene(Scene* value);
 
         APropertyValue propertyChildrenGet(const std::string&) const
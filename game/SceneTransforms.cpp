@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "SceneTransforms.h"
+#include "SceneObject.h"
+
+namespace af3d
+{
+    SceneTransforms::~SceneTransforms()
+    {
+        btAssert(size() == 0);
+    }
+
+    int SceneTransforms::add(SceneObject* obj)
+    {
+        int slot;
+
+        if (freeSlots_.empty()) {
+            slot = objects_.size();
+            world_.push_back(obj->smoothTransform());
+            prevWorld_.push_back(obj->smoothTransform());
+            objects_.push_back(obj);
+            flags_.push_back(FlagUsed);
+        } else {
+            slot = freeSlots_.back();
+            freeSlots_.pop_back();
+            world_[slot] = obj->smoothTransform();
+            prevWorld_[slot] = obj->smoothTransform();
+            objects_[slot] = obj;
+            flags_[slot] = FlagUsed;
+        }
+
+        return slot;
+    }
+
+    void SceneTransforms::remove(int slot)
+    {
+        btAssert((flags_[slot] & FlagUsed) != 0);
+
+        // Stale entries in dirty/moved lists are skipped by 'update'.
+        objects_[slot] = nullptr;
+        flags_[slot] = 0;
+        freeSlots_.push_back(slot);
+    }
+
+    void SceneTransforms::update()
+    {
+        for (auto slot : movedSlots_) {
+            if ((flags_[slot] & FlagUsed) != 0) {
+                flags_[slot] &= ~FlagMoved;
+                prevWorld_[slot] = world_[slot];
+            }
+        }
+
+        movedSlots_.clear();
+
+        for (auto slot : dirtySlots_) {
+            if ((flags_[slot] & FlagDirty) == 0) {
+                continue;
+            }
+            const auto& xf = objects_[slot]->smoothTransform();
+            flags_[slot] &= ~FlagDirty;
+            if (xf == world_[slot]) {
+                continue;
+            }
+            prevWorld_[slot] = world_[slot];
+            world_[slot] = xf;
+            flags_[slot] |= FlagMoved;
+            movedSlots_.push_back(slot);
+        }
+
+        dirtySlots_.clear();
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _SCENETRANSFORMS_H_
+#define _SCENETRANSFORMS_H_
+
+#include "af3d/Types.h"
+#include <boost/noncopyable.hpp>
+#include <vector>
+
+namespace af3d
+{
+    class SceneObject;
+
+    /*
+     * Flat, structure-of-arrays storage for scene object world transforms.
+     * Objects mark themselves dirty when their transform changes (editor/script
+     * setTransform or physics motion state interpolation), once per frame 'update'
+     * then walks only the dirty slots, snapshots new world transforms and flags
+     * them as moved. Consumers (render components, etc.) can then query 'moved'
+     * instead of comparing full transforms every frame, static objects cost nothing,
+     * and read 'world'/'prevWorld' (via SceneObject::worldTransform/prevWorldTransform)
+     * for a consistent per-frame snapshot and displacement.
+     */
+    class SceneTransforms : boost::noncopyable
+    {
+    public:
+        SceneTransforms() = default;
+        ~SceneTransforms();
+
+        int add(SceneObject* obj);
+
+        void remove(int slot);
+
+        inline void markDirty(int slot)
+        {
+            if ((flags_[slot] & FlagDirty) == 0) {
+                flags_[slot] |= FlagDirty;
+                dirtySlots_.push_back(slot);
+            }
+        }
+
+        void update();
+
+        inline bool moved(int slot) const { return (flags_[slot] & FlagMoved) != 0; }
+
+        inline const btTransform& world(int slot) const { return world_[slot]; }
+
+        inline const btTransform& prevWorld(int slot) const { return prevWorld_[slot]; }
+
+        inline size_t size() const { return objects_.size() - freeSlots_.size(); }
+
+        inline SceneObject* object(int slot) const { return objects_[slot]; }
+
+        // Slots that moved during last 'update'.
+        inline const std::vector<int>& movedSlots() const { return movedSlots_; }
+
+    private:
+        enum
+        {
+            FlagDirty = 1 << 0,
+            FlagMoved = 1 << 1,
+            FlagUsed = 1 << 2
+        };
+
+        std::vector<btTransform> world_;
+        std::vector<btTransform> prevWorld_;
+        std::vector<SceneObject*> objects_;
+        std::vector<std::uint8_t> flags_;
+
+        std::vector<int> dirtySlots_;
+        std::vector<int> movedSlots_;
+        std::vector<int> freeSlots_;
+    };
+}
+
+#endif
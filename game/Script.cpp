@@ -241,7 +241,16 @@ namespace af3d
                 .property("paused", &Scene::paused, &Scene::setPaused)
                 .property("playable", &Scene::playable)
                 .property("assetPath", &Scene::assetPath)
-                .property("timeScale", &Scene::timeScale, &Scene::setTimeScale),
+                .property("timeScale", &Scene::timeScale, &Scene::setTimeScale)
+                .def("rayCastBatch", &Scene::script_rayCastBatch)
+                .def("sphereSweepBatch", &Scene::script_sphereSweepBatch),
+
+            luabind::class_<QueryHit>("QueryHit")
+                .property("hit", &QueryHit::hit)
+                .property("obj", &queryHitObject)
+                .def_readonly("point", &QueryHit::point, luabind::copy(luabind::result))
+                .def_readonly("normal", &QueryHit::normal, luabind::copy(luabind::result))
+                .def_readonly("fraction", &QueryHit::fraction),
 
             luabind::class_<SceneObjectFactory>("SceneObjectFactory")
                 .def("createDummy", &SceneObjectFactory::createDummy),
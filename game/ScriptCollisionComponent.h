@@ -51,6 +51,9 @@ namespace af3d
 
         void updateContact(const Contact& contact, bool isNew) override;
 
+        // Scripts may rely on per-step contact updates.
+        bool wantsContactUpdates() const override { return true; }
+
         void endContact(const Contact& contact) override;
 
         void update(float dt) override;
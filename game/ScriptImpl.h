@@ -139,6 +139,13 @@ namespace af3d
      * @}
      */
 
+    static SceneObjectPtr queryHitObject(const QueryHit& hit)
+    {
+        auto body = btRigidBody::upcast(hit.collisionObject);
+        auto obj = body ? SceneObject::fromBody(const_cast<btRigidBody*>(body)) : nullptr;
+        return obj ? obj->shared_from_this() : SceneObjectPtr();
+    }
+
     class Script::Impl
     {
     public:
@@ -27,6 +27,8 @@
 #include "Utils.h"
 #include "Logger.h"
 #include <cmath>
+#include <cstdlib>
+#include <algorithm>
 
 namespace af3d
 {
@@ -59,12 +61,17 @@ namespace af3d
             minRenderDt = 0;
         }
 
+        framesInFlight = std::max(appConfig->getInt(".framesInFlight"), 1);
+
+        LOG4CPLUS_INFO(logger(), "Frames in flight : " << framesInFlight);
+
         maxImmCameras = appConfig->getInt(".maxImmCameras");
 
         viewAspect = static_cast<float>(viewWidth) / viewHeight;
         videoMode = -1;
         msaaMode = -1;
         vsync = false;
+        adaptiveVsync = appConfig->getBool(".adaptiveVsync");
         fullscreen = false;
         trilinearFilter = false;
         viewX = 0;
@@ -88,12 +95,45 @@ namespace af3d
         subKeys.push_back("taa");
 
         aaMode = static_cast<AAMode>(appConfig->getStringIndex(".aaMode", subKeys));
-        bloom = appConfig->getBool(".bloom");
-        ssao = appConfig->getBool(".ssao");
 
         LOG4CPLUS_INFO(logger(), "AA mode : " << subKeys[static_cast<int>(aaMode)]);
-        LOG4CPLUS_INFO(logger(), "Bloom : " << bloom);
-        LOG4CPLUS_INFO(logger(), "SSAO : " << ssao);
+
+        subKeys.clear();
+
+        subKeys.push_back("none");
+        subKeys.push_back("filter");
+        subKeys.push_back("compute");
+
+        bloom = static_cast<BloomMode>(appConfig->getStringIndex(".bloom", subKeys));
+
+        LOG4CPLUS_INFO(logger(), "Bloom : " << subKeys[static_cast<int>(bloom)]);
+
+        subKeys.clear();
+
+        subKeys.push_back("low");
+        subKeys.push_back("high");
+
+        bloomQuality = static_cast<BloomQuality>(appConfig->getStringIndex(".bloomQuality", subKeys));
+
+        LOG4CPLUS_INFO(logger(), "Bloom quality : " << subKeys[static_cast<int>(bloomQuality)]);
+
+        subKeys.clear();
+
+        subKeys.push_back("none");
+        subKeys.push_back("filter");
+        subKeys.push_back("compute");
+
+        ssao = static_cast<SSAOMode>(appConfig->getStringIndex(".ssao", subKeys));
+
+        LOG4CPLUS_INFO(logger(), "SSAO : " << subKeys[static_cast<int>(ssao)]);
+
+        gpuDriven = appConfig->getBool(".gpuDriven");
+
+        LOG4CPLUS_INFO(logger(), "GPU driven : " << gpuDriven);
+
+        bindlessTextures = appConfig->getBool(".bindlessTextures");
+
+        LOG4CPLUS_INFO(logger(), "Bindless textures : " << bindlessTextures);
 
         /*
          * physics.
@@ -102,6 +142,8 @@ namespace af3d
         physics.fixedTimestep = appConfig->getFloat("physics.fixedTimestep");
         physics.maxSteps = appConfig->getInt("physics.maxSteps");
         physics.slowmoFactor = appConfig->getFloat("physics.slowmoFactor");
+        physics.queryThreads = appConfig->getInt("physics.queryThreads");
+        physics.queryThreadMinBatch = appConfig->getInt("physics.queryThreadMinBatch");
         physics.debugWireframe = appConfig->getBool("physics.debug.wireframe");
         physics.debugAabb = appConfig->getBool("physics.debug.aabb");
         physics.debugContactPoints = appConfig->getBool("physics.debug.contactPoints");
@@ -111,6 +153,13 @@ namespace af3d
         physics.debugNormals = appConfig->getBool("physics.debug.normals");
         physics.debugFrames = appConfig->getBool("physics.debug.frames");
 
+        /*
+         * mesh.
+         */
+
+        mesh.importThreads = appConfig->getInt("mesh.importThreads");
+        mesh.keepCPUData = appConfig->getBool("mesh.keepCPUData");
+
         /*
          * imGui.
          */
@@ -125,6 +174,7 @@ namespace af3d
         editor.playing = false;
         editor.disableSimulation = appConfig->getBool("editor.disableSimulation");
         editor.styledJson = appConfig->getBool("editor.styledJson");
+        editor.exactPicking = appConfig->getBool("editor.exactPicking");
         editor.objMarkerSizeWorld = appConfig->getFloat("editor.objMarkerSizeWorld");
         editor.objMarkerSizePixels = appConfig->getInt("editor.objMarkerSizePixels");
         editor.objMarkerColorInactive = appConfig->getColor("editor.objMarkerColorInactive");
@@ -160,6 +210,7 @@ namespace af3d
         cluster.numTiles = cluster.gridSize.x() * cluster.gridSize.y() * cluster.gridSize.z();
         cluster.maxLights = appConfig->getInt("cluster.maxLights");
         cluster.maxLightsPerTile = appConfig->getInt("cluster.maxLightsPerTile");
+        cluster.maxLightIndices = appConfig->getInt("cluster.maxLightIndices");
         cluster.maxProbes = appConfig->getInt("cluster.maxProbes");
         cluster.maxProbesPerTile = appConfig->getInt("cluster.maxProbesPerTile");
 
@@ -170,6 +221,11 @@ namespace af3d
         lightProbe.irradianceResolution = appConfig->getInt("light probe.irradianceResolution");
         lightProbe.specularResolution = appConfig->getInt("light probe.specularResolution");
         lightProbe.specularMipLevels = appConfig->getInt("light probe.specularMipLevels");
+        lightProbe.compact = appConfig->getBool("light probe.compact");
+
+        LOG4CPLUS_INFO(logger(), "Compact light probes : " << lightProbe.compact);
+
+        lightProbe.maxConcurrentProbeBakes = appConfig->getInt("light probe.maxConcurrentProbeBakes");
 
         /*
          * csm.
@@ -178,5 +234,33 @@ namespace af3d
         csm.maxCount = appConfig->getInt("csm.maxCount");
         csm.numSplits = appConfig->getInt("csm.numSplits");
         csm.resolution = appConfig->getInt("csm.resolution");
+        csm.updateIntervals.assign(csm.numSplits, 1);
+
+        subKeys = appConfig->getSubKeys("csm.updateInterval");
+
+        for (const auto& key : subKeys) {
+            int idx = std::atoi(key.c_str());
+            if ((idx >= 0) && (idx < static_cast<int>(csm.numSplits))) {
+                csm.updateIntervals[idx] = std::max(appConfig->getInt(std::string("csm.updateInterval.") + key), 1);
+            }
+        }
+
+        csm.maxSplitsPerFrame = appConfig->getInt("csm.maxSplitsPerFrame");
+
+        /*
+         * dynamic resolution.
+         */
+
+        dynamicResolution.enabled = appConfig->getBool("dynamic resolution.enabled");
+        dynamicResolution.targetFrameMs = appConfig->getFloat("dynamic resolution.targetFrameMs");
+        dynamicResolution.minScale = appConfig->getFloat("dynamic resolution.minScale");
+        dynamicResolution.maxScale = appConfig->getFloat("dynamic resolution.maxScale");
+
+        if (dynamicResolution.enabled && (aaMode != AAMode::TAA)) {
+            LOG4CPLUS_WARN(logger(), "Dynamic resolution requires TAA, disabling");
+            dynamicResolution.enabled = false;
+        }
+
+        LOG4CPLUS_INFO(logger(), "Dynamic resolution : " << dynamicResolution.enabled);
     }
 }
@@ -43,6 +43,26 @@ namespace af3d
             TAA = 2
         };
 
+        enum class BloomMode
+        {
+            None = 0,
+            Filter = 1, // Downscale and separable blur filter passes.
+            Compute = 2 // Single compute mip chain.
+        };
+
+        enum class BloomQuality
+        {
+            Low = 0, // 4 mips.
+            High = 1 // 6 mips, Karis average on first downsample.
+        };
+
+        enum class SSAOMode
+        {
+            None = 0,
+            Filter = 1, // Full kernel, two bilateral blur passes.
+            Compute = 2 // Half resolution, temporal accumulation, depth-aware upsample.
+        };
+
         struct Physics
         {
             /*
@@ -56,6 +76,13 @@ namespace af3d
             std::uint32_t maxSteps;
             float slowmoFactor;
 
+            /*
+             * Batched ray/sweep queries use up to this many extra threads,
+             * each one gets at least 'queryThreadMinBatch' queries.
+             */
+            std::uint32_t queryThreads;
+            std::uint32_t queryThreadMinBatch;
+
             bool debugWireframe;
             bool debugAabb;
             bool debugContactPoints;
@@ -66,6 +93,20 @@ namespace af3d
             bool debugFrames;
         };
 
+        struct Mesh
+        {
+            /*
+             * Models are re-imported on this many threads, each one has its own importer.
+             */
+            std::uint32_t importThreads;
+
+            /*
+             * Keep CPU-side copy of imported geometry, so that collision shapes and tools
+             * never have to read it back from GPU.
+             */
+            bool keepCPUData;
+        };
+
         struct ImGui
         {
             bool drawCursor;
@@ -77,6 +118,7 @@ namespace af3d
             bool playing;
             bool disableSimulation;
             bool styledJson;
+            bool exactPicking;
             float objMarkerSizeWorld;
             int objMarkerSizePixels;
             Color objMarkerColorInactive;
@@ -109,6 +151,7 @@ namespace af3d
             std::uint32_t numTiles;
             std::uint32_t maxLights;
             std::uint32_t maxLightsPerTile;
+            std::uint32_t maxLightIndices;
             std::uint32_t maxProbes;
             std::uint32_t maxProbesPerTile;
         };
@@ -118,6 +161,20 @@ namespace af3d
             std::uint32_t irradianceResolution;
             std::uint32_t specularResolution;
             std::uint32_t specularMipLevels;
+
+            /*
+             * Irradiance is kept as L2 spherical harmonics in probes SSBO, specular cube mips
+             * are BC6H compressed, both are baked into a single binary '.probe' file instead
+             * of '.hdr' equirects.
+             */
+            bool compact;
+
+            /*
+             * Max number of probes being baked at the same time during recreation, the rest
+             * wait in queue, see 'SceneEnvironment::updateLightProbes'. Each bake spans several
+             * frames, so this is not a per-frame limit.
+             */
+            std::uint32_t maxConcurrentProbeBakes;
         };
 
         struct CSM
@@ -125,6 +182,31 @@ namespace af3d
             std::uint32_t maxCount;
             std::uint32_t numSplits;
             std::uint32_t resolution;
+
+            /*
+             * Split 'i' re-renders every 'updateIntervals[i]' frames, with staggered phases, its
+             * matrix in CSM SSBO is only updated when it does, one entry per split.
+             */
+            std::vector<std::uint32_t> updateIntervals;
+
+            /*
+             * Per-frame shadow cost budget, max split renders of all CSMs in one frame,
+             * near splits go first, the rest are deferred to the next frame. 0 - unlimited.
+             */
+            std::uint32_t maxSplitsPerFrame;
+        };
+
+        struct DynamicResolution
+        {
+            /*
+             * Main camera renders into a sub-rectangle of its targets, scaled to keep
+             * GPU frame time at 'targetFrameMs', TAA reconstructs to output resolution.
+             * Requires TAA, cleared on startup otherwise.
+             */
+            bool enabled;
+            float targetFrameMs;
+            float minScale;
+            float maxScale;
         };
 
         Settings() = default;
@@ -143,24 +225,52 @@ namespace af3d
         float viewAspect;
         std::uint32_t profileReportTimeoutMs;
         std::uint32_t minRenderDt;
+
+        /*
+         * Max frames submitted to GPU, but not yet presented. Render thread waits on
+         * a fence before going over it, lower is less input latency, higher is more
+         * CPU/GPU overlap.
+         */
+        std::uint32_t framesInFlight;
         std::uint32_t maxImmCameras;
         int videoMode;
         int msaaMode;
         bool vsync;
+
+        /*
+         * With vsync on, swap late frames right away instead of waiting for the next
+         * vblank, if swap_control_tear is supported.
+         */
+        bool adaptiveVsync;
         bool fullscreen;
         bool trilinearFilter;
         AAMode aaMode;
-        bool bloom;
-        bool ssao;
+        BloomMode bloom;
+        BloomQuality bloomQuality; // Compute bloom only.
+        SSAOMode ssao;
+
+        /*
+         * Static meshes are culled on GPU and drawn with multi-draw-indirect,
+         * ignored when editor is enabled.
+         */
+        bool gpuDriven;
+
+        /*
+         * Material textures of lit shaders are passed as GL_ARB_bindless_texture
+         * handles instead of texture units, cleared on startup if not supported.
+         */
+        bool bindlessTextures;
         std::uint32_t viewX;
         std::uint32_t viewY;
         std::set<VideoMode> winVideoModes;
         Physics physics;
+        Mesh mesh;
         ImGui imGui;
         Editor editor;
         Cluster cluster;
         LightProbe lightProbe;
         CSM csm;
+        DynamicResolution dynamicResolution;
     };
 
     extern Settings settings;
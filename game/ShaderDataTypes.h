@@ -64,6 +64,7 @@ namespace af3d
         std::uint32_t spherical;
         std::uint32_t enabled = 0;
         float padding;
+        Vector4f sh[9]; // L2 irradiance SH, basis constants folded in, xyz used, compact probes only.
     };
 
     struct ShaderClusterTileData
@@ -80,6 +81,25 @@ namespace af3d
         Matrix4f mat[4];
         std::uint32_t texIdx[4];
     };
+
+    struct ShaderIndirectInstance
+    {
+        Matrix4f model;
+        Matrix4f prevModel;
+        Vector4f aabbMin;
+        Vector4f aabbMax;
+        std::uint32_t flags[4]; // [0] - camera layer mask, 0 when hidden.
+    };
+
+    // Laid out as GL's DrawElementsIndirectCommand.
+    struct ShaderDrawCommand
+    {
+        std::uint32_t count;
+        std::uint32_t instanceCount;
+        std::uint32_t firstIndex;
+        std::int32_t baseVertex;
+        std::uint32_t baseInstance;
+    };
     #pragma pack()
 }
 
@@ -105,5 +105,15 @@ namespace af3d
         renderer.scheduleHwOp([upd](HardwareContext& ctx) {
             upd->ssbo->reload(upd->csms.size(), &upd->csms[0], ctx);
         });
+
+        // Pick splits that render next frame, near splits of all CSMs go first.
+        std::uint32_t budget = (settings.csm.maxSplitsPerFrame > 0) ?
+            settings.csm.maxSplitsPerFrame : (std::numeric_limits<std::uint32_t>::max)();
+        for (int i = 0; i < static_cast<int>(settings.csm.numSplits); ++i) {
+            for (auto csm : csms_) {
+                csm->schedule(frame_, i, budget);
+            }
+        }
+        ++frame_;
     }
 }
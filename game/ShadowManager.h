@@ -56,6 +56,7 @@ namespace af3d
 
         std::unordered_set<ShadowMapCSM*> csms_;
         IndexSet csmFreeIndices_;
+        std::uint32_t frame_ = 0;
     };
 }
 
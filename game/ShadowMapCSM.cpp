@@ -29,6 +29,7 @@
 #include "Const.h"
 #include "CameraRenderer.h"
 #include "Scene.h"
+#include "Settings.h"
 #include "Logger.h"
 
 namespace af3d
@@ -62,80 +63,97 @@ namespace af3d
             (prevViewAspect_ != viewFrustum.aspect()) ||
             (prevViewNearDist_ != viewFrustum.nearDist()) ||
             (prevViewFarDist_ != viewFrustum.farDist())) {
-            LOG4CPLUS_TRACE(logger(), "Updating CSM " << this << " proj params");
-
             prevViewFov_ = viewFrustum.fov();
             prevViewAspect_ = viewFrustum.aspect();
             prevViewNearDist_ = viewFrustum.nearDist();
             prevViewFarDist_ = viewFrustum.farDist();
 
-            float nd = viewFrustum.nearDist();
-            float fd = viewFrustum.farDist();
-
-            float ratio = fd / nd;
-            splits_[0].viewFrustum.setNearDist(nd);
-
-            for (size_t i = 0; i < splits_.size(); ++i) {
-                splits_[i].viewFrustum.setFov(viewFrustum.fov() + btRadians(11.5f));
-                splits_[i].viewFrustum.setAspect(viewFrustum.aspect());
-                if (i > 0) {
-                    float si = i / (float)splits_.size();
-                    float curNear = splitWeight_ * (nd * std::pow(ratio, si)) + (1.0f - splitWeight_) * (nd + (fd - nd) * si);
-                    float curFar = curNear * 1.005f;
-                    splits_[i].viewFrustum.setNearDist(curNear);
-                    splits_[i - 1].viewFrustum.setFarDist(curFar);
-                }
-            }
+            renderAll_ = true;
+        }
 
-            splits_.back().viewFrustum.setFarDist(fd);
+        if (renderAll_) {
+            /*
+             * New split distances are only applied on a frame where all splits render, until then
+             * the old ones are kept, so that far bounds always match what's in the layers.
+             */
+            bool allRender = true;
+            for (const auto& split : splits_) {
+                allRender &= !split.cam->skipFrame();
+            }
+            if (allRender) {
+                updateSplitDistances(viewFrustum);
+                renderAll_ = false;
+            }
         }
 
         auto lightViewXf = lightXf.inverse();
 
-        for (auto& split : splits_) {
-            btVector3 tMax = btVector3_one * -(std::numeric_limits<float>::max)();
-            btVector3 tMin = btVector3_one * (std::numeric_limits<float>::max)();
+        for (size_t i = 0; i < splits_.size(); ++i) {
+            auto& split = splits_[i];
+
+            // Split's far distance in current depth, doesn't depend on what's in the layer.
+            split.farBound = 0.5f * (-split.viewFrustum.farDist() * viewFrustum.projMat()[2][2] + viewFrustum.projMat()[2][3]) /
+                split.viewFrustum.farDist() + 0.5f;
 
             split.viewFrustum.setTransform(viewFrustum.transform());
 
             const auto& corners = split.viewFrustum.corners();
 
-            for (size_t i = 0; i < corners.size(); ++i) {
-                auto viewPt = lightViewXf * corners[i];
-                tMin.setZ(btMin(tMin.z(), viewPt.z()));
-                tMax.setZ(btMax(tMax.z(), viewPt.z()));
-            }
+            /*
+             * Bounding sphere of split corners, so that projection size doesn't depend on view
+             * direction, center is snapped to shadow texels, thus shadow edges don't shimmer
+             * when the view moves or when some frames skip this split.
+             */
 
-            tMax.setZ(tMax.z() + 50.0f);
+            btVector3 center = btVector3_zero;
+            for (const auto& corner : corners) {
+                center += corner;
+            }
+            center /= corners.size();
 
-            split.cam->setTransform(lightXf);
-            split.cam->setAspect(1.0f);
-            split.cam->setOrthoHeight(2.0f);
-            split.cam->setNearDist(-tMax.z());
-            split.cam->setFarDist(-tMin.z());
+            float radius = 0.0f;
+            for (const auto& corner : corners) {
+                radius = btMax(radius, (corner - center).length());
+            }
 
-            const auto& vp = split.cam->frustum().viewProjMat();
+            if (split.cam->skipFrame()) {
+                ++split.age;
+                // The view moved out of what the layer covers, render it next frame.
+                if ((center - split.center).length() + radius > split.coverRadius) {
+                    split.stale = true;
+                }
+                continue;
+            }
 
-            for (const auto& corner : corners) {
-                auto cornerNDC = vp * Vector4f(corner, 1.0f);
-                btAssert(cornerNDC.w() == 1.0f);
+            split.rendered = true;
+            split.stale = false;
+            split.age = 0;
 
-                tMin.setX(btMin(tMin.x(), cornerNDC.x()));
-                tMin.setY(btMin(tMin.y(), cornerNDC.y()));
-                tMax.setX(btMax(tMax.x(), cornerNDC.x()));
-                tMax.setY(btMax(tMax.y(), cornerNDC.y()));
+            // Splits that may skip frames get slack for the view to move in meanwhile.
+            if ((settings.csm.updateIntervals[i] > 1) || (settings.csm.maxSplitsPerFrame > 0)) {
+                radius *= 1.0f + motionMargin_;
             }
+            radius = std::ceil(radius * 16.0f) / 16.0f;
 
-            btVector3 offset((tMin.x() + tMax.x()) * 0.5f, (tMin.y() + tMax.y()) * 0.5f, 0.0f);
+            float texelSize = 2.0f * radius / settings.csm.resolution;
+            auto viewCenter = lightViewXf * center;
+            btVector3 offset(std::floor(viewCenter.x() / texelSize) * texelSize,
+                std::floor(viewCenter.y() / texelSize) * texelSize, 0.0f);
 
-            split.cam->setOrthoHeight(tMax.y() - tMin.y());
-            split.cam->setAspect((tMax.x() - tMin.x()) / split.cam->orthoHeight());
+            // Snapping moves the projection by less than a texel on each axis.
+            split.center = center;
+            split.coverRadius = radius - 2.0f * texelSize;
+
+            float minZ = viewCenter.z() - radius;
+            float maxZ = viewCenter.z() + radius + 50.0f;
+
+            split.cam->setAspect(1.0f);
+            split.cam->setOrthoHeight(2.0f * radius);
+            split.cam->setNearDist(-maxZ);
+            split.cam->setFarDist(-minZ);
             split.cam->setTransform(lightXf * toTransform(offset));
 
             split.mat = biasMat_ * split.cam->frustum().viewProjMat();
-
-            split.farBound = 0.5f * (-split.viewFrustum.farDist() * viewFrustum.projMat()[2][2] + viewFrustum.projMat()[2][3]) /
-                split.viewFrustum.farDist() + 0.5f;
         }
     }
 
@@ -149,6 +167,53 @@ namespace af3d
         }
     }
 
+    void ShadowMapCSM::schedule(std::uint32_t frame, int splitIdx, std::uint32_t& budget)
+    {
+        auto& split = splits_[splitIdx];
+        std::uint32_t interval = settings.csm.updateIntervals[splitIdx];
+
+        // Phase is offset by split and CSM index, so that splits with the same interval take turns,
+        // 'age' catches up splits that missed their turn because of the budget.
+        bool due = !split.rendered || (split.age >= interval) ||
+            (((frame + splitIdx + index_) % interval) == 0);
+
+        // Stale layers and pending split distance changes don't wait for the budget.
+        if (renderAll_ || split.stale) {
+            budget = (budget > 0) ? (budget - 1) : 0;
+            split.cam->setSkipFrame(false);
+        } else if (due && (budget > 0)) {
+            --budget;
+            split.cam->setSkipFrame(false);
+        } else {
+            split.cam->setSkipFrame(true);
+        }
+    }
+
+    void ShadowMapCSM::updateSplitDistances(const Frustum& viewFrustum)
+    {
+        LOG4CPLUS_TRACE(logger(), "Updating CSM " << this << " proj params");
+
+        float nd = viewFrustum.nearDist();
+        float fd = viewFrustum.farDist();
+
+        float ratio = fd / nd;
+        splits_[0].viewFrustum.setNearDist(nd);
+
+        for (size_t i = 0; i < splits_.size(); ++i) {
+            splits_[i].viewFrustum.setFov(viewFrustum.fov() + btRadians(11.5f));
+            splits_[i].viewFrustum.setAspect(viewFrustum.aspect());
+            if (i > 0) {
+                float si = i / (float)splits_.size();
+                float curNear = splitWeight_ * (nd * std::pow(ratio, si)) + (1.0f - splitWeight_) * (nd + (fd - nd) * si);
+                float curFar = curNear * 1.005f;
+                splits_[i].viewFrustum.setNearDist(curNear);
+                splits_[i - 1].viewFrustum.setFarDist(curFar);
+            }
+        }
+
+        splits_.back().viewFrustum.setFarDist(fd);
+    }
+
     void ShadowMapCSM::adopt(ShadowManager* mgr, int index, const CSMRenderTarget& rt)
     {
         btAssert(!mgr_);
@@ -57,10 +57,21 @@ namespace af3d
 
         void remove() override;
 
+        /*
+         * Recomputes splits that render this frame, the rest keep matrices their layers were rendered with
+         * and get marked stale if the view has moved out of what their layers cover.
+         */
         void update(const Frustum& viewFrustum, const btTransform& lightXf);
 
         void setupSSBO(ShaderCSM& sCSM) const;
 
+        /*
+         * Decides if split 'splitIdx' renders next frame according to 'settings.csm.updateIntervals',
+         * takes one from 'budget' if it does. Stale splits and splits waiting for new split distances
+         * render regardless of budget. Called for all splits in order every frame.
+         */
+        void schedule(std::uint32_t frame, int splitIdx, std::uint32_t& budget);
+
         /*
          * Internal, do not call.
          * @{
@@ -84,12 +95,23 @@ namespace af3d
             Frustum viewFrustum;
             Matrix4f mat;
             float farBound = 0.0f;
+            bool rendered = false;
+            bool stale = false;
+            std::uint32_t age = 0; // Updates since last render.
+            // Bounding sphere of split corners that the layer is guaranteed to cover.
+            btVector3 center = btVector3_zero;
+            float coverRadius = 0.0f;
         };
 
         using Splits = std::vector<Split>;
 
+        void updateSplitDistances(const Frustum& viewFrustum);
+
         const float splitWeight_ = 0.75f;
 
+        // Split radius padding, relative, for splits that don't render every frame.
+        const float motionMargin_ = 0.1f;
+
         Matrix4f biasMat_;
 
         ShadowManager* mgr_ = nullptr;
@@ -101,6 +123,9 @@ namespace af3d
         float prevViewAspect_ = 0.0f;
         float prevViewNearDist_ = 0.0f;
         float prevViewFarDist_ = 0.0f;
+
+        // Split distances changed, re-render everything and apply them once all splits render.
+        bool renderAll_ = false;
     };
 
     using ShadowMapCSMPtr = std::shared_ptr<ShadowMapCSM>;
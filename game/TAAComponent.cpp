@@ -60,6 +60,7 @@ namespace af3d
             TextureBinding(depthTexture,
                 SamplerParams(GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR)));
         taaFilter_->camera()->setOrder(camOrder);
+        taaFilter_->material()->params().setUniform(UniformName::ArgRenderScale, 1.0f);
 
         for (int i = 1; i <= 16; ++i) {
             jitters_.emplace_back((haltonNumber(2, i) - 0.5f) * 2.0f, (haltonNumber(3, i) - 0.5f) * 2.0f);
@@ -93,7 +94,10 @@ namespace af3d
 
         updateTextureBindings(prevTex_, outTex_);
 
-        Vector2f jitter = jitters_[jitterIdx_++] * 0.9f / Vector2f(prevTex_->width(), prevTex_->height());
+        // Sub-pixel offsets are in input pixels, i.e. in the source camera's dynamic resolution.
+        float renderScale = srcCamera_->renderScale();
+
+        Vector2f jitter = jitters_[jitterIdx_++] * 0.9f / (Vector2f(prevTex_->width(), prevTex_->height()) * renderScale);
         jitterIdx_ = jitterIdx_ % jitters_.size();
 
         srcCamera_->setJitter(jitter);
@@ -157,6 +161,7 @@ namespace af3d
         taaFilter_->material()->params().setUniform(UniformName::SampleWeights, sampleWeights_, true);
         taaFilter_->material()->params().setUniform(UniformName::LowpassWeights, lowpassWeights_, true);
         taaFilter_->material()->params().setUniform(UniformName::PlusWeights, plusWeights_);
+        taaFilter_->material()->params().setUniform(UniformName::ArgRenderScale, renderScale);
 
         std::swap(prevTex_, outTex_);
     }
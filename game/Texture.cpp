@@ -107,6 +107,46 @@ namespace af3d
             GLint level_;
             GLint layer_;
         };
+
+        class TextureCompressedUpdater : public ResourceLoader
+        {
+        public:
+            TextureCompressedUpdater(GLint internalFormat,
+                std::vector<Byte>&& pixels,
+                GLint level,
+                GLint layer)
+            : internalFormat_(internalFormat),
+              pixels_(std::move(pixels)),
+              level_(level),
+              layer_(layer)
+            {
+            }
+
+            void load(Resource& res, HardwareContext& ctx) override
+            {
+                Texture& texture = static_cast<Texture&>(res);
+
+                LOG4CPLUS_DEBUG(logger(), "textureManager: updating compressed " << texture.width() << "x" << texture.height() << "x" << texture.depth()
+                    << ", level = " << level_ << ", layer = " << layer_);
+
+                auto width = textureMipSize(texture.width(), level_);
+                auto height = textureMipSize(texture.height(), level_);
+                auto faceSize = HardwareTexture::compressedSize(internalFormat_, width, height);
+
+                btAssert(pixels_.size() == static_cast<size_t>(faceSize * (TextureCubeFaceMax + 1)));
+
+                texture.hwTex()->updateCompressed(internalFormat_,
+                    reinterpret_cast<const GLvoid*>(&pixels_[0]), pixels_.size(), level_, layer_, ctx);
+
+                pixels_.clear();
+            }
+
+        private:
+            GLint internalFormat_;
+            std::vector<Byte> pixels_;
+            GLint level_;
+            GLint layer_;
+        };
     }
 
     Texture::Texture(TextureManager* mgr, const std::string& name,
@@ -143,6 +183,11 @@ namespace af3d
         load(std::make_shared<TextureUpdater>(format, type, std::move(pixels), level, layer));
     }
 
+    void Texture::updateCompressed(GLint internalFormat, std::vector<Byte>&& data, GLint level, GLint layer)
+    {
+        load(std::make_shared<TextureCompressedUpdater>(internalFormat, std::move(data), level, layer));
+    }
+
     void Texture::download(GLenum format, GLenum type, std::vector<Byte>& pixels)
     {
         auto tex = hwTex_;
@@ -64,6 +64,9 @@ namespace af3d
 
         void update(GLenum format, GLenum type, std::vector<Byte>&& pixels, GLint level, GLint layer);
 
+        // Updates all faces of a cube map array layer with pre-compressed 'data'.
+        void updateCompressed(GLint internalFormat, std::vector<Byte>&& data, GLint level, GLint layer);
+
         void download(GLenum format, GLenum type, std::vector<Byte>& pixels);
 
         void download(GLenum format, GLenum type, Byte* pixels);
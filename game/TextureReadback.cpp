@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "TextureReadback.h"
+#include "HardwareResourceManager.h"
+#include "HardwareContext.h"
+#include "Renderer.h"
+
+namespace af3d
+{
+    namespace
+    {
+        GLsizeiptr pixelSize(GLenum format, GLenum type)
+        {
+            GLsizeiptr numComponents;
+            switch (format) {
+            case GL_RED: numComponents = 1; break;
+            case GL_RG: numComponents = 2; break;
+            case GL_RGB: numComponents = 3; break;
+            default:
+                btAssert(format == GL_RGBA);
+                numComponents = 4;
+                break;
+            }
+            switch (type) {
+            case GL_UNSIGNED_BYTE: return numComponents;
+            case GL_HALF_FLOAT: return numComponents * 2;
+            default:
+                btAssert(type == GL_FLOAT);
+                return numComponents * sizeof(float);
+            }
+        }
+    }
+
+    TextureReadback::TextureReadback(const StatePtr& state)
+    : state_(state)
+    {
+    }
+
+    TextureReadback::~TextureReadback()
+    {
+        if (state_->done) {
+            return;
+        }
+
+        auto st = state_;
+        renderer.scheduleHwOp([st](HardwareContext& ctx) {
+            if (st->fence && (st->pbo->id(ctx) != 0)) {
+                ogl.DeleteSync(st->fence);
+            }
+            st->fence = nullptr;
+        });
+    }
+
+    TextureReadbackPtr TextureReadback::texture2D(const TexturePtr& tex, GLenum format, GLenum type)
+    {
+        auto st = std::make_shared<State>();
+        st->tex = tex->hwTex();
+        st->format = format;
+        st->type = type;
+        st->width = tex->width();
+        st->height = tex->height();
+        return start(st);
+    }
+
+    TextureReadbackPtr TextureReadback::cube(const TexturePtr& tex, GLenum format, GLenum type, GLint level)
+    {
+        auto st = std::make_shared<State>();
+        st->tex = tex->hwTex();
+        st->format = format;
+        st->type = type;
+        st->level = level;
+        st->width = textureMipSize(tex->width(), level);
+        st->height = textureMipSize(tex->height(), level);
+        st->numFaces = TextureCubeFaceMax + 1;
+        return start(st);
+    }
+
+    bool TextureReadback::ready()
+    {
+        if (state_->done) {
+            return true;
+        }
+
+        // Poll once more on render thread, harmless if one is already queued.
+        auto st = state_;
+        renderer.scheduleHwOp([st](HardwareContext& ctx) {
+            poll(*st, ctx);
+        });
+
+        return false;
+    }
+
+    TextureReadbackPtr TextureReadback::start(const StatePtr& state)
+    {
+        state->faceSize = pixelSize(state->format, state->type) * state->width * state->height;
+        state->pbo = hwManager.createDataBuffer(HardwareBuffer::Usage::DynamicRead, 1);
+
+        auto st = state;
+        renderer.scheduleHwOp([st](HardwareContext& ctx) {
+            st->pbo->resize(st->faceSize * st->numFaces, ctx);
+            ogl.BindBuffer(GL_PIXEL_PACK_BUFFER, st->pbo->id(ctx));
+            if (st->tex->type() == TextureType2D) {
+                st->tex->download(st->format, st->type, nullptr, ctx);
+            } else {
+                for (int i = 0; i < st->numFaces; ++i) {
+                    st->tex->downloadCubeFace(static_cast<TextureCubeFace>(i), st->format, st->type,
+                        reinterpret_cast<GLvoid*>(i * st->faceSize), st->level, ctx);
+                }
+            }
+            ogl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            st->fence = ogl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        });
+
+        return TextureReadbackPtr(new TextureReadback(state));
+    }
+
+    void TextureReadback::poll(State& state, HardwareContext& ctx)
+    {
+        if (state.done) {
+            return;
+        }
+
+        if (!state.fence || (state.pbo->id(ctx) == 0)) {
+            // Start op was dropped or context was lost, fence went away with it.
+            state.fence = nullptr;
+            state.data.clear();
+            state.done = true;
+            return;
+        }
+
+        GLenum res = ogl.ClientWaitSync(state.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if ((res != GL_ALREADY_SIGNALED) && (res != GL_CONDITION_SATISFIED)) {
+            return;
+        }
+
+        ogl.DeleteSync(state.fence);
+        state.fence = nullptr;
+
+        auto ptr = static_cast<const Byte*>(state.pbo->lock(HardwareBuffer::ReadOnly, ctx));
+        state.data.assign(ptr, ptr + state.faceSize * state.numFaces);
+        state.pbo->unlock(ctx);
+
+        state.done = true;
+    }
+}
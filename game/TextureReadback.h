@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _TEXTURE_READBACK_H_
+#define _TEXTURE_READBACK_H_
+
+#include "Texture.h"
+#include "HardwareDataBuffer.h"
+
+namespace af3d
+{
+    class TextureReadback;
+    using TextureReadbackPtr = std::shared_ptr<TextureReadback>;
+
+    /*
+     * Reads texture contents back into a PBO and fences it, main thread
+     * polls with 'ready()' and never waits on render thread.
+     */
+    class TextureReadback : boost::noncopyable
+    {
+    public:
+        ~TextureReadback();
+
+        // Level 0 of a 2D texture.
+        static TextureReadbackPtr texture2D(const TexturePtr& tex, GLenum format, GLenum type);
+
+        // All faces of a cube map level, one after another.
+        static TextureReadbackPtr cube(const TexturePtr& tex, GLenum format, GLenum type, GLint level);
+
+        inline std::uint32_t width() const { return state_->width; }
+        inline std::uint32_t height() const { return state_->height; }
+
+        bool ready();
+
+        // Valid once 'ready()' returns true, empty if context was lost meanwhile.
+        inline std::vector<Byte>& data() { return state_->data; }
+
+    private:
+        struct State
+        {
+            HardwareTexturePtr tex;
+            GLenum format = 0;
+            GLenum type = 0;
+            GLint level = 0;
+            std::uint32_t width = 0;
+            std::uint32_t height = 0;
+            int numFaces = 1;
+            GLsizeiptr faceSize = 0;
+            HardwareDataBufferPtr pbo;
+            GLsync fence = nullptr;
+            std::vector<Byte> data;
+            std::atomic<bool> done{false};
+        };
+
+        using StatePtr = std::shared_ptr<State>;
+
+        explicit TextureReadback(const StatePtr& state);
+
+        static TextureReadbackPtr start(const StatePtr& state);
+
+        static void poll(State& state, HardwareContext& ctx);
+
+        StatePtr state_;
+    };
+}
+
+#endif
@@ -28,9 +28,19 @@
 
 #include "VertexArrayLayout.h"
 #include "HardwareVertexArray.h"
+#include "af3d/Vector3.h"
 
 namespace af3d
 {
+    // CPU-side copy of vertex positions and indices, indices are the same as in EBO.
+    struct VertexArrayData
+    {
+        std::shared_ptr<const std::vector<Vector3f>> positions;
+        std::vector<std::uint32_t> indices;
+    };
+
+    using VertexArrayDataPtr = std::shared_ptr<const VertexArrayData>;
+
     class VertexArray : boost::noncopyable
     {
     public:
@@ -48,6 +58,10 @@ namespace af3d
 
         inline const HardwareIndexBufferPtr& ebo() const { return ebo_; }
 
+        // Optional, set by loaders that want to avoid GPU readback of geometry.
+        inline const VertexArrayDataPtr& data() const { return data_; }
+        inline void setData(const VertexArrayDataPtr& value) { data_ = value; }
+
     private:
         // This one is populated and owned by the rendering thread!
         // VAOs cannot be shared between contexts, so only rendering thread
@@ -57,6 +71,7 @@ namespace af3d
         VertexArrayLayout layout_;
         VBOList vbos_;
         HardwareIndexBufferPtr ebo_;
+        VertexArrayDataPtr data_;
     };
 
     using VertexArrayPtr = std::shared_ptr<VertexArray>;
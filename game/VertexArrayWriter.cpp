@@ -30,8 +30,11 @@
 namespace af3d
 {
     VertexArrayWriter::VertexArrayWriter()
-    : data_(std::make_shared<Data>())
     {
+        for (auto& data : data_) {
+            data = std::make_shared<Data>();
+        }
+
         VertexArrayLayout vaLayout;
 
         vaLayout.addEntry(VertexArrayEntry(VertexAttribName::Pos, GL_FLOAT_VEC3, 0, 0));
@@ -49,7 +52,8 @@ namespace af3d
     void VertexArrayWriter::upload()
     {
         auto va = va_;
-        auto data = data_;
+        auto data = data_[dataIdx_];
+        data->inFlight = true;
         renderer.scheduleHwOp([va, data](HardwareContext& ctx) {
             if (!data->vertices.empty()) {
                 va->vbos()[0]->reload(data->vertices.size(), &data->vertices[0], ctx);
@@ -57,7 +61,18 @@ namespace af3d
             if (!data->indices.empty()) {
                 va->ebo()->reload(data->indices.size(), &data->indices[0], ctx);
             }
+            data->inFlight = false;
         });
-        data_ = std::make_shared<Data>();
+
+        dataIdx_ = (dataIdx_ + 1) % numBuffers;
+        auto& next = data_[dataIdx_];
+        if (next->inFlight) {
+            // Called more than once per frame or the op was dropped, leave that buffer to the op.
+            next = std::make_shared<Data>();
+        } else {
+            // Keeps capacity.
+            next->vertices.clear();
+            next->indices.clear();
+        }
     }
 }
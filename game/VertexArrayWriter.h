@@ -30,6 +30,8 @@
 #include "af3d/Vector2.h"
 #include "af3d/Vector3.h"
 #include "af3d/Vector4.h"
+#include <array>
+#include <atomic>
 
 namespace af3d
 {
@@ -78,6 +80,7 @@ namespace af3d
         {
             std::vector<VertexImm> vertices;
             std::vector<std::uint16_t> indices;
+            std::atomic<bool> inFlight{false}; // Upload op is queued on render thread.
         };
 
         VertexArrayWriter();
@@ -85,14 +88,22 @@ namespace af3d
 
         inline const VertexArrayPtr& va() const { return va_; }
         inline const VertexArrayPtr& vaNoEbo() const { return vaNoEbo_; }
-        inline Data& data() { return *data_; }
+        inline Data& data() { return *data_[dataIdx_]; }
 
+        // Call at most once per frame, buffers are recycled, so there's no allocation in steady state.
         void upload();
 
     private:
+        /*
+         * 'Renderer::swap' only waits for the frame before the previous one, so the buffer
+         * uploaded last frame may still be queued, the one before it is done.
+         */
+        static const int numBuffers = 3;
+
         VertexArrayPtr va_;
         VertexArrayPtr vaNoEbo_;
-        std::shared_ptr<Data> data_;
+        std::array<std::shared_ptr<Data>, numBuffers> data_;
+        int dataIdx_ = 0;
     };
 }
 
@@ -1,9 +1,15 @@
 //#define BLINN
-uniform sampler2D texMain;
+#ifdef BINDLESS
+// Material textures are set with bindless handles, see MaterialManager::renderReload.
+#define MATERIAL_SAMPLER layout(bindless_sampler) uniform
+#else
+#define MATERIAL_SAMPLER uniform
+#endif
+MATERIAL_SAMPLER sampler2D texMain;
 #ifdef NM
-uniform sampler2D texNormal;
+MATERIAL_SAMPLER sampler2D texNormal;
 #endif
-uniform sampler2D texSpecular;
+MATERIAL_SAMPLER sampler2D texSpecular;
 uniform sampler2DArray texShadowCSM;
 
 uniform vec4 mainColor;
@@ -77,25 +83,31 @@ layout (location = 2) out vec4 fragAmbient;
 
 float processCSMShadow(const CSM csm)
 {
-    int idx = CSM_NUM_SPLITS - 1;
-    for (int i = 0; i < CSM_NUM_SPLITS - 1; ++i) {
-        if (gl_FragCoord.z < csm.farBounds[i]) {
-            idx = i;
-            break;
+    // Pick split by depth, but fall through to the next one if the fragment is outside of
+    // the split's map, maps of splits that skipped frames may lag behind the view.
+    for (int i = 0; i < CSM_NUM_SPLITS; ++i) {
+        if ((i < CSM_NUM_SPLITS - 1) && (gl_FragCoord.z >= csm.farBounds[i])) {
+            continue;
         }
-    }
 
-    vec4 shadowPos = vec4(v_pos, 1.0) * csm.mat[idx];
+        vec4 shadowPos = vec4(v_pos, 1.0) * csm.mat[i];
 
-    shadowPos.w = shadowPos.z;
-    shadowPos.z = float(csm.texIdx[idx]);
+        if (any(lessThan(shadowPos.xyz, vec3(0.0))) || any(greaterThan(shadowPos.xyz, vec3(1.0)))) {
+            continue;
+        }
 
-    float shadowD = texture(texShadowCSM, shadowPos.xyz).x;
+        shadowPos.w = shadowPos.z;
+        shadowPos.z = float(csm.texIdx[i]);
 
-    // Get the difference of the stored depth and the distance of this fragment to the light.
-    float diff = shadowD - shadowPos.w;
+        float shadowD = texture(texShadowCSM, shadowPos.xyz).x;
+
+        // Get the difference of the stored depth and the distance of this fragment to the light.
+        float diff = shadowD - shadowPos.w;
+
+        return clamp(diff * 250.0 + 1.0, 0.0, 1.0);
+    }
 
-    return clamp(diff * 250.0 + 1.0, 0.0, 1.0);
+    return 1.0;
 }
 
 float linearDepth(float depthRange)
@@ -7,8 +7,27 @@ layout(location = 4) in vec3 tangent;
 layout(location = 5) in vec3 bitangent;
 #endif
 
-uniform mat4 viewProj;
+#ifdef INDIRECT
+layout(location = 6) in uint instanceIdx;
+
+struct IndirectInstance
+{
+    mat4 model;
+    mat4 prevModel;
+    vec4 aabbMin;
+    vec4 aabbMax;
+    uvec4 flags;
+};
+
+layout (std430, binding = 10) readonly buffer indirectInstancesSSBO
+{
+    IndirectInstance indirectInstances[];
+};
+#else
 uniform mat4 model;
+#endif
+
+uniform mat4 viewProj;
 
 out vec2 v_texCoord;
 out vec3 v_pos;
@@ -22,6 +41,9 @@ out vec4 v_clipPos;
 
 void main()
 {
+#ifdef INDIRECT
+    mat4 model = indirectInstances[instanceIdx].model;
+#endif
     v_texCoord = texCoord;
     v_pos = (vec4(pos, 1.0) * model).xyz;
 #ifdef NM
@@ -1,6 +1,8 @@
 uniform sampler2D texMain;
 uniform sampler2D texSpecular;
 uniform sampler2D texAO;
+// Dynamic resolution, only this much of the inputs is rendered to.
+uniform float renderScale;
 
 in vec2 v_texCoord;
 
@@ -8,5 +10,7 @@ out vec4 fragColor;
 
 void main()
 {
-    fragColor = vec4(texture(texMain, v_texCoord).rgb * texture(texAO, v_texCoord).r + texture(texSpecular, v_texCoord).rgb, 1.0);
+    vec2 uv = v_texCoord * renderScale;
+
+    fragColor = vec4(texture(texMain, uv).rgb * texture(texAO, uv).r + texture(texSpecular, uv).rgb, 1.0);
 }
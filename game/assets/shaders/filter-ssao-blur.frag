@@ -5,6 +5,8 @@ uniform float kernelOffset[5];
 uniform int kernelSize;
 uniform int kernelDir;
 uniform vec2 argNearFar;
+// Dynamic resolution, only this much of the inputs is rendered to.
+uniform float renderScale;
 
 in vec2 v_texCoord;
 
@@ -22,15 +24,19 @@ void main()
     int kSize = (kernelSize - 1) / 2;
     int rSize = (kSize / 2) + 1;
 
-    float centerZ = linearDepth(texture(texDepth, v_texCoord).r);
+    vec2 uv = v_texCoord * renderScale;
+    // Don't pick up stale texels outside of the rendered area.
+    vec2 uvMax = vec2(renderScale) - 0.5 / texSize;
+
+    float centerZ = linearDepth(texture(texDepth, uv).r);
 
     float weightSum = kernel[0];
-    float tmp = weightSum * texture(texMain, v_texCoord).r;
+    float tmp = weightSum * texture(texMain, uv).r;
 
     if (kernelDir == 0) {
         for (int i = 1; i < rSize; ++i) {
-            vec2 c1 = v_texCoord + vec2(0.0, kernelOffset[i]) / texSize;
-            vec2 c2 = v_texCoord - vec2(0.0, kernelOffset[i]) / texSize;
+            vec2 c1 = min(uv + vec2(0.0, kernelOffset[i]) / texSize, uvMax);
+            vec2 c2 = min(uv - vec2(0.0, kernelOffset[i]) / texSize, uvMax);
 
             float z1 = linearDepth(texture(texDepth, c1).r);
             float z2 = linearDepth(texture(texDepth, c2).r);
@@ -45,8 +51,8 @@ void main()
         }
     } else {
         for (int i = 1; i < rSize; ++i) {
-            vec2 c1 = v_texCoord + vec2(kernelOffset[i], 0.0) / texSize;
-            vec2 c2 = v_texCoord - vec2(kernelOffset[i], 0.0) / texSize;
+            vec2 c1 = min(uv + vec2(kernelOffset[i], 0.0) / texSize, uvMax);
+            vec2 c2 = min(uv - vec2(kernelOffset[i], 0.0) / texSize, uvMax);
 
             float z1 = linearDepth(texture(texDepth, c1).r);
             float z2 = linearDepth(texture(texDepth, c2).r);
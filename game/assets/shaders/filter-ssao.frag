@@ -8,6 +8,8 @@ uniform int kernelSize;
 uniform float radius;
 uniform mat4 argViewProj;
 uniform vec2 argNearFar;
+// Dynamic resolution, only this much of the inputs is rendered to.
+uniform float renderScale;
 
 mat4 invArgViewProj;
 
@@ -26,13 +28,15 @@ void main()
     invArgViewProj = inverse(argViewProj);
 
     // Early out if there is no data in the normal buffer at this particular sample
-    vec3 normal = texture(texNormal, v_texCoord).xyz;
+    vec2 uv = v_texCoord * renderScale;
+
+    vec3 normal = texture(texNormal, uv).xyz;
     if (normal == vec3(0.0)) {
         fragColor = 1.0;
         return;
     }
 
-    float fragDepth = texture(texDepth, v_texCoord).r;
+    float fragDepth = texture(texDepth, uv).r;
     float fragPosZ = linearDepth(fragDepth);
     vec4 fragPos = vec4(2.0 * v_texCoord - 1.0, 2.0 * fragDepth - 1.0, 1.0) * invArgViewProj;
     fragPos /= fragPos.w;
@@ -57,7 +61,7 @@ void main()
         sampleScreenSpace.xyz = (sampleScreenSpace.xyz * 0.5) + 0.5; // [-1, 1] -> [0, 1]
 
         // get sample depth
-        float sampleDepth = linearDepth(texture(texDepth, sampleScreenSpace.xy).r);
+        float sampleDepth = linearDepth(texture(texDepth, clamp(sampleScreenSpace.xy, 0.0, 1.0) * renderScale).r);
         float sampleZ = linearDepth(sampleScreenSpace.z);
 
         // range check & accumulate
@@ -11,6 +11,8 @@ uniform sampler2D texDepth;
 uniform mat4 argViewProj;
 uniform mat4 argPrevViewProj;
 uniform vec2 viewportSize;
+// Current frame inputs only cover this much of their textures with dynamic resolution.
+uniform float argRenderScale;
 
 in vec2 v_texCoord;
 
@@ -370,20 +372,22 @@ void main()
     float InExposureScale = 1.0;
 
     vec2 UV = v_texCoord;
+    vec2 InputUV = UV * argRenderScale;
 
     vec4 ViewportSize = vec4(viewportSize.x, viewportSize.y, 1.0 / viewportSize.x, 1.0 / viewportSize.y);
     vec4 ScreenPosToPixel = vec4(viewportSize.x * 0.5, viewportSize.y * 0.5, viewportSize.x * 0.5 - 0.5, viewportSize.y * 0.5 - 0.5);
     vec2 texMainSize = vec2(textureSize(texMain, 0));
     vec4 PostprocessInput0Size = vec4(texMainSize.x, texMainSize.y, 1.0 / texMainSize.x, 1.0 / texMainSize.y);
-    vec4 PostprocessInput1Size = PostprocessInput0Size;
+    vec2 texPrevSize = vec2(textureSize(texPrev, 0));
+    vec4 PostprocessInput1Size = vec4(texPrevSize.x, texPrevSize.y, 1.0 / texPrevSize.x, 1.0 / texPrevSize.y);
 
-    vec2 ScreenPos = ( UV * PostprocessInput0Size.xy - 0.5 - ScreenPosToPixel.zw ) / ScreenPosToPixel.xy;
+    vec2 ScreenPos = ( UV * ViewportSize.xy - 0.5 - ScreenPosToPixel.zw ) / ScreenPosToPixel.xy;
 
     // FIND MOTION OF PIXEL AND NEAREST IN NEIGHBORHOOD
     // ------------------------------------------------
     vec3 PosN; // Position of this pixel, possibly later nearest pixel in neighborhood.
     PosN.xy = ScreenPos;
-    PosN.z = texture(texDepth, UV).r;
+    PosN.z = texture(texDepth, InputUV).r;
     // Screen position of minimum depth.
     vec2 VelocityOffset = vec2(0.0, 0.0);
     #if AA_CROSS
@@ -392,10 +396,10 @@ void main()
         // Larger 2 pixel distance "x" works best (because AA dilates surface).
         vec4 Depths;
         // (1.0 - x) - because UE4 uses inverted depth buffer, we still use normal depth buffer.
-        Depths.x = 1.0 - textureLodOffset(texDepth, UV, 0, ivec2(-AA_CROSS, -AA_CROSS)).r;
-        Depths.y = 1.0 - textureLodOffset(texDepth, UV, 0, ivec2( AA_CROSS, -AA_CROSS)).r;
-        Depths.z = 1.0 - textureLodOffset(texDepth, UV, 0, ivec2(-AA_CROSS,  AA_CROSS)).r;
-        Depths.w = 1.0 - textureLodOffset(texDepth, UV, 0, ivec2( AA_CROSS,  AA_CROSS)).r;
+        Depths.x = 1.0 - textureLodOffset(texDepth, InputUV, 0, ivec2(-AA_CROSS, -AA_CROSS)).r;
+        Depths.y = 1.0 - textureLodOffset(texDepth, InputUV, 0, ivec2( AA_CROSS, -AA_CROSS)).r;
+        Depths.z = 1.0 - textureLodOffset(texDepth, InputUV, 0, ivec2(-AA_CROSS,  AA_CROSS)).r;
+        Depths.w = 1.0 - textureLodOffset(texDepth, InputUV, 0, ivec2( AA_CROSS,  AA_CROSS)).r;
 
         vec2 DepthOffset = vec2(AA_CROSS, AA_CROSS);
         float DepthOffsetXx = float(AA_CROSS);
@@ -429,21 +433,21 @@ void main()
         }
     #endif  // AA_CROSS
 
-    vec2 AN = (PosN.xy * ScreenPosToPixel.xy + ScreenPosToPixel.zw + 0.5) * PostprocessInput0Size.zw;
+    vec2 AN = (PosN.xy * ScreenPosToPixel.xy + ScreenPosToPixel.zw + 0.5) * ViewportSize.zw;
     vec4 WSP = vec4(AN * 2.f - 1.f, PosN.z * 2.0 - 1.0, 1.f) * inverse(argViewProj);
     WSP /= WSP.w;
     vec4 CVVPosHISTORY = WSP * argPrevViewProj;
     vec2 UVHISTORY = 0.5 * (CVVPosHISTORY.xy / CVVPosHISTORY.w) + 0.5;
-    vec2 PrevScreen = ( UVHISTORY * PostprocessInput0Size.xy - 0.5 - ScreenPosToPixel.zw ) / ScreenPosToPixel.xy;
+    vec2 PrevScreen = ( UVHISTORY * ViewportSize.xy - 0.5 - ScreenPosToPixel.zw ) / ScreenPosToPixel.xy;
     vec2 BackN = PosN.xy - PrevScreen;
 
     vec2 BackTemp = BackN * ViewportSize.xy;
     #if AA_DYNAMIC
         vec2 VelocityN;
         #if AA_CROSS
-            VelocityN = texture(texNoise, UV + VelocityOffset).xy;
+            VelocityN = texture(texNoise, InputUV + VelocityOffset).xy;
         #else
-            VelocityN = texture(texNoise, UV).xy;
+            VelocityN = texture(texNoise, InputUV).xy;
         #endif
         bool DynamicN = VelocityN.x < 60000.0;
         if(DynamicN)
@@ -471,7 +475,7 @@ void main()
     // Convert from [-1 to 1] to view rectangle which is somewhere in [0 to 1].
     // The extra +0.5 factor is because ScreenPosToPixel.zw is incorrectly computed
     // as the upper left of the pixel instead of the center of the pixel.
-    BackN = (BackN * ScreenPosToPixel.xy + ScreenPosToPixel.zw + 0.5) * PostprocessInput0Size.zw;
+    BackN = (BackN * ScreenPosToPixel.xy + ScreenPosToPixel.zw + 0.5) * PostprocessInput1Size.zw;
 
 
 
@@ -482,11 +486,11 @@ void main()
     // 678
     #if AA_YCOCG
         // Special case, only using 5 taps.
-        vec4 Neighbor1 = textureLodOffset(texMain, UV, 0.0, ivec2(0, -1));
-        vec4 Neighbor3 = textureLodOffset(texMain, UV, 0, ivec2(-1,  0));
-        vec4 Neighbor4 = texture(texMain, UV);
-        vec4 Neighbor5 = textureLodOffset(texMain, UV, 0, ivec2( 1,  0));
-        vec4 Neighbor7 = textureLodOffset(texMain, UV, 0, ivec2( 0,  1));
+        vec4 Neighbor1 = textureLodOffset(texMain, InputUV, 0.0, ivec2(0, -1));
+        vec4 Neighbor3 = textureLodOffset(texMain, InputUV, 0, ivec2(-1,  0));
+        vec4 Neighbor4 = texture(texMain, InputUV);
+        vec4 Neighbor5 = textureLodOffset(texMain, InputUV, 0, ivec2( 1,  0));
+        vec4 Neighbor7 = textureLodOffset(texMain, InputUV, 0, ivec2( 0,  1));
         Neighbor1.rgb = RGBToYCoCg(Neighbor1.rgb);
         Neighbor3.rgb = RGBToYCoCg(Neighbor3.rgb);
         Neighbor4.rgb = RGBToYCoCg(Neighbor4.rgb);
@@ -1,16 +1,24 @@
-uniform sampler2D texMain;
+#ifdef BINDLESS
+// Material textures are set with bindless handles, see MaterialManager::renderReload.
+#define MATERIAL_SAMPLER layout(bindless_sampler) uniform
+#else
+#define MATERIAL_SAMPLER uniform
+#endif
+MATERIAL_SAMPLER sampler2D texMain;
 #ifdef NM
-uniform sampler2D texNormal;
+MATERIAL_SAMPLER sampler2D texNormal;
 #endif
 #ifdef FAST
-uniform sampler2D texSpecular;
+MATERIAL_SAMPLER sampler2D texSpecular;
 #else
-uniform sampler2D texRoughness;
-uniform sampler2D texMetalness;
-uniform sampler2D texAO;
+MATERIAL_SAMPLER sampler2D texRoughness;
+MATERIAL_SAMPLER sampler2D texMetalness;
+MATERIAL_SAMPLER sampler2D texAO;
 #endif
-uniform sampler2D texEmissive;
+MATERIAL_SAMPLER sampler2D texEmissive;
+#ifndef PROBE_SH
 uniform samplerCubeArray texIrradiance;
+#endif
 uniform samplerCubeArray texSpecularCM;
 uniform sampler2D texSpecularLUT;
 uniform sampler2DArray texShadowCSM;
@@ -45,6 +53,7 @@ struct ClusterProbe
     uint spherical;
     uint enabled;
     float padding;
+    vec4 sh[9];
 };
 
 struct ClusterTileData
@@ -142,6 +151,26 @@ vec3 fresnelSchlick(vec3 F0, float cosTheta)
     return F0 + (vec3(1.0) - F0) * pow(1.0 - cosTheta + Epsilon, 5.0);
 }
 
+// Diffuse irradiance of a probe at normal direction.
+vec3 probeIrradiance(uint probeIndex, float layer, vec3 N)
+{
+#ifdef PROBE_SH
+    // L2 spherical harmonics with basis constants folded in, see LightProbeComponent::projectSH.
+    vec3 irradiance = clusterProbes[probeIndex].sh[0].xyz +
+        clusterProbes[probeIndex].sh[1].xyz * N.y +
+        clusterProbes[probeIndex].sh[2].xyz * N.z +
+        clusterProbes[probeIndex].sh[3].xyz * N.x +
+        clusterProbes[probeIndex].sh[4].xyz * (N.x * N.y) +
+        clusterProbes[probeIndex].sh[5].xyz * (N.y * N.z) +
+        clusterProbes[probeIndex].sh[6].xyz * (3.0 * N.z * N.z - 1.0) +
+        clusterProbes[probeIndex].sh[7].xyz * (N.x * N.z) +
+        clusterProbes[probeIndex].sh[8].xyz * (N.x * N.x - N.y * N.y);
+    return max(irradiance, vec3(0.0));
+#else
+    return texture(texIrradiance, vec4(N, layer)).rgb;
+#endif
+}
+
 const float blendPower = 12.0;
 
 // See: https://seblagarde.wordpress.com/2012/09/29/image-based-lighting-approaches-and-parallax-corrected-cubemap/
@@ -187,25 +216,31 @@ float linearDepth(float depthRange)
 
 float processCSMShadow(const CSM csm)
 {
-    int idx = CSM_NUM_SPLITS - 1;
-    for (int i = 0; i < CSM_NUM_SPLITS - 1; ++i) {
-        if (gl_FragCoord.z < csm.farBounds[i]) {
-            idx = i;
-            break;
+    // Pick split by depth, but fall through to the next one if the fragment is outside of
+    // the split's map, maps of splits that skipped frames may lag behind the view.
+    for (int i = 0; i < CSM_NUM_SPLITS; ++i) {
+        if ((i < CSM_NUM_SPLITS - 1) && (gl_FragCoord.z >= csm.farBounds[i])) {
+            continue;
         }
-    }
 
-    vec4 shadowPos = vec4(v_pos, 1.0) * csm.mat[idx];
+        vec4 shadowPos = vec4(v_pos, 1.0) * csm.mat[i];
+
+        if (any(lessThan(shadowPos.xyz, vec3(0.0))) || any(greaterThan(shadowPos.xyz, vec3(1.0)))) {
+            continue;
+        }
+
+        shadowPos.w = shadowPos.z;
+        shadowPos.z = float(csm.texIdx[i]);
 
-    shadowPos.w = shadowPos.z;
-    shadowPos.z = float(csm.texIdx[idx]);
+        float shadowD = texture(texShadowCSM, shadowPos.xyz).x;
 
-    float shadowD = texture(texShadowCSM, shadowPos.xyz).x;
+        // Get the difference of the stored depth and the distance of this fragment to the light.
+        float diff = shadowD - shadowPos.w;
 
-    // Get the difference of the stored depth and the distance of this fragment to the light.
-    float diff = shadowD - shadowPos.w;
+        return clamp(diff * 250.0 + 1.0, 0.0, 1.0);
+    }
 
-    return clamp(diff * 250.0 + 1.0, 0.0, 1.0);
+    return 1.0;
 }
 
 void main()
@@ -279,7 +314,7 @@ void main()
             }
 
             // Sample diffuse irradiance at normal direction.
-            vec3 irradiance = texture(texIrradiance, vec4(N, layer)).rgb;
+            vec3 irradiance = probeIrradiance(probeIndex, layer, N);
 
             // Sample pre-filtered specular reflection environment at correct mipmap level.
             vec3 specularIrradiance = textureLod(texSpecularCM, vec4(LrFixed, layer), roughness * SPECULAR_CM_LEVELS).rgb;
@@ -294,7 +329,7 @@ void main()
         }
 
         if (totalBlend < 0.99) {
-            totalIrradiance = mix(texture(texIrradiance, vec4(N, 0.0)).rgb, totalIrradiance, totalBlend);
+            totalIrradiance = mix(probeIrradiance(0u, 0.0, N), totalIrradiance, totalBlend);
             totalSpecularIrradiance = mix(textureLod(texSpecularCM, vec4(Lr, 0.0), roughness * SPECULAR_CM_LEVELS).rgb, totalSpecularIrradiance, totalBlend);
         }
 
@@ -1,6 +1,25 @@
 layout(location = 0) in vec3 pos;
 
+#ifdef INDIRECT
+layout(location = 6) in uint instanceIdx;
+
+struct IndirectInstance
+{
+    mat4 model;
+    mat4 prevModel;
+    vec4 aabbMin;
+    vec4 aabbMax;
+    uvec4 flags;
+};
+
+layout (std430, binding = 10) readonly buffer indirectInstancesSSBO
+{
+    IndirectInstance indirectInstances[];
+};
+#else
 uniform mat4 model;
+#endif
+
 uniform mat4 viewProj;
 #ifndef SHADOW
 uniform mat4 prevStableMVP;
@@ -12,9 +31,18 @@ out vec4 v_clipPos;
 
 void main()
 {
+#ifdef INDIRECT
+    mat4 model = indirectInstances[instanceIdx].model;
+#ifndef SHADOW
+    // Stable matrices come without model part here, there's no per-draw model uniform.
+    v_prevClipPos = vec4(pos, 1.0) * indirectInstances[instanceIdx].prevModel * prevStableMVP;
+    v_clipPos = vec4(pos, 1.0) * model * curStableMVP;
+#endif
+#else
 #ifndef SHADOW
     v_prevClipPos = vec4(pos, 1.0) * prevStableMVP;
     v_clipPos = vec4(pos, 1.0) * curStableMVP;
+#endif
 #endif
     gl_Position = vec4(pos, 1.0) * model * viewProj;
 }
@@ -96,6 +96,15 @@
         } \
     } while (0)
 
+// Extension entry points, left null if missing, callers check for support.
+#define GL_GET_PROC_OPTIONAL(func, sym) \
+    do { \
+        *(void**)(&af3d::ogl.func) = gGetProcAddress((LPCSTR)#sym); \
+        if (!af3d::ogl.func) { \
+            *(void**)(&af3d::ogl.func) = GetProcAddress(gHandle, #sym); \
+        } \
+    } while (0)
+
 #define AL_GET_PROC(func, sym) \
     do { \
         *(void**)(&af3d::oal.func) = GetProcAddress(handle, #sym); \
@@ -124,6 +133,8 @@ static PFNWGLGETPIXELFORMATATTRIBIVARBPROC gGetPixelFormatAttribivARB;
 static PFNWGLCREATECONTEXTATTRIBSARBPROC gCreateContextAttribsARB = nullptr;
 /* WGL_EXT_swap_control */
 static PFNWGLSWAPINTERVALEXTPROC gSwapIntervalEXT = nullptr;
+/* WGL_EXT_swap_control_tear, negative intervals with gSwapIntervalEXT */
+static bool gSwapControlTear = false;
 
 static DEVMODEA desktopMode;
 
@@ -335,6 +346,9 @@ static bool OGLPreInit()
     WGL_GET_EXT_PROC(WGL_ARB_pixel_format, gGetPixelFormatAttribivARB, wglGetPixelFormatAttribivARB);
     WGL_GET_EXT_PROC_OPT(WGL_ARB_create_context, gCreateContextAttribsARB, wglCreateContextAttribsARB);
     WGL_GET_EXT_PROC_OPT(WGL_EXT_swap_control, gSwapIntervalEXT, wglSwapIntervalEXT);
+    if (gSwapIntervalEXT) {
+        gSwapControlTear = (strstr(extStr, "WGL_EXT_swap_control_tear ") != nullptr);
+    }
 
     GL_GET_PROC(DrawBuffers, glDrawBuffers);
     GL_GET_PROC(GetTexImage, glGetTexImage);
@@ -372,6 +386,8 @@ static bool OGLPreInit()
     GL_GET_PROC(TexImage3D, glTexImage3D);
     GL_GET_PROC(TexSubImage3D, glTexSubImage3D);
     GL_GET_PROC(CompressedTexImage2D, glCompressedTexImage2D);
+    GL_GET_PROC(CompressedTexSubImage3D, glCompressedTexSubImage3D);
+    GL_GET_PROC(GetCompressedTexImage, glGetCompressedTexImage);
     GL_GET_PROC(TexParameteri, glTexParameteri);
     GL_GET_PROC(ClearColor, glClearColor);
     GL_GET_PROC(Clear, glClear);
@@ -436,6 +452,23 @@ static bool OGLPreInit()
     GL_GET_PROC(BindBufferBase, glBindBufferBase);
     GL_GET_PROC(DispatchCompute, glDispatchCompute);
     GL_GET_PROC(MemoryBarrier, glMemoryBarrier);
+    GL_GET_PROC(BindImageTexture, glBindImageTexture);
+    GL_GET_PROC(VertexAttribIPointer, glVertexAttribIPointer);
+    GL_GET_PROC(VertexAttribDivisor, glVertexAttribDivisor);
+    GL_GET_PROC(MultiDrawElementsIndirect, glMultiDrawElementsIndirect);
+    GL_GET_PROC(GenQueries, glGenQueries);
+    GL_GET_PROC(DeleteQueries, glDeleteQueries);
+    GL_GET_PROC(BeginQuery, glBeginQuery);
+    GL_GET_PROC(EndQuery, glEndQuery);
+    GL_GET_PROC(GetQueryObjectiv, glGetQueryObjectiv);
+    GL_GET_PROC(GetQueryObjectui64v, glGetQueryObjectui64v);
+    GL_GET_PROC(FenceSync, glFenceSync);
+    GL_GET_PROC(ClientWaitSync, glClientWaitSync);
+    GL_GET_PROC(DeleteSync, glDeleteSync);
+    GL_GET_PROC_OPTIONAL(GetTextureSamplerHandleARB, glGetTextureSamplerHandleARB);
+    GL_GET_PROC_OPTIONAL(MakeTextureHandleResidentARB, glMakeTextureHandleResidentARB);
+    GL_GET_PROC_OPTIONAL(MakeTextureHandleNonResidentARB, glMakeTextureHandleNonResidentARB);
+    GL_GET_PROC_OPTIONAL(UniformHandleui64ARB, glUniformHandleui64ARB);
 
     const int numPixelFormatsQuery = WGL_NUMBER_PIXEL_FORMATS_ARB;
     int numFormats = 0;
@@ -984,7 +1017,8 @@ static bool OGLInit(bool vsync)
     }
 
     if (gSwapIntervalEXT) {
-        gSwapIntervalEXT(vsync ? 1 : 0);
+        // -1 is adaptive vsync, late frames are swapped right away.
+        gSwapIntervalEXT(vsync ? ((gSwapControlTear && af3d::settings.adaptiveVsync) ? -1 : 1) : 0);
     }
 
     LOG4CPLUS_INFO(af3d::logger(), "OpenGL initialized");
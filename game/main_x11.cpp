@@ -99,6 +99,15 @@
         } \
     } while (0)
 
+// Extension entry points, left null if missing, callers check for support.
+#define GL_GET_PROC_OPTIONAL(func, sym) \
+    do { \
+        *(void**)(&af3d::ogl.func) = (void*)getProcAddress((const GLubyte*)#sym); \
+        if (!af3d::ogl.func) { \
+            *(void**)(&af3d::ogl.func) = ::dlsym(handle, #sym); \
+        } \
+    } while (0)
+
 #define AL_GET_PROC(func, sym) \
     do { \
         *(void**)(&af3d::oal.func) = ::dlsym(handle, #sym); \
@@ -1118,6 +1127,8 @@ static PFNGLXCREATECONTEXTATTRIBSARBPROC createContextAttribsARB = nullptr;
 static PFNGLXSWAPINTERVALSGIPROC swapIntervalSGI = nullptr;
 static PFNGLXSWAPINTERVALEXTPROC swapIntervalEXT = nullptr;
 static PFNGLXSWAPINTERVALMESAPROC swapIntervalMESA = nullptr;
+/* GLX_EXT_swap_control_tear, negative intervals with swapIntervalEXT */
+static bool swapControlTear = false;
 
 static const int ctxAttribs[] =
 {
@@ -1210,7 +1221,9 @@ static bool OGLPreInit()
     GLX_GET_PROC_OPT(GLX_ARB_create_context, createContextAttribsARB, glXCreateContextAttribsARB);
 
     GLX_GET_PROC_OPT(GLX_EXT_swap_control, swapIntervalEXT, glXSwapIntervalEXT);
-    if (!swapIntervalEXT) {
+    if (swapIntervalEXT) {
+        swapControlTear = (strstr(extStr, "GLX_EXT_swap_control_tear ") != nullptr);
+    } else {
         GLX_GET_PROC_OPT(GLX_MESA_swap_control, swapIntervalMESA, glXSwapIntervalMESA);
         if (!swapIntervalMESA) {
             GLX_GET_PROC_OPT(GLX_SGI_swap_control, swapIntervalSGI, glXSwapIntervalSGI);
@@ -1253,6 +1266,8 @@ static bool OGLPreInit()
     GL_GET_PROC(TexImage3D, glTexImage3D);
     GL_GET_PROC(TexSubImage3D, glTexSubImage3D);
     GL_GET_PROC(CompressedTexImage2D, glCompressedTexImage2D);
+    GL_GET_PROC(CompressedTexSubImage3D, glCompressedTexSubImage3D);
+    GL_GET_PROC(GetCompressedTexImage, glGetCompressedTexImage);
     GL_GET_PROC(TexParameteri, glTexParameteri);
     GL_GET_PROC(ClearColor, glClearColor);
     GL_GET_PROC(Clear, glClear);
@@ -1317,6 +1332,23 @@ static bool OGLPreInit()
     GL_GET_PROC(BindBufferBase, glBindBufferBase);
     GL_GET_PROC(DispatchCompute, glDispatchCompute);
     GL_GET_PROC(MemoryBarrier, glMemoryBarrier);
+    GL_GET_PROC(BindImageTexture, glBindImageTexture);
+    GL_GET_PROC(VertexAttribIPointer, glVertexAttribIPointer);
+    GL_GET_PROC(VertexAttribDivisor, glVertexAttribDivisor);
+    GL_GET_PROC(MultiDrawElementsIndirect, glMultiDrawElementsIndirect);
+    GL_GET_PROC(GenQueries, glGenQueries);
+    GL_GET_PROC(DeleteQueries, glDeleteQueries);
+    GL_GET_PROC(BeginQuery, glBeginQuery);
+    GL_GET_PROC(EndQuery, glEndQuery);
+    GL_GET_PROC(GetQueryObjectiv, glGetQueryObjectiv);
+    GL_GET_PROC(GetQueryObjectui64v, glGetQueryObjectui64v);
+    GL_GET_PROC(FenceSync, glFenceSync);
+    GL_GET_PROC(ClientWaitSync, glClientWaitSync);
+    GL_GET_PROC(DeleteSync, glDeleteSync);
+    GL_GET_PROC_OPTIONAL(GetTextureSamplerHandleARB, glGetTextureSamplerHandleARB);
+    GL_GET_PROC_OPTIONAL(MakeTextureHandleResidentARB, glMakeTextureHandleResidentARB);
+    GL_GET_PROC_OPTIONAL(MakeTextureHandleNonResidentARB, glMakeTextureHandleNonResidentARB);
+    GL_GET_PROC_OPTIONAL(UniformHandleui64ARB, glUniformHandleui64ARB);
 
     int n = 0;
 
@@ -1469,7 +1501,9 @@ static bool OGLInit(bool vsync)
     }
 
     if (swapIntervalEXT) {
-        swapIntervalEXT(dpy, window, vsync ? 1 : 0);
+        // -1 is adaptive vsync, late frames are swapped right away.
+        int interval = vsync ? ((swapControlTear && af3d::settings.adaptiveVsync) ? -1 : 1) : 0;
+        swapIntervalEXT(dpy, window, interval);
     } else if (swapIntervalMESA) {
         swapIntervalMESA(vsync ? 1 : 0);
     } else if (swapIntervalSGI) {
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _AF3D_BC6H_H_
+#define _AF3D_BC6H_H_
+
+#include "af3d/Types.h"
+
+namespace af3d
+{
+    /*
+     * CPU encoder for GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT (BC6H UF16). Only uses
+     * single region mode 11 (10-bit endpoints), that's good enough for smooth HDR
+     * content such as prefiltered light probes and is cheap enough for a worker thread.
+     */
+
+    // Size of a width x height image, same as 'HardwareTexture::compressedSize'.
+    std::uint32_t bc6hSize(std::uint32_t width, std::uint32_t height);
+
+    // 'pixels' is width x height tightly packed RGB floats, 'out' must hold 'bc6hSize' bytes.
+    // Negative values and NaNs become 0, values above half float max are clamped.
+    void bc6hEncode(const float* pixels, std::uint32_t width, std::uint32_t height, Byte* out);
+}
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020, Stanislav Vorobiov
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _AF3D_BVH_H_
+#define _AF3D_BVH_H_
+
+#include "af3d/Types.h"
+#include "af3d/AABB.h"
+#include <vector>
+
+namespace af3d
+{
+    /*
+     * Immutable flat bounding volume hierarchy, built top-down with binned SAH.
+     * Nodes are stored depth-first, left child always immediately follows its parent,
+     * so traversal is a linear walk over a contiguous array with a small fixed stack.
+     * Use it for data that rarely changes, rebuild on edits.
+     */
+    class BVH
+    {
+    public:
+        struct Node
+        {
+            AABB aabb;
+            std::uint32_t offset; // Right child index for internal nodes, first primitive for leaves.
+            std::uint32_t count; // Number of primitives, 0 for internal nodes.
+        };
+
+        static const int maxDepth = 64;
+
+        BVH() = default;
+        ~BVH() = default;
+
+        // 'aabbs' indices are the primitive ids reported during traversal.
+        void build(const std::vector<AABB>& aabbs, int maxLeafSize = 4);
+
+        void clear();
+
+        inline bool empty() const { return nodes_.empty(); }
+
+        inline const std::vector<Node>& nodes() const { return nodes_; }
+
+        inline const std::vector<int>& indices() const { return indices_; }
+
+        inline const AABB& aabb() const { return nodes_[0].aabb; }
+
+        /*
+         * 'descent(const AABB&)' returns false to skip a subtree,
+         * 'process(int)' is called for each primitive in visited leaves.
+         */
+        template <class DescentFn, class ProcessFn>
+        void traverse(DescentFn&& descent, ProcessFn&& process) const
+        {
+            if (nodes_.empty()) {
+                return;
+            }
+
+            std::uint32_t stack[maxDepth];
+            int sp = 0;
+
+            stack[sp++] = 0;
+
+            while (sp > 0) {
+                auto idx = stack[--sp];
+                const auto& node = nodes_[idx];
+                if (!descent(node.aabb)) {
+                    continue;
+                }
+                if (node.count > 0) {
+                    for (auto i = node.offset; i < node.offset + node.count; ++i) {
+                        process(indices_[i]);
+                    }
+                } else {
+                    btAssert(sp + 2 <= maxDepth);
+                    stack[sp++] = node.offset;
+                    stack[sp++] = idx + 1;
+                }
+            }
+        }
+
+    private:
+        struct BuildItem
+        {
+            AABB aabb;
+            btVector3 center;
+            int index;
+        };
+
+        void buildNode(std::vector<BuildItem>& items, std::uint32_t first, std::uint32_t count, int depth, int maxLeafSize);
+
+        std::vector<Node> nodes_;
+        std::vector<int> indices_;
+    };
+}
+
+#endif
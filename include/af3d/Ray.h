@@ -56,6 +56,10 @@ namespace af3d
         RayTestResult testSphere(const Sphere& s) const;
 
         RayTestResult testPlane(const btPlane& p) const;
+
+        // Moller-Trumbore, two-sided. On hit 't' is the distance, (u, v) are barycentrics of 'v1' and 'v2'.
+        bool testTriangle(const btVector3& v0, const btVector3& v1, const btVector3& v2,
+            float& t, float& u, float& v) const;
     };
 
     extern const Ray Ray_empty;
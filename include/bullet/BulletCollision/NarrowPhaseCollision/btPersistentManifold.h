@@ -87,6 +87,9 @@ public:
 
 	int m_index1a;
 
+	void* m_userPointer;
+	int m_userIndex;
+
 	btPersistentManifold();
 
 	btPersistentManifold(const btCollisionObject* body0, const btCollisionObject* body1, int, btScalar contactBreakingThreshold, btScalar contactProcessingThreshold)
@@ -98,7 +101,9 @@ public:
 		  m_contactProcessingThreshold(contactProcessingThreshold),
 		  m_companionIdA(0),
 		  m_companionIdB(0),
-		  m_index1a(0)
+		  m_index1a(0),
+		  m_userPointer(0),
+		  m_userIndex(-1)
 	{
 	}
 